@@ -44,6 +44,7 @@
 #include "iocinf.h"
 #include "oldAccess.h"
 #include "cac.h"
+#include "monitorDispatch.h"
 
 epicsThreadPrivateId caClientContextId;
 
@@ -354,6 +355,95 @@ int epicsShareAPI ca_create_channel (
     return ECA_NORMAL;
 }
 
+/*
+ *  ca_create_channels ()
+ */
+// extern "C"
+int epicsShareAPI ca_create_channels (
+     unsigned nChannels, const char * const * pNames,
+     caCh * conn_func, void * const * pUsers,
+     capri priority, chid * chanptrs )
+{
+    ca_client_context * pcac;
+    int caStatus = fetchClientContext ( & pcac );
+    if ( caStatus != ECA_NORMAL ) {
+        return caStatus;
+    }
+
+    {
+        CAFDHANDLER * pFunc = 0;
+        void * pArg = 0;
+        {
+            epicsGuard < epicsMutex >
+                guard ( pcac->mutex );
+            if ( pcac->fdRegFuncNeedsToBeCalled ) {
+                pFunc = pcac->fdRegFunc;
+                pArg = pcac->fdRegArg;
+                pcac->fdRegFuncNeedsToBeCalled = false;
+            }
+        }
+        if ( pFunc ) {
+            ( *pFunc ) ( pArg, pcac->sock, true );
+        }
+    }
+
+    // the mutex is released between batches so that the receive
+    // threads are not locked out while a very large set is created
+    unsigned i = 0u;
+    while ( i < nChannels ) {
+        unsigned batchEnd = i + ca_client_context::bulkBatchSize;
+        if ( batchEnd > nChannels || batchEnd < i ) {
+            batchEnd = nChannels;
+        }
+        epicsGuard < epicsMutex > guard ( pcac->mutex );
+        for ( ; i < batchEnd; i++ ) {
+            int status = ECA_NORMAL;
+            chanptrs[i] = 0;
+            try {
+                oldChannelNotify * pChanNotify =
+                    new ( pcac->oldChannelNotifyFreeList )
+                        oldChannelNotify ( guard, *pcac, pNames[i],
+                            conn_func, pUsers ? pUsers[i] : 0, priority );
+                // make sure that their chan pointer is set prior to
+                // calling connection call backs
+                chanptrs[i] = pChanNotify;
+                pChanNotify->initiateConnect ( guard );
+            }
+            catch ( cacChannel::badString & ) {
+                status = ECA_BADSTR;
+            }
+            catch ( std::bad_alloc & ) {
+                status = ECA_ALLOCMEM;
+            }
+            catch ( cacChannel::badPriority & ) {
+                status = ECA_BADPRIORITY;
+            }
+            catch ( cacChannel::unsupportedByService & ) {
+                status = ECA_UNAVAILINSERV;
+            }
+            catch ( std :: exception & except ) {
+                pcac->printFormated (
+                    "ca_create_channels: "
+                    "unexpected exception was \"%s\"",
+                    except.what () );
+                status = ECA_INTERNAL;
+            }
+            catch ( ... ) {
+                status = ECA_INTERNAL;
+            }
+            if ( status != ECA_NORMAL ) {
+                // cadef.h promises NULL for the channels that failed
+                chanptrs[i] = 0;
+                if ( caStatus == ECA_NORMAL ) {
+                    caStatus = status;
+                }
+            }
+        }
+    }
+
+    return caStatus;
+}
+
 /*
  *  ca_clear_channel ()
  *
@@ -374,11 +464,17 @@ int epicsShareAPI ca_clear_channel ( chid pChan )
             // intentionally ignored
         }
     }
+    // stop subscription update callbacks for the channel, and wait
+    // for one that might be in progress on a dispatch thread before
+    // the channel is destroyed
+    if ( cac.pMonitorDispatch.get () ) {
+        pChan->dispatchBlock ();
+        cac.pMonitorDispatch->quiesce ( pChan );
+    }
     if ( cac.pCallbackGuard.get() &&
             cac.createdByThread == epicsThreadGetIdSelf () ) {
         epicsGuard < epicsMutex > guard ( cac.mutex );
         pChan->destructor ( *cac.pCallbackGuard.get(), guard );
-        cac.oldChannelNotifyFreeList.release ( pChan );
     }
     else {
         //
@@ -392,11 +488,114 @@ int epicsShareAPI ca_clear_channel ( chid pChan )
         CallbackGuard cbGuard ( cac.cbMutex );
         epicsGuard < epicsMutex > guard ( cac.mutex );
         pChan->destructor ( *cac.pCallbackGuard.get(), guard );
+    }
+    // a dispatch thread that checked the block before the destructor
+    // ran may still be reading it, so wait again before reuse
+    if ( cac.pMonitorDispatch.get () ) {
+        cac.pMonitorDispatch->quiesce ( pChan );
+    }
+    {
+        epicsGuard < epicsMutex > guard ( cac.mutex );
         cac.oldChannelNotifyFreeList.release ( pChan );
     }
     return ECA_NORMAL;
 }
 
+/*
+ *  ca_clear_channels ()
+ */
+// extern "C"
+int epicsShareAPI ca_clear_channels (
+    unsigned nChannels, const chid * pChans )
+{
+    ca_client_context * pcac = 0;
+    for ( unsigned i = 0u; i < nChannels; i++ ) {
+        if ( pChans[i] ) {
+            if ( ! pcac ) {
+                pcac = & pChans[i]->getClientCtx ();
+            }
+            else if ( pcac != & pChans[i]->getClientCtx () ) {
+                return ECA_BADCHID;
+            }
+        }
+    }
+    if ( ! pcac ) {
+        return ECA_NORMAL;
+    }
+    ca_client_context & cac = *pcac;
+
+    // see the comments in ca_clear_channel ()
+    if ( cac.pMonitorDispatch.get () ) {
+        for ( unsigned i = 0u; i < nChannels; i++ ) {
+            if ( pChans[i] ) {
+                pChans[i]->dispatchBlock ();
+            }
+        }
+        for ( unsigned i = 0u; i < nChannels; i++ ) {
+            if ( pChans[i] ) {
+                cac.pMonitorDispatch->quiesce ( pChans[i] );
+            }
+        }
+    }
+
+    unsigned i = 0u;
+    while ( i < nChannels ) {
+        unsigned batchEnd = i + ca_client_context::bulkBatchSize;
+        if ( batchEnd > nChannels || batchEnd < i ) {
+            batchEnd = nChannels;
+        }
+        {
+            epicsGuard < epicsMutex > guard ( cac.mutex );
+            for ( unsigned j = i; j < batchEnd; j++ ) {
+                if ( pChans[j] ) {
+                    try {
+                        pChans[j]->eliminateExcessiveSendBacklog ( guard );
+                    }
+                    catch ( cacChannel::notConnected & ) {
+                        // intentionally ignored
+                    }
+                }
+            }
+        }
+        if ( cac.pCallbackGuard.get() &&
+                cac.createdByThread == epicsThreadGetIdSelf () ) {
+            epicsGuard < epicsMutex > guard ( cac.mutex );
+            for ( ; i < batchEnd; i++ ) {
+                if ( pChans[i] ) {
+                    pChans[i]->destructor ( *cac.pCallbackGuard.get(), guard );
+                }
+            }
+        }
+        else {
+            // see the comments in ca_clear_channel ()
+            CallbackGuard cbGuard ( cac.cbMutex );
+            epicsGuard < epicsMutex > guard ( cac.mutex );
+            for ( ; i < batchEnd; i++ ) {
+                if ( pChans[i] ) {
+                    pChans[i]->destructor ( cbGuard, guard );
+                }
+            }
+        }
+    }
+
+    if ( cac.pMonitorDispatch.get () ) {
+        for ( i = 0u; i < nChannels; i++ ) {
+            if ( pChans[i] ) {
+                cac.pMonitorDispatch->quiesce ( pChans[i] );
+            }
+        }
+    }
+    {
+        epicsGuard < epicsMutex > guard ( cac.mutex );
+        for ( i = 0u; i < nChannels; i++ ) {
+            if ( pChans[i] ) {
+                cac.oldChannelNotifyFreeList.release ( pChans[i] );
+            }
+        }
+    }
+    return ECA_NORMAL;
+}
+
 /*
  *  Specify an event subroutine to be run for asynch exceptions
  */
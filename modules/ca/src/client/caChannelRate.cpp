@@ -0,0 +1,170 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measures the rate at which channels can be created, subscribed and
+ * cleared, first one at a time and then with the bulk API functions.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cadef.h"
+#include "dbDefs.h"
+#include "epicsTime.h"
+#include "epicsStdio.h"
+
+#include "caDiagnostics.h"
+
+extern "C" void channelRateEventCallBack ( struct event_handler_args args )
+{
+    unsigned *pCount = static_cast < unsigned * > ( args.usr );
+    (*pCount)++;
+}
+
+static void waitForEvents ( unsigned & eventCount, unsigned count )
+{
+    while ( eventCount < count ) {
+        int status = ca_pend_event ( 0.01 );
+        if ( status != ECA_TIMEOUT ) {
+            SEVCHK ( status, NULL );
+        }
+    }
+}
+
+static void report ( const char * pWhat, unsigned count,
+    const epicsTime & begin, const epicsTime & end )
+{
+    double delay = end - begin;
+    printf ( "%-34s %10.3f sec %12.0f channels/sec\n",
+        pWhat, delay, delay > 0.0 ? count / delay : 0.0 );
+}
+
+static bool channelRateSingle ( const char * const * pNames, unsigned count,
+    chid * pChans, evid * pEvents, unsigned & eventCount )
+{
+    epicsTime begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < count; i++ ) {
+        int status = ca_create_channel ( pNames[i], 0, 0,
+            CA_PRIORITY_DEFAULT, & pChans[i] );
+        SEVCHK ( status, NULL );
+    }
+    int status = ca_pend_io ( 60.0 );
+    if ( status != ECA_NORMAL ) {
+        fprintf ( stderr, "Channels did not connect.\n" );
+        return false;
+    }
+    epicsTime end = epicsTime::getCurrent ();
+    report ( "ca_create_channel + ca_pend_io", count, begin, end );
+
+    eventCount = 0u;
+    begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < count; i++ ) {
+        status = ca_create_subscription ( DBR_DOUBLE, 1, pChans[i],
+            DBE_VALUE, channelRateEventCallBack, & eventCount, & pEvents[i] );
+        SEVCHK ( status, NULL );
+    }
+    status = ca_flush_io ();
+    SEVCHK ( status, NULL );
+    waitForEvents ( eventCount, count );
+    end = epicsTime::getCurrent ();
+    report ( "ca_create_subscription", count, begin, end );
+
+    begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < count; i++ ) {
+        status = ca_clear_channel ( pChans[i] );
+        SEVCHK ( status, NULL );
+    }
+    status = ca_flush_io ();
+    SEVCHK ( status, NULL );
+    end = epicsTime::getCurrent ();
+    report ( "ca_clear_channel", count, begin, end );
+    return true;
+}
+
+static bool channelRateBulk ( const char * const * pNames, unsigned count,
+    chid * pChans, evid * pEvents, unsigned & eventCount )
+{
+    epicsTime begin = epicsTime::getCurrent ();
+    int status = ca_create_channels ( count, pNames, 0, 0,
+        CA_PRIORITY_DEFAULT, pChans );
+    SEVCHK ( status, NULL );
+    status = ca_pend_io ( 60.0 );
+    if ( status != ECA_NORMAL ) {
+        fprintf ( stderr, "Channels did not connect.\n" );
+        return false;
+    }
+    epicsTime end = epicsTime::getCurrent ();
+    report ( "ca_create_channels + ca_pend_io", count, begin, end );
+
+    eventCount = 0u;
+    void ** pArgs = new void * [count];
+    for ( unsigned i = 0u; i < count; i++ ) {
+        pArgs[i] = & eventCount;
+    }
+    begin = epicsTime::getCurrent ();
+    status = ca_create_subscriptions ( DBR_DOUBLE, 1, count, pChans,
+        DBE_VALUE, channelRateEventCallBack, pArgs, pEvents );
+    SEVCHK ( status, NULL );
+    status = ca_flush_io ();
+    SEVCHK ( status, NULL );
+    waitForEvents ( eventCount, count );
+    end = epicsTime::getCurrent ();
+    report ( "ca_create_subscriptions", count, begin, end );
+    delete [] pArgs;
+
+    begin = epicsTime::getCurrent ();
+    status = ca_clear_channels ( count, pChans );
+    SEVCHK ( status, NULL );
+    status = ca_flush_io ();
+    SEVCHK ( status, NULL );
+    end = epicsTime::getCurrent ();
+    report ( "ca_clear_channels", count, begin, end );
+    return true;
+}
+
+int caChannelRate ( const char * pName, unsigned count,
+    enum appendNumberFlag appNF )
+{
+    char ** pNames = new char * [count];
+    for ( unsigned i = 0u; i < count; i++ ) {
+        char buf[256];
+        if ( appNF == appendNumber ) {
+            epicsSnprintf ( buf, sizeof ( buf ), "%.200s%u", pName, i );
+        }
+        else {
+            epicsSnprintf ( buf, sizeof ( buf ), "%.200s", pName );
+        }
+        pNames[i] = new char [strlen ( buf ) + 1];
+        strcpy ( pNames[i], buf );
+    }
+    chid * pChans = new chid [count];
+    evid * pEvents = new evid [count];
+    unsigned eventCount = 0u;
+
+    SEVCHK ( ca_context_create ( ca_disable_preemptive_callback ),
+        "Unable to initialize" );
+
+    printf ( "Channel rates for %u channels named \"%s%s\"\n",
+        count, pName, appNF == appendNumber ? "<n>" : "" );
+    bool success = channelRateSingle ( pNames, count,
+        pChans, pEvents, eventCount );
+    if ( success ) {
+        success = channelRateBulk ( pNames, count,
+            pChans, pEvents, eventCount );
+    }
+
+    ca_context_destroy ();
+
+    delete [] pEvents;
+    delete [] pChans;
+    for ( unsigned i = 0u; i < count; i++ ) {
+        delete [] pNames[i];
+    }
+    delete [] pNames;
+    return success ? CATIME_OK : CATIME_ERROR;
+}
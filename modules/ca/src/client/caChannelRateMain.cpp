@@ -0,0 +1,41 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "caDiagnostics.h"
+
+int main ( int argc, char **argv )
+{
+    if ( argc < 2 || argc > 4 ) {
+        fprintf ( stderr, "usage: %s < PV name > [channel count "
+            "[append number to pv name if true]]\n", argv[0] );
+        return 1;
+    }
+
+    unsigned count = 10000u;
+    if ( argc >= 3 ) {
+        int status = sscanf ( argv[2], " %u ", & count );
+        if ( status != 1 || count == 0u ) {
+            fprintf ( stderr, "expected positive integer 2nd argument\n" );
+            return 1;
+        }
+    }
+
+    unsigned appendNumberBool = 0u;
+    if ( argc == 4 ) {
+        int status = sscanf ( argv[3], " %u ", & appendNumberBool );
+        if ( status != 1 ) {
+            fprintf ( stderr, "expected unsigned integer 3rd argument\n" );
+            return 1;
+        }
+    }
+
+    return caChannelRate ( argv[1], count,
+        appendNumberBool ? appendNumber : dontAppendNumber ) ? 1 : 0;
+}
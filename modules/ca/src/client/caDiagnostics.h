@@ -19,6 +19,8 @@ extern "C" {
 
 enum appendNumberFlag {appendNumber, dontAppendNumber};
 int catime ( const char *channelName, unsigned channelCount, enum appendNumberFlag appNF );
+int caChannelRate ( const char *channelName, unsigned channelCount,
+            enum appendNumberFlag appNF );
 
 int acctst ( const char *pname, unsigned logggingInterestLevel, 
             unsigned channelCount, unsigned repetitionCount, 
@@ -32,12 +32,14 @@
 
 #include "epicsExit.h"
 #include "errlog.h"
+#include "envDefs.h"
 #include "locationException.h"
 
 #define epicsExportSharedSymbols
 #include "iocinf.h"
 #include "oldAccess.h"
 #include "cac.h"
+#include "monitorDispatch.h"
 
 epicsShareDef epicsThreadPrivateId caClientCallbackThreadId;
 
@@ -45,6 +47,10 @@ static epicsThreadOnceId cacOnce = EPICS_THREAD_ONCE_INIT;
 
 const unsigned ca_client_context :: flushBlockThreshold = 0x58000;
 
+// number of channels processed by the bulk API functions
+// each time they take the primary mutex
+const unsigned ca_client_context :: bulkBatchSize = 256u;
+
 extern "C" void cacExitHandler ( void *)
 {
     epicsThreadPrivateDelete ( caClientCallbackThreadId );
@@ -163,6 +169,24 @@ ca_client_context::ca_client_context ( bool enablePreemptiveCallback ) :
     if ( ! enablePreemptiveCallback ) {
         pCBGuard.reset ( new CallbackGuard ( this->cbMutex ) );
     }
+    else {
+        // optionally deliver subscription updates from a pool of
+        // threads so that one slow callback doesnt stall all circuits
+        long nThreads = 0;
+        if ( envGetLongConfigParam ( & EPICS_CA_MONITOR_THREADS, & nThreads ) ) {
+            nThreads = 0;
+        }
+        if ( nThreads > 0 ) {
+            static const long maxThreads = 256;
+            if ( nThreads > maxThreads ) {
+                nThreads = maxThreads;
+            }
+            this->pMonitorDispatch.reset (
+                new monitorDispatch ( *this,
+                    static_cast < unsigned > ( nThreads ),
+                    epicsThreadGetPrioritySelf () ) );
+        }
+    }
 
     // multiple steps ensure exception safety
     this->pCallbackGuard = pCBGuard;
@@ -190,6 +214,10 @@ ca_client_context::~ca_client_context ()
     else {
         this->pServiceContext.reset ( 0 );
     }
+
+    // there are no more producers so the dispatch threads can
+    // discard any remaining updates and exit
+    this->pMonitorDispatch.reset ( 0 );
 }
 
 void ca_client_context::destroyGetCopy (
@@ -220,10 +248,23 @@ void ca_client_context::destroySubscription (
     epicsGuard < epicsMutex > & guard, oldSubscription & os )
 {
     guard.assertIdenticalMutex ( this->mutex );
+    if ( this->pMonitorDispatch.get () && ! os.dispatchCancel ( guard ) ) {
+        // the last dispatch thread to deliver an update completes this
+        return;
+    }
     os.~oldSubscription ();
     this->subscriptionFreeList.release ( & os );
 }
 
+void ca_client_context::releaseSubscription ( oldSubscription & os )
+{
+    if ( os.dispatchRelease () ) {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        os.~oldSubscription ();
+        this->subscriptionFreeList.release ( & os );
+    }
+}
+
 void ca_client_context::changeExceptionEvent (
     caExceptionHandler * pfunc, void * arg )
 {
@@ -426,6 +467,9 @@ void ca_client_context::show ( unsigned level ) const
         this->pServiceContext->show ( guard, level - 1u );
         ::printf ( "\tpreemptive callback is %s\n",
             this->pCallbackGuard.get() ? "disabled" : "enabled" );
+        if ( this->pMonitorDispatch.get () ) {
+            this->pMonitorDispatch->show ( level - 1u );
+        }
         ::printf ( "\tthere are %u unsatisfied IO operations blocking ca_pend_io()\n",
                 this->pndRecvCnt );
         ::printf ( "\tthe current io sequence number is %u\n",
@@ -782,6 +826,11 @@ epicsShareFunc int epicsShareAPI ca_clear_subscription ( evid pMon )
       epicsGuard < epicsMutex > guard ( cac.mutex );
       pMon->cancel ( cbGuard, guard );
     }
+    // wait for a callback that might be in progress on a
+    // dispatch thread before returning to the user
+    if ( cac.pMonitorDispatch.get () ) {
+        cac.pMonitorDispatch->quiesce ( & chan );
+    }
     return ECA_NORMAL;
 }
 
@@ -227,6 +227,36 @@ epicsShareFunc int epicsShareAPI ca_create_channel
      chid           *pChanID
 );
 
+/*
+ * ca_create_channels ()
+ *
+ * Create many channels with one call. The library's locks are taken
+ * once for each batch of channels instead of once for each channel.
+ *
+ * nChannels            R   number of channels to create
+ * pChanNames           R   array of nChannels channel name strings
+ * pConnStateCallback   R   address of connection state change
+ *                          callback function shared by all of the
+ *                          channels
+ * pUserPrivates        R   array of nChannels pointers placed in the
+ *                          channels' user private fields, or NULL
+ * priority             R   priority level in the server 0 - 100
+ * pChanIDs             W   array of nChannels channel ids
+ *
+ * Returns ECA_NORMAL if all of the channels were created, otherwise the
+ * status of the first failure. The id of any channel that could not be
+ * created is set to NULL, all of the other channels are valid.
+ */
+epicsShareFunc int epicsShareAPI ca_create_channels
+(
+     unsigned       nChannels,
+     const char * const * pChanNames,
+     caCh           *pConnStateCallback,
+     void * const   *pUserPrivates,
+     capri          priority,
+     chid           *pChanIDs
+);
+
 /*
  * ca_change_connection_event()
  *
@@ -277,6 +307,21 @@ epicsShareFunc int epicsShareAPI ca_clear_channel
      chid   chanId
 );
 
+/*
+ * ca_clear_channels()
+ * - deallocate resources reserved for many channels with one call
+ *
+ * nChannels    R   number of channel ids in the array
+ * pChanIDs     R   array of channel ids, NULL entries are ignored
+ *
+ * All of the channels must belong to the same client context.
+ */
+epicsShareFunc int epicsShareAPI ca_clear_channels
+(
+     unsigned       nChannels,
+     const chid     *pChanIDs
+);
+
 /************************************************************************/
 /*  Write a value to a channel                  */
 /************************************************************************/
@@ -502,6 +547,38 @@ epicsShareFunc int epicsShareAPI ca_create_subscription
      evid *                 pEventID
 );
 
+/*
+ * ca_create_subscriptions ()
+ *
+ * Subscribe to many channels with one call, using the same data type,
+ * element count, event mask and callback function for all of them.
+ *
+ * type      R   data type from db_access.h
+ * count     R   array element count
+ * nChannels R   number of channels to subscribe to
+ * pChanIDs  R   array of nChannels channel identifiers
+ * mask      R   event mask - one of {DBE_VALUE, DBE_ALARM, DBE_LOG}
+ * pFunc     R   pointer to call-back function
+ * pArgs     R   array of nChannels pointers passed to pFunc, or NULL
+ * pEventIDs W   array of nChannels event ids, or NULL
+ *
+ * All of the channels must belong to the same client context. Returns
+ * ECA_NORMAL if all of the subscriptions were created, otherwise the
+ * status of the first failure. The event id of any subscription that
+ * could not be created is set to NULL.
+ */
+epicsShareFunc int epicsShareAPI ca_create_subscriptions
+(
+     chtype                 type,
+     unsigned long          count,
+     unsigned               nChannels,
+     const chid *           pChanIDs,
+     long                   mask,
+     caEventCallBackFunc *  pFunc,
+     void * const *         pArgs,
+     evid *                 pEventIDs
+);
+
 /************************************************************************/
 /*  Remove a function from a list of those specified to run             */
 /*  whenever significant changes occur to a channel                     */
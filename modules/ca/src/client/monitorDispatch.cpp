@@ -0,0 +1,263 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Delivery of subscription updates to the user's callbacks from a pool
+ * of threads when preemptive callback is enabled and
+ * EPICS_CA_MONITOR_THREADS is non-zero.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "iocinf.h"
+#include "oldAccess.h"
+#include "monitorDispatch.h"
+#include "db_access.h"
+
+extern epicsThreadPrivateId caClientCallbackThreadId;
+
+// keep the copied DBR structure aligned for any of its members
+static const size_t itemHeaderSize =
+    ( sizeof ( monitorDispatchItem ) + 15u ) & ~ static_cast < size_t > ( 15u );
+
+void * monitorDispatchItem::pData ()
+{
+    return reinterpret_cast < char * > ( this ) + itemHeaderSize;
+}
+
+monitorDispatchThread::monitorDispatchThread (
+    ca_client_context & ctxIn, const char * pName, unsigned priority ) :
+    thread ( *this, pName,
+        epicsThreadGetStackSize ( epicsThreadStackBig ), priority ),
+    ctx ( ctxIn ), head ( 0 ), nPosted ( 0u ), nDelivered ( 0u ),
+    maxBacklog ( 0u ), shutdownRequested ( 0 )
+{
+}
+
+monitorDispatchThread::~monitorDispatchThread ()
+{
+    epicsAtomicSetIntT ( & this->shutdownRequested, 1 );
+    this->wakeup.signal ();
+    this->thread.exitWait ();
+}
+
+void monitorDispatchThread::start ()
+{
+    this->thread.start ();
+}
+
+bool monitorDispatchThread::isSelf () const
+{
+    return this->thread.isCurrentThread ();
+}
+
+// lock free push onto the head of a singly linked list
+void monitorDispatchThread::post ( monitorDispatchItem & item )
+{
+    EpicsAtomicPtrT pOldHead = epicsAtomicGetPtrT ( & this->head );
+    while ( true ) {
+        item.pNext = static_cast < monitorDispatchItem * > ( pOldHead );
+        EpicsAtomicPtrT pPrev = epicsAtomicCmpAndSwapPtrT (
+            & this->head, pOldHead, & item );
+        if ( pPrev == pOldHead ) {
+            break;
+        }
+        pOldHead = pPrev;
+    }
+    epicsAtomicIncrSizeT ( & this->nPosted );
+    // the consumer only waits after it finds the list empty
+    if ( ! pOldHead ) {
+        this->wakeup.signal ();
+    }
+}
+
+void monitorDispatchThread::quiesce ()
+{
+    epicsGuard < epicsMutex > guard ( this->deliveryMutex );
+}
+
+void monitorDispatchThread::deliver ( monitorDispatchItem & item )
+{
+    if ( ! epicsAtomicGetIntT ( & this->shutdownRequested ) ) {
+        epicsGuard < epicsMutex > guard ( this->deliveryMutex );
+        item.pSubscr->dispatchedCallback ( item );
+    }
+    this->ctx.releaseSubscription ( *item.pSubscr );
+    ::free ( & item );
+    this->nDelivered++;
+}
+
+void monitorDispatchThread::run ()
+{
+    epicsThreadPrivateSet ( caClientCallbackThreadId, this );
+    this->ctx.attachToClientCtx ();
+
+    while ( true ) {
+        // take the entire list in one step so that there is no
+        // ABA hazard with concurrent producers
+        EpicsAtomicPtrT pList = epicsAtomicGetPtrT ( & this->head );
+        while ( pList ) {
+            EpicsAtomicPtrT pPrev = epicsAtomicCmpAndSwapPtrT (
+                & this->head, pList, 0 );
+            if ( pPrev == pList ) {
+                break;
+            }
+            pList = pPrev;
+        }
+        if ( ! pList ) {
+            if ( epicsAtomicGetIntT ( & this->shutdownRequested ) ) {
+                break;
+            }
+            this->wakeup.wait ();
+            continue;
+        }
+
+        // the list is LIFO, reverse it to preserve arrival order
+        monitorDispatchItem * pItem =
+            static_cast < monitorDispatchItem * > ( pList );
+        monitorDispatchItem * pFifo = 0;
+        size_t backlog = 0u;
+        while ( pItem ) {
+            monitorDispatchItem * pNext = pItem->pNext;
+            pItem->pNext = pFifo;
+            pFifo = pItem;
+            pItem = pNext;
+            backlog++;
+        }
+        if ( backlog > this->maxBacklog ) {
+            this->maxBacklog = backlog;
+        }
+
+        while ( pFifo ) {
+            monitorDispatchItem * pNext = pFifo->pNext;
+            this->deliver ( *pFifo );
+            pFifo = pNext;
+        }
+    }
+}
+
+void monitorDispatchThread::show ( unsigned level ) const
+{
+    char name[32];
+    this->thread.getName ( name, sizeof ( name ) );
+    size_t posted = epicsAtomicGetSizeT ( & this->nPosted );
+    ::printf ( "%s: %lu posted, %lu delivered, max backlog %lu\n",
+        name, static_cast < unsigned long > ( posted ),
+        static_cast < unsigned long > ( this->nDelivered ),
+        static_cast < unsigned long > ( this->maxBacklog ) );
+    if ( level > 0u ) {
+        this->thread.show ( level - 1u );
+    }
+}
+
+monitorDispatch::monitorDispatch ( ca_client_context & ctx,
+    unsigned nThreadsIn, unsigned priority ) :
+    pThreads ( new monitorDispatchThread * [nThreadsIn] ),
+    nThreads ( 0u )
+{
+    try {
+        while ( this->nThreads < nThreadsIn ) {
+            char name[32];
+            sprintf ( name, "CAC-monitor-%u", this->nThreads );
+            this->pThreads[this->nThreads] =
+                new monitorDispatchThread ( ctx, name, priority );
+            this->nThreads++;
+        }
+    }
+    catch ( ... ) {
+        while ( this->nThreads > 0u ) {
+            delete this->pThreads[--this->nThreads];
+        }
+        delete [] this->pThreads;
+        throw;
+    }
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->pThreads[i]->start ();
+    }
+}
+
+monitorDispatch::~monitorDispatch ()
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        delete this->pThreads[i];
+    }
+    delete [] this->pThreads;
+}
+
+monitorDispatchThread & monitorDispatch::owner (
+    const void * pChannel ) const
+{
+    size_t hash = reinterpret_cast < size_t > ( pChannel );
+    hash ^= hash >> 7u;
+    hash ^= hash >> 17u;
+    return * this->pThreads[hash % this->nThreads];
+}
+
+void monitorDispatch::post ( epicsGuard < epicsMutex > & guard,
+    oldSubscription & subscr, const void * pChannel, int status,
+    unsigned type, arrayElementCount count, const void * pData )
+{
+    // the reference must be taken while the primary mutex is
+    // held so that the subscription cant be destroyed under us
+    subscr.dispatchReference ( guard );
+
+    monitorDispatchItem * pItem;
+    {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        size_t dataSize = pData ? dbr_size_n ( type, count ) : 0u;
+        pItem = static_cast < monitorDispatchItem * >
+            ( ::malloc ( itemHeaderSize + dataSize ) );
+        if ( ! pItem ) {
+            errlogPrintf ( "CAC: unable to allocate %lu bytes to queue "
+                "a subscription update, update discarded\n",
+                static_cast < unsigned long > ( itemHeaderSize + dataSize ) );
+            subscr.channel().getClientCtx().releaseSubscription ( subscr );
+            return;
+        }
+        pItem->pNext = 0;
+        pItem->pSubscr = & subscr;
+        pItem->count = count;
+        pItem->type = type;
+        pItem->status = status;
+        pItem->hasData = pData != 0;
+        if ( pData ) {
+            memcpy ( pItem->pData (), pData, dataSize );
+        }
+        this->owner ( pChannel ).post ( *pItem );
+    }
+}
+
+void monitorDispatch::quiesce ( const void * pChannel )
+{
+    monitorDispatchThread & thr = this->owner ( pChannel );
+    if ( ! thr.isSelf () ) {
+        // waiting for another pool thread from within a pool thread
+        // could deadlock if that thread is waiting for us
+        for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+            if ( this->pThreads[i]->isSelf () ) {
+                return;
+            }
+        }
+    }
+    thr.quiesce ();
+}
+
+void monitorDispatch::show ( unsigned level ) const
+{
+    ::printf ( "subscription update dispatch to %u threads\n",
+        this->nThreads );
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->pThreads[i]->show ( level );
+    }
+}
@@ -0,0 +1,103 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Delivery of subscription updates to the user's callbacks from a pool
+ * of threads instead of from the circuit's receive thread.
+ *
+ * Each pool thread owns a lock free, multiple producer, single consumer
+ * queue. All of the updates for a particular channel are always posted to
+ * the same pool thread so that they are delivered in the order received.
+ */
+
+#ifndef monitorDispatchh
+#define monitorDispatchh
+
+#ifdef epicsExportSharedSymbols
+#   define monitorDispatchh_restore_epicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsAtomic.h"
+
+#ifdef monitorDispatchh_restore_epicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#   include "shareLib.h"
+#endif
+
+#include "cacIO.h"
+
+struct oldSubscription;
+struct ca_client_context;
+struct monitorDispatchItem;
+
+class monitorDispatchThread : private epicsThreadRunable {
+public:
+    monitorDispatchThread ( ca_client_context &,
+        const char * pName, unsigned priority );
+    ~monitorDispatchThread ();
+    void start ();
+    void post ( monitorDispatchItem & );
+    void quiesce ();
+    bool isSelf () const;
+    void show ( unsigned level ) const;
+private:
+    epicsThread thread;
+    epicsEvent wakeup;
+    epicsMutex deliveryMutex;
+    ca_client_context & ctx;
+    EpicsAtomicPtrT head;
+    size_t nPosted;
+    size_t nDelivered;
+    size_t maxBacklog;
+    int shutdownRequested;
+    void run ();
+    void deliver ( monitorDispatchItem & );
+    monitorDispatchThread ( const monitorDispatchThread & );
+    monitorDispatchThread & operator = ( const monitorDispatchThread & );
+};
+
+class monitorDispatch {
+public:
+    monitorDispatch ( ca_client_context &,
+        unsigned nThreads, unsigned priority );
+    ~monitorDispatch ();
+    // increments the subscription's reference count while the guard is
+    // held, copies the data with the guard released, and then queues
+    // the update for the pool thread which owns the channel
+    void post ( epicsGuard < epicsMutex > &, oldSubscription &,
+        const void * pChannel, int status, unsigned type,
+        arrayElementCount count, const void * pData );
+    // waits for any callback currently executing on the pool thread
+    // that owns the channel to complete. When called from a different
+    // pool thread this returns at once, because the owner might be
+    // waiting for the caller, so a callback may still be in progress.
+    void quiesce ( const void * pChannel );
+    void show ( unsigned level ) const;
+private:
+    monitorDispatchThread ** pThreads;
+    unsigned nThreads;
+    monitorDispatchThread & owner ( const void * pChannel ) const;
+    monitorDispatch ( const monitorDispatch & );
+    monitorDispatch & operator = ( const monitorDispatch & );
+};
+
+struct monitorDispatchItem {
+    monitorDispatchItem * pNext;
+    oldSubscription * pSubscr;
+    arrayElementCount count;
+    unsigned type;
+    int status;
+    bool hasData;
+    void * pData ();
+};
+
+#endif // ifndef monitorDispatchh
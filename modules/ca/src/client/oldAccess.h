@@ -47,6 +47,9 @@
 #include "cadef.h"
 #include "syncGroup.h"
 
+struct monitorDispatchItem;
+class monitorDispatch;
+
 struct oldChannelNotify : private cacChannelNotify {
 public:
     oldChannelNotify (
@@ -56,6 +59,10 @@ public:
     void destructor (
         CallbackGuard & cbGuard,
         epicsGuard < epicsMutex > & mutexGuard );
+    // no subscription update callbacks start on the monitor dispatch
+    // threads once the channel is blocked, see ca_clear_channel
+    void dispatchBlock ();
+    bool dispatchBlocked () const;
 
     // legacy C API
     friend unsigned epicsShareAPI ca_get_host_name (
@@ -102,6 +109,10 @@ public:
         chtype type, arrayElementCount count, chid pChan,
         long mask, caEventCallBackFunc * pCallBack,
         void * pCallBackArg, evid * monixptr );
+    friend int epicsShareAPI ca_create_subscriptions (
+        chtype type, arrayElementCount count, unsigned nChannels,
+        const chid * pChans, long mask, caEventCallBackFunc * pCallBack,
+        void * const * pCallBackArgs, evid * monixptrs );
     friend enum channel_state epicsShareAPI ca_state (
         chid pChan );
     friend double epicsShareAPI ca_receive_watchdog_delay (
@@ -147,6 +158,7 @@ private:
     void * pPrivate;
     caArh * pAccessRightsFunc;
     unsigned ioSeqNo;
+    int blocked;
     bool currentlyConnected;
     bool prevConnected;
     void connectNotify ( epicsGuard < epicsMutex > & );
@@ -268,6 +280,12 @@ public:
     void cancel (
         CallbackGuard & callbackGuard,
         epicsGuard < epicsMutex > & mutualExclusionGuard );
+    // updates queued for a monitor dispatch thread hold a reference
+    // which defers destruction until they have been delivered
+    void dispatchReference ( epicsGuard < epicsMutex > & );
+    bool dispatchRelease ();
+    bool dispatchCancel ( epicsGuard < epicsMutex > & );
+    void dispatchedCallback ( monitorDispatchItem & );
     void * operator new ( size_t size,
         tsFreeList < struct oldSubscription, 1024, epicsMutexNOOP > & );
     epicsPlacementDeleteOperator (( void *,
@@ -277,6 +295,8 @@ private:
     cacChannel::ioid id;
     caEventCallBackFunc * pFunc;
     void * pPrivate;
+    size_t dispatchRefs;
+    int cancelled;
     void current (
         epicsGuard < epicsMutex > &, unsigned type,
         arrayElementCount count, const void *pData );
@@ -345,6 +365,8 @@ public:
     void destroyGetCallback ( epicsGuard < epicsMutex > &, getCallback & );
     void destroyPutCallback ( epicsGuard < epicsMutex > &, putCallback & );
     void destroySubscription ( epicsGuard < epicsMutex > &, oldSubscription & );
+    void releaseSubscription ( oldSubscription & );
+    monitorDispatch * monitorDispatcher () const;
     epicsMutex & mutexRef () const;
 
     template < class T >
@@ -355,6 +377,12 @@ public:
         const char * name_str, caCh * conn_func, void * puser,
         capri priority, chid * chanptr );
     friend int epicsShareAPI ca_clear_channel ( chid pChan );
+    friend int epicsShareAPI ca_create_channels (
+        unsigned nChannels, const char * const * pNames,
+        caCh * conn_func, void * const * pUsers,
+        capri priority, chid * chanptrs );
+    friend int epicsShareAPI ca_clear_channels (
+        unsigned nChannels, const chid * pChans );
     friend int epicsShareAPI ca_array_get ( chtype type,
         arrayElementCount count, chid pChan, void * pValue );
     friend int epicsShareAPI ca_array_get_callback ( chtype type,
@@ -369,6 +397,10 @@ public:
         chtype type, arrayElementCount count, chid pChan,
         long mask, caEventCallBackFunc * pCallBack, void * pCallBackArg,
         evid *monixptr );
+    friend int epicsShareAPI ca_create_subscriptions (
+        chtype type, arrayElementCount count, unsigned nChannels,
+        const chid * pChans, long mask, caEventCallBackFunc * pCallBack,
+        void * const * pCallBackArgs, evid * monixptrs );
     friend int epicsShareAPI ca_flush_io ();
     friend int epicsShareAPI ca_clear_subscription ( evid pMon );
     friend int epicsShareAPI ca_sg_create ( CA_SYNC_GID * pgid );
@@ -405,6 +437,7 @@ private:
     epicsThreadId createdByThread;
     std::auto_ptr < CallbackGuard > pCallbackGuard;
     std::auto_ptr < cacContext > pServiceContext;
+    std::auto_ptr < monitorDispatch > pMonitorDispatch;
     caExceptionHandler * ca_exception_func;
     void * ca_exception_arg;
     caPrintfFunc * pVPrintfFunc;
@@ -430,9 +463,11 @@ private:
 
     friend void cacOnceFunc ( void * );
     friend void cacExitHandler ( void *);
+    friend class monitorDispatchThread;
     static cacService * pDefaultService;
     static epicsMutex * pDefaultServiceInstallMutex;
     static const unsigned flushBlockThreshold;
+    static const unsigned bulkBatchSize;
 };
 
 int fetchClientContext ( ca_client_context * * ppcac );
@@ -570,6 +605,11 @@ inline bool ca_client_context::preemptiveCallbakIsEnabled () const
     return this->pCallbackGuard.get () == 0;
 }
 
+inline monitorDispatch * ca_client_context::monitorDispatcher () const
+{
+    return this->pMonitorDispatch.get ();
+}
+
 inline bool ca_client_context::ioComplete () const
 {
     return ( this->pndRecvCnt == 0u );
@@ -32,6 +32,7 @@
 #define epicsAssertAuthor "Jeff Hill johill@lanl.gov"
 
 #include "errlog.h"
+#include "epicsAtomic.h"
 
 #define epicsExportSharedSymbols
 #include "iocinf.h"
@@ -51,7 +52,8 @@ oldChannelNotify::oldChannelNotify (
     io ( cacIn.createChannel ( guard, pName, *this, priority ) ),
     pConnCallBack ( pConnCallBackIn ),
     pPrivate ( pPrivateIn ), pAccessRightsFunc ( cacNoopAccesRightsHandler ),
-    ioSeqNo ( 0 ), currentlyConnected ( false ), prevConnected ( false )
+    ioSeqNo ( 0 ), blocked ( 0 ), currentlyConnected ( false ),
+    prevConnected ( false )
 {
     guard.assertIdenticalMutex ( cacIn.mutexRef () );
     this->ioSeqNo = cacIn.sequenceNumberOfOutstandingIO ( guard );
@@ -78,6 +80,16 @@ void  oldChannelNotify::destructor (
     this->~oldChannelNotify ();
 }
 
+void oldChannelNotify::dispatchBlock ()
+{
+    epicsAtomicSetIntT ( & this->blocked, 1 );
+}
+
+bool oldChannelNotify::dispatchBlocked () const
+{
+    return epicsAtomicGetIntT ( & this->blocked ) != 0;
+}
+
 void oldChannelNotify::connectNotify (
     epicsGuard < epicsMutex > & guard )
 {
@@ -610,6 +622,126 @@ int epicsShareAPI ca_create_subscription (
     }
 }
 
+int epicsShareAPI ca_create_subscriptions (
+        chtype type, arrayElementCount count, unsigned nChannels,
+        const chid * pChans, long mask, caEventCallBackFunc * pCallBack,
+        void * const * pCallBackArgs, evid * monixptrs )
+{
+    if ( type < 0 ) {
+        return ECA_BADTYPE;
+    }
+    unsigned tmpType = static_cast < unsigned > ( type );
+
+    if ( INVALID_DB_REQ (type) ) {
+        return ECA_BADTYPE;
+    }
+
+    if ( pCallBack == NULL ) {
+        return ECA_BADFUNCPTR;
+    }
+
+    static const long maskMask = 0xffff;
+    if ( ( mask & maskMask ) == 0) {
+        return ECA_BADMASK;
+    }
+
+    if ( mask & ~maskMask ) {
+        return ECA_BADMASK;
+    }
+
+    // null entries, such as channels ca_create_channels couldnt
+    // create, are skipped as in ca_clear_channels
+    ca_client_context * pcac = 0;
+    for ( unsigned i = 0u; i < nChannels; i++ ) {
+        if ( pChans[i] ) {
+            if ( ! pcac ) {
+                pcac = & pChans[i]->getClientCtx ();
+            }
+            else if ( pcac != & pChans[i]->getClientCtx () ) {
+                return ECA_BADCHID;
+            }
+        }
+    }
+    if ( monixptrs ) {
+        for ( unsigned i = 0u; i < nChannels; i++ ) {
+            if ( ! pChans[i] ) {
+                monixptrs[i] = 0;
+            }
+        }
+    }
+    if ( ! pcac ) {
+        return ECA_NORMAL;
+    }
+    ca_client_context & cac = *pcac;
+
+    int caStatus = ECA_NORMAL;
+    unsigned i = 0u;
+    while ( i < nChannels ) {
+        unsigned batchEnd = i + ca_client_context::bulkBatchSize;
+        if ( batchEnd > nChannels || batchEnd < i ) {
+            batchEnd = nChannels;
+        }
+        epicsGuard < epicsMutex > guard ( cac.mutexRef () );
+        for ( ; i < batchEnd; i++ ) {
+            oldChannelNotify * pChan = pChans[i];
+            if ( ! pChan ) {
+                continue;
+            }
+            evid * pEventId = monixptrs ? & monixptrs[i] : 0;
+            int status = ECA_NORMAL;
+            try {
+                try {
+                    pChan->eliminateExcessiveSendBacklog ( guard );
+                }
+                catch ( cacChannel::notConnected & ) {
+                    // intentionally ignored (its ok to subscribe when not connected)
+                }
+                new ( cac.subscriptionFreeList )
+                    oldSubscription  (
+                        guard, *pChan, pChan->io, tmpType, count, mask,
+                        pCallBack, pCallBackArgs ? pCallBackArgs[i] : 0,
+                        pEventId );
+                // dont touch object created after above new because
+                // the first callback might have canceled, and therefore
+                // destroyed, it
+            }
+            catch ( cacChannel::badType & ) {
+                status = ECA_BADTYPE;
+            }
+            catch ( cacChannel::outOfBounds & ) {
+                status = ECA_BADCOUNT;
+            }
+            catch ( cacChannel::badEventSelection & ) {
+                status = ECA_BADMASK;
+            }
+            catch ( cacChannel::noReadAccess & ) {
+                status = ECA_NORDACCESS;
+            }
+            catch ( cacChannel::unsupportedByService & ) {
+                status = ECA_UNAVAILINSERV;
+            }
+            catch ( std::bad_alloc & ) {
+                status = ECA_ALLOCMEM;
+            }
+            catch ( cacChannel::msgBodyCacheTooSmall & ) {
+                status = ECA_TOLARGE;
+            }
+            catch ( ... ) {
+                status = ECA_INTERNAL;
+            }
+            if ( status != ECA_NORMAL ) {
+                if ( pEventId ) {
+                    *pEventId = 0;
+                }
+                if ( caStatus == ECA_NORMAL ) {
+                    caStatus = status;
+                }
+            }
+        }
+    }
+    return caStatus;
+}
+
 void oldChannelNotify::write (
     epicsGuard < epicsMutex > & guard, unsigned type, arrayElementCount count,
     const void * pValue, cacWriteNotify & notify, cacChannel::ioid * pId )
@@ -26,6 +26,7 @@
 #define epicsExportSharedSymbols
 #include "iocinf.h"
 #include "oldAccess.h"
+#include "monitorDispatch.h"
 
 oldSubscription::oldSubscription  (
     epicsGuard < epicsMutex > & guard, 
@@ -34,7 +35,7 @@ oldSubscription::oldSubscription  (
     caEventCallBackFunc * pFuncIn, void * pPrivateIn,
     evid * pEventId ) :
     chan ( chanIn ), id ( UINT_MAX ), pFunc ( pFuncIn ), 
-        pPrivate ( pPrivateIn )
+        pPrivate ( pPrivateIn ), dispatchRefs ( 1u ), cancelled ( 0 )
 {
     // The users event id *must* be set prior to potentially
     // calling his callback from within subscribe.
@@ -55,6 +56,12 @@ void oldSubscription::current (
     epicsGuard < epicsMutex > & guard,
     unsigned type, arrayElementCount count, const void * pData )
 {
+    monitorDispatch * pDispatch = this->chan.getClientCtx().monitorDispatcher ();
+    if ( pDispatch ) {
+        pDispatch->post ( guard, *this, & this->chan,
+            ECA_NORMAL, type, count, pData );
+        return;
+    }
     struct event_handler_args args;
     args.usr = this->pPrivate;
     args.chid = & this->chan;
@@ -79,6 +86,13 @@ void oldSubscription::exception (
         cac.destroySubscription ( guard, *this );
     }
     else if ( status != ECA_DISCONN ) {
+        monitorDispatch * pDispatch =
+            this->chan.getClientCtx().monitorDispatcher ();
+        if ( pDispatch ) {
+            pDispatch->post ( guard, *this, & this->chan,
+                status, type, count, 0 );
+            return;
+        }
         struct event_handler_args args;
         args.usr = this->pPrivate;
         args.chid = & this->chan;
@@ -94,6 +108,44 @@ void oldSubscription::exception (
     }
 }
 
+void oldSubscription::dispatchReference (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->chan.getClientCtx().mutexRef () );
+    epicsAtomicIncrSizeT ( & this->dispatchRefs );
+}
+
+// returns true when the last reference is released
+bool oldSubscription::dispatchRelease ()
+{
+    return epicsAtomicDecrSizeT ( & this->dispatchRefs ) == 0u;
+}
+
+// returns true if there are no updates waiting for delivery
+bool oldSubscription::dispatchCancel (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->chan.getClientCtx().mutexRef () );
+    epicsAtomicSetIntT ( & this->cancelled, 1 );
+    return this->dispatchRelease ();
+}
+
+void oldSubscription::dispatchedCallback ( monitorDispatchItem & item )
+{
+    if ( epicsAtomicGetIntT ( & this->cancelled ) ||
+            this->chan.dispatchBlocked () ) {
+        return;
+    }
+    struct event_handler_args args;
+    args.usr = this->pPrivate;
+    args.chid = & this->chan;
+    args.type = static_cast < long > ( item.type );
+    args.count = static_cast < long > ( item.count );
+    args.status = item.status;
+    args.dbr = item.hasData ? item.pData () : 0;
+    ( *this->pFunc ) ( args );
+}
+
 void oldSubscription::operator delete ( void * )
 {
     // Visual C++ .net appears to require operator delete if
@@ -199,6 +199,14 @@ found:
     return 0;
 }
 
+/* Number of threads running callbacks of one priority */
+int callbackThreadCount(int prio)
+{
+    if (prio < 0 || prio >= NUM_CALLBACK_PRIORITIES)
+        return 0;
+    return epicsAtomicGetIntT(&callbackQueue[prio].threadsRunning);
+}
+
 static void callbackTask(void *arg)
 {
     int prio = *(int*)arg;
@@ -261,6 +269,7 @@ void callbackCleanup(void)
     }
 
     epicsTimerQueueRelease(timerQueue);
+    timerQueue = NULL;
     callbackIsInit = 0;
     memset(callbackQueue, 0, sizeof(callbackQueue));
 }
@@ -394,6 +403,14 @@ void callbackCancelDelayed(CALLBACK *pcallback)
     }
 }
 
+/* The queue behind callbackRequestDelayed(), for timers that expire
+ * without going through a callback thread
+ */
+epicsTimerQueueId callbackTimerQueue(void)
+{
+    return timerQueue;
+}
+
 void callbackRequestProcessCallbackDelayed(CALLBACK *pcallback,
     int Priority, void *pRec, double seconds)
 {
@@ -23,6 +23,8 @@
 extern "C" {
 #endif
 
+struct epicsTimerQueueActiveForC;
+
 /*
  * WINDOWS also has a "CALLBACK" type def
  */
@@ -83,6 +85,8 @@ epicsShareFunc int callbackSetQueueSize(int size);
 epicsShareFunc int callbackQueueStatus(const int reset, callbackQueueStats *result);
 epicsShareFunc void callbackQueueShow(const int reset);
 epicsShareFunc int callbackParallelThreads(int count, const char *prio);
+epicsShareFunc int callbackThreadCount(int Priority);
+epicsShareFunc struct epicsTimerQueueActiveForC * callbackTimerQueue(void);
 
 #ifdef __cplusplus
 }
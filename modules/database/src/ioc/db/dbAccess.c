@@ -48,15 +48,18 @@
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbFldTypes.h"
+#include "dbLatency.h"
 #include "dbLink.h"
 #include "dbLockPvt.h"
 #include "dbNotify.h"
+#include "dbProfile.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 #include "devSup.h"
 #include "epicsEvent.h"
+#include "iocInit.h"
 #include "link.h"
 #include "recGbl.h"
 #include "recSup.h"
@@ -458,6 +461,24 @@ int dbGetFieldIndex(const struct dbAddr *paddr)
  *     5.  Run the process routine specific to the record type.
  *     6.  Check to see if record contents should be automatically printed.
  */
+/* dbProcess() with latency measurement or profiling enabled */
+static long processMeasured(dbCommon *precord)
+{
+    int latency = dbLatencyEnabled;
+    epicsUInt64 previous = 0;
+    long status;
+
+    if (latency)
+        previous = dbLatencyProcessEnter();
+    if (dbProfileEnabled)
+        status = dbProfileProcess(precord);
+    else
+        status = precord->rset->process(precord);
+    if (latency)
+        dbLatencyProcessExit(previous);
+    return status;
+}
+
 long dbProcess(dbCommon *precord)
 {
     rset *prset = precord->rset;
@@ -585,7 +606,10 @@ long dbProcess(dbCommon *precord)
         printf("%s: dbProcess of '%s'\n", context, precord->name);
 
     /* process record */
-    status = prset->process(precord);
+    if (dbLatencyEnabled | dbProfileEnabled)
+        status = processMeasured(precord);
+    else
+        status = prset->process(precord);
 
     /* Print record's fields if PRINT_MASK set in breakpoint field */
     if (lset_stack_count != 0) {
@@ -781,6 +805,33 @@ int dbLoadRecords(const char* file, const char* subs)
     return status;
 }
 
+int dbLoadImage(const char *file)
+{
+    if (!file) {
+        printf("Usage: dbLoadImage \"file\"\n");
+        return -1;
+    }
+    if (!pdbbase) {
+        printf("dbLoadImage: Load the DBD files first\n");
+        return -1;
+    }
+    return dbImageRead(pdbbase, file);
+}
+
+int dbWriteImage(const char *file)
+{
+    if (!file) {
+        printf("Usage: dbWriteImage \"file\"\n");
+        return -1;
+    }
+    /* iocInit replaces the link text with the resolved links */
+    if (getIocState() != iocVoid) {
+        printf("dbWriteImage: Must be called before iocInit\n");
+        return -1;
+    }
+    return dbImageWrite(pdbbase, file);
+}
+
 
 static long getLinkValue(DBADDR *paddr, short dbrType,
     char *pbuf, long *nRequest)
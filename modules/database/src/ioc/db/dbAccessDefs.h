@@ -268,6 +268,8 @@ epicsShareFunc int  dbLoadDatabase(
     const char *filename, const char *path, const char *substitutions);
 epicsShareFunc int dbLoadRecords(
     const char* filename, const char* substitutions);
+epicsShareFunc int dbLoadImage(const char *filename);
+epicsShareFunc int dbWriteImage(const char *filename);
 
 #ifdef __cplusplus
 }
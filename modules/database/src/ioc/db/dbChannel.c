@@ -22,6 +22,7 @@
 #include "epicsString.h"
 #include "epicsStdio.h"
 #include "errlog.h"
+#include "epicsMutex.h"
 #include "freeList.h"
 #include "gpHash.h"
 #include "yajl_parse.h"
@@ -37,6 +38,7 @@
 #include "link.h"
 #include "recSup.h"
 #include "special.h"
+#include "epicsExport.h"
 
 typedef struct parseContext {
     dbChannel *chan;
@@ -50,12 +52,22 @@ static void *dbChannelFreeList;
 static void *chFilterFreeList;
 static void *dbchStringFreeList;
 
+/* Opened channels with filters, by name */
+static struct gphPvt *sharedTable;
+static epicsMutexId sharedLock;
+
+/* Set to one to share the filter instances of channels with the same name */
+int dbChannelShareFilters = 0;
+epicsExportAddress(int, dbChannelShareFilters);
+
 void dbChannelExit(void)
 {
     freeListCleanup(dbChannelFreeList);
     freeListCleanup(chFilterFreeList);
     freeListCleanup(dbchStringFreeList);
     dbChannelFreeList = chFilterFreeList = dbchStringFreeList = NULL;
+    gphFreeMem(sharedTable);
+    sharedTable = NULL;
 }
 
 void dbChannelInit (void)
@@ -66,6 +78,28 @@ void dbChannelInit (void)
     freeListInitPvt(&dbChannelFreeList,  sizeof(dbChannel), 128);
     freeListInitPvt(&chFilterFreeList,  sizeof(chFilter), 64);
     freeListInitPvt(&dbchStringFreeList, sizeof(epicsOldString), 128);
+    gphInitPvt(&sharedTable, 256);
+    if (!sharedLock)
+        sharedLock = epicsMutexMustCreate();
+}
+
+/* Return a shared channel with this name, or NULL */
+static dbChannel * findShared(const char *name)
+{
+    GPHENTRY *pgph;
+    dbChannel *chan = NULL;
+
+    if (!sharedTable)
+        return NULL;
+
+    epicsMutexMustLock(sharedLock);
+    pgph = gphFind(sharedTable, name, &sharedTable);
+    if (pgph) {
+        chan = (dbChannel *) pgph->userPvt;
+        chan->refs++;
+    }
+    epicsMutexUnlock(sharedLock);
+    return chan;
 }
 
 static void chf_value(parseContext *parser, parse_result *presult)
@@ -478,6 +512,12 @@ dbChannel * dbChannelCreate(const char *name)
     if (!name || !*name || !pdbbase)
         return NULL;
 
+    if (dbChannelShareFilters) {
+        chan = findShared(name);
+        if (chan)
+            return chan;
+    }
+
     status = pvNameLookup(&dbEntry, &pname);
     if (status)
         goto finish;
@@ -491,6 +531,7 @@ dbChannel * dbChannelCreate(const char *name)
 
     strcpy(cname, name);
     chan->name = cname;
+    chan->refs = 1;
     ellInit(&chan->filters);
     ellInit(&chan->pre_chain);
     ellInit(&chan->post_chain);
@@ -553,11 +594,22 @@ finish:
 }
 
 db_field_log* dbChannelRunPreChain(dbChannel *chan, db_field_log *pLogIn) {
+    return dbChannelRunPreChainAfter(chan, NULL, pLogIn);
+}
+
+db_field_log* dbChannelRunPreChainAfter(dbChannel *chan, void *from,
+    db_field_log *pLogIn)
+{
     chFilter *filter;
-    ELLNODE *node;
+    ELLNODE *node = ellFirst(&chan->pre_chain);
     db_field_log *pLog = pLogIn;
 
-    for (node = ellFirst(&chan->pre_chain); node && pLog; node = ellNext(node)) {
+    if (from) {
+        while (node && CONTAINER(node, chFilter, pre_node)->pre_arg != from)
+            node = ellNext(node);
+        if (node) node = ellNext(node);
+    }
+    for (; node && pLog; node = ellNext(node)) {
         filter = CONTAINER(node, chFilter, pre_node);
         pLog = filter->pre_func(filter->pre_arg, chan, pLog);
     }
@@ -586,6 +638,10 @@ long dbChannelOpen(dbChannel *chan)
     db_field_log probe;
     db_field_log p;
 
+    /* A shared channel was opened by its first user */
+    if (chan->shared)
+        return 0;
+
     for (node = ellFirst(&chan->filters); node; node = ellNext(node)) {
         filter = CONTAINER(node, chFilter, list_node);
          /* Call channel_open */
@@ -641,6 +697,27 @@ long dbChannelOpen(dbChannel *chan)
     chan->final_field_size   = probe.field_size;
     chan->final_type         = probe.field_type;
 
+    /*
+     * Later dbChannelCreate() calls with the same name get this channel.
+     * Only channels with filters are worth sharing, and they're added
+     * once opened so nobody else sees a channel that's half set up.
+     */
+    if (dbChannelShareFilters && sharedTable && ellCount(&chan->filters)) {
+        GPHENTRY *pgph;
+
+        epicsMutexMustLock(sharedLock);
+        if (!gphFind(sharedTable, chan->name, &sharedTable)) {
+            pgph = gphAdd(sharedTable, chan->name, &sharedTable);
+            if (pgph) {
+                pgph->userPvt = chan;
+                chan->shared = 1;
+                if (ellCount(&chan->post_chain))
+                    chan->post_lock = epicsMutexMustCreate();
+            }
+        }
+        epicsMutexUnlock(sharedLock);
+    }
+
     return 0;
 }
 
@@ -700,6 +777,9 @@ void dbChannelShow(dbChannel *chan, int level, const unsigned short indent)
                     indent + 4, "", count, count == 1 ? "" : "s", pre, post);
         else
             printf(", no filters\n");
+        if (chan->shared)
+            printf("%*sshared filter chain, %d user%s\n", indent + 4, "",
+                   chan->refs, chan->refs == 1 ? "" : "s");
         if (level > 1)
             dbChannelFilterShow(chan, level - 2, indent + 8);
         if (count) {
@@ -724,6 +804,21 @@ void dbChannelDelete(dbChannel *chan)
 {
     chFilter *filter;
 
+    if (chan->shared) {
+        int refs;
+
+        epicsMutexMustLock(sharedLock);
+        refs = --chan->refs;
+        if (!refs)
+            gphDelete(sharedTable, chan->name, &sharedTable);
+        epicsMutexUnlock(sharedLock);
+        if (refs)
+            return;
+        db_delete_field_log(chan->last_log);
+        if (chan->post_lock)
+            epicsMutexDestroy(chan->post_lock);
+    }
+
     /* Close filters in reverse order */
     while ((filter = (chFilter *) ellPop(&chan->filters))) {
         filter->plug->fif->channel_close(filter);
@@ -19,6 +19,7 @@
 #include "dbDefs.h"
 #include "dbAddr.h"
 #include "ellLib.h"
+#include "epicsMutex.h"
 #include "epicsTypes.h"
 #include "errMdef.h"
 #include "shareLib.h"
@@ -59,6 +60,18 @@ typedef struct dbChannel {
     ELLLIST filters;          /* list of filters as created from JSON */
     ELLLIST pre_chain;        /* list of filters to be called pre-event-queue */
     ELLLIST post_chain;       /* list of filters to be called post-event-queue */
+    /* Opened channels with filters may be shared by dbChannelCreate()
+     * calls with the same name, see dbChannelShareFilters. Their pre-chain
+     * runs once per post and all subscriptions get references to its
+     * output. The post-chain runs once per post too, in the event task
+     * that reads the first of them, holding post_lock.
+     */
+    int refs;                 /* dbChannelCreate() calls using this */
+    char shared;              /* in the shared channel table */
+    char post_done;           /* pre-chain has run for the post in progress */
+    db_field_log *post_log;   /* what to queue for the post in progress */
+    db_field_log *last_log;   /* last pre-chain output, for new subscriptions */
+    epicsMutexId post_lock;   /* if shared and there is a post-chain */
 } dbChannel;
 
 /* Prototype for the channel event function that is called in filter stacks
@@ -154,6 +167,9 @@ epicsShareFunc long dbChannelTest(const char *name);
 epicsShareFunc dbChannel * dbChannelCreate(const char *name);
 epicsShareFunc long dbChannelOpen(dbChannel *chan);
 
+/* Non-zero to share opened channels with filters, see dbChannel */
+epicsShareExtern int dbChannelShareFilters;
+
 /*Following is also defined in db_convert.h*/
 epicsShareExtern unsigned short dbDBRnewToDBRold[];
 
@@ -222,6 +238,9 @@ epicsShareFunc void dbChannelDelete(dbChannel *chan);
 
 epicsShareFunc void dbRegisterFilter(const char *key, const chFilterIf *fif, void *puser);
 epicsShareFunc db_field_log* dbChannelRunPreChain(dbChannel *chan, db_field_log *pLogIn);
+/* Runs the pre-event-queue filters that follow the one with pre_arg from */
+epicsShareFunc db_field_log* dbChannelRunPreChainAfter(dbChannel *chan,
+        void *from, db_field_log *pLogIn);
 epicsShareFunc db_field_log* dbChannelRunPostChain(dbChannel *chan, db_field_log *pLogIn);
 epicsShareFunc const chFilterPlugin * dbFindFilter(const char *key, size_t len);
 epicsShareFunc void dbChannelMakeArrayCopy(void *pvt, db_field_log *pfl, dbChannel *chan);
@@ -15,6 +15,9 @@ typedef struct dbCommonPvt {
     /* Thread which is currently processing this record */
     struct epicsThreadOSD* procThread;
 
+    /* Statistics kept by dbProfile, NULL if never selected */
+    struct profileRecord *profile;
+
     struct dbCommon common;
 } dbCommonPvt;
 
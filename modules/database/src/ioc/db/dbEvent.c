@@ -27,9 +27,11 @@
 #include "cantProceed.h"
 #include "dbDefs.h"
 #include "epicsAssert.h"
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 #include "errlog.h"
 #include "freeList.h"
 #include "taskwd.h"
@@ -45,6 +47,7 @@
 #include "dbEvent.h"
 #include "db_field_log.h"
 #include "dbFldTypes.h"
+#include "dbLatency.h"
 #include "dbLock.h"
 #include "link.h"
 #include "special.h"
@@ -63,6 +66,7 @@ struct event_que {
     epicsMutexId            writelock;
     db_field_log            *valque[EVENTQUESIZE];
     struct evSubscrip       *evque[EVENTQUESIZE];
+    epicsUInt64             tque[EVENTQUESIZE]; /* when queued, for dbLatency */
     struct event_que        *nextque;       /* in case que quota exceeded */
     struct event_user       *evUser;        /* event user parent struct */
     unsigned short          putix;
@@ -112,6 +116,28 @@ static void *dbevEventUserFreeList;
 static void *dbevEventQueueFreeList;
 static void *dbevEventSubscriptionFreeList;
 static void *dbevFieldLogFreeList;
+static void *dbevSharedRefFreeList;
+static void *dbevSharedPostFreeList;
+
+/*
+ * Data of a dbfl_type_ref field log from a shared channel, referenced by
+ * the field logs queued for each of its subscriptions
+ */
+struct shared_ref {
+    int             refs;
+    db_field_log    orig;           /* with the filter's dtor */
+};
+
+/*
+ * One post to a shared channel with post-event-queue filters. The field
+ * logs queued for its subscriptions refer to it, the first one read runs
+ * the post-chain on the pre-chain output and all get copies of the result.
+ */
+struct shared_post {
+    int             refs;
+    char            done;           /* the post-chain has run */
+    db_field_log    *pfl;           /* its input, then its output */
+};
 
 static char *EVENT_PEND_NAME = "eventTask";
 
@@ -280,6 +306,14 @@ dbEventCtx db_init_events (void)
         freeListInitPvt(&dbevFieldLogFreeList,
             sizeof(struct db_field_log),2048);
     }
+    if (!dbevSharedRefFreeList) {
+        freeListInitPvt(&dbevSharedRefFreeList,
+            sizeof(struct shared_ref),256);
+    }
+    if (!dbevSharedPostFreeList) {
+        freeListInitPvt(&dbevSharedPostFreeList,
+            sizeof(struct shared_post),256);
+    }
 
     evUser = (struct event_user *)
         freeListCalloc(dbevEventUserFreeList);
@@ -341,6 +375,11 @@ epicsShareFunc void db_cleanup_events(void)
 
     if(dbevFieldLogFreeList) freeListCleanup(dbevFieldLogFreeList);
     dbevFieldLogFreeList = NULL;
+
+    if(dbevSharedRefFreeList) freeListCleanup(dbevSharedRefFreeList);
+    dbevSharedRefFreeList = NULL;
+    if(dbevSharedPostFreeList) freeListCleanup(dbevSharedPostFreeList);
+    dbevSharedPostFreeList = NULL;
 }
 
     /* intentionally leak stopSync to avoid possible shutdown races */
@@ -730,6 +769,218 @@ db_field_log* db_create_read_log (struct dbChannel *chan)
     return pLog;
 }
 
+/*
+ *  SHARED_REF_RELEASE()
+ *
+ *  dtor of the field logs sharing one shared_ref
+ */
+static void shared_ref_release (db_field_log *pfl)
+{
+    struct shared_ref *pref = (struct shared_ref *) pfl->u.r.pvt;
+
+    if (epicsAtomicDecrIntT(&pref->refs) == 0) {
+        if (pref->orig.u.r.dtor) pref->orig.u.r.dtor(&pref->orig);
+        freeListFree(dbevSharedRefFreeList, pref);
+    }
+}
+
+/*
+ *  SHARED_POST_RELEASE()
+ *
+ *  dtor of the field logs queued for one shared_post
+ */
+static void shared_post_release (db_field_log *pfl)
+{
+    struct shared_post *ppost = (struct shared_post *) pfl->u.r.pvt;
+
+    if (epicsAtomicDecrIntT(&ppost->refs) == 0) {
+        db_delete_field_log(ppost->pfl);
+        freeListFree(dbevSharedPostFreeList, ppost);
+    }
+}
+
+/*
+ *  DB_CLONE_FIELD_LOG()
+ *
+ *  Copy a field log from a shared channel. The first copy of a
+ *  reference type field log moves its data into a shared_ref.
+ */
+static db_field_log* db_clone_field_log (db_field_log *pfl)
+{
+    db_field_log *pLog;
+
+    if (pfl->type == dbfl_type_ref && pfl->u.r.dtor != shared_ref_release &&
+        pfl->u.r.dtor != shared_post_release) {
+        struct shared_ref *pref = (struct shared_ref *)
+            freeListMalloc(dbevSharedRefFreeList);
+
+        if (!pref)
+            return NULL;
+        pref->refs = 1;
+        pref->orig = *pfl;
+        pfl->u.r.dtor = shared_ref_release;
+        pfl->u.r.pvt = pref;
+    }
+
+    pLog = (db_field_log *) freeListMalloc(dbevFieldLogFreeList);
+    if (pLog) {
+        *pLog = *pfl;
+        if (pLog->type != dbfl_type_ref)
+            ;
+        else if (pLog->u.r.dtor == shared_post_release)
+            epicsAtomicIncrIntT(&((struct shared_post *) pLog->u.r.pvt)->refs);
+        else
+            epicsAtomicIncrIntT(&((struct shared_ref *) pLog->u.r.pvt)->refs);
+    }
+    return pLog;
+}
+
+/*
+ *  DB_SHARED_POST_CREATE()
+ *
+ *  The field log to queue for the pre-chain output pfl of a shared
+ *  channel with a post-chain. The post-chain will run on a copy of pfl.
+ */
+static db_field_log* db_shared_post_create (db_field_log *pfl)
+{
+    struct shared_post *ppost = (struct shared_post *)
+        freeListMalloc(dbevSharedPostFreeList);
+    db_field_log *pLog = (db_field_log *) freeListCalloc(dbevFieldLogFreeList);
+
+    if (!ppost || !pLog || !(ppost->pfl = db_clone_field_log(pfl))) {
+        if (ppost) freeListFree(dbevSharedPostFreeList, ppost);
+        if (pLog) freeListFree(dbevFieldLogFreeList, pLog);
+        return NULL;
+    }
+    ppost->refs = 1;
+    ppost->done = FALSE;
+    pLog->ctx = dbfl_context_event;
+    pLog->type = dbfl_type_ref;
+    pLog->mask = pfl->mask;
+    pLog->u.r.dtor = shared_post_release;
+    pLog->u.r.pvt = ppost;
+    return pLog;
+}
+
+/*
+ *  DB_SHARED_POST_OUTPUT()
+ *
+ *  Replace a field log queued for a shared_post with a copy of the
+ *  post-chain output, running the chain if this is the first one read.
+ *
+ *  NOTE: Called by the event task, without any locks
+ */
+static db_field_log* db_shared_post_output (struct dbChannel *chan,
+    db_field_log *pfl)
+{
+    struct shared_post *ppost = (struct shared_post *) pfl->u.r.pvt;
+    db_field_log *pLog = NULL;
+
+    epicsMutexMustLock(chan->post_lock);
+    if (!ppost->done) {
+        ppost->pfl = dbChannelRunPostChain(chan, ppost->pfl);
+        ppost->done = TRUE;
+    }
+    if (ppost->pfl)
+        pLog = db_clone_field_log(ppost->pfl);
+    epicsMutexUnlock(chan->post_lock);
+    db_delete_field_log(pfl);
+    return pLog;
+}
+
+/*
+ *  DB_SHARED_EVENT_LOG()
+ *
+ *  For a shared channel the pre-event-queue filter chain runs for the
+ *  first subscription of a post, every subscription then gets a copy of
+ *  its output, or of the shared_post made from it when there are
+ *  post-event-queue filters. db_shared_event_done() must be called when
+ *  the post is complete.
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ */
+static void db_shared_event_run (struct dbChannel *chan, void *from,
+    db_field_log *pLog)
+{
+    pLog = dbChannelRunPreChainAfter(chan, from, pLog);
+    if (pLog) {
+        db_delete_field_log(chan->last_log);
+        chan->last_log = pLog;
+        if (chan->post_lock)
+            pLog = db_shared_post_create(pLog);
+    }
+    chan->post_log = pLog;
+    chan->post_done = TRUE;
+}
+
+static db_field_log* db_shared_event_log (struct evSubscrip *pevent,
+    unsigned int caEventMask)
+{
+    struct dbChannel *chan = pevent->chan;
+
+    if (!chan->post_done) {
+        db_field_log *pLog = db_create_event_log(pevent);
+
+        if (pLog) pLog->mask = caEventMask;
+        db_shared_event_run(chan, NULL, pLog);
+    }
+    return chan->post_log ? db_clone_field_log(chan->post_log) : NULL;
+}
+
+static void db_shared_event_done (struct dbChannel *chan)
+{
+    if (chan->post_log != chan->last_log)
+        db_delete_field_log(chan->post_log);
+    chan->post_log = NULL;
+    chan->post_done = FALSE;
+}
+
+/*
+ *  DB_SHARED_EVENT_OTHERS()
+ *
+ *  The number of other subscriptions to the shared channel of pevent,
+ *  and in *pselect the events they select. The last pre-chain output is
+ *  only up to date for a new subscription if the others selected all the
+ *  events it does, the chain only runs for posts that one of them gets.
+ *
+ *  NOTE: This assumes that the record's monitor lock is applied
+ */
+static int db_shared_event_others (struct evSubscrip *pevent,
+    unsigned int *pselect)
+{
+    struct dbChannel *chan = pevent->chan;
+    struct dbCommon * const prec = dbChannelRecord(chan);
+    struct evSubscrip *pother;
+    int others = 0;
+
+    *pselect = 0;
+    for (pother = (struct evSubscrip *) prec->mlis.node.next;
+        pother; pother = (struct evSubscrip *) pother->node.next) {
+        if (pother != pevent && pother->chan == chan) {
+            *pselect |= pother->select;
+            others++;
+        }
+    }
+    return others;
+}
+
+/*
+ *  DB_FILTERED_EVENT_LOG()
+ *
+ *  A new field log for a subscription of a channel without sharing,
+ *  passed through its pre-event-queue filters.
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ */
+static db_field_log* db_filtered_event_log (struct evSubscrip *pevent,
+    unsigned int caEventMask)
+{
+    db_field_log *pLog = db_create_event_log(pevent);
+
+    if (pLog) pLog->mask = caEventMask;
+    return dbChannelRunPreChain(pevent->chan, pLog);
+}
+
 /*
  *  DB_QUEUE_EVENT_LOG()
  *
@@ -796,6 +1047,8 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
         assert ( ev_que->evque[ev_que->putix] == EVENTQEMPTY );
         ev_que->evque[ev_que->putix] = pevent;
         ev_que->valque[ev_que->putix] = pLog;
+        ev_que->tque[ev_que->putix] =
+            dbLatencyEnabled ? epicsMonotonicGet() : 0;
         pevent->pLastLog = &ev_que->valque[ev_que->putix];
         if (pevent->npend>0u) {
             ev_que->nDuplicates++;
@@ -844,9 +1097,17 @@ unsigned int    caEventMask
 {
     struct dbCommon   * const prec = (struct dbCommon *) pRecord;
     struct evSubscrip *pevent;
+    int shared = FALSE;
 
     if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
 
+    if (dbLatencyEnabled) {
+        epicsUInt64 start = dbLatencyProcessPosted();
+
+        if (start)
+            dbLatencyRecord(dbLatencyProcess, start);
+    }
+
     LOCKREC (prec);
 
     for (pevent = (struct evSubscrip *) prec->mlis.node.next;
@@ -858,17 +1119,91 @@ unsigned int    caEventMask
          */
         if ( (dbChannelField(pevent->chan) == (void *)pField || pField==NULL) &&
             (caEventMask & pevent->select)) {
-            db_field_log *pLog = db_create_event_log(pevent);
-            pLog = dbChannelRunPreChain(pevent->chan, pLog);
+            db_field_log *pLog;
+
+            if (pevent->chan->shared) {
+                pLog = db_shared_event_log(pevent, caEventMask);
+                shared = TRUE;
+            }
+            else {
+                pLog = db_filtered_event_log(pevent, caEventMask);
+            }
             if (pLog) db_queue_event_log(pevent, pLog);
         }
     }
 
+    if (shared) {
+        for (pevent = (struct evSubscrip *) prec->mlis.node.next;
+            pevent; pevent = (struct evSubscrip *) pevent->node.next) {
+            if (pevent->chan->post_done)
+                db_shared_event_done(pevent->chan);
+        }
+    }
+
     UNLOCKREC (prec);
     return DB_EVENT_OK;
 
 }
 
+/*
+ *  DB_POST_CHANNEL_LOG()
+ *
+ *  Post a field log that a filter held back to the subscriptions of its
+ *  channel. Only the pre-event-queue filters that follow the one with
+ *  pre_arg from are run, the earlier ones have seen the update already.
+ *  The field log is consumed.
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ *
+ */
+int db_post_channel_log(
+struct dbChannel    *chan,
+void                *from,
+db_field_log        *pfl,
+unsigned int        caEventMask
+)
+{
+    struct dbCommon   * const prec = dbChannelRecord(chan);
+    struct evSubscrip *pevent;
+
+    if (!pfl) return DB_EVENT_OK;
+    if (prec->mlis.count == 0) {                    /* no monitors set */
+        db_delete_field_log(pfl);
+        return DB_EVENT_OK;
+    }
+
+    LOCKREC (prec);
+
+    if (chan->shared) {
+        db_shared_event_run(chan, from, pfl);
+        pfl = NULL;
+    }
+    for (pevent = (struct evSubscrip *) prec->mlis.node.next;
+        pevent; pevent = (struct evSubscrip *) pevent->node.next){
+
+        if (pevent->chan == chan && (caEventMask & pevent->select)) {
+            db_field_log *pLog;
+
+            if (chan->shared) {
+                pLog = chan->post_log ?
+                    db_clone_field_log(chan->post_log) : NULL;
+            }
+            else {
+                pLog = db_clone_field_log(pfl);
+                pLog = dbChannelRunPreChainAfter(chan, from, pLog);
+            }
+            if (pLog) db_queue_event_log(pevent, pLog);
+        }
+    }
+    if (chan->post_done)
+        db_shared_event_done(chan);
+    if (pfl)
+        db_delete_field_log(pfl);
+
+    UNLOCKREC (prec);
+    return DB_EVENT_OK;
+}
+
 /*
  *  DB_POST_SINGLE_EVENT()
  */
@@ -880,8 +1215,40 @@ void db_post_single_event (dbEventSubscription event)
 
     dbScanLock (prec);
 
-    pLog = db_create_event_log(pevent);
-    pLog = dbChannelRunPreChain(pevent->chan, pLog);
+    /*
+     * A new subscription to a shared channel gets the last update
+     * the others were sent, running its filters again would change
+     * their state. If that may have missed posts for the events it
+     * selects, it gets the current value without the pre-chain.
+     */
+    if (pevent->chan->shared) {
+        struct dbChannel *chan = pevent->chan;
+        unsigned int others;
+
+        LOCKREC (prec);
+        if (!db_shared_event_others(pevent, &others)) {
+            /* The filter state is its own */
+            pLog = db_shared_event_log(pevent, pevent->select);
+            db_shared_event_done(chan);
+        }
+        else if (chan->last_log && !(pevent->select & ~others)) {
+            pLog = chan->post_lock ? db_shared_post_create(chan->last_log) :
+                db_clone_field_log(chan->last_log);
+        }
+        else if ((pLog = db_create_event_log(pevent))) {
+            pLog->mask = pevent->select;
+            if (chan->post_lock) {
+                db_field_log *pHandle = db_shared_post_create(pLog);
+
+                db_delete_field_log(pLog);
+                pLog = pHandle;
+            }
+        }
+        UNLOCKREC (prec);
+    }
+    else {
+        pLog = db_filtered_event_log(pevent, pevent->select);
+    }
     if(pLog) db_queue_event_log(pevent, pLog);
 
     dbScanUnlock (prec);
@@ -914,6 +1281,7 @@ static int event_read ( struct event_que *ev_que )
 
     while ( ev_que->evque[ev_que->getix] != EVENTQEMPTY ) {
         struct evSubscrip *pevent = ev_que->evque[ev_que->getix];
+        epicsUInt64 queued = ev_que->tque[ev_que->getix];
 
         pfl = ev_que->valque[ev_que->getix];
         if ( pevent == &canceledEvent ) {
@@ -961,11 +1329,18 @@ static int event_read ( struct event_que *ev_que )
              */
             pevent->callBackInProgress = TRUE;
             UNLOCKEVQUE (ev_que);
-            /* Run post-event-queue filter chain */
-            if (ellCount(&pevent->chan->post_chain)) {
+            /* Run post-event-queue filter chain, once per post for
+             * the subscriptions of a shared channel */
+            if (pfl->type == dbfl_type_ref &&
+                pfl->u.r.dtor == shared_post_release) {
+                pfl = db_shared_post_output(pevent->chan, pfl);
+            }
+            else if (ellCount(&pevent->chan->post_chain)) {
                 pfl = dbChannelRunPostChain(pevent->chan, pfl);
             }
             if (pfl) {
+                if (queued && dbLatencyEnabled)
+                    dbLatencyRecord(dbLatencyQueue, queued);
                 /* Issue user callback */
                 ( *user_sub ) ( pevent->user_arg, pevent->chan,
                                 ev_que->evque[ev_que->getix] != EVENTQEMPTY, pfl );
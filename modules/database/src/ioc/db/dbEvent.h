@@ -46,6 +46,9 @@ epicsShareFunc int dbel (
     const char *name, unsigned level);
 epicsShareFunc int db_post_events (
     void *pRecord, void *pField, unsigned caEventMask );
+epicsShareFunc int db_post_channel_log (
+    struct dbChannel *chan, void *from, struct db_field_log *pfl,
+    unsigned caEventMask );
 
 typedef void * dbEventCtx;
 
@@ -17,6 +17,8 @@
 #include "dbEvent.h"
 #include "dbIocRegister.h"
 #include "dbJLink.h"
+#include "dbLatency.h"
+#include "dbProfile.h"
 #include "dbLock.h"
 #include "dbNotify.h"
 #include "dbScan.h"
@@ -52,6 +54,22 @@ static void dbLoadRecordsCallFunc(const iocshArgBuf *args)
     dbLoadRecords(args[0].sval,args[1].sval);
 }
 
+/* dbLoadImage */
+static const iocshArg dbImageArg0 = { "file name",iocshArgString};
+static const iocshArg * const dbImageArgs[1] = {&dbImageArg0};
+static const iocshFuncDef dbLoadImageFuncDef = {"dbLoadImage",1,dbImageArgs};
+static void dbLoadImageCallFunc(const iocshArgBuf *args)
+{
+    dbLoadImage(args[0].sval);
+}
+
+/* dbWriteImage */
+static const iocshFuncDef dbWriteImageFuncDef = {"dbWriteImage",1,dbImageArgs};
+static void dbWriteImageCallFunc(const iocshArgBuf *args)
+{
+    dbWriteImage(args[0].sval);
+}
+
 /* dbb */
 static const iocshArg dbbArg0 = { "record name",iocshArgString};
 static const iocshArg * const dbbArgs[1] = {&dbbArg0};
@@ -421,6 +439,80 @@ static void dbStateShowAllCallFunc (const iocshArgBuf *args)
     dbStateShowAll(args[0].ival);
 }
 
+/* dbLatencyEnable */
+static const iocshArg dbLatencyEnableArg0 = { "enable", iocshArgInt };
+static const iocshArg * const dbLatencyEnableArgs[] = { &dbLatencyEnableArg0 };
+static const iocshFuncDef dbLatencyEnableFuncDef = { "dbLatencyEnable", 1, dbLatencyEnableArgs };
+static void dbLatencyEnableCallFunc (const iocshArgBuf *args)
+{
+    dbLatencyEnable(args[0].ival);
+}
+
+/* dbLatencyReset */
+static const iocshFuncDef dbLatencyResetFuncDef = { "dbLatencyReset", 0, NULL };
+static void dbLatencyResetCallFunc (const iocshArgBuf *args)
+{
+    dbLatencyReset();
+}
+
+/* dbLatencyReport */
+static const iocshArg dbLatencyReportArg0 = { "level", iocshArgInt };
+static const iocshArg * const dbLatencyReportArgs[] = { &dbLatencyReportArg0 };
+static const iocshFuncDef dbLatencyReportFuncDef = { "dbLatencyReport", 1, dbLatencyReportArgs };
+static void dbLatencyReportCallFunc (const iocshArgBuf *args)
+{
+    dbLatencyReport(args[0].ival);
+}
+
+/* dbProfileType */
+static const iocshArg dbProfileTypeArg0 = { "record type", iocshArgString };
+static const iocshArg dbProfileTypeArg1 = { "enable", iocshArgInt };
+static const iocshArg * const dbProfileTypeArgs[] = {
+    &dbProfileTypeArg0, &dbProfileTypeArg1 };
+static const iocshFuncDef dbProfileTypeFuncDef = { "dbProfileType", 2, dbProfileTypeArgs };
+static void dbProfileTypeCallFunc (const iocshArgBuf *args)
+{
+    dbProfileType(args[0].sval, args[1].ival);
+}
+
+/* dbProfileScan */
+static const iocshArg dbProfileScanArg0 = { "scan", iocshArgString };
+static const iocshArg dbProfileScanArg1 = { "enable", iocshArgInt };
+static const iocshArg * const dbProfileScanArgs[] = {
+    &dbProfileScanArg0, &dbProfileScanArg1 };
+static const iocshFuncDef dbProfileScanFuncDef = { "dbProfileScan", 2, dbProfileScanArgs };
+static void dbProfileScanCallFunc (const iocshArgBuf *args)
+{
+    dbProfileScan(args[0].sval, args[1].ival);
+}
+
+/* dbProfileReset */
+static const iocshFuncDef dbProfileResetFuncDef = { "dbProfileReset", 0, NULL };
+static void dbProfileResetCallFunc (const iocshArgBuf *args)
+{
+    dbProfileReset();
+}
+
+/* dbProfileReport */
+static const iocshArg dbProfileReportArg0 = { "top N", iocshArgInt };
+static const iocshArg dbProfileReportArg1 = { "sort by", iocshArgString };
+static const iocshArg * const dbProfileReportArgs[] = {
+    &dbProfileReportArg0, &dbProfileReportArg1 };
+static const iocshFuncDef dbProfileReportFuncDef = { "dbProfileReport", 2, dbProfileReportArgs };
+static void dbProfileReportCallFunc (const iocshArgBuf *args)
+{
+    dbProfileReport(args[0].ival, args[1].sval);
+}
+
+/* dbProfileJSON */
+static const iocshArg dbProfileJSONArg0 = { "file name", iocshArgString };
+static const iocshArg * const dbProfileJSONArgs[] = { &dbProfileJSONArg0 };
+static const iocshFuncDef dbProfileJSONFuncDef = { "dbProfileJSON", 1, dbProfileJSONArgs };
+static void dbProfileJSONCallFunc (const iocshArgBuf *args)
+{
+    dbProfileJSON(args[0].sval);
+}
+
 void dbIocRegister(void)
 {
     iocshRegister(&dbbFuncDef,dbbCallFunc);
@@ -438,6 +530,8 @@ void dbIocRegister(void)
 
     iocshRegister(&dbLoadDatabaseFuncDef,dbLoadDatabaseCallFunc);
     iocshRegister(&dbLoadRecordsFuncDef,dbLoadRecordsCallFunc);
+    iocshRegister(&dbLoadImageFuncDef,dbLoadImageCallFunc);
+    iocshRegister(&dbWriteImageFuncDef,dbWriteImageCallFunc);
 
     iocshRegister(&dbaFuncDef,dbaCallFunc);
     iocshRegister(&dblFuncDef,dblCallFunc);
@@ -481,4 +575,14 @@ void dbIocRegister(void)
     iocshRegister(&dbStateClearFuncDef, dbStateClearCallFunc);
     iocshRegister(&dbStateShowFuncDef, dbStateShowCallFunc);
     iocshRegister(&dbStateShowAllFuncDef, dbStateShowAllCallFunc);
+
+    iocshRegister(&dbLatencyEnableFuncDef, dbLatencyEnableCallFunc);
+    iocshRegister(&dbLatencyResetFuncDef, dbLatencyResetCallFunc);
+    iocshRegister(&dbLatencyReportFuncDef, dbLatencyReportCallFunc);
+
+    iocshRegister(&dbProfileTypeFuncDef, dbProfileTypeCallFunc);
+    iocshRegister(&dbProfileScanFuncDef, dbProfileScanCallFunc);
+    iocshRegister(&dbProfileResetFuncDef, dbProfileResetCallFunc);
+    iocshRegister(&dbProfileReportFuncDef, dbProfileReportCallFunc);
+    iocshRegister(&dbProfileJSONFuncDef, dbProfileJSONCallFunc);
 }
@@ -0,0 +1,306 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Monitor latency histograms, see dbLatency.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsExit.h"
+#include "epicsSpin.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#define epicsExportSharedSymbols
+#include "dbLatency.h"
+
+/* Values below 2*SUB_BUCKETS get their own bucket, above that each
+ * power of two is divided into SUB_BUCKETS linear buckets.
+ */
+#define SUB_BITS 3
+#define SUB_BUCKETS (1u << SUB_BITS)
+#define NBUCKETS (2*SUB_BUCKETS + (64 - SUB_BITS - 1)*SUB_BUCKETS)
+
+typedef struct latencyHist {
+    epicsSpinId lock;
+    size_t count;
+    epicsUInt64 sum;
+    epicsUInt64 max;
+    size_t bucket[NBUCKETS];
+} latencyHist;
+
+static const char * const stageNames[dbLatencyNStages] = {
+    "process", "queue", "send"
+};
+
+volatile int dbLatencyEnabled;
+
+static latencyHist hists[dbLatencyNStages];
+static epicsThreadOnceId latencyOnce = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId processStartId;
+
+/* Per thread, for the outermost record being processed */
+typedef struct processStart {
+    epicsUInt64 start;      /* 0 when not processing */
+    int posted;             /* its process stage sample was taken */
+} processStart;
+
+static void latencyInit(void *junk)
+{
+    int i;
+
+    for (i = 0; i < dbLatencyNStages; i++)
+        hists[i].lock = epicsSpinMustCreate();
+    processStartId = epicsThreadPrivateCreate();
+}
+
+static unsigned msbOf(epicsUInt64 v)
+{
+    unsigned msb = 0;
+
+    if (v >> 32) { v >>= 32; msb += 32; }
+    if (v >> 16) { v >>= 16; msb += 16; }
+    if (v >> 8)  { v >>= 8;  msb += 8; }
+    if (v >> 4)  { v >>= 4;  msb += 4; }
+    if (v >> 2)  { v >>= 2;  msb += 2; }
+    if (v >> 1)  { msb += 1; }
+    return msb;
+}
+
+static unsigned bucketOf(epicsUInt64 ns)
+{
+    unsigned msb;
+
+    if (ns < 2*SUB_BUCKETS)
+        return (unsigned) ns;
+    msb = msbOf(ns);
+    return 2*SUB_BUCKETS + (msb - SUB_BITS - 1)*SUB_BUCKETS +
+        (unsigned) ((ns >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* Largest value that falls into bucket b */
+static epicsUInt64 bucketLimit(unsigned b)
+{
+    unsigned shift;
+    epicsUInt64 lower;
+
+    if (b < 2*SUB_BUCKETS)
+        return b;
+    shift = (b - 2*SUB_BUCKETS) / SUB_BUCKETS + 1;
+    lower = (epicsUInt64) (SUB_BUCKETS + (b % SUB_BUCKETS)) << shift;
+    return lower + (((epicsUInt64) 1) << shift) - 1;
+}
+
+void dbLatencyEnable(int enable)
+{
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    dbLatencyEnabled = enable;
+}
+
+void dbLatencyReset(void)
+{
+    int i;
+
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    for (i = 0; i < dbLatencyNStages; i++) {
+        latencyHist *ph = &hists[i];
+
+        epicsSpinLock(ph->lock);
+        ph->count = 0;
+        ph->sum = 0;
+        ph->max = 0;
+        memset(ph->bucket, 0, sizeof(ph->bucket));
+        epicsSpinUnlock(ph->lock);
+    }
+}
+
+void dbLatencyAdd(dbLatencyStage stage, epicsUInt64 ns)
+{
+    latencyHist *ph;
+    unsigned b = bucketOf(ns);
+
+    if ((unsigned) stage >= dbLatencyNStages)
+        return;
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    ph = &hists[stage];
+    epicsSpinLock(ph->lock);
+    ph->count++;
+    ph->sum += ns;
+    if (ns > ph->max)
+        ph->max = ns;
+    ph->bucket[b]++;
+    epicsSpinUnlock(ph->lock);
+}
+
+void dbLatencyRecord(dbLatencyStage stage, epicsUInt64 start)
+{
+    epicsUInt64 now = epicsMonotonicGet();
+
+    dbLatencyAdd(stage, now > start ? now - start : 0);
+}
+
+static void processStartFree(void *arg)
+{
+    epicsThreadPrivateSet(processStartId, NULL);
+    free(arg);
+}
+
+epicsUInt64 dbLatencyProcessEnter(void)
+{
+    processStart *pStart;
+    epicsUInt64 previous;
+
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    pStart = epicsThreadPrivateGet(processStartId);
+    if (!pStart) {
+        pStart = calloc(1, sizeof(*pStart));
+        if (!pStart)
+            return 0;
+        if (epicsAtThreadExit(processStartFree, pStart)) {
+            free(pStart);
+            return 0;
+        }
+        epicsThreadPrivateSet(processStartId, pStart);
+    }
+    previous = pStart->start;
+    /* nested processing is charged to the outermost record */
+    if (!previous) {
+        pStart->start = epicsMonotonicGet();
+        pStart->posted = 0;
+    }
+    return previous;
+}
+
+void dbLatencyProcessExit(epicsUInt64 previous)
+{
+    processStart *pStart = epicsThreadPrivateGet(processStartId);
+
+    if (pStart && !previous)
+        pStart->start = 0;
+}
+
+epicsUInt64 dbLatencyProcessStart(void)
+{
+    processStart *pStart;
+
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    pStart = epicsThreadPrivateGet(processStartId);
+    return pStart ? pStart->start : 0;
+}
+
+epicsUInt64 dbLatencyProcessPosted(void)
+{
+    processStart *pStart;
+
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    pStart = epicsThreadPrivateGet(processStartId);
+    if (!pStart || !pStart->start || pStart->posted)
+        return 0;
+    pStart->posted = 1;
+    return pStart->start;
+}
+
+static epicsUInt64 percentile(const latencyHist *ph, double fraction)
+{
+    size_t target, seen = 0;
+    unsigned b;
+
+    if (!ph->count)
+        return 0;
+    if (fraction >= 1.0)
+        return ph->max;
+    target = (size_t) (fraction * ph->count);
+    if (target < 1)
+        target = 1;
+    for (b = 0; b < NBUCKETS; b++) {
+        seen += ph->bucket[b];
+        if (seen >= target) {
+            epicsUInt64 limit = bucketLimit(b);
+
+            return limit < ph->max ? limit : ph->max;
+        }
+    }
+    return ph->max;
+}
+
+epicsUInt64 dbLatencyPercentile(dbLatencyStage stage, double fraction)
+{
+    latencyHist *ph;
+    epicsUInt64 result;
+
+    if ((unsigned) stage >= dbLatencyNStages)
+        return 0;
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    ph = &hists[stage];
+    epicsSpinLock(ph->lock);
+    result = percentile(ph, fraction);
+    epicsSpinUnlock(ph->lock);
+    return result;
+}
+
+size_t dbLatencyCount(dbLatencyStage stage)
+{
+    latencyHist *ph;
+    size_t count;
+
+    if ((unsigned) stage >= dbLatencyNStages)
+        return 0;
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    ph = &hists[stage];
+    epicsSpinLock(ph->lock);
+    count = ph->count;
+    epicsSpinUnlock(ph->lock);
+    return count;
+}
+
+long dbLatencyReport(int level)
+{
+    static const double usec = 1e-3;
+    latencyHist *pcopy;
+    int i;
+
+    epicsThreadOnce(&latencyOnce, latencyInit, NULL);
+    pcopy = malloc(sizeof(latencyHist));
+    if (!pcopy)
+        return -1;
+
+    printf("Monitor latency measurement is %s, times in microseconds\n",
+        dbLatencyEnabled ? "enabled" : "disabled");
+    printf("%-8s %10s %10s %10s %10s %10s %10s %10s\n", "stage",
+        "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+    for (i = 0; i < dbLatencyNStages; i++) {
+        latencyHist *ph = &hists[i];
+
+        /* don't hold the spinlock while printing */
+        epicsSpinLock(ph->lock);
+        *pcopy = *ph;
+        epicsSpinUnlock(ph->lock);
+
+        printf("%-8s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            stageNames[i], (unsigned long) pcopy->count,
+            pcopy->count ? usec * pcopy->sum / pcopy->count : 0.0,
+            usec * percentile(pcopy, 0.5),
+            usec * percentile(pcopy, 0.9),
+            usec * percentile(pcopy, 0.99),
+            usec * percentile(pcopy, 0.999),
+            usec * pcopy->max);
+
+        if (level > 0 && pcopy->count) {
+            unsigned b;
+
+            for (b = 0; b < NBUCKETS; b++) {
+                if (pcopy->bucket[b])
+                    printf("    <= %12.3f %10lu\n", usec * bucketLimit(b),
+                        (unsigned long) pcopy->bucket[b]);
+            }
+        }
+    }
+    free(pcopy);
+    return 0;
+}
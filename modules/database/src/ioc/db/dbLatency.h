@@ -0,0 +1,122 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/** @file dbLatency.h
+ * @brief Monitor latency instrumentation
+ *
+ * When enabled, the time taken by each stage of delivering a monitor
+ * update from record processing to the CA server's send() call is
+ * accumulated into one histogram per stage:
+ *
+ * - process: from entry to the record's process routine until
+ *   db_post_events() is first called for a field with subscribers,
+ *   one sample per process.
+ * - queue: time an update spends in an event queue until the event
+ *   task dispatches it to the server's callback.
+ * - send: time the oldest update waits in a server's send buffer until
+ *   the buffer is written to the socket.
+ *
+ * Histogram buckets have a resolution of 1/8th of a power of two
+ * (about 12%), and cover from 1 ns to several days.
+ */
+
+#ifndef INCdbLatencyH
+#define INCdbLatencyH
+
+#include "epicsTypes.h"
+#include "shareLib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    dbLatencyProcess,
+    dbLatencyQueue,
+    dbLatencySend,
+    dbLatencyNStages
+} dbLatencyStage;
+
+/** @brief Non-zero while latency measurement is enabled.
+ *
+ * Instrumented code tests this before doing anything else.
+ */
+epicsShareExtern volatile int dbLatencyEnabled;
+
+/** @brief Enable or disable latency measurement.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc void dbLatencyEnable(int enable);
+
+/** @brief Clear all of the histograms.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc void dbLatencyReset(void);
+
+/** @brief Print a summary of each stage's histogram.
+ *
+ * Level 0 shows count, mean and percentiles, level 1 also prints the
+ * non-empty histogram buckets.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc long dbLatencyReport(int level);
+
+/** @brief Add the interval from start until now to a stage histogram.
+ *
+ * @param stage The stage being measured.
+ * @param start Start time from epicsMonotonicGet().
+ */
+epicsShareFunc void dbLatencyRecord(dbLatencyStage stage, epicsUInt64 start);
+
+/** @brief Add a measured interval in nanoseconds to a stage histogram. */
+epicsShareFunc void dbLatencyAdd(dbLatencyStage stage, epicsUInt64 ns);
+
+/** @brief Mark the start of record processing in this thread.
+ *
+ * @return The previous start time which must be passed to
+ * dbLatencyProcessExit() so that nested processing is handled.
+ */
+epicsShareFunc epicsUInt64 dbLatencyProcessEnter(void);
+epicsShareFunc void dbLatencyProcessExit(epicsUInt64 previous);
+
+/** @brief Start time of the record processing in progress in this thread.
+ *
+ * @return 0 if this thread isn't processing a record.
+ */
+epicsShareFunc epicsUInt64 dbLatencyProcessStart(void);
+
+/** @brief Start time for the process stage sample of this thread's record.
+ *
+ * Like dbLatencyProcessStart(), but only the first call during one
+ * process gets the start time, so a record that posts several fields
+ * adds one sample.
+ *
+ * @return 0 if this thread isn't processing a record or the sample for
+ * it was already taken.
+ */
+epicsShareFunc epicsUInt64 dbLatencyProcessPosted(void);
+
+/** @brief Get the value below which the given fraction of samples lie.
+ *
+ * @param stage The stage.
+ * @param fraction Between 0 and 1, e.g. 0.99 for the 99th percentile.
+ * @return Upper bound of the bucket in nanoseconds, 0 if no samples.
+ */
+epicsShareFunc epicsUInt64 dbLatencyPercentile(dbLatencyStage stage,
+    double fraction);
+
+/** @brief Number of samples recorded for a stage. */
+epicsShareFunc size_t dbLatencyCount(dbLatencyStage stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdbLatencyH */
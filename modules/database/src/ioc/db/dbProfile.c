@@ -0,0 +1,482 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Per-record processing time profiler, see dbProfile.h */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsMutex.h"
+#include "epicsStdio.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "yajl_gen.h"
+
+#define epicsExportSharedSymbols
+#include "dbAccessDefs.h"
+#include "dbBase.h"
+#include "dbCommonPvt.h"
+#include "dbLock.h"
+#include "dbProfile.h"
+#include "dbStaticLib.h"
+#include "recSup.h"
+
+typedef struct profileRecord {
+    int enabled;
+    epicsUInt64 asyncStart;     /* when process returned with PACT set */
+    dbProfileStats stats;
+} profileRecord;
+
+/* Processing in progress in a thread, nested frames form a stack */
+typedef struct profileFrame {
+    struct profileFrame *parent;
+    epicsUInt64 nested;         /* time spent processing other records */
+} profileFrame;
+
+typedef struct profileEntry {
+    dbCommon *precord;
+    epicsUInt64 key;
+    dbProfileStats stats;
+} profileEntry;
+
+typedef struct profileList {
+    size_t count;
+    size_t size;
+    profileEntry *entries;
+} profileList;
+
+typedef void (*profileFunc)(dbCommon *precord, profileRecord *pprof,
+    void *arg);
+
+volatile int dbProfileEnabled;
+
+static epicsThreadOnceId profileOnce = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId frameId;
+static epicsMutexId profileLock;
+
+static void profileInit(void *junk)
+{
+    frameId = epicsThreadPrivateCreate();
+    profileLock = epicsMutexMustCreate();
+}
+
+/* The record lock only exists between iocInit and iocShutdown */
+static void lockRecord(dbCommon *precord)
+{
+    if (precord->lset)
+        dbScanLock(precord);
+}
+
+static void unlockRecord(dbCommon *precord)
+{
+    if (precord->lset)
+        dbScanUnlock(precord);
+}
+
+static void forEachProfiled(profileFunc func, void *arg)
+{
+    DBENTRY dbentry;
+    long status;
+
+    if (!pdbbase)
+        return;
+    dbInitEntry(pdbbase, &dbentry);
+    status = dbFirstRecordType(&dbentry);
+    while (!status) {
+        status = dbFirstRecord(&dbentry);
+        while (!status) {
+            dbCommon *precord = dbentry.precnode->precord;
+
+            if (!dbIsAlias(&dbentry) && precord &&
+                dbRec2Pvt(precord)->profile)
+                func(precord, dbRec2Pvt(precord)->profile, arg);
+            status = dbNextRecord(&dbentry);
+        }
+        status = dbNextRecordType(&dbentry);
+    }
+    dbFinishEntry(&dbentry);
+}
+
+static void countEnabled(dbCommon *precord, profileRecord *pprof, void *arg)
+{
+    if (pprof->enabled)
+        ++*(long *) arg;
+}
+
+static int setProfiled(dbCommon *precord, int enable)
+{
+    dbCommonPvt *ppvt = dbRec2Pvt(precord);
+    profileRecord *pprof = ppvt->profile;
+
+    if (!pprof) {
+        if (!enable)
+            return 0;
+        pprof = calloc(1, sizeof(*pprof));
+        if (!pprof)
+            return -1;
+        ppvt->profile = pprof;
+    }
+    lockRecord(precord);
+    if (enable && !pprof->enabled)
+        pprof->asyncStart = 0;
+    pprof->enabled = enable;
+    unlockRecord(precord);
+    return 0;
+}
+
+static long selectRecords(const char *recordType, const char *scan, int enable)
+{
+    int anyType = !recordType || !*recordType ||
+        strcmp(recordType, "*") == 0;
+    DBENTRY dbentry;
+    long status, count = 0, enabled = 0;
+
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return -1;
+    }
+    epicsThreadOnce(&profileOnce, profileInit, NULL);
+    epicsMutexMustLock(profileLock);
+    dbInitEntry(pdbbase, &dbentry);
+    status = anyType ? dbFirstRecordType(&dbentry) :
+        dbFindRecordType(&dbentry, recordType);
+    if (status) {
+        if (anyType)
+            printf("No record types defined\n");
+        else
+            printf("Record type \"%s\" not found\n", recordType);
+        count = -1;
+    }
+    while (!status) {
+        status = dbFirstRecord(&dbentry);
+        while (!status) {
+            dbCommon *precord = dbentry.precnode->precord;
+
+            if (!dbIsAlias(&dbentry) && precord) {
+                const char *value = NULL;
+
+                if (scan && dbFindField(&dbentry, "SCAN") == 0)
+                    value = dbGetString(&dbentry);
+                if (!scan || (value && strcmp(value, scan) == 0)) {
+                    if (setProfiled(precord, enable)) {
+                        printf("dbProfile: Out of memory\n");
+                        count = -1;
+                        break;
+                    }
+                    count++;
+                }
+            }
+            status = dbNextRecord(&dbentry);
+        }
+        status = (count >= 0 && anyType) ? dbNextRecordType(&dbentry) : -1;
+    }
+    dbFinishEntry(&dbentry);
+
+    forEachProfiled(countEnabled, &enabled);
+    dbProfileEnabled = enabled > 0;
+    epicsMutexUnlock(profileLock);
+    return count;
+}
+
+long dbProfileType(const char *recordType, int enable)
+{
+    return selectRecords(recordType, NULL, enable);
+}
+
+long dbProfileScan(const char *scan, int enable)
+{
+    if (!scan || !*scan) {
+        printf("Usage: dbProfileScan \"scan\" enable\n");
+        return -1;
+    }
+    return selectRecords(NULL, scan, enable);
+}
+
+long dbProfileProcess(dbCommon *precord)
+{
+    profileRecord *pprof = dbRec2Pvt(precord)->profile;
+    profileFrame frame, *parent;
+    epicsUInt64 start, now, elapsed, self;
+    long status;
+
+    epicsThreadOnce(&profileOnce, profileInit, NULL);
+    parent = epicsThreadPrivateGet(frameId);
+
+    /* Time is only needed for a profiled record or its parent */
+    if (!parent && !(pprof && pprof->enabled))
+        return precord->rset->process(precord);
+
+    frame.parent = parent;
+    frame.nested = 0;
+    epicsThreadPrivateSet(frameId, &frame);
+    start = epicsMonotonicGet();
+
+    status = precord->rset->process(precord);
+
+    now = epicsMonotonicGet();
+    epicsThreadPrivateSet(frameId, parent);
+    elapsed = now - start;
+    if (parent)
+        parent->nested += elapsed;
+
+    if (pprof && pprof->enabled) {
+        dbProfileStats *pstats = &pprof->stats;
+
+        self = elapsed > frame.nested ? elapsed - frame.nested : 0;
+        pstats->count++;
+        pstats->total += elapsed;
+        pstats->self += self;
+        if (elapsed > pstats->maxTotal)
+            pstats->maxTotal = elapsed;
+        if (self > pstats->maxSelf)
+            pstats->maxSelf = self;
+        if (precord->pact)
+            pprof->asyncStart = now;
+    }
+    return status;
+}
+
+void dbProfileComplete(dbCommon *precord)
+{
+    profileRecord *pprof = dbRec2Pvt(precord)->profile;
+    dbProfileStats *pstats;
+    epicsUInt64 elapsed;
+
+    if (!pprof || !pprof->asyncStart)
+        return;
+    elapsed = epicsMonotonicGet() - pprof->asyncStart;
+    pprof->asyncStart = 0;
+    if (!pprof->enabled)
+        return;
+    pstats = &pprof->stats;
+    pstats->asyncCount++;
+    pstats->asyncTotal += elapsed;
+    if (elapsed > pstats->asyncMax)
+        pstats->asyncMax = elapsed;
+}
+
+static void resetRecord(dbCommon *precord, profileRecord *pprof, void *arg)
+{
+    lockRecord(precord);
+    memset(&pprof->stats, 0, sizeof(pprof->stats));
+    unlockRecord(precord);
+}
+
+void dbProfileReset(void)
+{
+    epicsThreadOnce(&profileOnce, profileInit, NULL);
+    epicsMutexMustLock(profileLock);
+    forEachProfiled(resetRecord, NULL);
+    epicsMutexUnlock(profileLock);
+}
+
+long dbProfileGet(const char *recordName, dbProfileStats *pstats)
+{
+    DBENTRY dbentry;
+    long status = -1;
+
+    if (!pdbbase || !recordName)
+        return -1;
+    dbInitEntry(pdbbase, &dbentry);
+    if (dbFindRecord(&dbentry, recordName) == 0 &&
+        dbentry.precnode->precord) {
+        dbCommon *precord = dbentry.precnode->precord;
+        profileRecord *pprof = dbRec2Pvt(precord)->profile;
+
+        if (pprof) {
+            lockRecord(precord);
+            *pstats = pprof->stats;
+            unlockRecord(precord);
+            status = 0;
+        }
+    }
+    dbFinishEntry(&dbentry);
+    return status;
+}
+
+static void addEntry(dbCommon *precord, profileRecord *pprof, void *arg)
+{
+    profileList *plist = arg;
+    profileEntry *pentry;
+
+    if (plist->count == plist->size) {
+        size_t size = plist->size ? 2 * plist->size : 64;
+        profileEntry *entries = realloc(plist->entries,
+            size * sizeof(profileEntry));
+
+        if (!entries)
+            return;
+        plist->entries = entries;
+        plist->size = size;
+    }
+    pentry = &plist->entries[plist->count++];
+    pentry->precord = precord;
+    pentry->key = 0;
+    lockRecord(precord);
+    pentry->stats = pprof->stats;
+    unlockRecord(precord);
+}
+
+static void collect(profileList *plist)
+{
+    memset(plist, 0, sizeof(*plist));
+    epicsThreadOnce(&profileOnce, profileInit, NULL);
+    epicsMutexMustLock(profileLock);
+    forEachProfiled(addEntry, plist);
+    epicsMutexUnlock(profileLock);
+}
+
+static int compareKey(const void *pa, const void *pb)
+{
+    const profileEntry *a = pa;
+    const profileEntry *b = pb;
+
+    if (a->key != b->key)
+        return a->key < b->key ? 1 : -1;
+    return strcmp(a->precord->name, b->precord->name);
+}
+
+static double mean(epicsUInt64 total, epicsUInt64 count)
+{
+    return count ? 1e-3 * total / count : 0.0;
+}
+
+long dbProfileReport(int topN, const char *sortBy)
+{
+    static const double usec = 1e-3;
+    profileList list;
+    size_t i, n = 0;
+    int sort = 0;
+
+    if (sortBy && *sortBy) {
+        static const char * const keys[] = {
+            "self", "total", "max", "async", "count"
+        };
+
+        for (sort = 0; sort < (int) NELEMENTS(keys); sort++)
+            if (strcmp(sortBy, keys[sort]) == 0)
+                break;
+        if (sort == (int) NELEMENTS(keys)) {
+            printf("Usage: dbProfileReport topN "
+                "\"self|total|max|async|count\"\n");
+            return -1;
+        }
+    }
+    if (topN <= 0)
+        topN = 20;
+
+    collect(&list);
+    for (i = 0; i < list.count; i++) {
+        profileEntry *pentry = &list.entries[n];
+        dbProfileStats *pstats = &pentry->stats;
+
+        /* leave out records that haven't been processed */
+        *pentry = list.entries[i];
+        if (!pstats->count && !pstats->asyncCount)
+            continue;
+        n++;
+        switch (sort) {
+        case 0: pentry->key = pstats->self; break;
+        case 1: pentry->key = pstats->total; break;
+        case 2: pentry->key = pstats->maxSelf; break;
+        case 3: pentry->key = pstats->asyncTotal; break;
+        case 4: pentry->key = pstats->count; break;
+        }
+    }
+    list.count = n;
+    qsort(list.entries, list.count, sizeof(profileEntry), compareKey);
+
+    printf("Record processing profile is %s, times in microseconds\n",
+        dbProfileEnabled ? "enabled" : "disabled");
+    printf("%-28s %10s %12s %10s %10s %10s %10s %10s %10s\n", "record",
+        "count", "self", "self/call", "max self", "total/call",
+        "max total", "async/call", "max async");
+    for (i = 0; i < list.count && i < (size_t) topN; i++) {
+        profileEntry *pentry = &list.entries[i];
+        dbProfileStats *pstats = &pentry->stats;
+
+        printf("%-28s %10lu %12.1f %10.1f %10.1f %10.1f %10.1f "
+            "%10.1f %10.1f\n", pentry->precord->name,
+            (unsigned long) pstats->count, usec * pstats->self,
+            mean(pstats->self, pstats->count), usec * pstats->maxSelf,
+            mean(pstats->total, pstats->count), usec * pstats->maxTotal,
+            mean(pstats->asyncTotal, pstats->asyncCount),
+            usec * pstats->asyncMax);
+    }
+    if (list.count > (size_t) topN)
+        printf("%lu more records\n", (unsigned long) (list.count - topN));
+    free(list.entries);
+    return 0;
+}
+
+static void genString(yajl_gen gen, const char *str)
+{
+    yajl_gen_string(gen, (const unsigned char *) str, strlen(str));
+}
+
+static void genCount(yajl_gen gen, const char *key, epicsUInt64 value)
+{
+    genString(gen, key);
+    yajl_gen_integer(gen, (long long) value);
+}
+
+long dbProfileJSON(const char *filename)
+{
+    yajl_gen gen = yajl_gen_alloc(NULL);
+    const unsigned char *buf;
+    profileList list;
+    size_t length, i;
+    FILE *fp;
+    long status = -1;
+
+    if (!gen)
+        return -1;
+    collect(&list);
+    yajl_gen_config(gen, yajl_gen_beautify, 1);
+    yajl_gen_map_open(gen);
+    genString(gen, "records");
+    yajl_gen_array_open(gen);
+    for (i = 0; i < list.count; i++) {
+        dbCommon *precord = list.entries[i].precord;
+        dbProfileStats *pstats = &list.entries[i].stats;
+
+        yajl_gen_map_open(gen);
+        genString(gen, "name");
+        genString(gen, precord->name);
+        genString(gen, "type");
+        genString(gen, precord->rdes->name);
+        genCount(gen, "count", pstats->count);
+        genCount(gen, "total_ns", pstats->total);
+        genCount(gen, "self_ns", pstats->self);
+        genCount(gen, "max_total_ns", pstats->maxTotal);
+        genCount(gen, "max_self_ns", pstats->maxSelf);
+        genCount(gen, "async_count", pstats->asyncCount);
+        genCount(gen, "async_total_ns", pstats->asyncTotal);
+        genCount(gen, "async_max_ns", pstats->asyncMax);
+        yajl_gen_map_close(gen);
+    }
+    yajl_gen_array_close(gen);
+    yajl_gen_map_close(gen);
+    free(list.entries);
+
+    if (yajl_gen_get_buf(gen, &buf, &length) == yajl_gen_status_ok) {
+        if (!filename || !*filename) {
+            if (fwrite(buf, 1, length, stdout) == length)
+                status = 0;
+        }
+        else if ((fp = fopen(filename, "w")) != NULL) {
+            if (fwrite(buf, 1, length, fp) == length)
+                status = 0;
+            if (fclose(fp))
+                status = -1;
+        }
+        else
+            printf("dbProfileJSON: Can't open \"%s\"\n", filename);
+    }
+    yajl_gen_free(gen);
+    return status;
+}
@@ -0,0 +1,119 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/** @file dbProfile.h
+ * @brief Per-record processing time profiler
+ *
+ * Records are selected for profiling by record type or by their SCAN
+ * setting. Each time dbProcess() calls a selected record's process
+ * routine the profiler adds up:
+ *
+ * - total: time spent in the process routine, including any records it
+ *   processes through its links.
+ * - self: the same time less the time spent processing other records.
+ * - async: for asynchronous records, the time from the process routine
+ *   returning with PACT set until the record completes and calls
+ *   recGblFwdLink().
+ *
+ * While no record is selected dbProcess() only tests dbProfileEnabled.
+ */
+
+#ifndef INCdbProfileH
+#define INCdbProfileH
+
+#include "epicsTypes.h"
+#include "shareLib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct dbCommon;
+
+/** @brief A record's accumulated statistics, all times in nanoseconds */
+typedef struct dbProfileStats {
+    epicsUInt64 count;      /**< @brief Calls to the process routine */
+    epicsUInt64 total;      /**< @brief Including nested processing */
+    epicsUInt64 self;       /**< @brief Excluding nested processing */
+    epicsUInt64 maxTotal;
+    epicsUInt64 maxSelf;
+    epicsUInt64 asyncCount; /**< @brief Completed asynchronous operations */
+    epicsUInt64 asyncTotal;
+    epicsUInt64 asyncMax;
+} dbProfileStats;
+
+/** @brief Non-zero while any record is selected for profiling. */
+epicsShareExtern volatile int dbProfileEnabled;
+
+/** @brief Select or deselect records for profiling by record type.
+ *
+ * @param recordType Record type name, NULL, "" or "*" for all types.
+ * @param enable Non-zero to start profiling, zero to stop.
+ * @return The number of matching records, -1 for an unknown type.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc long dbProfileType(const char *recordType, int enable);
+
+/** @brief Select or deselect records for profiling by scan list.
+ *
+ * @param scan A SCAN menu choice, e.g. "1 second" or "I/O Intr".
+ * @param enable Non-zero to start profiling, zero to stop.
+ * @return The number of matching records.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc long dbProfileScan(const char *scan, int enable);
+
+/** @brief Clear the statistics of every record.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc void dbProfileReset(void);
+
+/** @brief Copy the statistics of one record.
+ *
+ * @return 0, or -1 if the record doesn't exist or has never been
+ * selected for profiling.
+ */
+epicsShareFunc long dbProfileGet(const char *recordName,
+    dbProfileStats *pstats);
+
+/** @brief List the records with the largest times.
+ *
+ * @param topN Number of records to show, 0 for 20.
+ * @param sortBy "self" (the default), "total", "max", "async" or "count".
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc long dbProfileReport(int topN, const char *sortBy);
+
+/** @brief Write the statistics of all profiled records as JSON.
+ *
+ * @param filename File to write, NULL or "" for stdout.
+ *
+ * <em>Also provided as an IOC Shell command.</em>
+ */
+epicsShareFunc long dbProfileJSON(const char *filename);
+
+/** @brief Call a record's process routine, measuring it if selected.
+ *
+ * Used by dbProcess() when dbProfileEnabled is set.
+ */
+epicsShareFunc long dbProfileProcess(struct dbCommon *precord);
+
+/** @brief Note the completion of an asynchronous record.
+ *
+ * Called by recGblFwdLink() when dbProfileEnabled is set.
+ */
+epicsShareFunc void dbProfileComplete(struct dbCommon *precord);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdbProfileH */
@@ -16,6 +16,7 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <math.h>
@@ -49,6 +50,7 @@
 #include "devSup.h"
 #include "link.h"
 #include "recGbl.h"
+#include "epicsExport.h"
 
 
 /* Task Control */
@@ -87,15 +89,32 @@ typedef struct scan_element{
 
 #define OVERRUN_REPORT_DELAY 10.0   /* Time between initial reports */
 #define OVERRUN_REPORT_MAX 3600.0   /* Maximum time between reports */
+#define SLOWEST_RECORDS 3           /* Named in over-run reports */
+
+typedef struct slow_record {
+    struct dbCommon     *precord;
+    double              time;
+} slow_record;
+
 typedef struct periodic_scan_list {
     scan_list           scan_list;
     double              period;
+    double              phase;      /* fraction of a slice to start late */
     const char          *name;
     unsigned long       overruns;
+    unsigned long       sliceOverruns;
     volatile enum ctl   scanCtl;
     epicsEventId        loopEvent;
+    slow_record         slowest[SLOWEST_RECORDS]; /* in the last period */
 } periodic_scan_list;
 
+/* Spread the records of each periodic scan list over this many equal
+ * slices of its period, in list order. 0 or 1 processes the whole list
+ * at the start of each period.
+ */
+int scanPeriodicSlices = 0;
+epicsExportAddress(int, scanPeriodicSlices);
+
 static int nPeriodic = 0;
 static periodic_scan_list **papPeriodic; /* pointer to array of pointers */
 static epicsThreadId *periodicTaskId;    /* array of thread ids */
@@ -122,6 +141,14 @@ static epicsMutexId event_lock;
 typedef struct io_scan_list {
     CALLBACK callback;
     scan_list scan_list;
+    int pending;            /* callback queued but not yet started */
+    size_t requested;       /* when the pending callback was requested,
+                             * may be set from an ISR, so epicsAtomic */
+    scanIoStats stats;      /* maxLatency is guarded by scan_list.lock */
+    /* guarded by scan_list.lock */
+    int running;            /* a scan started by the callback is running */
+    int deferred;           /* a callback ran while it was, scan again */
+    size_t deferredRequested;
 } io_scan_list;
 
 typedef struct ioscan_head {
@@ -134,22 +161,65 @@ typedef struct ioscan_head {
 static ioscan_head *pioscan_list = NULL;
 static epicsMutexId ioscan_lock;
 
+/* I/O Intr scan lists of at least this many records are split into
+ * chunks run by the parallel callback threads of their priority.
+ * Records in one lock set stay in one chunk, in their PHAS order.
+ * Zero scans every list in a single callback.
+ */
+int scanIoParallelMin = 0;
+epicsExportAddress(int, scanIoParallelMin);
+
+struct ioscan_run;
+
+typedef struct ioscan_chunk {
+    CALLBACK callback;
+    struct ioscan_run *prun;
+    struct dbCommon **precords;
+    int count;
+} ioscan_chunk;
+
+/* One split scan, freed when its last chunk finishes */
+typedef struct ioscan_run {
+    ioscan_head *piosh;
+    int prio;
+    size_t requested;
+    int pending;            /* chunks not yet finished */
+    ioscan_chunk *chunks;
+    struct dbCommon *precords[1]; /* actually arbitrary size */
+} ioscan_run;
+
 /* Private routines */
 static void onceTask(void *);
 static void initOnce(void);
 static void periodicTask(void *arg);
+static void scanSlices(periodic_scan_list *ppsl, const epicsTimeStamp *start,
+    int nslices);
 static void initPeriodic(void);
 static void deletePeriodic(void);
 static void spawnPeriodic(int ind);
 static void eventCallback(CALLBACK *pcallback);
 static void ioscanInit(void);
 static void ioscanCallback(CALLBACK *pcallback);
+static void ioscanDone(ioscan_head *piosh, int prio, size_t requested);
+static void ioscanFinish(ioscan_head *piosh, int prio, size_t requested);
+static int ioscanSplit(ioscan_head *piosh, int prio, int nthreads,
+    size_t requested);
+static void ioscanChunkCallback(CALLBACK *pcallback);
 static void ioscanDestroy(void);
 static void printList(scan_list *psl, char *message);
 static void scanList(scan_list *psl);
 static void buildScanLists(void);
 static void addToList(struct dbCommon *precord, scan_list *psl);
 static void deleteFromList(struct dbCommon *precord, scan_list *psl);
+
+/* Request times are monotonic nanoseconds truncated to size_t so they
+ * can be handed over with epicsAtomic; differences stay right as long
+ * as a request waits less than 4 seconds on a 32-bit target.
+ */
+static size_t requestTime(void)
+{
+    return (size_t) epicsMonotonicGet();
+}
 
 void scanStop(void)
 {
@@ -397,8 +467,13 @@ int scanppl(double period)      /* print periodic scan list(s) */
             (fabs(period - ppsl->period) > 0.05))
             continue;
 
-        sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
-            ppsl->name, ppsl->overruns);
+        if (ppsl->sliceOverruns)
+            sprintf(message, "Records with SCAN = '%s' (%lu over-runs, "
+                "%lu slice over-runs):", ppsl->name, ppsl->overruns,
+                ppsl->sliceOverruns);
+        else
+            sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
+                ppsl->name, ppsl->overruns);
         printList(&ppsl->scan_list, message);
     }
     return 0;
@@ -438,9 +513,17 @@ int scanpiol(void)                  /* print pioscan_list */
             io_scan_list *piosl = &piosh->iosl[prio];
             char message[80];
 
+            if (ellCount(&piosl->scan_list.list) == 0)
+                continue;
             sprintf(message, "IO Event %p: Priority %s",
                 piosh, priorityName[prio]);
             printList(&piosl->scan_list, message);
+            printf("    requests %d, coalesced %d, scans %d, "
+                "max latency %.3f ms\n",
+                epicsAtomicGetIntT(&piosl->stats.requests),
+                epicsAtomicGetIntT(&piosl->stats.coalesced),
+                epicsAtomicGetIntT(&piosl->stats.processed),
+                piosl->stats.maxLatency * 1e3);
         }
         piosh = piosh->next;
     }
@@ -616,9 +699,23 @@ unsigned int scanIoRequest(IOSCANPVT piosh)
     for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
         io_scan_list *piosl = &piosh->iosl[prio];
 
-        if (ellCount(&piosl->scan_list.list) > 0)
-            if (!callbackRequest(&piosl->callback))
-                queued |= 1 << prio;
+        if (ellCount(&piosl->scan_list.list) == 0)
+            continue;
+        epicsAtomicIncrIntT(&piosl->stats.requests);
+
+        /* A callback that hasn't started yet will scan for this request
+         * too, so don't fill the callback queue with copies of it.
+         */
+        if (epicsAtomicCmpAndSwapIntT(&piosl->pending, 0, 1) != 0) {
+            epicsAtomicIncrIntT(&piosl->stats.coalesced);
+            queued |= 1 << prio;
+            continue;
+        }
+        epicsAtomicSetSizeT(&piosl->requested, requestTime());
+        if (!callbackRequest(&piosl->callback))
+            queued |= 1 << prio;
+        else
+            epicsAtomicSetIntT(&piosl->pending, 0);
     }
 
     return queued;
@@ -627,6 +724,7 @@ unsigned int scanIoRequest(IOSCANPVT piosh)
 unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
 {
     io_scan_list *piosl;
+    size_t requested = requestTime();
 
     if (prio<0 || prio>=NUM_CALLBACK_PRIORITIES)
         return S_db_errArg;
@@ -638,10 +736,9 @@ unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
     if (ellCount(&piosl->scan_list.list) == 0)
         return 0;
 
+    epicsAtomicIncrIntT(&piosl->stats.requests);
     scanList(&piosl->scan_list);
-
-    if (piosh->cb)
-        piosh->cb(piosh->arg, piosh, prio);
+    ioscanDone(piosh, prio, requested);
 
     return 1 << prio;
 }
@@ -653,6 +750,31 @@ void scanIoSetComplete(IOSCANPVT piosh, io_scan_complete cb, void *arg)
     piosh->arg = arg;
 }
 
+int scanIoStatus(IOSCANPVT piosh, int prio, const int reset,
+    scanIoStats *result)
+{
+    io_scan_list *piosl;
+
+    if (prio < 0 || prio >= NUM_CALLBACK_PRIORITIES)
+        return -1;
+    piosl = &piosh->iosl[prio];
+    epicsMutexMustLock(piosl->scan_list.lock);
+    if (result) {
+        result->requests = epicsAtomicGetIntT(&piosl->stats.requests);
+        result->coalesced = epicsAtomicGetIntT(&piosl->stats.coalesced);
+        result->processed = epicsAtomicGetIntT(&piosl->stats.processed);
+        result->maxLatency = piosl->stats.maxLatency;
+    }
+    if (reset) {
+        epicsAtomicSetIntT(&piosl->stats.requests, 0);
+        epicsAtomicSetIntT(&piosl->stats.coalesced, 0);
+        epicsAtomicSetIntT(&piosl->stats.processed, 0);
+        piosl->stats.maxLatency = 0.0;
+    }
+    epicsMutexUnlock(piosl->scan_list.lock);
+    return 0;
+}
+
 int scanOnce(struct dbCommon *precord) {
     return scanOnceCallback(precord, NULL, NULL);
 }
@@ -719,6 +841,104 @@ shutdown:
     epicsEventSignal(startStopEvent);
 }
 
+static void noteSlowRecord(periodic_scan_list *ppsl, struct dbCommon *precord,
+    double time)
+{
+    slow_record *slowest = ppsl->slowest;
+    int i = SLOWEST_RECORDS - 1;
+
+    if (time <= slowest[i].time)
+        return;
+    for (; i > 0 && time > slowest[i - 1].time; i--)
+        slowest[i] = slowest[i - 1];
+    slowest[i].precord = precord;
+    slowest[i].time = time;
+}
+
+/* Process records from pse on until *pindex reaches end. A changed list
+ * is found again by position, so a record can be skipped or repeated
+ * when records before it leave or join the list.
+ */
+static scan_element * scanRange(periodic_scan_list *ppsl, scan_element *pse,
+    int *pindex, int end)
+{
+    scan_list *psl = &ppsl->scan_list;
+
+    while (*pindex < end) {
+        struct dbCommon *precord;
+        epicsUInt64 start;
+
+        epicsMutexMustLock(psl->lock);
+        if (psl->modified) {
+            int i;
+
+            pse = (scan_element *)ellFirst(&psl->list);
+            for (i = 0; pse && i < *pindex; i++)
+                pse = (scan_element *)ellNext(&pse->node);
+            psl->modified = FALSE;
+        }
+        if (!pse) {
+            epicsMutexUnlock(psl->lock);
+            break;
+        }
+        precord = pse->precord;
+        pse = (scan_element *)ellNext(&pse->node);
+        epicsMutexUnlock(psl->lock);
+
+        start = epicsMonotonicGet();
+        dbScanLock(precord);
+        dbProcess(precord);
+        dbScanUnlock(precord);
+        noteSlowRecord(ppsl, precord, (epicsMonotonicGet() - start) * 1e-9);
+        (*pindex)++;
+    }
+    return pse;
+}
+
+/* Process a periodic scan list in nslices parts spaced evenly over the
+ * period that begins at start. Each slice that ends after the start of
+ * the next one counts as a slice over-run.
+ */
+static void scanSlices(periodic_scan_list *ppsl, const epicsTimeStamp *start,
+    int nslices)
+{
+    scan_list *psl = &ppsl->scan_list;
+    double slice = ppsl->period / nslices;
+    scan_element *pse;
+    int count, index = 0, k;
+
+    memset(ppsl->slowest, 0, sizeof(ppsl->slowest));
+    epicsMutexMustLock(psl->lock);
+    count = ellCount(&psl->list);
+    pse = (scan_element *)ellFirst(&psl->list);
+    psl->modified = FALSE;
+    epicsMutexUnlock(psl->lock);
+
+    for (k = 0; k < nslices; k++) {
+        int end = (int) ((double) count * (k + 1) / nslices);
+        epicsTimeStamp deadline = *start;
+        epicsTimeStamp now;
+
+        if (k > 0) {
+            double delay;
+
+            epicsTimeAddSeconds(&deadline, slice * k);
+            epicsTimeGetCurrent(&now);
+            delay = epicsTimeDiffInSeconds(&deadline, &now);
+            if (delay > 0.0)
+                epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
+            if (ppsl->scanCtl != ctlRun)
+                return;
+            deadline = *start;
+        }
+        pse = scanRange(ppsl, pse, &index, end);
+        epicsTimeAddSeconds(&deadline, slice * (k + 1));
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &deadline) > 0.0)
+            ppsl->sliceOverruns++;
+    }
+}
+
 int scanOnceSetQueueSize(int size)
 {
     onceQueueSize = size;
@@ -790,12 +1010,22 @@ static void periodicTask(void *arg)
     epicsTimeGetCurrent(&next);
     reported = next;
 
+    /* Keep the slices of different periods from starting together */
+    if (scanPeriodicSlices > 1)
+        epicsTimeAddSeconds(&next,
+            ppsl->phase * ppsl->period / scanPeriodicSlices);
+
     while (ppsl->scanCtl != ctlExit) {
         double delay;
         epicsTimeStamp now;
+        int nslices = scanPeriodicSlices;
 
-        if (ppsl->scanCtl == ctlRun)
-            scanList(&ppsl->scan_list);
+        if (ppsl->scanCtl == ctlRun) {
+            if (nslices > 1)
+                scanSlices(ppsl, &next, nslices);
+            else
+                scanList(&ppsl->scan_list);
+        }
 
         epicsTimeAddSeconds(&next, ppsl->period);
         epicsTimeGetCurrent(&now);
@@ -823,6 +1053,16 @@ static void periodicTask(void *arg)
                     "\tTo fix this, move some records to a slower scan rate.\n",
                     ppsl->name, ppsl->period + overtime / overruns,
                     ppsl->period + over_min, ppsl->period + over_max, overruns);
+                if (nslices > 1 && ppsl->slowest[0].precord) {
+                    int i;
+
+                    errlogPrintf("\tSlowest records in the last period:\n");
+                    for (i = 0; i < SLOWEST_RECORDS &&
+                         ppsl->slowest[i].precord; i++)
+                        errlogPrintf("\t    %s %.3f ms\n",
+                            ppsl->slowest[i].precord->name,
+                            ppsl->slowest[i].time * 1e3);
+                }
 
                 reported = now;
                 if (report_delay < (OVERRUN_REPORT_MAX / 2))
@@ -896,6 +1136,7 @@ static void initPeriodic(void)
         ppsl->scan_list.lock = epicsMutexMustCreate();
         ellInit(&ppsl->scan_list.list);
         ppsl->name = choice;
+        ppsl->phase = (double) i / nPeriodic;
         ppsl->scanCtl = ctlPause;
         ppsl->loopEvent = epicsEventMustCreate(epicsEventEmpty);
 
@@ -947,15 +1188,186 @@ static void spawnPeriodic(int ind)
 static void ioscanCallback(CALLBACK *pcallback)
 {
     ioscan_head *piosh;
-    int prio;
+    io_scan_list *piosl;
+    scan_list *psl;
+    int prio, nthreads;
+    size_t requested;
 
     callbackGetUser(piosh, pcallback);
     callbackGetPriority(prio, pcallback);
-    scanList(&piosh->iosl[prio].scan_list);
+    piosl = &piosh->iosl[prio];
+    psl = &piosl->scan_list;
+
+    /* Requests from now on need another scan */
+    requested = epicsAtomicGetSizeT(&piosl->requested);
+    epicsAtomicSetIntT(&piosl->pending, 0);
+
+    /* With parallel callback threads the previous scan of this list may
+     * not have finished yet. Scans must not overlap, so leave this one
+     * for ioscanFinish() to start.
+     */
+    epicsMutexMustLock(psl->lock);
+    if (piosl->running) {
+        if (!piosl->deferred) {
+            piosl->deferred = 1;
+            piosl->deferredRequested = requested;
+        }
+        epicsMutexUnlock(psl->lock);
+        return;
+    }
+    piosl->running = 1;
+    epicsMutexUnlock(psl->lock);
+
+    if (scanIoParallelMin > 0 &&
+        ellCount(&psl->list) >= scanIoParallelMin &&
+        (nthreads = callbackThreadCount(prio)) > 1 &&
+        ioscanSplit(piosh, prio, nthreads, requested))
+        return;
+    scanList(psl);
+    ioscanFinish(piosh, prio, requested);
+}
+
+/* The end of a scan started by ioscanCallback() */
+static void ioscanFinish(ioscan_head *piosh, int prio, size_t requested)
+{
+    io_scan_list *piosl = &piosh->iosl[prio];
+    int again;
+
+    ioscanDone(piosh, prio, requested);
+
+    epicsMutexMustLock(piosl->scan_list.lock);
+    piosl->running = 0;
+    again = piosl->deferred;
+    piosl->deferred = 0;
+    requested = piosl->deferredRequested;
+    epicsMutexUnlock(piosl->scan_list.lock);
+
+    /* Queue the scan deferred above, unless a new one is already queued */
+    if (again && epicsAtomicCmpAndSwapIntT(&piosl->pending, 0, 1) == 0) {
+        epicsAtomicSetSizeT(&piosl->requested, requested);
+        if (callbackRequest(&piosl->callback))
+            epicsAtomicSetIntT(&piosl->pending, 0);
+    }
+}
+
+static void ioscanDone(ioscan_head *piosh, int prio, size_t requested)
+{
+    io_scan_list *piosl = &piosh->iosl[prio];
+    double latency = (size_t) (requestTime() - requested) * 1e-9;
+
+    epicsAtomicIncrIntT(&piosl->stats.processed);
+    epicsMutexMustLock(piosl->scan_list.lock);
+    if (latency > piosl->stats.maxLatency)
+        piosl->stats.maxLatency = latency;
+    epicsMutexUnlock(piosl->scan_list.lock);
+
     if (piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
 }
 
+static void ioscanChunk(ioscan_chunk *pchunk)
+{
+    ioscan_run *prun = pchunk->prun;
+    ioscan_head *piosh = prun->piosh;
+    int prio = prun->prio;
+    scan_list *psl = &piosh->iosl[prio].scan_list;
+    int i;
+
+    for (i = 0; i < pchunk->count; i++) {
+        struct dbCommon *precord = pchunk->precords[i];
+        scan_element *pse;
+
+        /* A record's SCAN can only change while it is locked */
+        dbScanLock(precord);
+        pse = precord->spvt;
+        if (pse && pse->pscan_list == psl)
+            dbProcess(precord);
+        dbScanUnlock(precord);
+    }
+
+    if (epicsAtomicDecrIntT(&prun->pending) == 0) {
+        size_t requested = prun->requested;
+
+        free(prun);
+        ioscanFinish(piosh, prio, requested);
+    }
+}
+
+static void ioscanChunkCallback(CALLBACK *pcallback)
+{
+    ioscan_chunk *pchunk;
+
+    callbackGetUser(pchunk, pcallback);
+    ioscanChunk(pchunk);
+}
+
+/* Take a copy of the scan list, with the records of each lock set in the
+ * same chunk, and queue all but the first chunk, which is run here.
+ * Returns 0 if the list must be scanned serially.
+ */
+static int ioscanSplit(ioscan_head *piosh, int prio, int nthreads,
+    size_t requested)
+{
+    scan_list *psl = &piosh->iosl[prio].scan_list;
+    ioscan_run *prun;
+    ioscan_chunk *pchunk;
+    scan_element *pse;
+    int count, nchunks, i;
+
+    epicsMutexMustLock(psl->lock);
+    count = ellCount(&psl->list);
+    nchunks = count < nthreads ? count : nthreads;
+    prun = count ? malloc(sizeof(ioscan_run) +
+        (count - 1) * sizeof(struct dbCommon *) +
+        nchunks * sizeof(ioscan_chunk)) : NULL;
+    if (!prun) {
+        epicsMutexUnlock(psl->lock);
+        return 0;
+    }
+    prun->piosh = piosh;
+    prun->prio = prio;
+    prun->requested = requested;
+    prun->chunks = (ioscan_chunk *) &prun->precords[count];
+    memset(prun->chunks, 0, nchunks * sizeof(ioscan_chunk));
+
+    /* Lock set ids are sequential, so spreading them round-robin
+     * balances the chunks unless a few lock sets hold most records.
+     */
+    for (pse = (scan_element *)ellFirst(&psl->list); pse;
+         pse = (scan_element *)ellNext(&pse->node))
+        prun->chunks[dbLockGetLockId(pse->precord) % nchunks].count++;
+    for (i = 0, count = 0; i < nchunks; i++) {
+        prun->chunks[i].precords = &prun->precords[count];
+        count += prun->chunks[i].count;
+        prun->chunks[i].count = 0;
+    }
+    for (pse = (scan_element *)ellFirst(&psl->list); pse;
+         pse = (scan_element *)ellNext(&pse->node)) {
+        pchunk = &prun->chunks[dbLockGetLockId(pse->precord) % nchunks];
+        pchunk->precords[pchunk->count++] = pse->precord;
+    }
+    epicsMutexUnlock(psl->lock);
+
+    /* Skip empty chunks, and keep the first for this thread */
+    for (i = 0, count = 0; i < nchunks; i++)
+        if (prun->chunks[i].count)
+            prun->chunks[count++] = prun->chunks[i];
+    prun->pending = count;
+
+    for (i = 1; i < count; i++) {
+        pchunk = &prun->chunks[i];
+        pchunk->prun = prun;
+        callbackSetCallback(ioscanChunkCallback, &pchunk->callback);
+        callbackSetPriority(prio, &pchunk->callback);
+        callbackSetUser(pchunk, &pchunk->callback);
+        if (callbackRequest(&pchunk->callback))
+            ioscanChunk(pchunk);    /* queue full */
+    }
+    prun->chunks[0].prun = prun;
+    ioscanChunk(&prun->chunks[0]);
+    return 1;
+}
+
 static void printList(scan_list *psl, char *message)
 {
     scan_element *pse;
@@ -1081,7 +1493,7 @@ static void addToList(struct dbCommon *precord, scan_list *psl)
         }
         ptemp = (scan_element *)ellPrevious(&ptemp->node);
     }
-    if (ptemp == NULL) ellAdd(&psl->list, (void *)pse);
+    if (ptemp == NULL) ellInsert(&psl->list, NULL, &pse->node);
     psl->modified = TRUE;
     epicsMutexUnlock(psl->lock);
 }
@@ -49,6 +49,13 @@ typedef struct scanOnceQueueStats {
     int numOverflow;
 } scanOnceQueueStats;
 
+typedef struct scanIoStats {
+    int requests;       /* scanIoRequest() calls for a non-empty list */
+    int coalesced;      /* requests served by a scan already queued */
+    int processed;      /* scans of the list completed */
+    double maxLatency;  /* longest time from request to completion, s */
+} scanIoStats;
+
 epicsShareFunc long scanInit(void);
 epicsShareFunc void scanRun(void);
 epicsShareFunc void scanPause(void);
@@ -80,6 +87,8 @@ epicsShareFunc void scanIoInit(IOSCANPVT *ppios);
 epicsShareFunc unsigned int scanIoRequest(IOSCANPVT pios);
 epicsShareFunc unsigned int scanIoImmediate(IOSCANPVT pios, int prio);
 epicsShareFunc void scanIoSetComplete(IOSCANPVT, io_scan_complete, void *usr);
+epicsShareFunc int scanIoStatus(IOSCANPVT pios, int prio, const int reset,
+    scanIoStats *result);
 
 #ifdef __cplusplus
 }
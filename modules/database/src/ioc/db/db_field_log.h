@@ -92,6 +92,7 @@ typedef struct db_field_log {
     unsigned int     type:2;  /* type (union) selector */
     /* ctx is used for all types */
     unsigned int      ctx:1;  /* context (operation type) */
+    unsigned int     mask:8;  /* DBE_* events of the post, 0 for reads */
     /* the following are used for value and reference types */
     epicsTimeStamp     time;  /* Time stamp */
     unsigned short     stat;  /* Alarm Status */
@@ -40,6 +40,7 @@
 #include "dbFldTypes.h"
 #include "dbLink.h"
 #include "dbNotify.h"
+#include "dbProfile.h"
 #include "dbScan.h"
 #include "devSup.h"
 #include "link.h"
@@ -247,6 +248,8 @@ void recGblFwdLink(void *precord)
 {
     dbCommon *pdbc = precord;
 
+    if (dbProfileEnabled)
+        dbProfileComplete(pdbc);
     dbScanFwdLink(&pdbc->flnk);
     /*Handle dbPutFieldNotify record completions*/
     if(pdbc->ppn) dbNotifyCompletion(pdbc);
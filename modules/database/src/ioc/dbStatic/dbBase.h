@@ -151,16 +151,21 @@ typedef struct dbRecordType {
     short		no_fields;	/* number of fields defined	*/
     short		no_prompt;	/* number of fields to configure*/
     short		no_links;	/* number of links		*/
-    short		no_aliases;	/* number of aliases in recList */
+    int		no_aliases;	/* number of aliases in recList */
     short		*link_ind;	/* addr of array of ind in papFldDes*/
     char		**papsortFldName;/* ptr to array of ptr to fld names*/
     short		*sortFldInd;	/* addr of array of ind in papFldDes*/
+    short		*fieldHash;	/* perfect hash of names to papFldDes ind*/
+    unsigned short	*fieldHashSeed;	/* hash seed of each name bucket*/
+    unsigned int	fieldHashMask;	/* fieldHash size - 1		*/
+    unsigned int	fieldBucketMask;/* fieldHashSeed size - 1	*/
     dbFldDes	*pvalFldDes;	/*pointer dbFldDes for VAL field*/
     short		indvalFlddes;	/*ind in papFldDes*/
     dbFldDes 	**papFldDes;	/* ptr to array of ptr to fldDes*/
     /*The following are only available on run time system*/
     rset        *prset;
     int		rec_size;	/*record size in bytes          */
+    void	*recordArena;	/*storage of the record instances*/
 }dbRecordType;
 
 struct dbPvd;           /* Contents private to dbPvdLib code */
@@ -182,5 +187,7 @@ typedef struct dbBase {
 	struct gphPvt	*pgpHash;
 	short		ignoreMissingMenus;
 	short		loadCdefs;
+    void            *recnodeFreeList;   /* dbRecordNodes */
+    void            *infoFreeList;      /* dbInfoNodes */
 }dbBase;
 #endif
@@ -0,0 +1,759 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Binary database images.
+ *
+ * An image holds the record instances of a dbBase with their field
+ * values already converted, so loading one avoids the parser and the
+ * string conversions of dbPutString(). Record types, menus and device
+ * support are not stored; they come from the DBD files loaded into the
+ * IOC, and the image records a checksum of their layout which must
+ * match the running DBD.
+ *
+ * All values are in host byte order. After the header, each record type
+ * that has records is written as a section:
+ *
+ *   string   record type name
+ *   uint32   number of record nodes
+ *   nodes    in the order of the recList
+ *
+ * where a node is a kind byte (IMAGE_RECORD or IMAGE_ALIAS), a flags
+ * byte and the name, then for an alias the name of its record, or for
+ * a record the fields which differ from the record type's defaults:
+ *
+ *   uint16   number of fields
+ *   fields   uint16 field index, then a string for DBF_STRING and link
+ *            fields or the raw field contents for the other types
+ *   uint16   number of info items
+ *   infos    string name, string value
+ *
+ * Strings are stored as a uint32 length followed by the characters
+ * without a terminating nil.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "dbDefs.h"
+#include "ellLib.h"
+#include "epicsPrint.h"
+#include "epicsString.h"
+#include "epicsTypes.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "dbBase.h"
+#include "dbCommonPvt.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "devSup.h"
+#include "link.h"
+
+#define IMAGE_MAGIC "EPICSDBI"
+#define IMAGE_VERSION 1
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+#define IMAGE_RECORD 'R'
+#define IMAGE_ALIAS 'A'
+
+#define IMAGE_FLAG_VISIBLE 1
+
+typedef struct imageHeader {
+    char magic[8];
+    epicsUInt32 version;
+    epicsUInt32 byteOrder;
+    epicsUInt32 checksum;
+    epicsUInt32 nSections;
+    epicsUInt32 nNodes;
+} imageHeader;
+
+/* Default contents of a record type, built by dbAllocRecord() */
+typedef struct imageProto {
+    dbRecordNode node;
+    dbCommonPvt *ppvt;
+    size_t size;
+    int nLinks;
+    short *linkInd;
+} imageProto;
+
+static int isLinkField(const dbFldDes *pflddes)
+{
+    return pflddes->field_type == DBF_INLINK ||
+        pflddes->field_type == DBF_OUTLINK ||
+        pflddes->field_type == DBF_FWDLINK;
+}
+
+static long protoCreate(DBBASE *pdbbase, dbRecordType *precordType,
+    imageProto *pproto)
+{
+    DBENTRY dbentry;
+    long status;
+    int i;
+
+    memset(pproto, 0, sizeof(*pproto));
+    dbInitEntry(pdbbase, &dbentry);
+    dbentry.precordType = precordType;
+    dbentry.precnode = &pproto->node;
+    status = dbAllocRecord(&dbentry, "");
+    dbFinishEntry(&dbentry);
+    if (!pproto->node.precord)
+        return status ? status : S_dbLib_noRecSup;
+    pproto->ppvt = dbRec2Pvt(pproto->node.precord);
+    pproto->size = offsetof(dbCommonPvt, common) + precordType->rec_size;
+
+    pproto->linkInd = dbCalloc(precordType->no_fields + 1, sizeof(short));
+    for (i = 1; i < precordType->no_fields; i++) {
+        dbFldDes *pflddes = precordType->papFldDes[i];
+
+        if (pflddes && isLinkField(pflddes))
+            pproto->linkInd[pproto->nLinks++] = i;
+    }
+    return status;
+}
+
+static void protoFree(dbRecordType *precordType, imageProto *pproto)
+{
+    int i;
+
+    if (pproto->ppvt) {
+        for (i = 0; i < pproto->nLinks; i++) {
+            dbFldDes *pflddes = precordType->papFldDes[pproto->linkInd[i]];
+            DBLINK *plink = (DBLINK *)
+                ((char *) pproto->node.precord + pflddes->offset);
+
+            free(plink->text);
+        }
+        dbRecordStorageFree(precordType, pproto->ppvt);
+    }
+    free(pproto->linkInd);
+    memset(pproto, 0, sizeof(*pproto));
+}
+
+static epicsUInt32 hashString(epicsUInt32 hash, const char *str)
+{
+    return epicsStrHash(str ? str : "", hash) * 31 + (str ? 1 : 0);
+}
+
+static epicsUInt32 hashInt(epicsUInt32 hash, long value)
+{
+    epicsInt32 v = (epicsInt32) value;
+
+    return epicsMemHash((const char *) &v, sizeof(v), hash);
+}
+
+/* Covers everything an image depends on: the record types, their field
+ * layout and defaults, and the menu and device choices whose indices are
+ * stored in DBF_MENU and DBF_DEVICE fields.
+ */
+epicsUInt32 dbImageChecksum(DBBASE *pdbbase)
+{
+    epicsUInt32 hash = IMAGE_VERSION;
+    dbRecordType *precordType;
+
+    if (!pdbbase)
+        return 0;
+    hash = hashInt(hash, sizeof(void *));
+    for (precordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+         precordType;
+         precordType = (dbRecordType *) ellNext(&precordType->node)) {
+        devSup *pdevSup;
+        int i;
+
+        hash = hashString(hash, precordType->name);
+        hash = hashInt(hash, precordType->rec_size);
+        hash = hashInt(hash, precordType->no_fields);
+        for (i = 0; i < precordType->no_fields; i++) {
+            dbFldDes *pflddes = precordType->papFldDes[i];
+
+            if (!pflddes)
+                continue;
+            hash = hashString(hash, pflddes->name);
+            hash = hashInt(hash, pflddes->field_type);
+            hash = hashInt(hash, pflddes->offset);
+            hash = hashInt(hash, pflddes->size);
+            hash = hashString(hash, pflddes->initial);
+            if (pflddes->field_type == DBF_MENU && pflddes->ftPvt) {
+                dbMenu *pmenu = (dbMenu *) pflddes->ftPvt;
+                int j;
+
+                hash = hashString(hash, pmenu->name);
+                for (j = 0; j < pmenu->nChoice; j++)
+                    hash = hashString(hash, pmenu->papChoiceValue[j]);
+            }
+        }
+        for (pdevSup = (devSup *) ellFirst(&precordType->devList);
+             pdevSup;
+             pdevSup = (devSup *) ellNext(&pdevSup->node)) {
+            hash = hashString(hash, pdevSup->choice);
+            hash = hashInt(hash, pdevSup->link_type);
+        }
+    }
+    return hash;
+}
+
+/* Writing */
+
+typedef struct imageWriter {
+    FILE *fp;
+    int error;
+} imageWriter;
+
+static void putBytes(imageWriter *pw, const void *data, size_t len)
+{
+    if (len && fwrite(data, 1, len, pw->fp) != len)
+        pw->error = 1;
+}
+
+static void putUInt8(imageWriter *pw, int value)
+{
+    epicsUInt8 v = (epicsUInt8) value;
+
+    putBytes(pw, &v, sizeof(v));
+}
+
+static void putUInt16(imageWriter *pw, int value)
+{
+    epicsUInt16 v = (epicsUInt16) value;
+
+    putBytes(pw, &v, sizeof(v));
+}
+
+static void putUInt32(imageWriter *pw, size_t value)
+{
+    epicsUInt32 v = (epicsUInt32) value;
+
+    putBytes(pw, &v, sizeof(v));
+}
+
+static void putString(imageWriter *pw, const char *str)
+{
+    size_t len = str ? strlen(str) : 0;
+
+    putUInt32(pw, len);
+    putBytes(pw, str, len);
+}
+
+static int fieldDiffers(const dbFldDes *pflddes, const char *pfield,
+    const char *pdefault)
+{
+    switch (pflddes->field_type) {
+    case DBF_NOACCESS:
+        return 0;
+    case DBF_STRING:
+        return strncmp(pfield, pdefault, pflddes->size) != 0;
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK: {
+            const char *text = ((const DBLINK *) pfield)->text;
+            const char *dflt = ((const DBLINK *) pdefault)->text;
+
+            return strcmp(text ? text : "", dflt ? dflt : "") != 0;
+        }
+    default:
+        return memcmp(pfield, pdefault, pflddes->size) != 0;
+    }
+}
+
+static void putField(imageWriter *pw, const dbFldDes *pflddes,
+    const char *pfield)
+{
+    putUInt16(pw, pflddes->indRecordType);
+    switch (pflddes->field_type) {
+    case DBF_STRING:
+        putUInt32(pw, epicsStrnLen(pfield, pflddes->size));
+        putBytes(pw, pfield, epicsStrnLen(pfield, pflddes->size));
+        break;
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        putString(pw, ((const DBLINK *) pfield)->text);
+        break;
+    default:
+        putBytes(pw, pfield, pflddes->size);
+    }
+}
+
+static void putRecord(imageWriter *pw, dbRecordType *precordType,
+    dbRecordNode *precnode, const imageProto *pproto)
+{
+    const char *precord = (const char *) precnode->precord;
+    const char *pdefault = (const char *) pproto->node.precord;
+    dbInfoNode *pinfo;
+    int nFields = 0;
+    int i;
+
+    for (i = 1; i < precordType->no_fields; i++) {
+        dbFldDes *pflddes = precordType->papFldDes[i];
+
+        if (pflddes && fieldDiffers(pflddes, precord + pflddes->offset,
+                pdefault + pflddes->offset))
+            nFields++;
+    }
+    putUInt16(pw, nFields);
+    for (i = 1; i < precordType->no_fields; i++) {
+        dbFldDes *pflddes = precordType->papFldDes[i];
+
+        if (pflddes && fieldDiffers(pflddes, precord + pflddes->offset,
+                pdefault + pflddes->offset))
+            putField(pw, pflddes, precord + pflddes->offset);
+    }
+
+    putUInt16(pw, ellCount(&precnode->infoList));
+    for (pinfo = (dbInfoNode *) ellFirst(&precnode->infoList);
+         pinfo;
+         pinfo = (dbInfoNode *) ellNext(&pinfo->node)) {
+        putString(pw, pinfo->name);
+        putString(pw, pinfo->string);
+    }
+}
+
+long dbImageWrite(DBBASE *pdbbase, const char *filename)
+{
+    imageWriter writer;
+    imageHeader header;
+    dbRecordType *precordType;
+    long status = 0;
+
+    if (!pdbbase)
+        return S_dbLib_recordTypeNotFound;
+    writer.fp = fopen(filename, "wb");
+    writer.error = 0;
+    if (!writer.fp) {
+        errPrintf(0, __FILE__, __LINE__, "dbImageWrite opening file %s: %s",
+            filename, strerror(errno));
+        return S_dbLib_badImage;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.byteOrder = IMAGE_BYTE_ORDER;
+    header.checksum = dbImageChecksum(pdbbase);
+    for (precordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+         precordType;
+         precordType = (dbRecordType *) ellNext(&precordType->node)) {
+        if (ellCount(&precordType->recList))
+            header.nSections++;
+        header.nNodes += ellCount(&precordType->recList);
+    }
+    putBytes(&writer, &header, sizeof(header));
+
+    for (precordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+         precordType && !status;
+         precordType = (dbRecordType *) ellNext(&precordType->node)) {
+        dbRecordNode *precnode;
+        imageProto proto;
+
+        if (!ellCount(&precordType->recList))
+            continue;
+        status = protoCreate(pdbbase, precordType, &proto);
+        if (status)
+            break;
+        putString(&writer, precordType->name);
+        putUInt32(&writer, ellCount(&precordType->recList));
+        for (precnode = (dbRecordNode *) ellFirst(&precordType->recList);
+             precnode;
+             precnode = (dbRecordNode *) ellNext(&precnode->node)) {
+            int isAlias = precnode->flags & DBRN_FLAGS_ISALIAS;
+
+            putUInt8(&writer, isAlias ? IMAGE_ALIAS : IMAGE_RECORD);
+            putUInt8(&writer, precnode->flags & DBRN_FLAGS_VISIBLE ?
+                IMAGE_FLAG_VISIBLE : 0);
+            putString(&writer, precnode->recordname);
+            if (isAlias)
+                putString(&writer, precnode->aliasedRecnode->recordname);
+            else
+                putRecord(&writer, precordType, precnode, &proto);
+        }
+        protoFree(precordType, &proto);
+    }
+
+    if (fclose(writer.fp))
+        writer.error = 1;
+    if (!status && writer.error) {
+        errPrintf(0, __FILE__, __LINE__, "dbImageWrite writing file %s: %s",
+            filename, strerror(errno));
+        status = S_dbLib_badImage;
+    }
+    return status;
+}
+
+/* Reading */
+
+typedef struct imageReader {
+    const char *filename;
+    const char *pos;
+    const char *end;
+    int error;
+} imageReader;
+
+static const char * getBytes(imageReader *pr, size_t len)
+{
+    const char *data = pr->pos;
+
+    if (pr->error || (size_t) (pr->end - pr->pos) < len) {
+        pr->error = 1;
+        return NULL;
+    }
+    pr->pos += len;
+    return data;
+}
+
+static int getUInt8(imageReader *pr)
+{
+    const char *data = getBytes(pr, 1);
+
+    return data ? (epicsUInt8) *data : 0;
+}
+
+static unsigned getUInt16(imageReader *pr)
+{
+    const char *data = getBytes(pr, sizeof(epicsUInt16));
+    epicsUInt16 v = 0;
+
+    if (data)
+        memcpy(&v, data, sizeof(v));
+    return v;
+}
+
+static epicsUInt32 getUInt32(imageReader *pr)
+{
+    const char *data = getBytes(pr, sizeof(epicsUInt32));
+    epicsUInt32 v = 0;
+
+    if (data)
+        memcpy(&v, data, sizeof(v));
+    return v;
+}
+
+/* The returned string is not nil-terminated */
+static const char * getString(imageReader *pr, size_t *plen)
+{
+    *plen = getUInt32(pr);
+    return getBytes(pr, *plen);
+}
+
+static char * getStringDup(imageReader *pr)
+{
+    size_t len;
+    const char *str = getString(pr, &len);
+    char *copy;
+
+    if (!str)
+        return NULL;
+    copy = dbMalloc(len + 1);
+    memcpy(copy, str, len);
+    copy[len] = 0;
+    return copy;
+}
+
+static long badImage(imageReader *pr, const char *what)
+{
+    errlogPrintf("dbLoadImage: %s in '%s'\n", what, pr->filename);
+    return S_dbLib_badImage;
+}
+
+/* Free a record node that getRecord() filled in, before it was added */
+static void recordFree(DBBASE *pdbbase, dbRecordType *precordType,
+    const imageProto *pproto, dbRecordNode *precnode)
+{
+    dbInfoNode *pinfo;
+    int i;
+
+    if (precnode->precord) {
+        for (i = 0; i < pproto->nLinks; i++) {
+            dbFldDes *pflddes = precordType->papFldDes[pproto->linkInd[i]];
+            DBLINK *plink = (DBLINK *)
+                ((char *) precnode->precord + pflddes->offset);
+
+            free(plink->text);
+        }
+        dbRecordStorageFree(precordType, dbRec2Pvt(precnode->precord));
+    }
+    while ((pinfo = (dbInfoNode *) ellGet(&precnode->infoList))) {
+        free(pinfo->name);
+        free(pinfo->string);
+        dbInfoNodeFree(pdbbase, pinfo);
+    }
+    dbRecordNodeFree(pdbbase, precnode);
+}
+
+/* Make a record from the defaults and apply the stored field values */
+static long getRecord(imageReader *pr, DBBASE *pdbbase,
+    dbRecordType *precordType, const imageProto *pproto,
+    dbRecordNode *precnode)
+{
+    dbCommonPvt *ppvt;
+    char *precord;
+    unsigned nFields, nInfo;
+    size_t len;
+    const char *name = getString(pr, &len);
+    int i;
+
+    if (!name || len >= sizeof(ppvt->common.name))
+        return badImage(pr, "Bad record name");
+    ppvt = dbRecordStorageAlloc(precordType);
+    memcpy(ppvt, pproto->ppvt, pproto->size);
+    ppvt->recnode = precnode;
+    precnode->precord = &ppvt->common;
+    precord = (char *) &ppvt->common;
+    memcpy(ppvt->common.name, name, len);
+    ppvt->common.name[len] = 0;
+    precnode->recordname = ppvt->common.name;
+    ellInit(&precnode->infoList);
+
+    for (i = 0; i < pproto->nLinks; i++) {
+        dbFldDes *pflddes = precordType->papFldDes[pproto->linkInd[i]];
+        DBLINK *plink = (DBLINK *) (precord + pflddes->offset);
+
+        if (plink->text)
+            plink->text = epicsStrDup(plink->text);
+    }
+
+    nFields = getUInt16(pr);
+    while (nFields-- && !pr->error) {
+        unsigned ind = getUInt16(pr);
+        dbFldDes *pflddes;
+        char *pfield;
+        const char *data;
+
+        if (ind == 0 || ind >= (unsigned) precordType->no_fields)
+            return badImage(pr, "Bad field index");
+        pflddes = precordType->papFldDes[ind];
+        pfield = precord + pflddes->offset;
+        switch (pflddes->field_type) {
+        case DBF_NOACCESS:
+            return badImage(pr, "Bad field index");
+        case DBF_STRING:
+            data = getString(pr, &len);
+            if (!data || len >= (size_t) pflddes->size)
+                return badImage(pr, "Bad string field");
+            memset(pfield, 0, pflddes->size);
+            memcpy(pfield, data, len);
+            break;
+        case DBF_INLINK:
+        case DBF_OUTLINK:
+        case DBF_FWDLINK: {
+                DBLINK *plink = (DBLINK *) pfield;
+
+                free(plink->text);
+                plink->text = getStringDup(pr);
+            }
+            break;
+        default:
+            data = getBytes(pr, pflddes->size);
+            if (data)
+                memcpy(pfield, data, pflddes->size);
+        }
+    }
+
+    nInfo = getUInt16(pr);
+    while (nInfo-- && !pr->error) {
+        dbInfoNode *pinfo = dbInfoNodeAlloc(pdbbase);
+
+        pinfo->name = getStringDup(pr);
+        pinfo->string = getStringDup(pr);
+        ellAdd(&precnode->infoList, &pinfo->node);
+    }
+    return pr->error ? badImage(pr, "Truncated record") : 0;
+}
+
+static long getSection(imageReader *pr, DBBASE *pdbbase)
+{
+    dbRecordType *precordType;
+    imageProto proto;
+    epicsUInt32 nNodes;
+    dbRecordNode **paliases = NULL;
+    char **ptargets = NULL;
+    epicsUInt32 nAliases = 0;
+    epicsUInt32 i;
+    long status = 0;
+    char *name;
+
+    name = getStringDup(pr);
+    if (!name)
+        return badImage(pr, "Truncated file");
+    precordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+    while (precordType && strcmp(precordType->name, name) != 0)
+        precordType = (dbRecordType *) ellNext(&precordType->node);
+    free(name);
+    if (!precordType)
+        return badImage(pr, "Unknown record type");
+    status = protoCreate(pdbbase, precordType, &proto);
+    if (status) {
+        protoFree(precordType, &proto);
+        return status;
+    }
+
+    nNodes = getUInt32(pr);
+    for (i = 0; i < nNodes && !status; i++) {
+        int kind = getUInt8(pr);
+        int flags = getUInt8(pr);
+        dbRecordNode *precnode;
+
+        if (pr->error) {
+            status = badImage(pr, "Truncated file");
+            break;
+        }
+        precnode = dbRecordNodeAlloc(pdbbase);
+        if (kind == IMAGE_RECORD) {
+            status = getRecord(pr, pdbbase, precordType, &proto,
+                precnode);
+            if (status) {
+                recordFree(pdbbase, precordType, &proto, precnode);
+                break;
+            }
+            if (flags & IMAGE_FLAG_VISIBLE)
+                precnode->flags |= DBRN_FLAGS_VISIBLE;
+            if (!dbPvdAdd(pdbbase, precordType, precnode)) {
+                errlogPrintf("dbLoadImage: Record \"%s\" already exists\n",
+                    precnode->recordname);
+                recordFree(pdbbase, precordType, &proto, precnode);
+                status = S_dbLib_recExists;
+                break;
+            }
+            ellAdd(&precordType->recList, &precnode->node);
+        }
+        else if (kind == IMAGE_ALIAS) {
+            /* resolved after the records, which may come later */
+            precnode->recordname = getStringDup(pr);
+            precnode->flags = DBRN_FLAGS_ISALIAS;
+            ellInit(&precnode->infoList);
+            if (!paliases) {
+                paliases = dbCalloc(nNodes, sizeof(dbRecordNode *));
+                ptargets = dbCalloc(nNodes, sizeof(char *));
+            }
+            paliases[nAliases] = precnode;
+            ptargets[nAliases++] = getStringDup(pr);
+            if (pr->error) {
+                status = badImage(pr, "Truncated file");
+                break;
+            }
+            ellAdd(&precordType->recList, &precnode->node);
+        }
+        else {
+            dbRecordNodeFree(pdbbase, precnode);
+            status = badImage(pr, "Bad record entry");
+        }
+    }
+
+    for (i = 0; i < nAliases; i++) {
+        dbRecordNode *palias = paliases[i];
+        PVDENTRY *ppvd = status ? NULL :
+            dbPvdFind(pdbbase, ptargets[i], strlen(ptargets[i]));
+
+        if (!status && (!ppvd || ppvd->precordType != precordType)) {
+            errlogPrintf("dbLoadImage: Alias \"%s\" refers to unknown "
+                "record \"%s\"\n", palias->recordname, ptargets[i]);
+            status = S_dbLib_recNotFound;
+        }
+        if (!status) {
+            dbRecordNode *precnode = ppvd->precnode;
+
+            while (precnode->flags & DBRN_FLAGS_ISALIAS)
+                precnode = precnode->aliasedRecnode;
+            palias->precord = precnode->precord;
+            palias->aliasedRecnode = precnode;
+            precnode->flags |= DBRN_FLAGS_HASALIAS;
+            if (dbPvdAdd(pdbbase, precordType, palias)) {
+                precordType->no_aliases++;
+                palias = NULL;
+            }
+            else {
+                errlogPrintf("dbLoadImage: Record \"%s\" already exists\n",
+                    palias->recordname);
+                status = S_dbLib_recExists;
+            }
+        }
+        if (palias) {
+            ellDelete(&precordType->recList, &palias->node);
+            free(palias->recordname);
+            dbRecordNodeFree(pdbbase, palias);
+        }
+        free(ptargets[i]);
+    }
+    free(paliases);
+    free(ptargets);
+    protoFree(precordType, &proto);
+    return status;
+}
+
+long dbImageRead(DBBASE *pdbbase, const char *filename)
+{
+    imageReader reader;
+    imageHeader header;
+    FILE *fp;
+    char *buffer;
+    long size;
+    long status = 0;
+    epicsUInt32 i;
+
+    if (!pdbbase)
+        return S_dbLib_recordTypeNotFound;
+    reader.filename = filename;
+    fp = fopen(filename, "rb");
+    if (!fp) {
+        errPrintf(0, __FILE__, __LINE__, "dbLoadImage opening file %s: %s",
+            filename, strerror(errno));
+        return S_dbLib_badImage;
+    }
+
+    /* The whole image is read with one call and decoded in place */
+    if (fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 ||
+        fseek(fp, 0, SEEK_SET)) {
+        fclose(fp);
+        return badImage(&reader, "Can't determine size");
+    }
+    buffer = malloc(size ? size : 1);
+    if (!buffer) {
+        fclose(fp);
+        return S_dbLib_outMem;
+    }
+    if (fread(buffer, 1, size, fp) != (size_t) size) {
+        free(buffer);
+        fclose(fp);
+        return badImage(&reader, "Read error");
+    }
+    fclose(fp);
+
+    reader.pos = buffer;
+    reader.end = buffer + size;
+    reader.error = 0;
+
+    if (size < (long) sizeof(header)) {
+        status = badImage(&reader, "Not a database image");
+        goto done;
+    }
+    memcpy(&header, getBytes(&reader, sizeof(header)), sizeof(header));
+    if (memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0) {
+        status = badImage(&reader, "Not a database image");
+    }
+    else if (header.byteOrder != IMAGE_BYTE_ORDER ||
+        header.version != IMAGE_VERSION) {
+        status = badImage(&reader,
+            "Image version or byte order not supported");
+    }
+    else if (header.checksum != dbImageChecksum(pdbbase)) {
+        errlogPrintf("dbLoadImage: '%s' was made with different DBD files "
+            "(checksum %08x, running DBD %08x)\n", filename,
+            (unsigned) header.checksum, (unsigned) dbImageChecksum(pdbbase));
+        status = S_dbLib_badImage;
+    }
+
+    if (!status)
+        dbPvdReserve(pdbbase, header.nNodes);
+    for (i = 0; i < header.nSections && !status; i++)
+        status = getSection(&reader, pdbbase);
+
+done:
+    free(buffer);
+    return status;
+}
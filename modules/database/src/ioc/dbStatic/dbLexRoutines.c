@@ -12,16 +12,21 @@
 /*The routines in this module are serially reusable NOT reentrant*/
 
 #include <ctype.h>
+#include <errno.h>
 #include <epicsStdlib.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "cantProceed.h"
 #include "dbDefs.h"
 #include "dbmf.h"
 #include "ellLib.h"
+#include "epicsEvent.h"
 #include "epicsPrint.h"
 #include "epicsString.h"
+#include "epicsThread.h"
+#include "epicsThreadPool.h"
 #include "errMdef.h"
 #include "freeList.h"
 #include "gpHash.h"
@@ -102,7 +107,50 @@ typedef struct inputFile{
 	char		*filename;
 	FILE		*fp;
 	int		line_num;
+	char		*text;		/* lines prepared by a read-ahead job */
+	char		*text_next;
+	char		*text_end;
 }inputFile;
+
+/* A file to be read by dbReadAhead, see dbStaticLib.h
+ *
+ * Jobs read and macro expand the file's lines into text, which holds a
+ * sequence of entries each consisting of a kind character followed by a
+ * nul-terminated line. READ_AHEAD_RAW lines contain undefined macros and
+ * are expanded again by the parser so its warnings appear in order.
+ */
+#define READ_AHEAD_EXPANDED 'E'
+#define READ_AHEAD_RAW 'R'
+
+typedef struct readAheadItem{
+	ELLNODE		node;
+	struct dbReadAhead *pahead;
+	char		*filename;
+	char		*substitutions;
+	char		*expanded;	/* filename after macEnvExpand() */
+	char		*path;
+	int		found;
+	int		openErrno;
+	char		*text;
+	size_t		len;
+	size_t		size;
+	epicsEventId	done;
+	epicsJob	*job;
+}readAheadItem;
+
+struct dbReadAhead{
+	DBBASE		**ppdbbase;
+	char		*path;
+	int		fixedPath;	/* path given, not from the environment */
+	DBBASE		pathBase;	/* only holds the path list */
+	epicsThreadPool	*pool;
+	ELLLIST		pending;
+	int		window;
+	int		failed;
+	dbReadAheadCallback callback;
+	void		*arg;
+};
+
 static ELLLIST inputFileList = ELLLIST_INIT;
 
 static inputFile *pinputFileNow = NULL;
@@ -185,18 +233,23 @@ static char *dbOpenFile(DBBASE *pdbbase,const char *filename,FILE **fp)
 }
 
 
+static void closeInputFile(inputFile *pinputFile)
+{
+    if(pinputFile->fp && fclose(pinputFile->fp))
+	errPrintf(0,__FILE__, __LINE__,
+		"Closing file %s",pinputFile->filename);
+    free((void *)pinputFile->text);
+    free((void *)pinputFile->filename);
+    ellDelete(&inputFileList,(ELLNODE *)pinputFile);
+    free((void *)pinputFile);
+}
+
 static void freeInputFileList(void)
 {
     inputFile *pinputFileNow;
 
-    while((pinputFileNow=(inputFile *)ellFirst(&inputFileList))) {
-	if(fclose(pinputFileNow->fp))
-	    errPrintf(0,__FILE__, __LINE__,
-			"Closing file %s",pinputFileNow->filename);
-	free((void *)pinputFileNow->filename);
-	ellDelete(&inputFileList,(ELLNODE *)pinputFileNow);
-	free((void *)pinputFileNow);
-    }
+    while((pinputFileNow=(inputFile *)ellFirst(&inputFileList)))
+	closeInputFile(pinputFileNow);
 }
 
 static
@@ -209,7 +262,7 @@ int cmp_dbRecordNode(const ELLNODE *lhs, const ELLNODE *rhs)
 }
 
 static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
-	const char *path,const char *substitutions)
+	const char *path,const char *substitutions,readAheadItem *pitem)
 {
     long	status;
     inputFile	*pinputFile = NULL;
@@ -252,10 +305,27 @@ static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
         macSuppressWarning(macHandle,dbQuietMacroWarnings);
     }
     pinputFile = dbCalloc(1,sizeof(inputFile));
-    if (filename) {
+    if (pitem) {
+        pinputFile->filename = pitem->expanded;
+        pitem->expanded = NULL;
+        if (!pinputFile->filename || !pitem->found) {
+            errno = pitem->openErrno;
+            errPrintf(0, __FILE__, __LINE__,
+                "dbRead opening file %s",pinputFile->filename);
+            free(pinputFile->filename);
+            free(pinputFile);
+            status = -1;
+            goto cleanup;
+        }
+        pinputFile->path = pitem->path;
+        pinputFile->text = pitem->text;
+        pinputFile->text_next = pitem->text;
+        pinputFile->text_end = pitem->text + pitem->len;
+        pitem->text = NULL;
+    } else if (filename) {
         pinputFile->filename = macEnvExpand(filename);
     }
-    if (!fp) {
+    if (!pitem && !fp) {
         FILE *fp1 = 0;
 
         if (pinputFile->filename)
@@ -269,7 +339,7 @@ static long dbReadCOM(DBBASE **ppdbbase,const char *filename, FILE *fp,
             goto cleanup;
         }
         pinputFile->fp = fp1;
-    } else {
+    } else if (!pitem) {
         pinputFile->fp = fp;
     }
     pinputFile->line_num = 0;
@@ -331,12 +401,219 @@ cleanup:
 
 long dbReadDatabase(DBBASE **ppdbbase,const char *filename,
 	const char *path,const char *substitutions)
-{return (dbReadCOM(ppdbbase,filename,0,path,substitutions));}
+{return (dbReadCOM(ppdbbase,filename,0,path,substitutions,NULL));}
 
 long dbReadDatabaseFP(DBBASE **ppdbbase,FILE *fp,
 	const char *path,const char *substitutions)
-{return (dbReadCOM(ppdbbase,0,fp,path,substitutions));}
+{return (dbReadCOM(ppdbbase,0,fp,path,substitutions,NULL));}
+
+static void readAheadAppend(readAheadItem *pitem, char kind, const char *line)
+{
+    size_t n = strlen(line) + 2;
+
+    if(pitem->len + n > pitem->size) {
+	size_t size = pitem->size ? 2*pitem->size : 4096;
+
+	while(size < pitem->len + n) size *= 2;
+	pitem->text = realloc(pitem->text, size);
+	if(!pitem->text) cantProceed("dbReadAhead: out of memory\n");
+	pitem->size = size;
+    }
+    pitem->text[pitem->len] = kind;
+    strcpy(&pitem->text[pitem->len + 1], line);
+    pitem->len += n;
+}
+
+/* Runs on a pool thread, so may only touch the item and pathBase */
+static void readAheadExpand(readAheadItem *pitem)
+{
+    MAC_HANDLE *handle = NULL;
+    char *raw, *line;
+    FILE *fp;
+
+    if(!pitem->expanded) return;
+    pitem->path = dbOpenFile(&pitem->pahead->pathBase, pitem->expanded, &fp);
+    if(!fp) {
+	pitem->openErrno = errno;
+	return;
+    }
+    pitem->found = TRUE;
+
+    if(pitem->substitutions) {
+	char **macPairs;
+
+	if(macCreateHandle(&handle,NULL) == 0) {
+	    macParseDefns(handle,pitem->substitutions,&macPairs);
+	    if(macPairs == NULL) {
+		macDeleteHandle(handle);
+		handle = NULL;
+	    } else {
+		macInstallMacros(handle,macPairs);
+		free((void *)macPairs);
+		macSuppressWarning(handle,TRUE);
+	    }
+	}
+    }
+
+    raw = dbMalloc(MY_BUFFER_SIZE);
+    line = dbMalloc(MY_BUFFER_SIZE);
+    while(fgets(raw,MY_BUFFER_SIZE,fp)) {
+	if(!handle) {
+	    readAheadAppend(pitem,READ_AHEAD_EXPANDED,raw);
+	} else if(macExpandString(handle,raw,line,MY_BUFFER_SIZE) < 0) {
+	    readAheadAppend(pitem,READ_AHEAD_RAW,raw);
+	} else {
+	    readAheadAppend(pitem,READ_AHEAD_EXPANDED,line);
+	}
+    }
+    /* an empty file still needs a text buffer */
+    if(!pitem->text) pitem->text = dbCalloc(1,1);
+    free(raw);
+    free(line);
+    if(handle) macDeleteHandle(handle);
+    fclose(fp);
+}
+
+static void readAheadJob(void *arg, epicsJobMode mode)
+{
+    readAheadItem *pitem = (readAheadItem *)arg;
+
+    if(mode == epicsJobModeRun)
+	readAheadExpand(pitem);
+    epicsEventMustTrigger(pitem->done);
+}
+
+/* The search path dbReadCOM() uses for a top level file */
+static const char *readAheadSearchPath(const char *path)
+{
+    const char *penv;
+
+    if(path && *path) return path;
+    penv = getenv("EPICS_DB_INCLUDE_PATH");
+    return penv ? penv : ".";
+}
+
+static void readAheadParse(dbReadAhead *pahead)
+{
+    readAheadItem *pitem = (readAheadItem *)ellGet(&pahead->pending);
+    long status;
+
+    epicsEventMustWait(pitem->done);
+    /* The file was opened with the search path from when the read-ahead
+     * started. If EPICS_DB_INCLUDE_PATH has changed since, read it again
+     * with the one in effect now, as dbReadDatabase() would. */
+    if(!pahead->fixedPath &&
+	strcmp(readAheadSearchPath(NULL),pahead->path) != 0)
+	status = dbReadCOM(pahead->ppdbbase,pitem->filename,0,NULL,
+	    pitem->substitutions,NULL);
+    else
+	status = dbReadCOM(pahead->ppdbbase,0,0,pahead->path,
+	    pitem->substitutions,pitem);
+    if(status) pahead->failed = TRUE;
+    if(pahead->callback)
+	pahead->callback(pahead->arg,pitem->filename,pitem->substitutions,
+	    status);
+
+    if(pitem->job) epicsJobDestroy(pitem->job);
+    epicsEventDestroy(pitem->done);
+    free(pitem->filename);
+    free(pitem->substitutions);
+    free(pitem->expanded);
+    free(pitem->text);
+    free(pitem);
+}
+
+dbReadAhead *dbReadAheadCreate(DBBASE **ppdbbase, const char *path,
+    int nThreads, dbReadAheadCallback callback, void *arg)
+{
+    dbReadAhead *pahead = dbCalloc(1,sizeof(dbReadAhead));
+
+    pahead->fixedPath = path && *path;
+    pahead->path = epicsStrDup(readAheadSearchPath(path));
+    dbPath(&pahead->pathBase,pahead->path);
+
+    pahead->ppdbbase = ppdbbase;
+    pahead->callback = callback;
+    pahead->arg = arg;
+    ellInit(&pahead->pending);
+    if(nThreads > 0) {
+	epicsThreadPoolConfig opts;
+
+	epicsThreadPoolConfigDefaults(&opts);
+	opts.initialThreads = nThreads;
+	opts.maxThreads = nThreads;
+	opts.workerPriority = epicsThreadGetPrioritySelf();
+	pahead->pool = epicsThreadPoolCreate(&opts);
+	if(!pahead->pool)
+	    epicsPrintf("dbReadAheadCreate: no thread pool, reading serially\n");
+    }
+    /* enough files in flight to keep all of the threads busy */
+    pahead->window = 4*(nThreads > 0 ? nThreads : 1);
+    return pahead;
+}
+
+long dbReadAheadAdd(dbReadAhead *pahead, const char *filename,
+    const char *substitutions)
+{
+    readAheadItem *pitem;
+
+    if(!pahead || !filename) return -1;
+    pitem = dbCalloc(1,sizeof(readAheadItem));
+    pitem->pahead = pahead;
+    pitem->filename = epicsStrDup(filename);
+    if(substitutions)
+	pitem->substitutions = epicsStrDup(substitutions);
+    pitem->expanded = macEnvExpand(filename);
+    pitem->done = epicsEventMustCreate(epicsEventEmpty);
+    ellAdd(&pahead->pending,&pitem->node);
+
+    if(pahead->pool)
+	pitem->job = epicsJobCreate(pahead->pool,readAheadJob,pitem);
+    if(!pitem->job || epicsJobQueue(pitem->job))
+	readAheadJob(pitem,epicsJobModeRun);
+
+    while(ellCount(&pahead->pending) > pahead->window)
+	readAheadParse(pahead);
+    return 0;
+}
+
+long dbReadAheadFinish(dbReadAhead *pahead)
+{
+    long status;
+
+    if(!pahead) return -1;
+    while(ellCount(&pahead->pending))
+	readAheadParse(pahead);
+    if(pahead->pool)
+	epicsThreadPoolDestroy(pahead->pool);
+    dbFreePath(&pahead->pathBase);
+    status = pahead->failed ? -1 : 0;
+    free(pahead->path);
+    free(pahead);
+    return status;
+}
 
+static char *readAheadLine(inputFile *pinputFile)
+{
+    char kind;
+    char *line;
+
+    if(pinputFile->text_next >= pinputFile->text_end) return NULL;
+    kind = *pinputFile->text_next++;
+    line = pinputFile->text_next;
+    pinputFile->text_next += strlen(line) + 1;
+    if(kind == READ_AHEAD_RAW && macHandle) {
+	int exp = macExpandString(macHandle,line,my_buffer,MY_BUFFER_SIZE);
+	if (exp < 0) {
+	    fprintf(stderr, "Warning: '%s' line %d has undefined macros\n",
+		pinputFile->filename, pinputFile->line_num+1);
+	}
+    } else {
+	strcpy(my_buffer, line);
+    }
+    return my_buffer;
+}
+
 static int db_yyinput(char *buf, int max_size)
 {
     size_t  l,n;
@@ -345,7 +622,9 @@ static int db_yyinput(char *buf, int max_size)
     if(yyAbort) return(0);
     if(*my_buffer_ptr==0) {
 	while(TRUE) { /*until we get some input*/
-	    if(macHandle) {
+	    if(pinputFileNow->text) {
+		fgetsRtn = readAheadLine(pinputFileNow);
+	    } else if(macHandle) {
 		fgetsRtn = fgets(mac_input_buffer,MY_BUFFER_SIZE,
 			pinputFileNow->fp);
 		if(fgetsRtn) {
@@ -360,12 +639,7 @@ static int db_yyinput(char *buf, int max_size)
 		fgetsRtn = fgets(my_buffer,MY_BUFFER_SIZE,pinputFileNow->fp);
 	    }
 	    if(fgetsRtn) break;
-	    if(fclose(pinputFileNow->fp))
-		errPrintf(0,__FILE__, __LINE__,
-			"Closing file %s",pinputFileNow->filename);
-	    free((void *)pinputFileNow->filename);
-	    ellDelete(&inputFileList,(ELLNODE *)pinputFileNow);
-	    free((void *)pinputFileNow);
+	    closeInputFile(pinputFileNow);
 	    pinputFileNow = (inputFile *)ellLast(&inputFileList);
 	    if(!pinputFileNow) return(0);
 	}
@@ -754,6 +1028,7 @@ static void dbRecordtypeBody(void)
 	    }
 	}
     }
+    dbRecordTypeHashFields(pdbRecordType);
     /*Initialize lists*/
     ellInit(&pdbRecordType->attributeList);
     ellInit(&pdbRecordType->recList);
@@ -19,29 +19,43 @@
 #include "epicsMutex.h"
 #include "epicsStdio.h"
 #include "epicsString.h"
+#include "freeList.h"
 
 #define epicsExportSharedSymbols
 #include "dbBase.h"
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 
-typedef struct {
-    ELLLIST      list;
-    epicsMutexId lock;
-} dbPvdBucket;
+/* The table grows as records are added. Each bucket is protected by one
+ * of NLOCKS mutexes selected by the low bits of the name's hash, which
+ * don't depend on the current table size. Growing the table takes all
+ * of the locks, so the buckets and mask only need to be read after one
+ * of them has been taken.
+ */
+#define NLOCKS 256
 
 typedef struct dbPvd {
     unsigned int size;
     unsigned int mask;
-    dbPvdBucket **buckets;
+    unsigned int count;
+    ELLLIST *buckets;
+    epicsMutexId locks[NLOCKS];
+    void *entryFreeList;    /* PVDENTRYs, set by the first dbPvdAdd() */
 } dbPvd;
 
+/* entryFreeList when dbRecordArenaSize was 0 */
+static char noFreeList;
+
 unsigned int dbPvdHashTableSize = 0;
 
 #define MIN_SIZE 256
 #define DEFAULT_SIZE 512
 #define MAX_SIZE 65536
 
+/* Average chain length which triggers growth, and the largest table */
+#define GROW_LOAD 4
+#define GROW_MAX_SIZE (1u << 22)
+
 
 int dbPvdTableSize(int size)
 {
@@ -63,6 +77,7 @@ int dbPvdTableSize(int size)
 void dbPvdInitPvt(dbBase *pdbbase)
 {
     dbPvd *ppvd;
+    int i;
 
     if (pdbbase->ppvd) return;
 
@@ -70,26 +85,70 @@ void dbPvdInitPvt(dbBase *pdbbase)
         dbPvdHashTableSize = DEFAULT_SIZE;
     }
 
-    ppvd = (dbPvd *)dbMalloc(sizeof(dbPvd));
+    ppvd = (dbPvd *)dbCalloc(1, sizeof(dbPvd));
     ppvd->size    = dbPvdHashTableSize;
     ppvd->mask    = dbPvdHashTableSize - 1;
-    ppvd->buckets = dbCalloc(ppvd->size, sizeof(dbPvdBucket *));
+    ppvd->buckets = dbCalloc(ppvd->size, sizeof(ELLLIST));
+    for (i = 0; i < NLOCKS; i++)
+        ppvd->locks[i] = epicsMutexMustCreate();
 
     pdbbase->ppvd = ppvd;
     return;
 }
 
+static void dbPvdGrow(dbPvd *ppvd, unsigned int size)
+{
+    ELLLIST *buckets;
+    unsigned int h;
+    int i;
+
+    buckets = calloc(size, sizeof(ELLLIST));
+    if (!buckets) return;   /* keep using the current table */
+
+    for (i = 0; i < NLOCKS; i++)
+        epicsMutexMustLock(ppvd->locks[i]);
+    for (h = 0; h < ppvd->size; h++) {
+        PVDENTRY *ppvdNode;
+
+        while ((ppvdNode = (PVDENTRY *) ellGet(&ppvd->buckets[h]))) {
+            unsigned int hash = epicsStrHash(ppvdNode->precnode->recordname, 0);
+
+            ellAdd(&buckets[hash & (size - 1)], (ELLNODE *)ppvdNode);
+        }
+    }
+    free(ppvd->buckets);
+    ppvd->buckets = buckets;
+    ppvd->size = size;
+    ppvd->mask = size - 1;
+    for (i = NLOCKS - 1; i >= 0; i--)
+        epicsMutexUnlock(ppvd->locks[i]);
+}
+
+/* Make room for count more records without any chains getting long */
+void dbPvdReserve(dbBase *pdbbase, size_t count)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+    unsigned int size = ppvd->size;
+
+    count += ppvd->count;
+    while (size < count && size < GROW_MAX_SIZE)
+        size *= 2;
+    if (size > ppvd->size)
+        dbPvdGrow(ppvd, size);
+}
+
 PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
+    epicsMutexId lock;
     PVDENTRY *ppvdNode;
-    
-    pbucket = ppvd->buckets[epicsMemHash(name, lenName, 0) & ppvd->mask];
-    if (pbucket == NULL) return NULL;
+    unsigned int h;
+
+    h = epicsMemHash(name, lenName, 0);
+    lock = ppvd->locks[h & (NLOCKS - 1)];
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
+    epicsMutexMustLock(lock);
+    ppvdNode = (PVDENTRY *) ellFirst(&ppvd->buckets[h & ppvd->mask]);
     while (ppvdNode) {
         const char *recordname = ppvdNode->precnode->recordname;
 
@@ -98,68 +157,97 @@ PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
             break;
         ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
     }
-    epicsMutexUnlock(pbucket->lock);
+    epicsMutexUnlock(lock);
     return ppvdNode;
 }
-
+
 PVDENTRY *dbPvdAdd(dbBase *pdbbase, dbRecordType *precordType,
     dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
+    epicsMutexId lock;
+    ELLLIST *pbucket;
     PVDENTRY *ppvdNode;
     char *name = precnode->recordname;
     unsigned int h;
+    int grow;
 
-    h = epicsStrHash(name, 0) & ppvd->mask;
-    pbucket = ppvd->buckets[h];
-    if (pbucket == NULL) {
-        pbucket = dbCalloc(1, sizeof(dbPvdBucket));
-        ellInit(&pbucket->list);
-        pbucket->lock = epicsMutexCreate();
-        ppvd->buckets[h] = pbucket;
-    }
+    h = epicsStrHash(name, 0);
+    lock = ppvd->locks[h & (NLOCKS - 1)];
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
+    epicsMutexMustLock(lock);
+    pbucket = &ppvd->buckets[h & ppvd->mask];
+    ppvdNode = (PVDENTRY *) ellFirst(pbucket);
     while (ppvdNode) {
         if (strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            epicsMutexUnlock(pbucket->lock);
+            epicsMutexUnlock(lock);
             return NULL;
         }
         ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
     }
-    ppvdNode = dbCalloc(1, sizeof(PVDENTRY));
+    if (!ppvd->entryFreeList) {
+        if (dbRecordArenaSize > 0)
+            freeListInitPvt(&ppvd->entryFreeList, sizeof(PVDENTRY),
+                dbRecordArenaSize / sizeof(PVDENTRY) + 1);
+        else
+            ppvd->entryFreeList = &noFreeList;
+    }
+    if (ppvd->entryFreeList != &noFreeList) {
+        ppvdNode = freeListMalloc(ppvd->entryFreeList);
+        if (!ppvdNode)
+            cantProceed("dbPvdAdd: Out of memory\n");
+    }
+    else
+        ppvdNode = dbMalloc(sizeof(PVDENTRY));
     ppvdNode->precordType = precordType;
     ppvdNode->precnode = precnode;
-    ellAdd(&pbucket->list, (ELLNODE *)ppvdNode);
-    epicsMutexUnlock(pbucket->lock);
+    ellAdd(pbucket, (ELLNODE *)ppvdNode);
+    epicsMutexUnlock(lock);
+
+    /* Records are only added by one thread at a time */
+    ppvd->count++;
+    grow = ppvd->count > GROW_LOAD * ppvd->size &&
+        ppvd->size < GROW_MAX_SIZE;
+    if (grow)
+        dbPvdGrow(ppvd, ppvd->size * 2);
     return ppvdNode;
 }
 
+static void entryFree(dbPvd *ppvd, PVDENTRY *ppvdNode)
+{
+    if (ppvd->entryFreeList != &noFreeList)
+        freeListFree(ppvd->entryFreeList, ppvdNode);
+    else
+        free(ppvdNode);
+}
+
 void dbPvdDelete(dbBase *pdbbase, dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
+    epicsMutexId lock;
+    ELLLIST *pbucket;
     PVDENTRY *ppvdNode;
     char *name = precnode->recordname;
+    unsigned int h;
 
-    pbucket = ppvd->buckets[epicsStrHash(name, 0) & ppvd->mask];
-    if (pbucket == NULL) return;
+    h = epicsStrHash(name, 0);
+    lock = ppvd->locks[h & (NLOCKS - 1)];
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
+    epicsMutexMustLock(lock);
+    pbucket = &ppvd->buckets[h & ppvd->mask];
+    ppvdNode = (PVDENTRY *) ellFirst(pbucket);
     while (ppvdNode) {
         if (ppvdNode->precnode &&
             ppvdNode->precnode->recordname &&
             strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
-            free(ppvdNode);
+            ellDelete(pbucket, (ELLNODE *)ppvdNode);
+            entryFree(ppvd, ppvdNode);
+            ppvd->count--;
             break;
         }
         ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
     }
-    epicsMutexUnlock(pbucket->lock);
+    epicsMutexUnlock(lock);
     return;
 }
 
@@ -167,25 +255,23 @@ void dbPvdFreeMem(dbBase *pdbbase)
 {
     dbPvd *ppvd = pdbbase->ppvd;
     unsigned int h;
+    int i;
 
     if (ppvd == NULL) return;
     pdbbase->ppvd = NULL;
 
     for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
         PVDENTRY *ppvdNode;
 
-        if (pbucket == NULL) continue;
-        epicsMutexMustLock(pbucket->lock);
-        ppvd->buckets[h] = NULL;
-        while ((ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list))) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
+        if (ppvd->entryFreeList != &noFreeList)
+            break;
+        while ((ppvdNode = (PVDENTRY *) ellGet(&ppvd->buckets[h])))
             free(ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
-        epicsMutexDestroy(pbucket->lock);
-        free(pbucket);
     }
+    if (ppvd->entryFreeList && ppvd->entryFreeList != &noFreeList)
+        freeListCleanup(ppvd->entryFreeList);
+    for (i = 0; i < NLOCKS; i++)
+        epicsMutexDestroy(ppvd->locks[i]);
     free(ppvd->buckets);
     free(ppvd);
 }
@@ -203,27 +289,31 @@ void dbPvdDump(dbBase *pdbbase, int verbose)
     ppvd = pdbbase->ppvd;
     if (ppvd == NULL) return;
 
-    printf("Process Variable Directory has %u buckets", ppvd->size);
+    printf("Process Variable Directory has %u entries in %u buckets",
+        ppvd->count, ppvd->size);
 
     for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
+        epicsMutexId lock = ppvd->locks[h & (NLOCKS - 1)];
+        ELLLIST *pbucket;
         PVDENTRY *ppvdNode;
         int i = 1;
 
-        if (pbucket == NULL) {
+        epicsMutexMustLock(lock);
+        pbucket = &ppvd->buckets[h];
+        if (ellCount(pbucket) == 0) {
+            epicsMutexUnlock(lock);
             empty++;
             continue;
         }
-        epicsMutexMustLock(pbucket->lock);
-        ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-        printf("\n [%4u] %4d  ", h, ellCount(&pbucket->list));
+        ppvdNode = (PVDENTRY *) ellFirst(pbucket);
+        printf("\n [%4u] %4d  ", h, ellCount(pbucket));
         while (ppvdNode && verbose) {
             if (!(++i % 4))
                 printf("\n         ");
             printf("  %s", ppvdNode->precnode->recordname);
             ppvdNode = (PVDENTRY *) ellNext((ELLNODE*)ppvdNode);
         }
-        epicsMutexUnlock(pbucket->lock);
+        epicsMutexUnlock(lock);
     }
     printf("\n%u buckets empty.\n", empty);
 }
@@ -26,6 +26,7 @@
 #include "epicsStdlib.h"
 #include "epicsString.h"
 #include "errlog.h"
+#include "freeList.h"
 #include "gpHash.h"
 #include "osiFileName.h"
 #include "postfix.h"
@@ -83,6 +84,7 @@ epicsShareDef maplinkType pamaplinkType[LINK_NTYPES] = {
 static void dbMsgPrint(DBENTRY *pdbentry, const char *fmt, ...)
     EPICS_PRINTF_STYLE(2,3);
 static long dbAddOnePath (DBBASE *pdbbase, const char *path, unsigned length);
+static void deleteAliasNodes(DBENTRY *pdbentry, dbRecordType *pdbRecordType);
 
 /* internal routines*/
 static FILE *openOutstream(const char *filename)
@@ -416,6 +418,66 @@ dbBase * dbAllocBase(void)
     dbPvdInitPvt(pdbbase);
     return (pdbbase);
 }
+
+/* Node freeList of a dbBase which allocates each node separately */
+static char noFreeList;
+
+/* Like dbRecordStorageAlloc() the first node decides, so that
+ * dbRecordArenaSize can still be set after the DBD files are loaded.
+ */
+static void * nodeAlloc(void **pfreeList, size_t size, const char *name)
+{
+    void *pnode;
+
+    if (!*pfreeList) {
+        if (dbRecordArenaSize > 0)
+            freeListInitPvt(pfreeList, size, dbRecordArenaSize / size + 1);
+        else
+            *pfreeList = &noFreeList;
+    }
+    if (*pfreeList == &noFreeList)
+        return dbCalloc(1, size);
+    pnode = freeListCalloc(*pfreeList);
+    if (!pnode)
+        cantProceed("%s: Out of memory\n", name);
+    return pnode;
+}
+
+static void nodeFree(void *freeList, void *pnode)
+{
+    if (!freeList || freeList == &noFreeList)
+        free(pnode);
+    else
+        freeListFree(freeList, pnode);
+}
+
+static void nodeCleanup(void *freeList)
+{
+    if (freeList && freeList != &noFreeList)
+        freeListCleanup(freeList);
+}
+
+dbRecordNode *dbRecordNodeAlloc(DBBASE *pdbbase)
+{
+    return nodeAlloc(&pdbbase->recnodeFreeList, sizeof(dbRecordNode),
+        "dbRecordNodeAlloc");
+}
+
+void dbRecordNodeFree(DBBASE *pdbbase, dbRecordNode *precnode)
+{
+    nodeFree(pdbbase->recnodeFreeList, precnode);
+}
+
+dbInfoNode *dbInfoNodeAlloc(DBBASE *pdbbase)
+{
+    return nodeAlloc(&pdbbase->infoFreeList, sizeof(dbInfoNode),
+        "dbInfoNodeAlloc");
+}
+
+void dbInfoNodeFree(DBBASE *pdbbase, dbInfoNode *pinfo)
+{
+    nodeFree(pdbbase->infoFreeList, pinfo);
+}
 void dbFreeBase(dbBase *pdbbase)
 {
     dbMenu		*pdbMenu;
@@ -447,6 +509,7 @@ void dbFreeBase(dbBase *pdbbase)
     dbInitEntry(pdbbase,&dbentry);
     status = dbFirstRecordType(&dbentry);
     while(!status) {
+        deleteAliasNodes(&dbentry, dbentry.precordType);
         /* dbDeleteRecord() will remove alias or real record node.
          * For real record nodes, also removes the nodes of all aliases.
          * This complicates safe traversal, so we re-start iteration
@@ -511,7 +574,10 @@ void dbFreeBase(dbBase *pdbbase)
         free((void *)pdbRecordType->link_ind);
         free((void *)pdbRecordType->papsortFldName);
         free((void *)pdbRecordType->sortFldInd);
+        free((void *)pdbRecordType->fieldHash);
+        free((void *)pdbRecordType->fieldHashSeed);
         free((void *)pdbRecordType->papFldDes);
+        dbRecordStorageCleanup(pdbRecordType);
         free((void *)pdbRecordType);
         pdbRecordType = pdbRecordTypeNext;
     }
@@ -599,6 +665,8 @@ void dbFreeBase(dbBase *pdbbase)
     gphFreeMem(pdbbase->pgpHash);
     dbPvdFreeMem(pdbbase);
     dbFreePath(pdbbase);
+    nodeCleanup(pdbbase->recnodeFreeList);
+    nodeCleanup(pdbbase->infoFreeList);
     free((void *)pdbbase);
     pdbbase = NULL;
     return;
@@ -1427,7 +1495,7 @@ long dbCreateRecord(DBENTRY *pdbentry,const char *precordName)
     pdbentry->precordType = precordType;
     preclist = &precordType->recList;
     /* create a recNode */
-    pNewRecNode = dbCalloc(1,sizeof(dbRecordNode));
+    pNewRecNode = dbRecordNodeAlloc(pdbentry->pdbbase);
     /* create a new record of this record type */
     pdbentry->precnode = pNewRecNode;
     if((status = dbAllocRecord(pdbentry,precordName))) return(status);
@@ -1494,11 +1562,30 @@ long dbDeleteRecord(DBENTRY *pdbentry)
         status = dbFreeRecord(pdbentry);
         if (status) return status;
     }
-    free(precnode);
+    dbRecordNodeFree(pdbbase, precnode);
     pdbentry->precnode = NULL;
     return 0;
 }
 
+/* Deleting a record searches the whole list for its aliases, so when
+ * deleting all of the records the aliases are removed first.
+ */
+static void deleteAliasNodes(DBENTRY *pdbentry, dbRecordType *pdbRecordType)
+{
+    dbRecordNode *pdbRecordNode;
+    dbRecordNode *pdbRecordNodeNext;
+
+    pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+    while(pdbRecordNode) {
+	pdbRecordNodeNext = (dbRecordNode *)ellNext(&pdbRecordNode->node);
+	if(!(pdbRecordNode->flags & DBRN_FLAGS_ISALIAS))
+	    pdbRecordNode->flags &= ~DBRN_FLAGS_HASALIAS;
+	else if(!dbFindRecord(pdbentry,pdbRecordNode->recordname))
+	    dbDeleteRecord(pdbentry);
+	pdbRecordNode = pdbRecordNodeNext;
+    }
+}
+
 long dbFreeRecords(DBBASE *pdbbase)
 {
     DBENTRY		dbentry;
@@ -1509,6 +1596,7 @@ long dbFreeRecords(DBBASE *pdbbase)
     dbInitEntry(pdbbase,&dbentry);
     pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
     while(pdbRecordType) {
+	deleteAliasNodes(&dbentry,pdbRecordType);
 	pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
 	while(pdbRecordNode) {
 	    pdbRecordNodeNext = (dbRecordNode *)ellNext(&pdbRecordNode->node);
@@ -1660,7 +1748,7 @@ long dbCreateAlias(DBENTRY *pdbentry, const char *alias)
         return S_dbLib_recExists;
     dbFinishEntry(&tempEntry);
 
-    pnewnode = dbCalloc(1, sizeof(dbRecordNode));
+    pnewnode = dbRecordNodeAlloc(pdbentry->pdbbase);
     pnewnode->recordname = epicsStrDup(alias);
     pnewnode->precord = precnode->precord;
     pnewnode->aliasedRecnode = precnode;
@@ -1751,6 +1839,115 @@ long dbCopyRecord(DBENTRY *pdbentry,const char *newRecordName,int overWriteOK)
     return(dbFindRecord(pdbentry,newRecordName));
 }
 
+/* Seeded FNV-1a. The multiply makes collisions depend on the seed, which
+ * epicsMemHash() can't do as its seed only XORs a constant into the result.
+ */
+static unsigned int fieldNameHash(const char *name, size_t len,
+    unsigned int seed)
+{
+    unsigned int hash = 2166136261u ^ seed;
+
+    while (len--) {
+        hash ^= (unsigned char) *name++;
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+/* Hash and displace: the seed-0 hash of a name picks a bucket, and each
+ * bucket has its own seed, found here, which sends the names in it to
+ * free slots of the table. Fullest buckets are placed first.
+ */
+static int fieldHashPlace(dbRecordType *pdbRecordType, short *table,
+    unsigned short *seeds, unsigned int mask, unsigned int bucketMask)
+{
+    int no_fields = pdbRecordType->no_fields;
+    unsigned int *bucket = dbCalloc(no_fields, sizeof(unsigned int));
+    unsigned int *count = dbCalloc(bucketMask + 1, sizeof(unsigned int));
+    short *members = dbCalloc(no_fields, sizeof(short));
+    unsigned int *slots = dbCalloc(no_fields, sizeof(unsigned int));
+    unsigned int b, c, maxCount = 0;
+    int i, ok = 1;
+
+    for (i = 0; i < no_fields; i++) {
+        const char *name = pdbRecordType->papFldDes[i]->name;
+
+        bucket[i] = fieldNameHash(name, strlen(name), 0) & bucketMask;
+        if (++count[bucket[i]] > maxCount)
+            maxCount = count[bucket[i]];
+    }
+    memset(table, 0xff, (mask + 1) * sizeof(short));
+    for (c = maxCount; ok && c > 0; c--) {
+        for (b = 0; ok && b <= bucketMask; b++) {
+            unsigned int seed;
+            int n = 0;
+
+            if (count[b] != c) continue;
+            for (i = 0; i < no_fields; i++)
+                if (bucket[i] == b)
+                    members[n++] = i;
+            for (seed = 1; seed <= USHRT_MAX; seed++) {
+                int j, k;
+
+                for (j = 0; j < n; j++) {
+                    const char *name =
+                        pdbRecordType->papFldDes[members[j]]->name;
+
+                    slots[j] = fieldNameHash(name, strlen(name), seed) & mask;
+                    if (table[slots[j]] >= 0) break;
+                    for (k = 0; k < j; k++)
+                        if (slots[k] == slots[j]) break;
+                    if (k < j) break;
+                }
+                if (j == n) break;
+            }
+            if (seed > USHRT_MAX) {
+                ok = 0;
+                break;
+            }
+            for (i = 0; i < n; i++)
+                table[slots[i]] = members[i];
+            seeds[b] = seed;
+        }
+    }
+    free(bucket);
+    free(count);
+    free(members);
+    free(slots);
+    return ok;
+}
+
+void dbRecordTypeHashFields(dbRecordType *pdbRecordType)
+{
+    int no_fields = pdbRecordType->no_fields;
+    unsigned int size = 4, buckets = 1;
+    short *table;
+    unsigned short *seeds;
+
+    if (no_fields <= 0) return;
+    while (size < 2u * no_fields)
+        size <<= 1;
+    while (2 * buckets < (unsigned int) no_fields)
+        buckets <<= 1;
+    /* a bigger table only if placement fails, e.g. for duplicate names */
+    for (; size <= 8u * no_fields; size <<= 1) {
+        table = dbCalloc(size, sizeof(short));
+        seeds = dbCalloc(buckets, sizeof(unsigned short));
+        if (fieldHashPlace(pdbRecordType, table, seeds, size - 1,
+                buckets - 1)) {
+            free((void *)pdbRecordType->fieldHash);
+            free((void *)pdbRecordType->fieldHashSeed);
+            pdbRecordType->fieldHash = table;
+            pdbRecordType->fieldHashSeed = seeds;
+            pdbRecordType->fieldHashMask = size - 1;
+            pdbRecordType->fieldBucketMask = buckets - 1;
+            return;
+        }
+        free((void *)table);
+        free((void *)seeds);
+    }
+}
+
 long dbFindFieldPart(DBENTRY *pdbentry,const char **ppname)
 {
     dbRecordType *precordType = pdbentry->precordType;
@@ -1787,6 +1984,27 @@ long dbFindFieldPart(DBENTRY *pdbentry,const char **ppname)
         return dbGetFieldAddress(pdbentry);
     }
 
+    /* one probe of the perfect hash decides it */
+    if (precordType->fieldHash) {
+        unsigned int bucket = fieldNameHash(pname, nameLen, 0) &
+            precordType->fieldBucketMask;
+        unsigned int hash = fieldNameHash(pname, nameLen,
+            precordType->fieldHashSeed[bucket]) & precordType->fieldHashMask;
+        short ind = precordType->fieldHash[hash];
+        dbFldDes *pflddes;
+
+        if (ind < 0)
+            return S_dbLib_fieldNotFound;
+        pflddes = precordType->papFldDes[ind];
+        if (strncmp(pflddes->name, pname, nameLen) != 0 ||
+            pflddes->name[nameLen] != '\0')
+            return S_dbLib_fieldNotFound;
+        pdbentry->pflddes = pflddes;
+        pdbentry->indfield = ind;
+        *ppname = &pname[nameLen];
+        return dbGetFieldAddress(pdbentry);
+    }
+
     /* binary search through ordered field names */
     top = precordType->no_fields - 1;
     bottom = 0;
@@ -2885,7 +3103,7 @@ long dbDeleteInfo(DBENTRY *pdbentry)
     ellDelete(&precnode->infoList,&pinfo->node);
     free(pinfo->name);
     free(pinfo->string);
-    free(pinfo);
+    dbInfoNodeFree(pdbentry->pdbbase, pinfo);
     pdbentry->pinfonode = NULL;
     return (0);
 }
@@ -2948,18 +3166,17 @@ long dbPutInfo(DBENTRY *pdbentry,const char *name,const char *string)
     if (pinfo) return (dbPutInfoString(pdbentry, string));
 
     /*Create new info node*/
-    pinfo = calloc(1,sizeof(dbInfoNode));
-    if (!pinfo) return (S_dbLib_outMem);
+    pinfo = dbInfoNodeAlloc(pdbentry->pdbbase);
     pinfo->name = calloc(1,1+strlen(name));
     if (!pinfo->name) {
-	free(pinfo);
+	dbInfoNodeFree(pdbentry->pdbbase, pinfo);
 	return (S_dbLib_outMem);
     }
     strcpy(pinfo->name, name);
     pinfo->string = calloc(1,1+strlen(string));
     if (!pinfo->string) {
 	free(pinfo->name);
-	free(pinfo);
+	dbInfoNodeFree(pdbentry->pdbbase, pinfo);
 	return (S_dbLib_outMem);
     }
     strcpy(pinfo->string, string);
@@ -3250,6 +3467,10 @@ void dbDumpRecordType(DBBASE *pdbbase,const char *recordTypeName)
 		i,pdbFldDes->name,
 		pdbRecordType->sortFldInd[i],pdbRecordType->papsortFldName[i]);
 	}
+	if(pdbRecordType->fieldHash)
+	    printf("fieldHash size %u buckets %u\n",
+		pdbRecordType->fieldHashMask + 1,
+		pdbRecordType->fieldBucketMask + 1);
 	printf("link_ind ");
 	for(i=0; i<pdbRecordType->no_links; i++)
 	    printf(" %hd",pdbRecordType->link_ind[i]);
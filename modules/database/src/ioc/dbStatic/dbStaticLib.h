@@ -60,6 +60,32 @@ epicsShareFunc long dbReadDatabase(DBBASE **ppdbbase,
     const char *filename, const char *path, const char *substitutions);
 epicsShareFunc long dbReadDatabaseFP(DBBASE **ppdbbase,
     FILE *fp, const char *path, const char *substitutions);
+
+/* Read ahead of the parser: files added to a dbReadAhead are read and
+ * macro expanded concurrently by nThreads pool threads, then parsed in
+ * the order they were added, with the same results as calling
+ * dbReadDatabase() for each one. As there, each top level file is found
+ * on path, or EPICS_DB_INCLUDE_PATH when path is NULL, and "path" and
+ * "addpath" statements only apply to the includes of the file they are
+ * in. The callback is given the status of each file after it has been
+ * parsed.
+ */
+typedef struct dbReadAhead dbReadAhead;
+typedef void (*dbReadAheadCallback)(void *arg, const char *filename,
+    const char *substitutions, long status);
+epicsShareFunc dbReadAhead * dbReadAheadCreate(DBBASE **ppdbbase,
+    const char *path, int nThreads, dbReadAheadCallback callback, void *arg);
+epicsShareFunc long dbReadAheadAdd(dbReadAhead *pahead,
+    const char *filename, const char *substitutions);
+epicsShareFunc long dbReadAheadFinish(dbReadAhead *pahead);
+
+/* Binary images of the record instances, see dbImage.c. An image can
+ * only be read into an IOC running the DBD files it was written with.
+ */
+epicsShareFunc long dbImageWrite(DBBASE *pdbbase, const char *filename);
+epicsShareFunc long dbImageRead(DBBASE *pdbbase, const char *filename);
+epicsShareFunc epicsUInt32 dbImageChecksum(DBBASE *pdbbase);
+
 epicsShareFunc long dbPath(DBBASE *pdbbase, const char *path);
 epicsShareFunc long dbAddPath(DBBASE *pdbbase, const char *path);
 epicsShareFunc char * dbGetPromptGroupNameFromKey(DBBASE *pdbbase,
@@ -231,6 +257,7 @@ epicsShareFunc void dbCatString(char **string, int *stringLength,
 
 extern int dbStaticDebug;
 extern int dbConvertStrict;
+extern int dbRecordArenaSize;
 
 #define S_dbLib_recordTypeNotFound (M_dbLib|1) /* Record Type does not exist */
 #define S_dbLib_recExists (M_dbLib|3)          /* Record Already exists */
@@ -246,6 +273,7 @@ extern int dbConvertStrict;
 #define S_dbLib_noSizeOffset (M_dbLib|23)      /* Missing SizeOffset Routine - No record support? */
 #define S_dbLib_outMem (M_dbLib|27)            /* Out of memory */
 #define S_dbLib_infoNotFound (M_dbLib|29)      /* Info item Not Found */
+#define S_dbLib_badImage (M_dbLib|31)          /* Bad or incompatible database image */
 
 #ifdef __cplusplus
 }
@@ -30,6 +30,32 @@ int dbIsMacroOk(DBENTRY *pdbentry);
 long dbAllocRecord(DBENTRY *pdbentry,const char *precordName);
 long dbFreeRecord(DBENTRY *pdbentry);
 
+/* Uninitialized storage for one record of a type, its dbCommonPvt
+ * followed by the record itself. Records of the same type come from
+ * blocks released together by dbRecordStorageCleanup().
+ */
+void *dbRecordStorageAlloc(dbRecordType *pdbRecordType);
+void dbRecordStorageFree(dbRecordType *pdbRecordType, void *pstorage);
+void dbRecordStorageCleanup(dbRecordType *pdbRecordType);
+
+/* Move the records of each type into new storage, in the order in which
+ * they will appear on the scan lists. Only safe before iocInit, while
+ * the record nodes and aliases are the only references to the records.
+ */
+void dbRecordStorageScanOrder(DBBASE *pdbbase);
+
+/* Zeroed record and info nodes, from blocks owned by the dbBase */
+dbRecordNode *dbRecordNodeAlloc(DBBASE *pdbbase);
+void dbRecordNodeFree(DBBASE *pdbbase, dbRecordNode *precnode);
+dbInfoNode *dbInfoNodeAlloc(DBBASE *pdbbase);
+void dbInfoNodeFree(DBBASE *pdbbase, dbInfoNode *pinfo);
+
+/* Build the collision-free hash table used by dbFindFieldPart() to map
+ * a field name straight to its index in papFldDes. Leaves fieldHash NULL,
+ * and the lookup falling back to the sorted names, if no table is found.
+ */
+void dbRecordTypeHashFields(dbRecordType *pdbRecordType);
+
 long dbGetFieldAddress(DBENTRY *pdbentry);
 char *dbRecordName(DBENTRY *pdbentry);
 
@@ -103,6 +129,7 @@ void	dbPvdInitPvt(DBBASE *pdbbase);
 PVDENTRY *dbPvdFind(DBBASE *pdbbase,const char *name,size_t lenname);
 PVDENTRY *dbPvdAdd(DBBASE *pdbbase,dbRecordType *precordType,dbRecordNode *precnode);
 void dbPvdDelete(DBBASE *pdbbase,dbRecordNode *precnode);
+void dbPvdReserve(DBBASE *pdbbase,size_t count);
 void dbPvdFreeMem(DBBASE *pdbbase);
 
 #ifdef __cplusplus
@@ -11,10 +11,12 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <math.h>
 
+#include "cantProceed.h"
 #include "cvtFast.h"
 #include "dbDefs.h"
 #include "ellLib.h"
@@ -22,6 +24,7 @@
 #include "epicsStdlib.h"
 #include "epicsTypes.h"
 #include "errMdef.h"
+#include "freeList.h"
 
 #include "epicsExport.h" /* #define epicsExportSharedSymbols */
 #include "dbBase.h"
@@ -29,11 +32,72 @@
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 #include "devSup.h"
+#include "menuScan.h"
 #include "special.h"
 
 epicsShareDef int dbConvertStrict = 0;
 epicsExportAddress(int, dbConvertStrict);
 
+/* The records of each type are allocated from blocks of about this many
+ * bytes, so records loaded together lie next to each other in memory and
+ * are all released at once by dbFreeBase(). Set it to 0 before loading
+ * any records to allocate each one separately.
+ */
+epicsShareDef int dbRecordArenaSize = 65536;
+epicsExportAddress(int, dbRecordArenaSize);
+
+/* recordArena of record types which don't use a freeList */
+static char noArena;
+
+static size_t recordStorageSize(dbRecordType *pdbRecordType)
+{
+    return offsetof(dbCommonPvt, common) + pdbRecordType->rec_size;
+}
+
+void *dbRecordStorageAlloc(dbRecordType *pdbRecordType)
+{
+    size_t size = recordStorageSize(pdbRecordType);
+    void *pstorage;
+
+    if (!pdbRecordType->recordArena) {
+        /* decided by the first record, all others must match */
+        if (dbRecordArenaSize > 0) {
+            int nmalloc = dbRecordArenaSize / size;
+
+            freeListInitPvt(&pdbRecordType->recordArena, size,
+                nmalloc > 1 ? nmalloc : 1);
+        }
+        else
+            pdbRecordType->recordArena = &noArena;
+    }
+    if (pdbRecordType->recordArena == &noArena)
+        return dbMalloc(size);
+
+    pstorage = freeListMalloc(pdbRecordType->recordArena);
+    if (!pstorage)
+        cantProceed("dbRecordStorageAlloc: Out of memory for %s record\n",
+            pdbRecordType->name);
+    return pstorage;
+}
+
+void dbRecordStorageFree(dbRecordType *pdbRecordType, void *pstorage)
+{
+    if (!pstorage)
+        return;
+    if (pdbRecordType->recordArena == &noArena)
+        free(pstorage);
+    else
+        freeListFree(pdbRecordType->recordArena, pstorage);
+}
+
+void dbRecordStorageCleanup(dbRecordType *pdbRecordType)
+{
+    if (pdbRecordType->recordArena &&
+        pdbRecordType->recordArena != &noArena)
+        freeListCleanup(pdbRecordType->recordArena);
+    pdbRecordType->recordArena = NULL;
+}
+
 static long do_nothing(struct dbCommon *precord) { return 0; }
 
 /* Dummy DSXT used for soft device supports */
@@ -66,6 +130,109 @@ void devExtend(dsxt *pdsxt)
     }
 }
 
+typedef struct scanOrderItem {
+    dbRecordNode *precnode;
+    size_t index;
+} scanOrderItem;
+
+/* By scan list, then phase as scanAdd() does, then database order */
+static int compareScanOrder(const void *a, const void *b)
+{
+    const scanOrderItem *pa = (const scanOrderItem *) a;
+    const scanOrderItem *pb = (const scanOrderItem *) b;
+    const dbCommon *ra = (const dbCommon *) pa->precnode->precord;
+    const dbCommon *rb = (const dbCommon *) pb->precnode->precord;
+
+    if (ra->scan != rb->scan)
+        return ra->scan < rb->scan ? -1 : 1;
+    if (ra->prio != rb->prio)
+        return ra->prio < rb->prio ? -1 : 1;
+    if (ra->scan == menuScanEvent) {
+        int cmp = strcmp(ra->evnt, rb->evnt);
+
+        if (cmp)
+            return cmp;
+    }
+    if (ra->phas != rb->phas)
+        return ra->phas < rb->phas ? -1 : 1;
+    return pa->index < pb->index ? -1 : pa->index > pb->index;
+}
+
+static int compareAddress(const void *a, const void *b)
+{
+    const char *pa = *(const char * const *) a;
+    const char *pb = *(const char * const *) b;
+
+    return pa < pb ? -1 : pa > pb;
+}
+
+void dbRecordStorageScanOrder(DBBASE *pdbbase)
+{
+    dbRecordType *pdbRecordType;
+
+    for (pdbRecordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *) ellNext(&pdbRecordType->node)) {
+        size_t size = recordStorageSize(pdbRecordType);
+        int nRecords = ellCount(&pdbRecordType->recList) -
+            pdbRecordType->no_aliases;
+        void *oldArena = pdbRecordType->recordArena;
+        scanOrderItem *items;
+        void **slots;
+        dbRecordNode *precnode;
+        size_t n = 0, i;
+
+        if (nRecords <= 1 || !oldArena)
+            continue;
+
+        items = dbCalloc(nRecords, sizeof(scanOrderItem));
+        for (precnode = (dbRecordNode *) ellFirst(&pdbRecordType->recList);
+             precnode;
+             precnode = (dbRecordNode *) ellNext(&precnode->node)) {
+            if (precnode->flags & DBRN_FLAGS_ISALIAS || !precnode->precord)
+                continue;
+            items[n].precnode = precnode;
+            items[n].index = n;
+            n++;
+        }
+        qsort(items, n, sizeof(scanOrderItem), compareScanOrder);
+
+        /* a single block, filled in ascending address order */
+        pdbRecordType->recordArena = NULL;
+        freeListInitPvt(&pdbRecordType->recordArena, size, n);
+        slots = dbCalloc(n, sizeof(void *));
+        for (i = 0; i < n; i++) {
+            slots[i] = freeListMalloc(pdbRecordType->recordArena);
+            if (!slots[i])
+                cantProceed("dbRecordStorageScanOrder: Out of memory\n");
+        }
+        qsort(slots, n, sizeof(void *), compareAddress);
+        for (i = 0; i < n; i++) {
+            dbCommonPvt *pold = dbRec2Pvt(items[i].precnode->precord);
+            dbCommonPvt *pnew = slots[i];
+
+            memcpy(pnew, pold, size);
+            items[i].precnode->precord = &pnew->common;
+            items[i].precnode->recordname = pnew->common.name;
+            if (oldArena == &noArena)
+                free(pold);
+            else
+                freeListFree(oldArena, pold);
+        }
+        if (oldArena != &noArena)
+            freeListCleanup(oldArena);
+
+        for (precnode = (dbRecordNode *) ellFirst(&pdbRecordType->recList);
+             precnode;
+             precnode = (dbRecordNode *) ellNext(&precnode->node)) {
+            if (precnode->flags & DBRN_FLAGS_ISALIAS)
+                precnode->precord = precnode->aliasedRecnode->precord;
+        }
+        free(slots);
+        free(items);
+    }
+}
+
 long dbAllocRecord(DBENTRY *pdbentry,const char *precordName)
 {
     dbRecordType	*pdbRecordType = pdbentry->precordType;
@@ -89,7 +256,8 @@ long dbAllocRecord(DBENTRY *pdbentry,const char *precordName)
                     precordName, pdbRecordType->name, pdbRecordType->rec_size);
         return(S_dbLib_noRecSup);
     }
-    ppvt = dbCalloc(1, offsetof(dbCommonPvt, common) + pdbRecordType->rec_size);
+    ppvt = dbRecordStorageAlloc(pdbRecordType);
+    memset(ppvt, 0, recordStorageSize(pdbRecordType));
     precord = &ppvt->common;
     ppvt->recnode = precnode;
     precord->rdes = pdbRecordType;
@@ -179,7 +347,8 @@ long dbFreeRecord(DBENTRY *pdbentry)
     if(!pdbRecordType) return(S_dbLib_recordTypeNotFound);
     if(!precnode) return(S_dbLib_recNotFound);
     if(!precnode->precord) return(S_dbLib_recNotFound);
-    free(dbRec2Pvt(precnode->precord));
+    free(dbRec2Pvt(precnode->precord)->profile);
+    dbRecordStorageFree(pdbRecordType, dbRec2Pvt(precnode->precord));
     precnode->precord = NULL;
     return(0);
 }
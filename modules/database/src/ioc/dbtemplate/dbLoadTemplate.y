@@ -18,6 +18,7 @@
 
 #include "epicsExport.h"
 #include "dbAccess.h"
+#include "dbStaticLib.h"
 #include "dbLoadTemplate.h"
 
 static int line_num;
@@ -39,6 +40,30 @@ static int var_count, sub_count;
 int dbTemplateMaxVars = 100;
 epicsExportAddress(int, dbTemplateMaxVars);
 
+/* When non-zero, the database files are read and macro expanded by this
+ * many threads ahead of the parser, see dbReadAheadCreate(). They are
+ * found on the same search path as dbLoadRecords() uses.
+ */
+int dbTemplateLoadThreads = 0;
+epicsExportAddress(int, dbTemplateLoadThreads);
+
+static dbReadAhead *readAhead = NULL;
+
+static void loadedRecords(void *arg, const char *file, const char *subs,
+    long status)
+{
+    if (!status && dbLoadRecordsHook)
+        dbLoadRecordsHook(file, subs);
+}
+
+static void loadRecords(const char *file, const char *subs)
+{
+    if (readAhead && file)
+        dbReadAheadAdd(readAhead, file, subs);
+    else
+        dbLoadRecords(file, subs);
+}
+
 %}
 
 %start substitution_file
@@ -165,7 +190,7 @@ pattern_definition: global_definitions
         fprintf(stderr, "pattern_definition: pattern_values empty\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
     }
     | O_BRACE pattern_values C_BRACE
     {
@@ -173,7 +198,7 @@ pattern_definition: global_definitions
         fprintf(stderr, "pattern_definition:\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
         *sub_locals = '\0';
         sub_count = 0;
     }
@@ -188,7 +213,7 @@ pattern_definition: global_definitions
         fprintf(stderr, "pattern_definition:\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
         dbmfFree($1);
         *sub_locals = '\0';
         sub_count = 0;
@@ -248,7 +273,7 @@ variable_substitution: global_definitions
         fprintf(stderr, "variable_substitution: variable_definitions empty\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
     }
     | O_BRACE variable_definitions C_BRACE
     {
@@ -256,7 +281,7 @@ variable_substitution: global_definitions
         fprintf(stderr, "variable_substitution:\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
         *sub_locals = '\0';
     }
     | WORD O_BRACE variable_definitions C_BRACE
@@ -270,7 +295,7 @@ variable_substitution: global_definitions
         fprintf(stderr, "variable_substitution:\n");
         fprintf(stderr, "    dbLoadRecords(%s)\n", sub_collect+1);
     #endif
-        dbLoadRecords(db_file_name, sub_collect+1);
+        loadRecords(db_file_name, sub_collect+1);
         dbmfFree($1);
         *sub_locals = '\0';
     }
@@ -375,8 +400,17 @@ int dbLoadTemplate(const char *sub_file, const char *cmd_collect)
         yyrestart(fp);
     }
 
+    if (dbTemplateLoadThreads > 0)
+        readAhead = dbReadAheadCreate(&pdbbase, NULL, dbTemplateLoadThreads,
+            loadedRecords, NULL);
+
     yyparse();
 
+    if (readAhead) {
+        dbReadAheadFinish(readAhead);
+        readAhead = NULL;
+    }
+
     for (i = 0; i < var_count; i++) {
         dbmfFree(vars[i]);
     }
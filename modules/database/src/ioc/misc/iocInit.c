@@ -30,6 +30,8 @@
 #include "epicsPrint.h"
 #include "epicsSignal.h"
 #include "epicsThread.h"
+#include "epicsThreadPool.h"
+#include "epicsTime.h"
 #include "errMdef.h"
 #include "iocsh.h"
 #include "taskwd.h"
@@ -50,6 +52,7 @@
 #include "dbCommon.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "dbLockPvt.h"
 #include "dbNotify.h"
 #include "dbScan.h"
 #include "dbServer.h"
@@ -70,9 +73,8 @@
 #include "registryJLinks.h"
 #include "registryRecordType.h"
 
-static enum {
-    iocVirgin, iocBuilding, iocBuilt, iocRunning, iocPaused, iocStopped
-} iocState = iocVirgin;
+static enum iocStateEnum iocState = iocVoid;
+static int iocWasBuilt;     /* iocBuild has run before */
 static enum {
     buildServers, buildIsolated
 } iocBuildMode;
@@ -99,6 +101,50 @@ static void iterateRecords(recIterFunc func, void *user);
 int dbThreadRealtimeLock = 1;
 epicsExportAddress(int, dbThreadRealtimeLock);
 
+/*
+ * Record initialization statistics, and the optional parallel
+ * initialization of record types marked with iocInitParallelType().
+ */
+int iocInitThreads = 0;
+epicsExportAddress(int, iocInitThreads);
+int iocInitTiming = 0;
+epicsExportAddress(int, iocInitTiming);
+
+/* Relocate the records into scan list order before they are initialized */
+int iocInitScanLayout = 0;
+epicsExportAddress(int, iocInitScanLayout);
+
+typedef enum {
+    initPass0, initLinks, initPass1, initPini, initNPhases
+} initPhase;
+
+typedef struct initTypeStats {
+    dbRecordType *prt;
+    int parallel;
+    unsigned long count;
+    double seconds[initNPhases];
+} initTypeStats;
+
+typedef struct parallelTypeNode {
+    ELLNODE node;
+    char name[1];
+} parallelTypeNode;
+
+static ELLLIST parallelTypes = ELLLIST_INIT;
+static initTypeStats *initStats;
+static int nInitStats;
+static int initParallelThreads;
+
+static void initStatsCreate(void);
+static void initRecords(initPhase phase, recIterFunc func);
+static void iterateTimed(initPhase phase, recIterFunc func, void *user);
+static void initStatsReport(void);
+
+enum iocStateEnum getIocState(void)
+{
+    return iocState;
+}
+
 /*
  *  Initialize EPICS on the IOC.
  */
@@ -109,7 +155,7 @@ int iocInit(void)
 
 static int iocBuild_1(void)
 {
-    if (iocState != iocVirgin && iocState != iocStopped) {
+    if (iocState != iocVoid) {
         errlogPrintf("iocBuild: IOC can only be initialized from uninitialized or stopped state\n");
         return -1;
     }
@@ -125,11 +171,14 @@ static int iocBuild_1(void)
         errlogPrintf("iocBuild: Aborting, bad database definition (DBD)!\n");
         return -1;
     }
+    if (!iocWasBuilt && iocInitScanLayout)
+        dbRecordStorageScanOrder(pdbbase);
     epicsSignalInstallSigHupIgnore();
     initHookAnnounce(initHookAtBeginning);
 
     coreRelease();
     iocState = iocBuilding;
+    iocWasBuilt = 1;
 
     checkGeneralTime();
     taskwdInit();
@@ -253,6 +302,9 @@ int iocRun(void)
     if (iocState == iocBuilt)
         initHookAnnounce(initHookAtEnd);
 
+    if (iocState == iocBuilt && iocInitTiming)
+        initStatsReport();
+
     errlogPrintf("iocRun: %s\n", iocState == iocBuilt ?
         "All initialization complete" :
         "IOC restarted");
@@ -464,6 +516,24 @@ static void finishDevSup(void)
     }
 }
 
+static void iterateTypeRecords(dbRecordType *pdbRecordType,
+    recIterFunc func, void *user)
+{
+    dbRecordNode *pdbRecordNode;
+
+    for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+         pdbRecordNode;
+         pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
+        dbCommon *precord = pdbRecordNode->precord;
+
+        if (!precord->name[0] ||
+            pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
+            continue;
+
+        func(pdbRecordType, precord, user);
+    }
+}
+
 static void iterateRecords(recIterFunc func, void *user)
 {
     dbRecordType *pdbRecordType;
@@ -471,21 +541,282 @@ static void iterateRecords(recIterFunc func, void *user)
     for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
          pdbRecordType;
          pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node)) {
-        dbRecordNode *pdbRecordNode;
+        iterateTypeRecords(pdbRecordType, func, user);
+    }
+    return;
+}
+
+/* Like iterateRecords(), adding the time taken to each type's stats */
+static void iterateTimed(initPhase phase, recIterFunc func, void *user)
+{
+    int i;
 
-        for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
-             pdbRecordNode;
-             pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
-            dbCommon *precord = pdbRecordNode->precord;
+    if (!initStats) {
+        iterateRecords(func, user);
+        return;
+    }
+    for (i = 0; i < nInitStats; i++) {
+        initTypeStats *pstats = &initStats[i];
+        epicsUInt64 start;
 
-            if (!precord->name[0] ||
-                pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
-                continue;
+        start = epicsMonotonicGet();
+        iterateTypeRecords(pstats->prt, func, user);
+        pstats->seconds[phase] += (epicsMonotonicGet() - start) * 1e-9;
+    }
+}
+
+int iocInitParallelType(const char *recordTypes)
+{
+    const char *sep = " ,\t";
+    const char *name = recordTypes;
+
+    if (!recordTypes) {
+        printf("Usage: iocInitParallelType \"recordType ...\"\n");
+        return -1;
+    }
+    if (iocState != iocVoid) {
+        errlogPrintf("iocInitParallelType: IOC already initialized\n");
+        return -1;
+    }
+    while (*(name += strspn(name, sep))) {
+        size_t len = strcspn(name, sep);
+        parallelTypeNode *pnode = callocMustSucceed(1,
+            sizeof(parallelTypeNode) + len, "iocInitParallelType");
+
+        memcpy(pnode->name, name, len);
+        ellAdd(&parallelTypes, &pnode->node);
+        name += len;
+    }
+    return 0;
+}
+
+static void initStatsCreate(void)
+{
+    dbRecordType *pdbRecordType;
+    parallelTypeNode *pnode;
+    int i = 0;
+
+    free(initStats);
+    nInitStats = ellCount(&pdbbase->recordTypeList);
+    initStats = callocMustSucceed(nInitStats ? nInitStats : 1,
+        sizeof(initTypeStats), "initStatsCreate");
+    initParallelThreads = iocInitThreads;
 
-            func(pdbRecordType, precord, user);
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node)) {
+        initStats[i++].prt = pdbRecordType;
+    }
+
+    for (pnode = (parallelTypeNode *)ellFirst(&parallelTypes);
+         pnode;
+         pnode = (parallelTypeNode *)ellNext(&pnode->node)) {
+        for (i = 0; i < nInitStats; i++) {
+            if (strcmp(initStats[i].prt->name, pnode->name) == 0)
+                break;
         }
+        if (i < nInitStats)
+            initStats[i].parallel = initParallelThreads > 0;
+        else
+            errlogPrintf("iocInitParallelType: Unknown record type '%s'\n",
+                pnode->name);
+    }
+}
+
+static void countRecord(dbRecordType *rtyp, dbCommon *prec, void *user)
+{
+    (*(unsigned long *)user)++;
+}
+
+/*
+ * The records of a parallel type are spread over the jobs by lock set,
+ * so records that are linked together are still initialized one after
+ * the other, in database order, by the same thread. This is only done
+ * in pass 1, after the links have been resolved and the lock sets are
+ * final. A job keeps the status returned by each init_record() call,
+ * which are reported in database order afterwards.
+ */
+typedef struct initItem {
+    dbCommon *precord;
+    long status;
+} initItem;
+
+typedef struct initJob {
+    epicsJob *job;
+    recIterFunc func;
+    dbRecordType *prt;
+    initItem *items;
+    size_t *order;
+    size_t count;
+    double seconds;
+} initJob;
+
+static void collectRecord(dbRecordType *rtyp, dbCommon *prec, void *user)
+{
+    initItem **ppitem = (initItem **)user;
+
+    (*ppitem)->precord = prec;
+    (*ppitem)++;
+}
+
+static void initJobRun(void *arg, epicsJobMode mode)
+{
+    initJob *pjob = (initJob *)arg;
+    epicsUInt64 start = epicsMonotonicGet();
+    size_t i;
+
+    if (mode != epicsJobModeRun)
+        return;
+    for (i = 0; i < pjob->count; i++) {
+        initItem *pitem = &pjob->items[pjob->order[i]];
+
+        pjob->func(pjob->prt, pitem->precord, &pitem->status);
+    }
+    pjob->seconds = (epicsMonotonicGet() - start) * 1e-9;
+}
+
+static void initParallel(initPhase phase, recIterFunc func,
+    initTypeStats *pstats)
+{
+    epicsThreadPoolConfig opts;
+    epicsThreadPool *pool;
+    initItem *items, *pitem;
+    initJob *jobs;
+    size_t *order, *next;
+    size_t nItems = pstats->count, i;
+    int nJobs = 4 * initParallelThreads;
+    int j;
+
+    if (!nItems)
+        return;
+
+    items = callocMustSucceed(nItems, sizeof(initItem), "initParallel");
+    order = callocMustSucceed(nItems, sizeof(size_t), "initParallel");
+    jobs = callocMustSucceed(nJobs, sizeof(initJob), "initParallel");
+    next = callocMustSucceed(nJobs, sizeof(size_t), "initParallel");
+    pitem = items;
+    iterateTypeRecords(pstats->prt, collectRecord, &pitem);
+
+    /* count the records for each job, then place them */
+    for (i = 0; i < nItems; i++) {
+        size_t key = (size_t) items[i].precord->lset->plockSet;
+
+        jobs[(key / sizeof(void *)) % nJobs].count++;
+    }
+    for (j = 0, i = 0; j < nJobs; j++) {
+        jobs[j].order = order + i;
+        jobs[j].items = items;
+        jobs[j].func = func;
+        jobs[j].prt = pstats->prt;
+        i += jobs[j].count;
+    }
+    for (i = 0; i < nItems; i++) {
+        size_t key = (size_t) items[i].precord->lset->plockSet;
+
+        j = (key / sizeof(void *)) % nJobs;
+        jobs[j].order[next[j]++] = i;
+    }
+
+    epicsThreadPoolConfigDefaults(&opts);
+    opts.initialThreads = initParallelThreads;
+    opts.maxThreads = initParallelThreads;
+    opts.workerPriority = epicsThreadGetPrioritySelf();
+    pool = epicsThreadPoolCreate(&opts);
+    if (!pool)
+        errlogPrintf("iocInit: No thread pool, initializing serially\n");
+
+    for (j = 0; j < nJobs; j++) {
+        if (pool)
+            jobs[j].job = epicsJobCreate(pool, initJobRun, &jobs[j]);
+        if (!jobs[j].job || epicsJobQueue(jobs[j].job))
+            initJobRun(&jobs[j], epicsJobModeRun);
+    }
+    if (pool) {
+        epicsThreadPoolWait(pool, -1.0);
+        for (j = 0; j < nJobs; j++) {
+            if (jobs[j].job)
+                epicsJobDestroy(jobs[j].job);
+        }
+        epicsThreadPoolDestroy(pool);
+    }
+
+    for (j = 0; j < nJobs; j++)
+        pstats->seconds[phase] += jobs[j].seconds;
+    for (i = 0; i < nItems; i++) {
+        if (items[i].status)
+            errlogPrintf("iocInit: %s init_record(%d) returned status %ld\n",
+                items[i].precord->name, phase == initPass1, items[i].status);
+    }
+    free(next);
+    free(jobs);
+    free(order);
+    free(items);
+}
+
+/*
+ * Record types in database order. In pass 1 the thread pool finishes
+ * each parallel type before the next type starts.
+ */
+static void initRecords(initPhase phase, recIterFunc func)
+{
+    int i;
+
+    if (phase != initPass1 || initParallelThreads <= 0) {
+        iterateTimed(phase, func, NULL);
+        return;
+    }
+    for (i = 0; i < nInitStats; i++) {
+        initTypeStats *pstats = &initStats[i];
+        epicsUInt64 start;
+
+        if (pstats->parallel) {
+            initParallel(phase, func, pstats);
+            continue;
+        }
+        start = epicsMonotonicGet();
+        iterateTypeRecords(pstats->prt, func, NULL);
+        pstats->seconds[phase] += (epicsMonotonicGet() - start) * 1e-9;
     }
-    return;
+}
+
+static void initStatsReport(void)
+{
+    static const char * const phaseNames[initNPhases] = {
+        "pass 0", "links", "pass 1", "pini"
+    };
+    double total[initNPhases];
+    unsigned long count = 0;
+    int i, p;
+
+    if (!initStats)
+        return;
+    memset(total, 0, sizeof(total));
+    printf("iocInit: Record initialization times in seconds\n");
+    printf("%-20s %10s", "record type", "records");
+    for (p = 0; p < initNPhases; p++)
+        printf(" %9s", phaseNames[p]);
+    printf("\n");
+    for (i = 0; i < nInitStats; i++) {
+        initTypeStats *pstats = &initStats[i];
+
+        if (!pstats->count)
+            continue;
+        printf("%-19s%c %10lu", pstats->prt->name,
+            pstats->parallel ? '*' : ' ', pstats->count);
+        for (p = 0; p < initNPhases; p++) {
+            printf(" %9.3f", pstats->seconds[p]);
+            total[p] += pstats->seconds[p];
+        }
+        printf("\n");
+        count += pstats->count;
+    }
+    printf("%-20s %10lu", "total", count);
+    for (p = 0; p < initNPhases; p++)
+        printf(" %9.3f", total[p]);
+    printf("\n");
+    if (initParallelThreads > 0)
+        printf("* pass 1 run by %d threads, times are summed over the "
+            "threads\n", initParallelThreads);
 }
 
 static void doInitRecord0(dbRecordType *pdbRecordType, dbCommon *precord,
@@ -511,8 +842,12 @@ static void doInitRecord0(dbRecordType *pdbRecordType, dbCommon *precord,
     pdevSup = dbDTYPtoDevSup(pdbRecordType, precord->dtyp);
     precord->dset = pdevSup ? pdevSup->pdset : NULL;
 
-    if (prset->init_record)
-        prset->init_record(precord, 0);
+    if (prset->init_record) {
+        long status = prset->init_record(precord, 0);
+
+        if (user)
+            *(long *)user = status;
+    }
 }
 
 static void doResolveLinks(dbRecordType *pdbRecordType, dbCommon *precord,
@@ -549,16 +884,26 @@ static void doInitRecord1(dbRecordType *pdbRecordType, dbCommon *precord,
 
     if (!prset) return;         /* unlikely */
 
-    if (prset->init_record)
-        prset->init_record(precord, 1);
+    if (prset->init_record) {
+        long status = prset->init_record(precord, 1);
+
+        if (user)
+            *(long *)user = status;
+    }
 }
 
 static void initDatabase(void)
 {
+    int i;
+
     dbChannelInit();
-    iterateRecords(doInitRecord0, NULL);
-    iterateRecords(doResolveLinks, NULL);
-    iterateRecords(doInitRecord1, NULL);
+    initStatsCreate();
+    for (i = 0; i < nInitStats; i++)
+        iterateTypeRecords(initStats[i].prt, countRecord, &initStats[i].count);
+
+    initRecords(initPass0, doInitRecord0);
+    iterateTimed(initLinks, doResolveLinks, NULL);
+    initRecords(initPass1, doInitRecord1);
 
     epicsAtExit(exitDatabase, NULL);
     return;
@@ -606,7 +951,7 @@ static void piniProcess(int pini)
     do {
         phase.this = phase.next;
         phase.next = MAX_PHASE + 1;
-        iterateRecords(doRecordPini, &phase);
+        iterateTimed(initPini, doRecordPini, &phase);
     } while (phase.next != MAX_PHASE + 1);
 }
 
@@ -705,7 +1050,7 @@ static void doFreeRecord(dbRecordType *pdbRecordType, dbCommon *precord,
 
 int iocShutdown(void)
 {
-    if (iocState == iocVirgin || iocState == iocStopped)
+    if (iocState == iocVoid)
         return 0;
 
     iterateRecords(doCloseLinks, NULL);
@@ -729,12 +1074,16 @@ int iocShutdown(void)
         dbLockCleanupRecords(pdbbase);
 
         asShutdown();
+        free(initStats);
+        initStats = NULL;
+        nInitStats = 0;
+        ellFree(&parallelTypes);
         dbChannelExit();
         dbProcessNotifyExit();
         iocshFree();
     }
 
-    iocState = iocStopped;
+    iocState = iocVoid;
     iocBuildMode = buildServers;
     return 0;
 }
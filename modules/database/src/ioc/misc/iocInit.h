@@ -17,6 +17,13 @@
 extern "C" {
 #endif
 
+enum iocStateEnum {
+    iocVoid, iocBuilding, iocBuilt, iocRunning, iocPaused
+};
+
+/* iocVoid before iocInit and after iocShutdown */
+epicsShareFunc enum iocStateEnum getIocState(void);
+
 epicsShareFunc int iocInit(void);
 epicsShareFunc int iocBuild(void);
 epicsShareFunc int iocBuildIsolated(void);
@@ -24,6 +31,13 @@ epicsShareFunc int iocRun(void);
 epicsShareFunc int iocPause(void);
 epicsShareFunc int iocShutdown(void);
 
+/* Allow records of the named types, separated by spaces or commas, to have
+ * their second init_record() pass run by iocInitThreads threads. Only for
+ * record types whose init_record() routine and device support are safe to
+ * run concurrently for records in different lock sets.
+ */
+epicsShareFunc int iocInitParallelType(const char *recordTypes);
+
 #ifdef __cplusplus
 }
 #endif
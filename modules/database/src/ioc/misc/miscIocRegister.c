@@ -46,6 +46,17 @@ static void iocPauseCallFunc(const iocshArgBuf *args)
     iocPause();
 }
 
+/* iocInitParallelType */
+static const iocshArg iocInitParallelTypeArg0 = { "record types",iocshArgString};
+static const iocshArg * const iocInitParallelTypeArgs[1] =
+    {&iocInitParallelTypeArg0};
+static const iocshFuncDef iocInitParallelTypeFuncDef =
+    {"iocInitParallelType",1,iocInitParallelTypeArgs};
+static void iocInitParallelTypeCallFunc(const iocshArgBuf *args)
+{
+    iocInitParallelType(args[0].sval);
+}
+
 /* coreRelease */
 static const iocshFuncDef coreReleaseFuncDef = {"coreRelease",0,NULL};
 static void coreReleaseCallFunc(const iocshArgBuf *args)
@@ -60,6 +71,7 @@ void miscIocRegister(void)
     iocshRegister(&iocBuildFuncDef,iocBuildCallFunc);
     iocshRegister(&iocRunFuncDef,iocRunCallFunc);
     iocshRegister(&iocPauseFuncDef,iocPauseCallFunc);
+    iocshRegister(&iocInitParallelTypeFuncDef,iocInitParallelTypeCallFunc);
     iocshRegister(&coreReleaseFuncDef, coreReleaseCallFunc);
 }
 
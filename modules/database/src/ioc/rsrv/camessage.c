@@ -45,6 +45,7 @@
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
+#include "dbLatency.h"
 #include "db_field_log.h"
 #include "dbNotify.h"
 #include "rsrv.h"
@@ -500,6 +501,9 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
 
     SEND_LOCK ( pClient );
 
+    if ( dbLatencyEnabled && ! pClient->sendPendingSince )
+        pClient->sendPendingSince = epicsMonotonicGet ();
+
     cid = ECA_NORMAL;
 
     /* If the client has requested a zero element count we interpret this as a
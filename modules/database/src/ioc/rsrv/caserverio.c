@@ -31,6 +31,7 @@
 #include "net_convert.h"
 
 #define epicsExportSharedSymbols
+#include "dbLatency.h"
 #include "server.h"
 
 /*
@@ -71,6 +72,11 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
             if ( transferSize >= pclient->send.stk ) {
                 pclient->send.stk = 0;
                 epicsTimeGetCurrent ( &pclient->time_at_last_send );
+                if ( pclient->sendPendingSince ) {
+                    dbLatencyRecord ( dbLatencySend,
+                        pclient->sendPendingSince );
+                    pclient->sendPendingSince = 0u;
+                }
                 break;
             }
             else {
@@ -40,6 +40,7 @@
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
+#include "dbLatency.h"
 #include "db_field_log.h"
 #include "dbServer.h"
 #include "rsrv.h"
@@ -1015,6 +1016,9 @@ void casr (unsigned level)
                 printf("    %s\n", buf);
             }
         }
+
+        if (dbLatencyEnabled)
+            dbLatencyReport(level - 1);
     }
 
     if (level>=4u) {
@@ -100,6 +100,8 @@ typedef struct client {
   ca_uint32_t           seqNoOfReq; /* for udp  */
   unsigned              recvBytesToDrain;
   unsigned              priority;
+  /*! guarded by SEND_LOCK(), when the oldest unsent update was queued */
+  epicsUInt64           sendPendingSince;
   char                  disconnect; /* disconnect detected */
 } client;
 
@@ -59,6 +59,15 @@ static long init_record(histogramRecord	*prec)
 
 static long read_histogram(histogramRecord *prec)
 {
+    if (prec->nsam > 1 && prec->sptr) {
+        /* Read up to NSAM samples, the record bins them all */
+        long nRequest = prec->nsam;
+
+        if (dbGetLink(&prec->svl, DBR_DOUBLE, prec->sptr, 0, &nRequest))
+            nRequest = 0;
+        prec->nord = nRequest;
+        return 0; /*add count*/
+    }
     dbGetLink(&prec->svl, DBR_DOUBLE, &prec->sgnl, 0, 0);
     return 0; /*add count*/
 }
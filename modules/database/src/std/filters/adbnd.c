@@ -0,0 +1,338 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Array deadband filter: drops updates of an array that are the same as
+ *  the last array sent, element by element within a deadband, or by a
+ *  checksum of its contents.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <errlog.h>
+#include <freeList.h>
+#include <dbAccess.h>
+#include <dbLock.h>
+#include <db_field_log.h>
+#include <epicsExit.h>
+#include <chfPlugin.h>
+#include <epicsExport.h>
+
+enum {modeAbs, modeRel, modeSum};
+
+/* Buffers are shared between channels of the same size */
+typedef struct bufPool {
+    ELLNODE node;
+    size_t size;
+    void *freeList;
+} bufPool;
+
+typedef struct myStruct {
+    int mode;
+    double cval;            /* deadband, in percent for rel */
+    short type;             /* DBR type of the data */
+    long capacity;
+    bufPool *pool;
+    void *cur;              /* the update being filtered */
+    void *ref;              /* the last update sent, unless mode is sum */
+    long nref;              /* elements in ref, -1 before the first update */
+    epicsUInt64 sum;        /* checksum of the last update sent */
+    unsigned long dropped;
+    unsigned long unread;   /* sent unfiltered, dbGet() failed */
+} myStruct;
+
+static void *myStructFreeList;
+static ELLLIST poolList = ELLLIST_INIT;
+static epicsMutexId poolLock;
+
+static const
+chfPluginEnumType modeEnum[] = {
+    {"abs", modeAbs}, {"rel", modeRel}, {"sum", modeSum}, {NULL, 0}
+};
+
+static const
+chfPluginArgDef opts[] = {
+    chfDouble    (myStruct, cval, "d", 0, 1),
+    chfEnum      (myStruct, mode, "m", 0, 1, modeEnum),
+    chfTagDouble (myStruct, cval, "abs", mode, modeAbs, 0, 1),
+    chfTagDouble (myStruct, cval, "rel", mode, modeRel, 0, 1),
+    chfPluginArgEnd
+};
+
+static void * getBuffer(size_t size, bufPool **ppool)
+{
+    bufPool *pool;
+
+    epicsMutexMustLock(poolLock);
+    for (pool = (bufPool *) ellFirst(&poolList); pool;
+         pool = (bufPool *) ellNext(&pool->node))
+        if (pool->size == size)
+            break;
+    if (!pool) {
+        pool = calloc(1, sizeof(bufPool));
+        if (!pool) {
+            epicsMutexUnlock(poolLock);
+            return NULL;
+        }
+        pool->size = size;
+        freeListInitPvt(&pool->freeList, size, 1);
+        ellAdd(&poolList, &pool->node);
+    }
+    epicsMutexUnlock(poolLock);
+    *ppool = pool;
+    return freeListMalloc(pool->freeList);
+}
+
+static void * allocPvt(void)
+{
+    return freeListCalloc(myStructFreeList);
+}
+
+static void freePvt(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (my->cur) freeListFree(my->pool->freeList, my->cur);
+    if (my->ref) freeListFree(my->pool->freeList, my->ref);
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (my->cval < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * Compare n elements of a against b, the last array sent. Blocks of
+ * elements are compared without branches so the compiler can vectorize
+ * the loop; it stops at the first block with a change. NaN is the same
+ * as NaN.
+ */
+#define BLOCK 64
+#define BOTH_NAN(x, y) ((x) != (x) && (y) != (y))
+
+#define DEFINE_CHANGED(NAME, TYPE) \
+static int NAME(const void *pa, const void *pb, long n, double d, int rel) \
+{ \
+    const TYPE *a = (const TYPE *) pa; \
+    const TYPE *b = (const TYPE *) pb; \
+    long i, j, end; \
+\
+    for (i = 0; i < n; i = end) { \
+        int changed = 0; \
+\
+        end = i + BLOCK < n ? i + BLOCK : n; \
+        if (rel) { \
+            for (j = i; j < end; j++) { \
+                double x = a[j], y = b[j]; \
+                changed |= !(fabs(x - y) <= d * fabs(y) || BOTH_NAN(x, y)); \
+            } \
+        } \
+        else { \
+            for (j = i; j < end; j++) { \
+                double x = a[j], y = b[j]; \
+                changed |= !(fabs(x - y) <= d || BOTH_NAN(x, y)); \
+            } \
+        } \
+        if (changed) \
+            return 1; \
+    } \
+    return 0; \
+}
+
+DEFINE_CHANGED(changedInt8,    epicsInt8)
+DEFINE_CHANGED(changedUInt8,   epicsUInt8)
+DEFINE_CHANGED(changedInt16,   epicsInt16)
+DEFINE_CHANGED(changedUInt16,  epicsUInt16)
+DEFINE_CHANGED(changedInt32,   epicsInt32)
+DEFINE_CHANGED(changedUInt32,  epicsUInt32)
+DEFINE_CHANGED(changedInt64,   epicsInt64)
+DEFINE_CHANGED(changedUInt64,  epicsUInt64)
+DEFINE_CHANGED(changedFloat32, epicsFloat32)
+DEFINE_CHANGED(changedFloat64, epicsFloat64)
+
+typedef int (changedFunc)(const void *pa, const void *pb, long n,
+    double d, int rel);
+
+/* Indexed by DBR type, DBR_CHAR .. DBR_ENUM */
+static changedFunc * const changedTable[] = {
+    NULL, changedInt8, changedUInt8, changedInt16, changedUInt16,
+    changedInt32, changedUInt32, changedInt64, changedUInt64,
+    changedFloat32, changedFloat64, changedUInt16
+};
+
+/* A 64-bit checksum using four independent lanes */
+static epicsUInt64 checksum(const void *p, size_t size)
+{
+    static const epicsUInt64 prime = 0x100000001b3ull;
+    epicsUInt64 h[4] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull,
+                        0x9ce484222325cbf2ull, 0x2325cbf29ce48422ull};
+    const unsigned char *pc = (const unsigned char *) p;
+    epicsUInt64 w[4];
+    size_t i;
+    int k;
+
+    for (i = 0; i + sizeof(w) <= size; i += sizeof(w)) {
+        memcpy(w, pc + i, sizeof(w));
+        for (k = 0; k < 4; k++)
+            h[k] = (h[k] ^ w[k]) * prime;
+    }
+    for (; i < size; i++)
+        h[0] = (h[0] ^ pc[i]) * prime;
+    for (k = 1; k < 4; k++)
+        h[0] = (h[0] ^ (h[k] >> 29) ^ h[k]) * prime;
+    return h[0] ^ (h[0] >> 32) ^ size;
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    dbCommon *prec = dbChannelRecord(chan);
+    long nelem = my->capacity;
+    size_t size;
+    epicsUInt64 sum = 0;
+    int send;
+    long status;
+
+    /* Reads get the current value */
+    if (pfl->ctx != dbfl_context_event)
+        return pfl;
+
+    dbScanLock(prec);
+    status = dbGet(&chan->addr, my->type, my->cur, NULL, &nelem, pfl);
+    dbScanUnlock(prec);
+    /* Without the data there is nothing to compare, so the update is
+     * sent and the reference kept */
+    if (status) {
+        my->unread++;
+        return pfl;
+    }
+
+    size = nelem * dbValueSize(my->type);
+    if (nelem != my->nref)
+        send = 1;
+    else if (my->mode == modeSum)
+        send = (sum = checksum(my->cur, size)) != my->sum;
+    else if (my->mode == modeAbs && my->cval == 0)
+        send = memcmp(my->cur, my->ref, size) != 0;
+    else
+        send = changedTable[my->type](my->cur, my->ref, nelem,
+            my->mode == modeRel ? my->cval / 100. : my->cval,
+            my->mode == modeRel);
+
+    if (!send) {
+        my->dropped++;
+        db_delete_field_log(pfl);
+        return NULL;
+    }
+
+    /* This update becomes the reference */
+    my->nref = nelem;
+    if (my->mode == modeSum) {
+        my->sum = sum ? sum : checksum(my->cur, size);
+    }
+    else {
+        void *tmp = my->ref;
+
+        my->ref = my->cur;
+        my->cur = tmp;
+    }
+    return pfl;
+}
+
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+    short type = probe->field_type;
+    size_t size;
+
+    if (type > DBF_ENUM || probe->no_elements <= 0)
+        return;
+    /* Strings can only be compared exactly */
+    if (type == DBF_STRING && my->mode != modeSum &&
+        (my->mode == modeRel || my->cval != 0))
+        return;
+
+    size = probe->no_elements * dbValueSize(type);
+    my->type = type;
+    my->capacity = probe->no_elements;
+    my->nref = -1;
+    my->cur = getBuffer(size, &my->pool);
+    if (my->cur && my->mode != modeSum)
+        my->ref = freeListMalloc(my->pool->freeList);
+    if (!my->cur || (my->mode != modeSum && !my->ref)) {
+        errlogPrintf("adbnd: Can't allocate %lu byte buffers for '%s',"
+            " not filtering\n", (unsigned long) size, dbChannelName(chan));
+        if (my->cur)
+            freeListFree(my->pool->freeList, my->cur);
+        my->cur = NULL;
+        return;
+    }
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    printf("%*sArray deadband (adbnd): mode=%s, delta=%g%s, %lu dropped,"
+           " %lu unread\n",
+           indent, "", chfPluginEnumString(modeEnum, my->mode, "n/a"),
+           my->cval, my->mode == modeRel ? "%" : "", my->dropped, my->unread);
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    NULL, /* channel_open, */
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    NULL /* channel_close */
+};
+
+static void adbndShutdown(void* ignore)
+{
+    bufPool *pool;
+
+    while ((pool = (bufPool *) ellGet(&poolList))) {
+        freeListCleanup(pool->freeList);
+        free(pool);
+    }
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+}
+
+static void adbndInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+    if (!poolLock)
+        poolLock = epicsMutexMustCreate();
+
+    chfPluginRegister("adbnd", &pif, opts);
+    epicsAtExit(adbndShutdown, NULL);
+}
+
+epicsExportRegistrar(adbndInitialize);
@@ -0,0 +1,218 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Decimation filter: passes every Nth update and/or no more than one
+ *  update per time interval. Updates dropped by the time limit are not
+ *  lost: the latest value is sent when the interval ends.
+ */
+
+#include <stdio.h>
+
+#include <freeList.h>
+#include <dbAccess.h>
+#include <dbEvent.h>
+#include <dbLock.h>
+#include <db_field_log.h>
+#include <callback.h>
+#include <epicsTime.h>
+#include <epicsTimer.h>
+#include <epicsExit.h>
+#include <chfPlugin.h>
+#include <epicsExport.h>
+
+typedef struct myStruct {
+    epicsInt32 n;           /* pass every Nth update */
+    double t;               /* seconds between updates, 0 for no limit */
+    dbChannel *chan;
+    epicsTimerQueueId timerQueue;   /* the callback timers */
+    epicsTimerId timer;     /* ends the interval, on timerQueue */
+    epicsUInt64 last;       /* when the last update was sent */
+    epicsUInt32 count;
+    unsigned long dropped;
+    db_field_log *held;     /* latest update dropped in this interval */
+    unsigned int mask;      /* events of the updates dropped since */
+    char sent;              /* an update has been sent */
+    char armed;             /* the timer is running */
+} myStruct;
+
+static void *myStructFreeList;
+
+static const
+chfPluginArgDef opts[] = {
+    chfInt32 (myStruct, n, "n", 0, 1),
+    chfDouble(myStruct, t, "t", 0, 1),
+    chfPluginArgEnd
+};
+
+static void * allocPvt(void)
+{
+    myStruct *my = (myStruct*) freeListCalloc(myStructFreeList);
+
+    if (my) my->n = 1;
+    return (void *) my;
+}
+
+static void freePvt(void *pvt)
+{
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    if (my->n < 1 || my->t < 0)
+        return -1;
+    return 0;
+}
+
+static long channel_open(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    my->chan = chan;
+    return 0;
+}
+
+/* Send the latest update held back at the end of its interval. It
+ * continues down the filter chain from here with the events it and the
+ * updates it replaced were posted for.
+ */
+static void expire(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+    dbCommon *prec = dbChannelRecord(my->chan);
+
+    dbScanLock(prec);
+    my->armed = 0;
+    if (my->held) {
+        db_field_log *pfl = my->held;
+
+        my->held = NULL;
+        my->last = epicsMonotonicGet();
+        db_post_channel_log(my->chan, my, pfl, my->mask);
+    }
+    dbScanUnlock(prec);
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    epicsUInt64 now, interval;
+
+    if (pfl->ctx != dbfl_context_event)
+        return pfl;
+
+    if (my->n > 1 && my->count++ % my->n)
+        goto drop;
+
+    if (my->t > 0) {
+        now = epicsMonotonicGet();
+        interval = (epicsUInt64) (my->t * 1e9);
+
+        if (my->sent && now - my->last < interval) {
+            my->dropped++;
+            if (!my->timer) {
+                db_delete_field_log(pfl);
+                return NULL;
+            }
+            if (my->held) {
+                my->mask |= pfl->mask;
+                db_delete_field_log(my->held);
+            }
+            else
+                my->mask = pfl->mask;
+            my->held = pfl;
+            if (!my->armed) {
+                my->armed = 1;
+                epicsTimerStartDelay(my->timer,
+                    (double) (interval - (now - my->last)) * 1e-9);
+            }
+            return NULL;
+        }
+        my->last = now;
+        if (my->held) {
+            /* this update supersedes the one held back */
+            db_delete_field_log(my->held);
+            my->held = NULL;
+        }
+    }
+    my->sent = 1;
+    return pfl;
+
+drop:
+    my->dropped++;
+    db_delete_field_log(pfl);
+    return NULL;
+}
+
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* Without the callback timers there will be no trailing updates */
+    if (my->t > 0 && !my->timer && (my->timerQueue = callbackTimerQueue()))
+        my->timer = epicsTimerQueueCreateTimer(my->timerQueue, expire, my);
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    printf("%*sDecimate (dec): n=%d, t=%g, %lu dropped\n",
+           indent, "", my->n, my->t, my->dropped);
+}
+
+static void channel_close(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* Waits for a running expire() */
+    if (my->timer)
+        epicsTimerQueueDestroyTimer(my->timerQueue, my->timer);
+    my->timer = NULL;
+    my->timerQueue = NULL;
+    db_delete_field_log(my->held);
+    my->held = NULL;
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    channel_open,
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    channel_close
+};
+
+static void decShutdown(void* ignore)
+{
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+}
+
+static void decInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+
+    chfPluginRegister("dec", &pif, opts);
+    epicsAtExit(decShutdown, NULL);
+}
+
+epicsExportRegistrar(decInitialize);
@@ -0,0 +1,351 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Windowed statistics filter: collects updates in the pre-chain and
+ *  sends one update per window with the mean, minimum, maximum or
+ *  standard deviation of each element. A time window also ends when its
+ *  time is up without another update.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <freeList.h>
+#include <dbAccess.h>
+#include <dbEvent.h>
+#include <db_field_log.h>
+#include <dbLock.h>
+#include <callback.h>
+#include <epicsTime.h>
+#include <epicsTimer.h>
+#include <epicsExit.h>
+#include <chfPlugin.h>
+#include <epicsExport.h>
+
+enum {statMean, statMin, statMax, statStd};
+
+typedef struct myStruct {
+    epicsInt32 n;           /* samples per window, 0 for no limit */
+    double t;               /* window length in seconds, 0 for no limit */
+    int stat;
+    dbChannel *chan;
+    epicsTimerQueueId timerQueue;   /* the callback timers */
+    epicsTimerId timer;     /* ends a time window, on timerQueue */
+    long capacity;          /* most elements the channel can have */
+    double *sample;         /* the converted update */
+    double *acc;            /* mean, minimum or maximum */
+    double *m2;             /* sum of squared differences from the mean */
+    void *arrayFreeList;
+    long nelem;             /* elements in this window */
+    epicsInt32 count;       /* samples in this window */
+    epicsTimeStamp start;   /* of this window */
+    epicsTimeStamp end;     /* of its latest update */
+    epicsUInt64 opened;     /* when the window began, monotonic */
+    unsigned int mask;      /* events of its updates */
+    unsigned short wstat;   /* worst alarm in this window */
+    unsigned short wsevr;
+} myStruct;
+
+static void *myStructFreeList;
+
+static const
+chfPluginEnumType statEnum[] = {
+    {"mean", statMean}, {"min", statMin}, {"max", statMax}, {"std", statStd},
+    {NULL, 0}
+};
+
+static const
+chfPluginArgDef opts[] = {
+    chfInt32 (myStruct, n, "n", 0, 1),
+    chfDouble(myStruct, t, "t", 0, 1),
+    chfEnum  (myStruct, stat, "s", 0, 1, statEnum),
+    chfPluginArgEnd
+};
+
+static void * allocPvt(void)
+{
+    return freeListCalloc(myStructFreeList);
+}
+
+static void freePvt(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    free(my->sample);
+    free(my->acc);
+    free(my->m2);
+    if (my->arrayFreeList) freeListCleanup(my->arrayFreeList);
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* A window needs a sample count or a length */
+    if (my->n < 0 || my->t < 0 || (my->n == 0 && !(my->t > 0)))
+        return -1;
+    return 0;
+}
+
+static long channel_open(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    my->chan = chan;
+    return 0;
+}
+
+static void freeArray(db_field_log *pfl)
+{
+    if (pfl->type == dbfl_type_ref) {
+        freeListFree(pfl->u.r.pvt, pfl->u.r.field);
+    }
+}
+
+static void accumulate(myStruct *my, db_field_log *pfl, long nelem)
+{
+    double k = ++my->count;
+    long i;
+
+    my->end = pfl->time;
+    if (my->count == 1) {
+        my->nelem = nelem;
+        my->start = pfl->time;
+        my->mask = pfl->mask;
+        my->wstat = pfl->stat;
+        my->wsevr = pfl->sevr;
+        for (i = 0; i < nelem; i++) {
+            my->acc[i] = my->sample[i];
+            my->m2[i] = 0;
+        }
+        if (my->timer && my->t > 0) {
+            my->opened = epicsMonotonicGet();
+            epicsTimerStartDelay(my->timer, my->t);
+        }
+        return;
+    }
+    my->mask |= pfl->mask;
+    if (pfl->sevr > my->wsevr) {
+        my->wstat = pfl->stat;
+        my->wsevr = pfl->sevr;
+    }
+
+    switch (my->stat) {
+    case statMin:
+        for (i = 0; i < nelem; i++)
+            if (my->sample[i] < my->acc[i])
+                my->acc[i] = my->sample[i];
+        break;
+    case statMax:
+        for (i = 0; i < nelem; i++)
+            if (my->sample[i] > my->acc[i])
+                my->acc[i] = my->sample[i];
+        break;
+    default:
+        /* Welford's running mean and variance */
+        for (i = 0; i < nelem; i++) {
+            double delta = my->sample[i] - my->acc[i];
+
+            my->acc[i] += delta / k;
+            my->m2[i] += delta * (my->sample[i] - my->acc[i]);
+        }
+    }
+}
+
+static int windowDone(myStruct *my, const epicsTimeStamp *now)
+{
+    if (my->n > 0 && my->count >= my->n)
+        return 1;
+    return my->t > 0 && epicsTimeDiffInSeconds(now, &my->start) >= my->t;
+}
+
+/* Replace the contents of pfl with the statistics of the window */
+static db_field_log* emit(myStruct *my, db_field_log *pfl)
+{
+    double *pdst;
+    long i;
+
+    if (pfl->type == dbfl_type_ref && pfl->u.r.dtor) {
+        pfl->u.r.dtor(pfl);
+        pfl->type = dbfl_type_val;
+    }
+    if (my->stat == statStd) {
+        for (i = 0; i < my->nelem; i++)
+            my->acc[i] = sqrt(my->m2[i] / my->count);
+    }
+
+    pfl->stat = my->wstat;
+    pfl->sevr = my->wsevr;
+    pfl->field_type = DBF_DOUBLE;
+    pfl->field_size = sizeof(double);
+    pfl->no_elements = my->nelem;
+    if (my->capacity == 1) {
+        pfl->type = dbfl_type_val;
+        pfl->u.v.field.dbf_double = my->acc[0];
+    }
+    else {
+        pdst = freeListMalloc(my->arrayFreeList);
+        if (!pdst) {
+            my->count = 0;
+            db_delete_field_log(pfl);
+            return NULL;
+        }
+        for (i = 0; i < my->nelem; i++)
+            pdst[i] = my->acc[i];
+        pfl->type = dbfl_type_ref;
+        pfl->u.r.dtor = freeArray;
+        pfl->u.r.pvt = my->arrayFreeList;
+        pfl->u.r.field = pdst;
+    }
+    my->count = 0;
+    return pfl;
+}
+
+/* Send a time window that no update has ended when its time is up */
+static void expire(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+    dbCommon *prec = dbChannelRecord(my->chan);
+    epicsUInt64 elapsed;
+
+    dbScanLock(prec);
+    elapsed = epicsMonotonicGet() - my->opened;
+    if (my->count && elapsed < (epicsUInt64) (my->t * 1e9)) {
+        /* a new window began while this call was waiting for the lock */
+        epicsTimerStartDelay(my->timer, my->t - elapsed * 1e-9);
+    }
+    else if (my->count) {
+        db_field_log *pfl = db_create_read_log(my->chan);
+
+        if (pfl) {
+            pfl->ctx = dbfl_context_event;
+            pfl->time = my->end;
+            db_post_channel_log(my->chan, my, emit(my, pfl), my->mask);
+        }
+    }
+    dbScanUnlock(prec);
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    dbCommon *prec = dbChannelRecord(chan);
+    long nelem = my->capacity;
+    long status;
+
+    /* Reads get the current value */
+    if (pfl->ctx != dbfl_context_event)
+        return pfl;
+
+    dbScanLock(prec);
+    if (pfl->type == dbfl_type_rec) {
+        pfl->stat = prec->stat;
+        pfl->sevr = prec->sevr;
+        pfl->time = prec->time;
+    }
+    status = dbGet(&chan->addr, DBR_DOUBLE, my->sample, NULL, &nelem, pfl);
+    dbScanUnlock(prec);
+
+    if (status || nelem <= 0) {
+        db_delete_field_log(pfl);
+        return NULL;
+    }
+    /* A change of length starts a new window */
+    if (my->count && nelem != my->nelem)
+        my->count = 0;
+
+    accumulate(my, pfl, nelem);
+    if (windowDone(my, &pfl->time))
+        return emit(my, pfl);
+
+    db_delete_field_log(pfl);
+    return NULL;
+}
+
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+    long capacity = probe->no_elements;
+
+    /* numeric data only */
+    if (probe->field_type <= DBF_STRING || probe->field_type > DBF_DOUBLE ||
+        capacity <= 0)
+        return;
+
+    my->sample = calloc(capacity, sizeof(double));
+    my->acc = calloc(capacity, sizeof(double));
+    my->m2 = calloc(capacity, sizeof(double));
+    if (!my->sample || !my->acc || !my->m2)
+        return;
+    if (capacity > 1 && !my->arrayFreeList)
+        freeListInitPvt(&my->arrayFreeList, capacity * sizeof(double), 2);
+    my->capacity = capacity;
+    if (my->t > 0 && !my->timer && (my->timerQueue = callbackTimerQueue()))
+        my->timer = epicsTimerQueueCreateTimer(my->timerQueue, expire, my);
+
+    probe->field_type = DBF_DOUBLE;
+    probe->field_size = sizeof(double);
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    printf("%*sStatistics (stat): %s, n=%d, t=%g, %d in window\n",
+           indent, "", chfPluginEnumString(statEnum, my->stat, "n/a"),
+           my->n, my->t, my->count);
+}
+
+static void channel_close(dbChannel *chan, void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* Waits for a running expire() */
+    if (my->timer)
+        epicsTimerQueueDestroyTimer(my->timerQueue, my->timer);
+    my->timer = NULL;
+    my->timerQueue = NULL;
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    channel_open,
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    channel_close
+};
+
+static void statShutdown(void* ignore)
+{
+    if (myStructFreeList)
+        freeListCleanup(myStructFreeList);
+    myStructFreeList = NULL;
+}
+
+static void statInitialize(void)
+{
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+
+    chfPluginRegister("stat", &pif, opts);
+    epicsAtExit(statShutdown, NULL);
+}
+
+epicsExportRegistrar(statInitialize);
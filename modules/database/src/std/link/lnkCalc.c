@@ -59,6 +59,9 @@ typedef struct calc_link {
     char *post_expr;
     char *post_major;
     char *post_minor;
+    calcProgram *prog_expr;
+    calcProgram *prog_major;
+    calcProgram *prog_minor;
     char *units;
     short tinp;
     struct link inp[CALCPERFORM_NARGS];
@@ -71,6 +74,15 @@ typedef struct calc_link {
 static lset lnkCalc_lset;
 
 
+/* Evaluate compiled if possible */
+static long doCalc(double *parg, double *presult, const calcProgram *prog,
+    const char *post)
+{
+    return prog ? calcExecute(parg, presult, prog) :
+        calcPerform(parg, presult, post);
+}
+
+
 /*************************** jlif Routines **************************/
 
 static jlink* lnkCalc_alloc(short dbfType)
@@ -113,6 +125,9 @@ static void lnkCalc_free(jlink *pjlink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcProgramFree(clink->prog_expr);
+    calcProgramFree(clink->prog_major);
+    calcProgramFree(clink->prog_minor);
     free(clink->units);
     free(clink);
 }
@@ -222,6 +237,13 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
         return jlif_stop;
     }
 
+    if (clink->pstate == ps_major)
+        clink->prog_major = calcCompile(postbuf);
+    else if (clink->pstate == ps_minor)
+        clink->prog_minor = calcCompile(postbuf);
+    else
+        clink->prog_expr = calcCompile(postbuf);
+
     return jlif_continue;
 }
 
@@ -484,6 +506,9 @@ static void lnkCalc_remove(struct dbLocker *locker, struct link *plink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcProgramFree(clink->prog_expr);
+    calcProgramFree(clink->prog_major);
+    calcProgramFree(clink->prog_minor);
     free(clink->units);
     free(clink);
     plink->value.json.jlink = NULL;
@@ -578,7 +603,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     clink->sevr = 0;
 
     if (clink->post_expr) {
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = doCalc(clink->arg, &clink->val, clink->prog_expr,
+            clink->post_expr);
         if (!status)
             status = conv(&clink->val, pbuffer, NULL);
         if (!status && pnRequest)
@@ -593,7 +619,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = doCalc(clink->arg, &alval, clink->prog_major,
+            clink->post_major);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -604,7 +631,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = doCalc(clink->arg, &alval, clink->prog_minor,
+            clink->post_minor);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
@@ -652,12 +680,14 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     status = conv(pbuffer, &clink->val, NULL);
 
     if (!status && clink->post_expr)
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = doCalc(clink->arg, &clink->val, clink->prog_expr,
+            clink->post_expr);
 
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = doCalc(clink->arg, &alval, clink->prog_major,
+            clink->post_major);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -668,7 +698,8 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = doCalc(clink->arg, &alval, clink->prog_minor,
+            clink->post_minor);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
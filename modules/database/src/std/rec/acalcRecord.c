@@ -0,0 +1,331 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Record Support Routines for Array Calculation records */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "cantProceed.h"
+#include "dbAccess.h"
+#include "dbEvent.h"
+#include "dbFldTypes.h"
+#include "dbLink.h"
+#include "errMdef.h"
+#include "recSup.h"
+#include "recGbl.h"
+#include "special.h"
+
+#define GEN_SIZE_OFFSET
+#include "acalcRecord.h"
+#undef  GEN_SIZE_OFFSET
+#include "epicsExport.h"
+
+/* Create RSET - Record Support Entry Table */
+
+#define report NULL
+#define initialize NULL
+static long init_record(struct dbCommon *prec, int pass);
+static long process(struct dbCommon *prec);
+static long special(DBADDR *paddr, int after);
+#define get_value NULL
+static long cvt_dbaddr(DBADDR *paddr);
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset);
+static long put_array_info(DBADDR *paddr, long nNew);
+static long get_units(DBADDR *paddr, char *units);
+static long get_precision(const DBADDR *paddr, long *precision);
+#define get_enum_str NULL
+#define get_enum_strs NULL
+#define put_enum_str NULL
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd);
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd);
+#define get_alarm_double NULL
+
+rset acalcRSET={
+    RSETNUMBER,
+    report,
+    initialize,
+    init_record,
+    process,
+    special,
+    get_value,
+    cvt_dbaddr,
+    get_array_info,
+    put_array_info,
+    get_units,
+    get_precision,
+    get_enum_str,
+    get_enum_strs,
+    put_enum_str,
+    get_graphic_double,
+    get_control_double,
+    get_alarm_double
+};
+epicsExportAddress(rset, acalcRSET);
+
+static void monitor(acalcRecord *prec, epicsUInt32 nordLast);
+static int fetch_values(acalcRecord *prec);
+
+#define indexof(field) acalcRecord##field
+
+static long init_record(struct dbCommon *pcommon, int pass)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    struct link *plink = &prec->inpa;
+    double **pvalue = &prec->a;
+    epicsUInt32 *pcount = &prec->nea;
+    short error_number;
+    int i;
+
+    if (pass == 0) {
+        if (prec->nelm <= 0)
+            prec->nelm = 1;
+        prec->val = callocMustSucceed(prec->nelm, sizeof(double),
+            "acalc calloc failed");
+        prec->nord = 0;
+        for (i = 0; i < CALCPERFORM_NARGS; i++, pvalue++)
+            *pvalue = callocMustSucceed(prec->nelm, sizeof(double),
+                "acalc calloc failed");
+        prec->work = calcArrayCreate();
+        if (!prec->work)
+            cantProceed("acalc calcArrayCreate failed");
+        return 0;
+    }
+
+    /* A constant input is a scalar unless it holds an array */
+    for (i = 0; i < CALCPERFORM_NARGS; i++, plink++, pvalue++, pcount++) {
+        long n = prec->nelm;
+
+        *pcount = 1;
+        if (dbLinkIsConstant(plink) &&
+            dbLoadLinkArray(plink, DBR_DOUBLE, *pvalue, &n) == 0 && n > 1)
+            *pcount = n;
+    }
+    if (postfix(prec->calc, prec->rpcl, &error_number)) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "acalc: init_record: Illegal CALC field");
+        errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
+                     prec->name, calcErrorStr(error_number), prec->calc);
+    }
+    prec->rprg = calcCompile(prec->rpcl);
+    return 0;
+}
+
+static long process(struct dbCommon *pcommon)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    epicsUInt32 nordLast = prec->nord;
+
+    prec->pact = TRUE;
+    if (fetch_values(prec) == 0) {
+        calcArrayArg args[CALCPERFORM_NARGS];
+        calcArrayArg result;
+        double **pvalue = &prec->a;
+        epicsUInt32 *pcount = &prec->nea;
+        int i;
+
+        for (i = 0; i < CALCPERFORM_NARGS; i++, pvalue++, pcount++) {
+            args[i].pvalue = *pvalue;
+            args[i].count = *pcount;
+        }
+        result.pvalue = prec->val;
+        result.count = prec->nord;
+        if (!prec->rprg ||
+            calcArrayExecute(prec->work, args, &result, prec->nelm,
+                prec->rprg)) {
+            recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
+        } else {
+            prec->nord = result.count;
+            prec->udf = FALSE;
+        }
+    }
+
+    recGblGetTimeStamp(prec);
+    if (prec->udf)
+        recGblSetSevr(prec, UDF_ALARM, prec->udfs);
+    monitor(prec, nordLast);
+    /* process the forward scan link record */
+    recGblFwdLink(prec);
+    prec->pact = FALSE;
+    return 0;
+}
+
+static long special(DBADDR *paddr, int after)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    short error_number;
+
+    if (!after) return 0;
+    if (paddr->special == SPC_CALC) {
+        long status = postfix(prec->calc, prec->rpcl, &error_number);
+
+        calcProgramFree(prec->rprg);
+        prec->rprg = calcCompile(prec->rpcl);
+        if (status) {
+            recGblRecordError(S_db_badField, (void *)prec,
+                              "acalc: Illegal CALC field");
+            errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
+                         prec->name, calcErrorStr(error_number), prec->calc);
+            return S_db_badField;
+        }
+        return 0;
+    }
+    recGblDbaddrError(S_db_badChoice, paddr, "acalc::special - bad special value!");
+    return S_db_badChoice;
+}
+
+static long get_linkNumber(int fieldIndex) {
+    if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        return fieldIndex - indexof(A);
+    return -1;
+}
+
+static long cvt_dbaddr(DBADDR *paddr)
+{
+    acalcRecord *prec = (acalcRecord *) paddr->precord;
+    int linkNumber = get_linkNumber(dbGetFieldIndex(paddr));
+
+    paddr->pfield = linkNumber >= 0 ? (&prec->a)[linkNumber] : prec->val;
+    paddr->no_elements = prec->nelm;
+    paddr->field_type = DBF_DOUBLE;
+    paddr->field_size = sizeof(double);
+    paddr->dbr_field_type = DBR_DOUBLE;
+    return 0;
+}
+
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
+{
+    acalcRecord *prec = (acalcRecord *) paddr->precord;
+    int linkNumber = get_linkNumber(dbGetFieldIndex(paddr));
+
+    if (linkNumber >= 0) {
+        paddr->pfield = (&prec->a)[linkNumber];
+        *no_elements = (&prec->nea)[linkNumber];
+    } else {
+        paddr->pfield = prec->val;
+        *no_elements = prec->nord;
+    }
+    *offset = 0;
+    return 0;
+}
+
+static long put_array_info(DBADDR *paddr, long nNew)
+{
+    acalcRecord *prec = (acalcRecord *) paddr->precord;
+    int linkNumber = get_linkNumber(dbGetFieldIndex(paddr));
+
+    if (linkNumber >= 0)
+        (&prec->nea)[linkNumber] = nNew;
+    else
+        prec->nord = nNew;
+    return 0;
+}
+
+static long get_units(DBADDR *paddr, char *units)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int linkNumber = get_linkNumber(dbGetFieldIndex(paddr));
+
+    if (linkNumber >= 0)
+        dbGetUnits(&prec->inpa + linkNumber, units, DB_UNITS_SIZE);
+    else if (dbGetFieldIndex(paddr) == indexof(VAL))
+        strncpy(units, prec->egu, DB_UNITS_SIZE);
+    return 0;
+}
+
+static long get_precision(const DBADDR *paddr, long *pprecision)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+    int linkNumber;
+
+    *pprecision = prec->prec;
+    if (fieldIndex == indexof(VAL))
+        return 0;
+
+    linkNumber = get_linkNumber(fieldIndex);
+    if (linkNumber >= 0) {
+        short precision;
+
+        if (dbGetPrecision(&prec->inpa + linkNumber, &precision) == 0)
+            *pprecision = precision;
+    } else
+        recGblGetPrec(paddr, pprecision);
+    return 0;
+}
+
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+    int linkNumber;
+
+    if (fieldIndex == indexof(VAL)) {
+        pgd->lower_disp_limit = prec->lopr;
+        pgd->upper_disp_limit = prec->hopr;
+        return 0;
+    }
+    linkNumber = get_linkNumber(fieldIndex);
+    if (linkNumber >= 0) {
+        dbGetGraphicLimits(&prec->inpa + linkNumber,
+            &pgd->lower_disp_limit,
+            &pgd->upper_disp_limit);
+    } else
+        recGblGetGraphicDouble(paddr, pgd);
+    return 0;
+}
+
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+
+    if (dbGetFieldIndex(paddr) == indexof(VAL)) {
+        pcd->lower_ctrl_limit = prec->lopr;
+        pcd->upper_ctrl_limit = prec->hopr;
+    } else
+        recGblGetControlDouble(paddr, pcd);
+    return 0;
+}
+
+static void monitor(acalcRecord *prec, epicsUInt32 nordLast)
+{
+    unsigned short monitor_mask = recGblResetAlarms(prec);
+
+    monitor_mask |= DBE_VALUE | DBE_LOG;
+    db_post_events(prec, prec->val, monitor_mask);
+    if (prec->nord != nordLast)
+        db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
+}
+
+static int fetch_values(acalcRecord *prec)
+{
+    struct link *plink = &prec->inpa;
+    double **pvalue = &prec->a;
+    epicsUInt32 *pcount = &prec->nea;
+    long status = 0;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++, plink++, pvalue++, pcount++) {
+        long nRequest = prec->nelm;
+        int newStatus;
+
+        /* constant inputs keep their values, which may have been put */
+        if (dbLinkIsConstant(plink))
+            continue;
+        newStatus = dbGetLink(plink, DBR_DOUBLE, *pvalue, 0, &nRequest);
+        if (newStatus == 0)
+            *pcount = nRequest;
+        if (status == 0) status = newStatus;
+    }
+    return status;
+}
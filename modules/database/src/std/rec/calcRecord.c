@@ -107,6 +107,7 @@ static long init_record(struct dbCommon *pcommon, int pass)
         errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
                      prec->name, calcErrorStr(error_number), prec->calc);
     }
+    prec->rprg = calcCompile(prec->rpcl);
     return 0;
 }
 
@@ -117,7 +118,8 @@ static long process(struct dbCommon *pcommon)
 
     prec->pact = TRUE;
     if (fetch_values(prec) == 0) {
-        if (calcPerform(&prec->a, &prec->val, prec->rpcl)) {
+        if (prec->rprg ? calcExecute(&prec->a, &prec->val, prec->rprg) :
+            calcPerform(&prec->a, &prec->val, prec->rpcl)) {
             recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
         } else
             prec->udf = isnan(prec->val);
@@ -142,7 +144,11 @@ static long special(DBADDR *paddr, int after)
 
     if (!after) return 0;
     if (paddr->special == SPC_CALC) {
-        if (postfix(prec->calc, prec->rpcl, &error_number)) {
+        long status = postfix(prec->calc, prec->rpcl, &error_number);
+
+        calcProgramFree(prec->rprg);
+        prec->rprg = calcCompile(prec->rpcl);
+        if (status) {
             recGblRecordError(S_db_badField, (void *)prec,
                               "calc: Illegal CALC field");
             errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
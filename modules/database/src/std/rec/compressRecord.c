@@ -91,6 +91,13 @@ static void reset(compressRecord *prec)
     if (prec->alg == compressALG_Average && prec->sptr == NULL) {
         prec->sptr = calloc(prec->nsam, sizeof(double));
     }
+    /* scalar percentiles keep the last N samples, N may have changed */
+    if (prec->alg == compressALG_N_to_1_Percentile) {
+        epicsUInt32 n = prec->n > prec->nsam ? prec->n : prec->nsam;
+
+        free(prec->sptr);
+        prec->sptr = calloc(n, sizeof(double));
+    }
 
     if (prec->bptr && prec->nsam)
         memset(prec->bptr, 0, prec->nsam * sizeof(double));
@@ -108,52 +115,180 @@ static void monitor(compressRecord *prec)
     db_post_events(prec, prec->bptr, monitor_mask);
 }
 
-static void put_value(compressRecord *prec, double *psource, int n)
+static void put_value(compressRecord *prec, double *psource, epicsUInt32 n)
 {
     int fifo = (prec->balg == bufferingALG_FIFO);
     epicsUInt32 offset = prec->off;
     epicsUInt32 nuse = prec->nuse;
     epicsUInt32 nsam = prec->nsam;
+    double *pdest = prec->bptr;
 
     nuse += n;
     if (nuse > nsam)
         nuse = nsam;
 
-    while (n--) {
-        /* for LIFO, pre-decrement modulo nsam */
-        if (!fifo)
-            offset = (offset + nsam - 1) % nsam;
+    /* only the last nsam values would survive */
+    if (n > nsam) {
+        epicsUInt32 skip = (n - nsam) % nsam;
 
-        prec->bptr[offset] = *psource++;
+        psource += n - nsam;
+        n = nsam;
+        offset = fifo ? (offset + skip) % nsam : (offset + nsam - skip) % nsam;
+    }
 
-        /* for FIFO, post-increment modulo nsam */
-        if (fifo)
-            offset = (offset + 1) % nsam;
+    if (fifo) {
+        /* copy in at most two pieces, post-incrementing modulo nsam */
+        epicsUInt32 first = nsam - offset;
+
+        if (first > n)
+            first = n;
+        memcpy(pdest + offset, psource, first * sizeof(double));
+        memcpy(pdest, psource + first, (n - first) * sizeof(double));
+        offset = (offset + n) % nsam;
+    }
+    else {
+        /* for LIFO, pre-decrement modulo nsam */
+        while (n--) {
+            if (offset == 0)
+                offset = nsam;
+            pdest[--offset] = *psource++;
+        }
     }
 
     prec->off = offset;
     prec->nuse = nuse;
 }
 
+/* The block kernels below keep four independent partial results so the
+ * compiler can vectorize them and the loops aren't limited by latency.
+ */
 
-/* qsort comparison function (for median calculation) */
-static int compare(const void *arg1, const void *arg2)
+static double block_low(const double *psource, epicsInt32 n)
 {
-    double a = *(double *)arg1;
-    double b = *(double *)arg2;
+    double v0 = psource[0], v1 = v0, v2 = v0, v3 = v0;
+    epicsInt32 j = 1;
+
+    for (; j + 4 <= n; j += 4) {
+        v0 = psource[j] < v0 ? psource[j] : v0;
+        v1 = psource[j + 1] < v1 ? psource[j + 1] : v1;
+        v2 = psource[j + 2] < v2 ? psource[j + 2] : v2;
+        v3 = psource[j + 3] < v3 ? psource[j + 3] : v3;
+    }
+    for (; j < n; j++)
+        v0 = psource[j] < v0 ? psource[j] : v0;
+    v0 = v1 < v0 ? v1 : v0;
+    v2 = v3 < v2 ? v3 : v2;
+    return v2 < v0 ? v2 : v0;
+}
 
-    if      ( a <  b ) return -1;
-    else if ( a == b ) return  0;
-    else               return  1;
+static double block_high(const double *psource, epicsInt32 n)
+{
+    double v0 = psource[0], v1 = v0, v2 = v0, v3 = v0;
+    epicsInt32 j = 1;
+
+    for (; j + 4 <= n; j += 4) {
+        v0 = psource[j] > v0 ? psource[j] : v0;
+        v1 = psource[j + 1] > v1 ? psource[j + 1] : v1;
+        v2 = psource[j + 2] > v2 ? psource[j + 2] : v2;
+        v3 = psource[j + 3] > v3 ? psource[j + 3] : v3;
+    }
+    for (; j < n; j++)
+        v0 = psource[j] > v0 ? psource[j] : v0;
+    v0 = v1 > v0 ? v1 : v0;
+    v2 = v3 > v2 ? v3 : v2;
+    return v2 > v0 ? v2 : v0;
+}
+
+static double block_sum(const double *psource, epicsInt32 n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    epicsInt32 j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+        s0 += psource[j];
+        s1 += psource[j + 1];
+        s2 += psource[j + 2];
+        s3 += psource[j + 3];
+    }
+    for (; j < n; j++)
+        s0 += psource[j];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double block_sum_squares(const double *psource, epicsInt32 n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    epicsInt32 j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+        s0 += psource[j] * psource[j];
+        s1 += psource[j + 1] * psource[j + 1];
+        s2 += psource[j + 2] * psource[j + 2];
+        s3 += psource[j + 3] * psource[j + 3];
+    }
+    for (; j < n; j++)
+        s0 += psource[j] * psource[j];
+    return (s0 + s1) + (s2 + s3);
+}
+
+#define SWAP(a, b) { double tmp = (a); (a) = (b); (b) = tmp; }
+
+/* Return the k'th smallest of n values, partially reordering them.
+ * Quickselect with a median of three pivot, O(n) on average.
+ */
+static double select_kth(double *pv, epicsInt32 n, epicsInt32 k)
+{
+    epicsInt32 lo = 0, hi = n - 1;
+
+    while (lo < hi) {
+        epicsInt32 mid = lo + (hi - lo) / 2;
+        epicsInt32 i = lo, j = hi;
+        double pivot;
+
+        if (pv[mid] < pv[lo]) SWAP(pv[mid], pv[lo]);
+        if (pv[hi] < pv[lo]) SWAP(pv[hi], pv[lo]);
+        if (pv[hi] < pv[mid]) SWAP(pv[hi], pv[mid]);
+        pivot = pv[mid];
+
+        while (i <= j) {
+            while (i <= hi && pv[i] < pivot) i++;
+            while (j >= lo && pivot < pv[j]) j--;
+            if (i <= j) {
+                SWAP(pv[i], pv[j]);
+                i++;
+                j--;
+            }
+        }
+        /* now [lo, j] <= pivot <= [i, hi], values between equal pivot */
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            break;
+    }
+    return pv[k];
+}
+
+/* Index of the PCTL percentile in n sorted values */
+static epicsInt32 percentile_index(compressRecord *prec, epicsInt32 n)
+{
+    double pctl = prec->pctl;
+
+    if (!(pctl > 0))
+        pctl = 0;
+    else if (pctl > 100)
+        pctl = 100;
+    return (epicsInt32) floor(pctl / 100 * (n - 1) + 0.5);
 }
 
 static int compress_array(compressRecord *prec,
     double *psource, int no_elements)
 {
-    epicsInt32 i,j;
-    epicsInt32 n, nnew;
+    epicsInt32 i;
+    epicsInt32 n, nnew, k;
     epicsInt32 nsam = prec->nsam;
-    double value;
+    double *pdest;
 
     /* skip out of limit data */
     if (prec->ilil < prec->ihil) {
@@ -174,51 +309,45 @@ static int compress_array(compressRecord *prec,
         nnew = (no_elements / n);
     else nnew = nsam;
 
+    /* Results overwrite the start of the work buffer, each one lands
+     * at or before the block it was computed from.
+     */
+    pdest = psource;
+
     /* compress according to specified algorithm */
     switch (prec->alg){
     case compressALG_N_to_1_Low_Value:
         /* compress N to 1 keeping the lowest value */
-        for (i = 0; i < nnew; i++) {
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++) {
-                if (value > *psource)
-                    value = *psource;
-            }
-            put_value(prec, &value, 1);
-        }
+        for (i = 0; i < nnew; i++, psource += n)
+            pdest[i] = block_low(psource, n);
         break;
     case compressALG_N_to_1_High_Value:
         /* compress N to 1 keeping the highest value */
-        for (i = 0; i < nnew; i++){
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++) {
-                if (value < *psource)
-                    value = *psource;
-            }
-            put_value(prec, &value, 1);
-        }
+        for (i = 0; i < nnew; i++, psource += n)
+            pdest[i] = block_high(psource, n);
         break;
     case compressALG_N_to_1_Average:
         /* compress N to 1 keeping the average value */
-        for (i = 0; i < nnew; i++) {
-            value = 0;
-            for (j = 0; j < n; j++, psource++)
-                value += *psource;
-            value /= n;
-            put_value(prec, &value, 1);
-        }
+        for (i = 0; i < nnew; i++, psource += n)
+            pdest[i] = block_sum(psource, n) / n;
+        break;
+    case compressALG_N_to_1_RMS:
+        /* compress N to 1 keeping the root mean square */
+        for (i = 0; i < nnew; i++, psource += n)
+            pdest[i] = sqrt(block_sum_squares(psource, n) / n);
         break;
 
     case compressALG_N_to_1_Median:
-        /* compress N to 1 keeping the median value */
-        /* note: sorts source array (OK; it's a work pointer) */
-        for (i = 0; i < nnew; i++, psource += nnew) {
-            qsort(psource, n, sizeof(double), compare);
-            value = psource[n / 2];
-            put_value(prec, &value, 1);
-        }
+    case compressALG_N_to_1_Percentile:
+        /* compress N to 1 keeping the median or PCTL percentile value */
+        /* note: reorders source array (OK; it's a work pointer) */
+        k = prec->alg == compressALG_N_to_1_Median ? n / 2 :
+            percentile_index(prec, n);
+        for (i = 0; i < nnew; i++, psource += n)
+            pdest[i] = select_kth(psource, n, k);
         break;
     }
+    put_value(prec, pdest, nnew);
     return 0;
 }
 
@@ -299,6 +428,23 @@ static int compress_scalar(struct compressRecord *prec,double *psource)
                 *pdest = *pdest / (inx + 1);
         }
         break;
+    case (compressALG_N_to_1_RMS):
+        if (inx == 0)
+            *pdest = value * value;
+        else
+            *pdest += value * value;
+        if (inx + 1 >= prec->n)
+            *pdest = sqrt(*pdest / (inx + 1));
+        break;
+    case (compressALG_N_to_1_Percentile):
+        /* the last N samples are kept in the summing buffer */
+        if (!prec->sptr)
+            break;
+        prec->sptr[inx] = value;
+        if (inx + 1 >= prec->n)
+            *pdest = select_kth(prec->sptr, inx + 1,
+                percentile_index(prec, inx + 1));
+        break;
     }
     inx++;
     if (inx >= prec->n) {
@@ -22,6 +22,7 @@
 #include <limits.h>
 
 #include "dbDefs.h"
+#include "epicsAtomic.h"
 #include "epicsPrint.h"
 #include "alarm.h"
 #include "callback.h"
@@ -35,11 +36,11 @@
 #include "recSup.h"
 #include "recGbl.h"
 #include "menuYesNo.h"
+#include "epicsExport.h"
 
 #define GEN_SIZE_OFFSET
 #include "histogramRecord.h"
 #undef  GEN_SIZE_OFFSET
-#include "epicsExport.h"
 
 #define indexof(field) histogramRecord##field
 
@@ -104,7 +105,18 @@ typedef struct myCallback {
     histogramRecord *prec;
 } myCallback;
 
+/* Counts binned by histogramAccumulate(), not yet added to VAL */
+typedef struct accumulator {
+    int pending;            /* non-zero if any bins have counts */
+    int bins[1];            /* nelm of them */
+} accumulator;
+
+/* Samples are binned in blocks of this many */
+#define BIN_BLOCK 256
+
 static long add_count(histogramRecord *);
+static long add_samples(histogramRecord *);
+static void add_accumulated(histogramRecord *);
 static long clear_histogram(histogramRecord *);
 static void monitor(histogramRecord *);
 static long readValue(histogramRecord *);
@@ -175,6 +187,13 @@ static long init_record(struct dbCommon *pcommon, int pass)
             prec->bptr = calloc(prec->nelm, sizeof(epicsUInt32));
         }
 
+        /* samples read from an array, and counts from device threads */
+        if (prec->nsam > 1 && !prec->sptr)
+            prec->sptr = calloc(prec->nsam, sizeof(double));
+        if (!prec->apvt)
+            prec->apvt = calloc(1, sizeof(accumulator) +
+                (prec->nelm - 1) * sizeof(int));
+
         /* calulate width of array element */
         prec->wdth = (prec->ulim - prec->llim) / prec->nelm;
         return 0;
@@ -230,10 +249,15 @@ static long process(struct dbCommon *pcommon)
 
     recGblGetTimeStampSimm(prec, prec->simm, &prec->siol);
 
-    if (status == 0)
-        add_count(prec);
+    if (status == 0) {
+        if (prec->nsam > 1)
+            add_samples(prec);
+        else
+            add_count(prec);
+    }
     else if (status == 2)
         status = 0;
+    add_accumulated(prec);
 
     monitor(prec);
     recGblFwdLink(prec);
@@ -332,32 +356,71 @@ static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
     return 0;
 }
 
-static long add_count(histogramRecord *prec)
+/*
+ * Find the bins of n samples, or -1 for samples outside the limits.
+ * Sample x goes in the first bin i with x - llim <= (i + 1) * wdth.
+ * The loop has no branches so the compiler can vectorize it.
+ */
+static void find_bins(const histogramRecord *prec, const double *samples,
+    long n, int *bins)
 {
-    double temp;
-    epicsUInt32 *pdest;
-    int i;
-
-    if (prec->csta == FALSE)
-        return 0;
+    const double llim = prec->llim;
+    const double ulim = prec->ulim;
+    const double wdth = prec->wdth;
+    const double last = prec->nelm - 1;
+    long j;
+
+    for (j = 0; j < n; j++) {
+        double temp = samples[j] - llim;
+        int inside = samples[j] >= llim && samples[j] < ulim;
+        double bin = ceil(temp / wdth) - 1;
+        int i;
+
+        bin = bin < 0 ? 0 : bin > last ? last : bin;
+        i = (int) (inside ? bin : 0);
+        /* correct for rounding in the division */
+        i -= i > 0 && temp <= i * wdth;
+        i += i < last && temp > (i + 1) * wdth;
+        bins[j] = inside ? i : -1;
+    }
+}
 
+static int check_limits(histogramRecord *prec)
+{
     if (prec->llim >= prec->ulim) {
         if (prec->nsev < INVALID_ALARM) {
             prec->stat = SOFT_ALARM;
             prec->sevr = INVALID_ALARM;
-            return -1;
         }
+        return -1;
     }
-    if (prec->sgnl < prec->llim ||
-        prec->sgnl >= prec->ulim)
+    return 0;
+}
+
+static void add_mcnt(histogramRecord *prec, unsigned long n)
+{
+    if (n >= (unsigned long) (SHRT_MAX - prec->mcnt))
+        prec->mcnt = SHRT_MAX;
+    else
+        prec->mcnt += (epicsInt16) n;
+}
+
+static long add_count(histogramRecord *prec)
+{
+    epicsUInt32 *pdest;
+    int i;
+
+    if (prec->csta == FALSE)
         return 0;
 
-    temp = prec->sgnl - prec->llim;
-    for (i = 1; i <= prec->nelm; i++){
-        if (temp <= (double) i * prec->wdth)
-            break;
-    }
-    pdest = prec->bptr + i - 1;
+    if (check_limits(prec))
+        return -1;
+
+    find_bins(prec, &prec->sgnl, 1, &i);
+    if (i < 0)
+        return 0;
+
+    pdest = prec->bptr + i;
     if (*pdest == (epicsUInt32) UINT_MAX)
         *pdest = 0;
     (*pdest)++;
@@ -366,10 +429,118 @@ static long add_count(histogramRecord *prec)
     return 0;
 }
 
+/* Add the NORD samples read into the sample buffer */
+static long add_samples(histogramRecord *prec)
+{
+    int bins[BIN_BLOCK];
+    unsigned long counted = 0;
+    long i, j, n;
+
+    if (prec->csta == FALSE || !prec->sptr)
+        return 0;
+
+    if (check_limits(prec))
+        return -1;
+
+    for (i = 0; i < (long) prec->nord; i += n) {
+        n = prec->nord - i < BIN_BLOCK ? prec->nord - i : BIN_BLOCK;
+        find_bins(prec, prec->sptr + i, n, bins);
+        for (j = 0; j < n; j++) {
+            if (bins[j] >= 0) {
+                epicsUInt32 *pdest = prec->bptr + bins[j];
+
+                if (*pdest == (epicsUInt32) UINT_MAX)
+                    *pdest = 0;
+                (*pdest)++;
+                counted++;
+            }
+        }
+    }
+    add_mcnt(prec, counted);
+
+    return 0;
+}
+
+/*
+ * Called by device support without the record lock, from any thread.
+ * Counts are added to the accumulator bins atomically, and moved into
+ * VAL by the record's next process. The limits are read without the
+ * lock, changing them while samples are accumulated may put those
+ * samples in the wrong bins.
+ */
+long histogramAccumulate(histogramRecord *prec, const double *samples,
+    long nSamples)
+{
+    accumulator *pacc = (accumulator *) prec->apvt;
+    int bins[BIN_BLOCK];
+    long i, j, n;
+    int counted = 0;
+
+    if (!pacc || prec->csta == FALSE || prec->llim >= prec->ulim)
+        return 0;
+
+    for (i = 0; i < nSamples; i += n) {
+        n = nSamples - i < BIN_BLOCK ? nSamples - i : BIN_BLOCK;
+        find_bins(prec, samples + i, n, bins);
+        for (j = 0; j < n; j++) {
+            if (bins[j] >= 0) {
+                epicsAtomicIncrIntT(&pacc->bins[bins[j]]);
+                counted++;
+            }
+        }
+    }
+    if (counted)
+        epicsAtomicAddIntT(&pacc->pending, counted);
+    return counted;
+}
+
+/*
+ * Move counts from the accumulator into VAL, or just drop them if
+ * discard is set. Only the counts seen are subtracted, so counts added
+ * at the same time are kept for the next call.
+ */
+static unsigned long take_accumulated(histogramRecord *prec, int discard)
+{
+    accumulator *pacc = (accumulator *) prec->apvt;
+    unsigned long taken = 0;
+    int pending, i;
+
+    if (!pacc || !(pending = epicsAtomicGetIntT(&pacc->pending)))
+        return 0;
+    epicsAtomicAddIntT(&pacc->pending, -pending);
+
+    for (i = 0; i < prec->nelm; i++) {
+        int count = epicsAtomicGetIntT(&pacc->bins[i]);
+
+        if (count) {
+            epicsAtomicAddIntT(&pacc->bins[i], -count);
+            if (!discard) {
+                /* Wrap the way add_count() does, past UINT_MAX to 1 */
+                epicsUInt64 total = (epicsUInt64) prec->bptr[i] + count;
+
+                if (total > UINT_MAX)
+                    total -= UINT_MAX;
+                prec->bptr[i] = (epicsUInt32) total;
+            }
+            taken += count;
+        }
+    }
+    return taken;
+}
+
+static void add_accumulated(histogramRecord *prec)
+{
+    if (prec->csta == FALSE)
+        return;
+
+    add_mcnt(prec, take_accumulated(prec, FALSE));
+}
+
 static long clear_histogram(histogramRecord *prec)
 {
     int i;
 
+    take_accumulated(prec, TRUE);
     for (i = 0; i < prec->nelm; i++)
         prec->bptr[i] = 0;
     prec->mcnt = prec->mdel + 1;
@@ -399,6 +570,10 @@ static long readValue(histogramRecord *prec)
             status = dbGetLink(&prec->siol, DBR_DOUBLE, &prec->sval, 0, 0);
             if (status == 0) {
                 prec->sgnl = prec->sval;
+                if (prec->sptr) {
+                    prec->sptr[0] = prec->sval;
+                    prec->nord = 1;
+                }
                 prec->udf = FALSE;
             }
             prec->pact = FALSE;
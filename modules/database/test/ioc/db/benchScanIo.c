@@ -0,0 +1,137 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * I/O Intr scan benchmark: times the interrupt to completion callback
+ * interval of one scan list scanned by a single callback and split
+ * across parallel callback threads (scanIoParallelMin).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "callback.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbUnitTest.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+#include "devx.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int scanIoParallelMin;
+
+#define NPASSES 20
+
+typedef struct {
+    int processed;
+    int atComplete;
+    epicsEventId done;
+} benchData;
+
+static void benchRecord(xpriv *priv, void *raw)
+{
+    benchData *pdata = raw;
+    volatile double x = priv->member;
+    int i;
+
+    /* a little work, like a driver copying out its data */
+    for (i = 0; i < 200; i++)
+        x = x * 1.0001 + 1.0;
+    epicsAtomicIncrIntT(&pdata->processed);
+}
+
+static void benchComplete(void *raw, IOSCANPVT scan, int prio)
+{
+    benchData *pdata = raw;
+
+    pdata->atComplete = epicsAtomicGetIntT(&pdata->processed);
+    epicsEventMustTrigger(pdata->done);
+}
+
+/* Mean interrupt to completion time of one scan */
+static double timeScans(xdrv *drv, benchData *pdata, int count, int passes)
+{
+    epicsTimeStamp start, stop;
+    double total = 0.0;
+    int i, ok = 1;
+
+    for (i = 0; i < passes; i++) {
+        pdata->processed = 0;
+        epicsTimeGetCurrent(&start);
+        scanIoRequest(drv->scan);
+        epicsEventMustWait(pdata->done);
+        epicsTimeGetCurrent(&stop);
+        total += epicsTimeDiffInSeconds(&stop, &start);
+        if (pdata->atComplete != count)
+            ok = 0;
+    }
+    testOk(ok, "All %d records processed before completion", count);
+    return total / passes;
+}
+
+static void runBench(int count, int nthreads)
+{
+    benchData data;
+    double serial, parallel;
+    xdrv *drv;
+    int i;
+
+    memset(&data, 0, sizeof(data));
+    data.done = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < count; i++) {
+        char macros[40];
+
+        sprintf(macros, "GROUP=0,MEMBER=%d,PRIO=LOW", i);
+        testdbReadDatabase("scanIoTest.db", NULL, macros);
+    }
+
+    drv = xdrv_add(0, &benchRecord, &data);
+    scanIoSetComplete(drv->scan, &benchComplete, &data);
+    callbackParallelThreads(nthreads, "LOW");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    scanIoParallelMin = 0;
+    timeScans(drv, &data, count, 2);    /* warm up */
+    serial = timeScans(drv, &data, count, NPASSES);
+    scanIoParallelMin = 2;
+    parallel = timeScans(drv, &data, count, NPASSES);
+    scanIoParallelMin = 0;
+
+    testDiag("%5d records: serial %.3f ms, %d threads %.3f ms (%.1fx)",
+        count, serial * 1e3, nthreads, parallel * 1e3, serial / parallel);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    xdrv_reset();
+    epicsEventDestroy(data.done);
+}
+
+MAIN(benchScanIo)
+{
+    testPlan(0);
+    testDiag("%d CPUs", epicsThreadGetCPUs());
+    runBench(10, 4);
+    runBench(1000, 4);
+    runBench(8000, 4);
+    runBench(8000, 8);
+    return testDone();
+}
@@ -0,0 +1,144 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Scan cost benchmark: loads records for two I/O Intr scan lists and
+ * passive records interleaved with each other, then times scanning one
+ * of the lists with the records left in load order and after iocInit
+ * has relocated them into scan list order (iocInitScanLayout).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "callback.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "menuScan.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "devx.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int iocInitScanLayout;
+
+#define NPASSES 20
+
+/* Interleaves low and high priority I/O Intr and passive records */
+static void load(unsigned long nRecords)
+{
+    unsigned long i;
+
+    for (i = 0; i < nRecords; i++) {
+        char macros[20];
+
+        sprintf(macros, "N=%lu", i);
+        testdbReadDatabase("benchScanLayout.db", NULL, macros);
+    }
+}
+
+/* Only read the dbCommon fields of the low priority records, in the
+ * order of their scan list
+ */
+static double walkCost(unsigned long nRecords)
+{
+    dbCommon **precs = calloc(nRecords, sizeof(dbCommon *));
+    epicsTimeStamp start, stop;
+    DBENTRY entry;
+    unsigned long n = 0, i, sum = 0;
+    int pass;
+    long status;
+
+    if (!precs)
+        testAbort("Out of memory");
+    dbInitEntry(pdbbase, &entry);
+    status = dbFindRecordType(&entry, "x");
+    for (status = status ? status : dbFirstRecord(&entry); !status;
+         status = dbNextRecord(&entry)) {
+        dbCommon *prec = (dbCommon *) entry.precnode->precord;
+
+        if (!dbIsAlias(&entry) && prec->scan == menuScanI_O_Intr &&
+            prec->prio == priorityLow && n < nRecords)
+            precs[n++] = prec;
+    }
+    dbFinishEntry(&entry);
+
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < NPASSES; pass++) {
+        for (i = 0; i < n; i++) {
+            dbCommon *prec = precs[i];
+
+            if (!prec->pact && !prec->disp)
+                sum += prec->stat + prec->sevr + prec->time.nsec;
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    free(precs);
+    if (sum == 1)
+        testDiag("unlikely");
+    return epicsTimeDiffInSeconds(&stop, &start) / NPASSES / nRecords;
+}
+
+static double scanCost(unsigned long nRecords, int layout, double *pwalk)
+{
+    epicsTimeStamp start, stop;
+    xdrv *drv;
+    int pass;
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    drv = xdrv_add(1, NULL, NULL);
+    load(nRecords);
+
+    iocInitScanLayout = layout;
+    testIocInitOk();
+    iocInitScanLayout = 0;
+
+    /* warm up, then time */
+    scanIoImmediate(drv->scan, priorityLow);
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < NPASSES; pass++)
+        scanIoImmediate(drv->scan, priorityLow);
+    epicsTimeGetCurrent(&stop);
+    *pwalk += walkCost(nRecords) / 2;
+
+    testIocShutdownOk();
+    testdbCleanup();
+    xdrv_reset();
+    return epicsTimeDiffInSeconds(&stop, &start) / NPASSES / nRecords;
+}
+
+static void runBench(unsigned long nRecords)
+{
+    double loadOrder, scanOrder, loadWalk = 0, scanWalk = 0;
+
+    testDiag("%lu records on each scan list", nRecords);
+    /* the heap left by earlier runs matters, so alternate them */
+    loadOrder = scanCost(nRecords, 0, &loadWalk);
+    scanOrder = scanCost(nRecords, 1, &scanWalk);
+    scanOrder = (scanOrder + scanCost(nRecords, 1, &scanWalk)) / 2;
+    loadOrder = (loadOrder + scanCost(nRecords, 0, &loadWalk)) / 2;
+    testDiag("scan: load order %.1f ns/record, scan order %.1f ns/record "
+        "(%.2fx)", loadOrder * 1e9, scanOrder * 1e9, loadOrder / scanOrder);
+    testDiag("walk: load order %.1f ns/record, scan order %.1f ns/record "
+        "(%.2fx)", loadWalk * 1e9, scanWalk * 1e9, loadWalk / scanWalk);
+}
+
+MAIN(benchScanLayout)
+{
+    testPlan(0);
+    runBench(10000);
+    runBench(50000);
+    runBench(200000);
+    return testDone();
+}
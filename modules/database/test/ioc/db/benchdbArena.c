@@ -0,0 +1,135 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Record storage benchmark: loads synthetic databases with each record
+ * allocated separately (dbRecordArenaSize = 0) and from per-type blocks,
+ * and compares the heap used and the time taken to walk all of the
+ * records in database order, reading the fields a scan task touches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NPASSES 20
+
+/* Each record links to the next one, every fourth has an alias */
+static void load(unsigned long nRecords)
+{
+    unsigned long i;
+
+    for (i = 0; i < nRecords; i++) {
+        char macros[40];
+
+        sprintf(macros, "N=%lu,NEXT=%lu", i, (i + 1) % nRecords);
+        testdbReadDatabase("benchdbArena.db", NULL, macros);
+        if (i % 4 == 0)
+            testdbReadDatabase("benchdbArenaAlias.db", NULL, macros);
+    }
+}
+
+/* Bytes allocated from the heap, or 0 if unknown */
+static double heapUsed(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+
+    return (double) mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/* Visit the records the way the scan lists do, in load order */
+static double walk(unsigned long *psum)
+{
+    DBENTRY entry;
+    epicsTimeStamp start, stop;
+    unsigned long sum = 0;
+    int pass;
+    long status;
+
+    dbInitEntry(pdbbase, &entry);
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < NPASSES; pass++) {
+        status = dbFindRecordType(&entry, "x");
+        for (status = status ? status : dbFirstRecord(&entry); !status;
+             status = dbNextRecord(&entry)) {
+            xRecord *prec = (xRecord *) entry.precnode->precord;
+
+            if (!prec->pact && prec->scan == 0)
+                sum += prec->val + prec->inp.type;
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    dbFinishEntry(&entry);
+    *psum = sum;
+    return epicsTimeDiffInSeconds(&stop, &start) / NPASSES;
+}
+
+static void runBench(unsigned long nRecords)
+{
+    static const int sizes[] = {0, 65536};
+    double heap[2], loadTime[2], walkTime[2];
+    unsigned long sum[2];
+    int i;
+
+    testDiag("%lu records", nRecords);
+
+    for (i = 0; i < 2; i++) {
+        epicsTimeStamp start, stop;
+        double before;
+
+        dbRecordArenaSize = sizes[i];
+        testdbPrepare();
+        testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+        dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+        before = heapUsed();
+        epicsTimeGetCurrent(&start);
+        load(nRecords);
+        epicsTimeGetCurrent(&stop);
+        heap[i] = heapUsed() - before;
+        loadTime[i] = epicsTimeDiffInSeconds(&stop, &start);
+        walkTime[i] = walk(&sum[i]);
+        testdbCleanup();
+    }
+    dbRecordArenaSize = sizes[1];
+    testOk(sum[0] == sum[1], "Same records walked");
+
+    for (i = 0; i < 2; i++)
+        testDiag("%s: load %.3f s, walk %.2f ms, heap %.1f MB "
+            "(%.0f bytes/record)", sizes[i] ? "per-type blocks" : "separate",
+            loadTime[i], walkTime[i] * 1e3, heap[i] / 1e6,
+            heap[i] / nRecords);
+    if (heap[0] > 0)
+        testDiag("Blocks save %.1f MB, walk %.2fx faster",
+            (heap[0] - heap[1]) / 1e6, walkTime[0] / walkTime[1]);
+}
+
+MAIN(benchdbArena)
+{
+    testPlan(0);
+    runBench(100000);
+    runBench(500000);
+    return testDone();
+}
@@ -0,0 +1,186 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Startup benchmark: times loading synthetic databases of 100k to 2M
+ * records with dbLoadRecords() from one flat file, and as instances of
+ * a template with dbLoadTemplate(), both serially and with the files
+ * read ahead by dbTemplateLoadThreads threads, and from a binary image
+ * of the same records written with dbImageWrite().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dbAccess.h"
+#include "dbLoadTemplate.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int dbTemplateLoadThreads;
+
+#define RECORDS_PER_UNIT 4
+
+static const char unitFile[] = "benchdbLoad-unit.db";
+static const char subsFile[] = "benchdbLoad.substitutions";
+static const char flatFile[] = "benchdbLoad-flat.db";
+static const char imageFile[] = "benchdbLoad.dbi";
+
+static void writeUnit(FILE *fp, const char *prefix, const char *n)
+{
+    fprintf(fp,
+        "record(x, \"%s:in%s\") {\n"
+        "    field(DESC, \"Input %s\")\n"
+        "    field(SCAN, \"1 second\")\n"
+        "    field(INP, \"%s:calc%s NPP\")\n"
+        "    field(FLNK, \"%s:calc%s\")\n"
+        "}\n"
+        "record(x, \"%s:calc%s\") {\n"
+        "    field(DESC, \"Calculation %s\")\n"
+        "    field(INP, \"%s:in%s NPP\")\n"
+        "    field(FLNK, \"%s:out%s\")\n"
+        "    alias(\"%s:alias%s\")\n"
+        "}\n"
+        "record(x, \"%s:out%s\") {\n"
+        "    field(DESC, \"Output %s\")\n"
+        "    field(LNK, \"%s:status%s PP\")\n"
+        "}\n"
+        "record(x, \"%s:status%s\") {\n"
+        "    field(DESC, \"Status %s\")\n"
+        "    field(VAL, \"%s\")\n"
+        "}\n",
+        prefix, n, n, prefix, n, prefix, n,
+        prefix, n, n, prefix, n, prefix, n, prefix, n,
+        prefix, n, n, prefix, n,
+        prefix, n, n, n);
+}
+
+static void generate(unsigned long nUnits)
+{
+    FILE *unit = fopen(unitFile, "w");
+    FILE *subs = fopen(subsFile, "w");
+    FILE *flat = fopen(flatFile, "w");
+    unsigned long i;
+
+    if (!unit || !subs || !flat)
+        testAbort("Can't create database files");
+
+    writeUnit(unit, "$(P)", "$(N)");
+    fprintf(subs, "file \"%s\" {\npattern { P, N }\n", unitFile);
+    for (i = 0; i < nUnits; i++) {
+        char n[16];
+
+        sprintf(n, "%lu", i);
+        fprintf(subs, "{ bench, %s }\n", n);
+        writeUnit(flat, "bench", n);
+    }
+    fprintf(subs, "}\n");
+    fclose(unit);
+    fclose(subs);
+    fclose(flat);
+}
+
+static void prepare(void)
+{
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+}
+
+static void checkLoaded(unsigned long nUnits)
+{
+    DBENTRY entry;
+    char name[40];
+
+    dbInitEntry(pdbbase, &entry);
+    testOk(dbFindRecordType(&entry, "x") == 0 &&
+        dbGetNRecords(&entry) - dbGetNAliases(&entry) ==
+            (int) (nUnits * RECORDS_PER_UNIT),
+        "%lu records loaded", nUnits * RECORDS_PER_UNIT);
+    sprintf(name, "bench:alias%lu", nUnits - 1);
+    testOk(dbFindRecord(&entry, name) == 0 && dbIsAlias(&entry),
+        "Found alias %s", name);
+    dbFinishEntry(&entry);
+}
+
+static void runBench(unsigned long nRecords, int nThreads)
+{
+    unsigned long nUnits = nRecords / RECORDS_PER_UNIT;
+    epicsTimeStamp start, stop;
+    double flat, serial, ahead, image;
+
+    testDiag("%lu records", nUnits * RECORDS_PER_UNIT);
+    generate(nUnits);
+
+    prepare();
+    epicsTimeGetCurrent(&start);
+    testOk1(dbLoadRecords(flatFile, NULL) == 0);
+    epicsTimeGetCurrent(&stop);
+    flat = epicsTimeDiffInSeconds(&stop, &start);
+    checkLoaded(nUnits);
+    testOk1(dbImageWrite(pdbbase, imageFile) == 0);
+    testdbCleanup();
+
+    prepare();
+    epicsTimeGetCurrent(&start);
+    testOk1(dbLoadImage(imageFile) == 0);
+    epicsTimeGetCurrent(&stop);
+    image = epicsTimeDiffInSeconds(&stop, &start);
+    checkLoaded(nUnits);
+    testdbCleanup();
+
+    prepare();
+    dbTemplateLoadThreads = 0;
+    epicsTimeGetCurrent(&start);
+    dbLoadTemplate(subsFile, NULL);
+    epicsTimeGetCurrent(&stop);
+    serial = epicsTimeDiffInSeconds(&stop, &start);
+    checkLoaded(nUnits);
+    testdbCleanup();
+
+    prepare();
+    dbTemplateLoadThreads = nThreads;
+    epicsTimeGetCurrent(&start);
+    dbLoadTemplate(subsFile, NULL);
+    epicsTimeGetCurrent(&stop);
+    dbTemplateLoadThreads = 0;
+    ahead = epicsTimeDiffInSeconds(&stop, &start);
+    checkLoaded(nUnits);
+    testdbCleanup();
+
+    testDiag("dbLoadRecords %.3f s, dbLoadTemplate %.3f s, "
+        "with %d threads %.3f s (%.0f records/s)",
+        flat, serial, nThreads, ahead, nUnits * RECORDS_PER_UNIT / ahead);
+    testDiag("dbLoadImage %.3f s (%.0f records/s)",
+        image, nUnits * RECORDS_PER_UNIT / image);
+
+    remove(unitFile);
+    remove(subsFile);
+    remove(flatFile);
+    remove(imageFile);
+}
+
+MAIN(benchdbLoad)
+{
+    int nThreads = epicsThreadGetCPUs();
+
+    if (nThreads < 2)
+        nThreads = 2;
+
+    testPlan(0);
+    runBench(100000, nThreads);
+    runBench(500000, nThreads);
+    runBench(1000000, nThreads);
+    runBench(2000000, nThreads);
+    return testDone();
+}
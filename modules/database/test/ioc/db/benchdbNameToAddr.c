@@ -0,0 +1,116 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Name lookup benchmark: measures dbNameToAddr() calls per second for
+ * every field of a record type, with field names resolved through the
+ * record type's perfect hash and by binary search of the sorted names.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbBase.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECORDS 1000
+#define NPASSES 20
+
+/* All "record.FIELD" names, one per field of each record */
+static char ** makeNames(dbRecordType *prt, int *pcount)
+{
+    int count = NRECORDS * prt->no_fields;
+    char **names = calloc(count, sizeof(char *));
+    int i, j, n = 0;
+
+    if (!names)
+        testAbort("Out of memory");
+    for (i = 0; i < NRECORDS; i++) {
+        for (j = 0; j < prt->no_fields; j++) {
+            char name[PVNAME_STRINGSZ + 8];
+
+            sprintf(name, "lookup:rec%d.%s", i, prt->papFldDes[j]->name);
+            names[n++] = strdup(name);
+        }
+    }
+    *pcount = count;
+    return names;
+}
+
+static double lookup(char **names, int count)
+{
+    epicsTimeStamp start, stop;
+    DBADDR addr;
+    int pass, i, failed = 0;
+
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < NPASSES; pass++)
+        for (i = 0; i < count; i++)
+            if (dbNameToAddr(names[i], &addr))
+                failed++;
+    epicsTimeGetCurrent(&stop);
+    testOk(failed == 0, "%d names found", count - failed / NPASSES);
+    return NPASSES * count / epicsTimeDiffInSeconds(&stop, &start);
+}
+
+MAIN(benchdbNameToAddr)
+{
+    DBENTRY entry;
+    dbRecordType *prt;
+    short *fieldHash;
+    char **names;
+    int count, i;
+    double hashed, searched;
+
+    testPlan(0);
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NRECORDS; i++) {
+        char macros[20];
+
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("benchdbNameToAddr.db", NULL, macros);
+    }
+
+    dbInitEntry(pdbbase, &entry);
+    if (dbFindRecordType(&entry, "x"))
+        testAbort("No record type x");
+    prt = entry.precordType;
+    dbFinishEntry(&entry);
+    names = makeNames(prt, &count);
+    testDiag("%d records of type x with %d fields", NRECORDS,
+        prt->no_fields);
+
+    /* warm up, then alternate to even out cache effects */
+    lookup(names, count);
+    hashed = lookup(names, count);
+    fieldHash = prt->fieldHash;
+    prt->fieldHash = NULL;
+    searched = lookup(names, count);
+    searched = (searched + lookup(names, count)) / 2;
+    prt->fieldHash = fieldHash;
+    hashed = (hashed + lookup(names, count)) / 2;
+
+    testDiag("dbNameToAddr with field hash %.0f calls/s, "
+        "binary search %.0f calls/s (%.2fx)",
+        hashed, searched, hashed / searched);
+
+    for (i = 0; i < count; i++)
+        free(names[i]);
+    free(names);
+    testdbCleanup();
+    return testDone();
+}
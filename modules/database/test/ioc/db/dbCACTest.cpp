@@ -10,11 +10,15 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include <vector>
 #include <stdexcept>
 
 #include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <envDefs.h>
 
 #include "epicsUnitTest.h"
 
@@ -82,3 +86,97 @@ void dbCaLinkTest_testCAC(void)
         testAbort("Unexpected exception in testCAC: %s", e.what());
     }
 }
+
+extern "C"
+void ignoreUpdate(struct event_handler_args args)
+{
+}
+
+extern "C"
+void dbCaLinkTest_testCACBulk(void)
+{
+    testDiag("Bulk subscriptions skip null channels");
+    try {
+        CATestContext ctxt;
+        chid chans[2] = {0, 0};
+        evid evids[2];
+
+        testECA(ca_create_channel("target1", NULL, NULL, 0, &chans[1]));
+        testECA(ca_pend_io(1.0));
+        testECA(ca_create_subscriptions(DBR_DOUBLE, 1, 2, chans, DBE_VALUE,
+            ignoreUpdate, NULL, evids));
+        testOk(!evids[0] && evids[1], "event id only for the channel");
+        testECA(ca_clear_channels(2, chans));
+    }catch(std::exception& e){
+        testAbort("Unexpected exception in testCACBulk: %s", e.what());
+    }
+}
+
+namespace {
+struct blockedMonitor
+{
+    epicsEvent entered, release, cleared;
+    chid chanid;
+    int calls;
+    int running;
+    int runningAtClear;
+    bool nameOk;
+    blockedMonitor() :chanid(0), calls(0), running(0), runningAtClear(0),
+        nameOk(false) {}
+};
+}
+
+extern "C"
+void blockingUpdate(struct event_handler_args args)
+{
+    blockedMonitor *pmon = (blockedMonitor *) args.usr;
+
+    if (epicsAtomicIncrIntT(&pmon->calls) != 1)
+        return;
+    epicsAtomicSetIntT(&pmon->running, 1);
+    pmon->entered.signal();
+    pmon->release.wait(5.0);
+    // the chid must still be valid here
+    pmon->nameOk = strcmp(ca_name(args.chid), "target1") == 0;
+    epicsAtomicSetIntT(&pmon->running, 0);
+}
+
+extern "C"
+void clearBlocked(void *arg)
+{
+    blockedMonitor *pmon = (blockedMonitor *) arg;
+
+    ca_clear_channel(pmon->chanid);
+    pmon->runningAtClear = epicsAtomicGetIntT(&pmon->running);
+    pmon->cleared.signal();
+}
+
+extern "C"
+void dbCaLinkTest_testCACDispatch(void)
+{
+    testDiag("Clear a channel while its update callback is running");
+    try {
+        epicsEnvSet("EPICS_CA_MONITOR_THREADS", "2");
+        CATestContext ctxt;
+        epicsEnvUnset("EPICS_CA_MONITOR_THREADS");
+        blockedMonitor mon;
+        evid evid;
+
+        testECA(ca_create_channel("target1", NULL, NULL, 0, &mon.chanid));
+        testECA(ca_pend_io(1.0));
+        testECA(ca_create_subscription(DBR_DOUBLE, 1, mon.chanid, DBE_VALUE,
+            blockingUpdate, &mon, &evid));
+        testOk(mon.entered.wait(5.0), "update callback running");
+
+        epicsThreadCreate("clearBlocked", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            clearBlocked, &mon);
+        testOk(!mon.cleared.wait(0.2), "ca_clear_channel() waits for it");
+        mon.release.signal();
+        testOk(mon.cleared.wait(5.0), "ca_clear_channel() returned");
+        testOk(!mon.runningAtClear && mon.nameOk,
+               "callback completed with a valid chid before that");
+    }catch(std::exception& e){
+        testAbort("Unexpected exception in testCACDispatch: %s", e.what());
+    }
+}
@@ -573,6 +573,8 @@ static void testreTargetTypeChange(void)
 }
 
 void dbCaLinkTest_testCAC(void);
+void dbCaLinkTest_testCACBulk(void);
+void dbCaLinkTest_testCACDispatch(void);
 
 static void testCAC(void)
 {
@@ -602,6 +604,8 @@ static void testCAC(void)
     buftarg2= ptarg2->bptr;
 
     dbCaLinkTest_testCAC();
+    dbCaLinkTest_testCACBulk();
+    dbCaLinkTest_testCACDispatch();
 
     testIocShutdownOk();
 
@@ -617,7 +621,7 @@ static void testCAC(void)
 
 MAIN(dbCaLinkTest)
 {
-    testPlan(101);
+    testPlan(113);
     testNativeLink();
     testStringLink();
     testCP();
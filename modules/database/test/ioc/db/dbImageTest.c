@@ -0,0 +1,146 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Tests for binary database images
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "epicsStdio.h"
+#include "epicsUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char imageFile[] = "dbImageTest.dbi";
+static const char badFile[] = "dbImageTest-bad.dbi";
+
+static void prepare(void)
+{
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+}
+
+/* All records with all of their fields, as text */
+static char * dumpRecords(void)
+{
+    FILE *fp = epicsTempFile();
+    char *text;
+    long size;
+
+    if (!fp)
+        testAbort("Can't create temporary file");
+    dbWriteRecordFP(pdbbase, fp, NULL, 2);
+    size = ftell(fp);
+    rewind(fp);
+    text = calloc(1, size + 1);
+    if (!text || fread(text, 1, size, fp) != (size_t) size)
+        testAbort("Can't read temporary file");
+    fclose(fp);
+    return text;
+}
+
+/* Copy the image, changing one byte and possibly truncating it */
+static void copyImage(long offset, long length)
+{
+    FILE *in = fopen(imageFile, "rb");
+    FILE *out = fopen(badFile, "wb");
+    long i;
+    int ch;
+
+    if (!in || !out)
+        testAbort("Can't copy %s", imageFile);
+    for (i = 0; (ch = getc(in)) != EOF && (length < 0 || i < length); i++)
+        putc(i == offset ? ch ^ 0x55 : ch, out);
+    fclose(in);
+    fclose(out);
+}
+
+static void testRoundTrip(void)
+{
+    char *fromText, *fromImage;
+    DBENTRY entry;
+
+    testDiag("Write and load an image");
+
+    prepare();
+    testdbReadDatabase("dbImageTest.db", NULL, NULL);
+    fromText = dumpRecords();
+    testOk1(dbWriteImage(imageFile) == 0);
+    testdbCleanup();
+
+    prepare();
+    testOk1(dbLoadImage(imageFile) == 0);
+    fromImage = dumpRecords();
+    testOk(strcmp(fromText, fromImage) == 0, "Records match the text load");
+    if (strcmp(fromText, fromImage) != 0)
+        testDiag("Expected:\n%s\nLoaded:\n%s", fromText, fromImage);
+    free(fromText);
+    free(fromImage);
+
+    dbInitEntry(pdbbase, &entry);
+    testOk1(dbFindRecord(&entry, "srcAlias2") == 0 && dbIsAlias(&entry));
+    testOk1(dbFollowAlias(&entry) == 0 &&
+        strcmp(dbGetRecordName(&entry), "src") == 0);
+    testOk1(dbFindRecord(&entry, "hidden") == 0 &&
+        dbIsVisibleRecord(&entry));
+    testOk1(dbFindRecord(&entry, "plain") == 0 &&
+        !dbIsVisibleRecord(&entry));
+    testOk1(dbFindRecordType(&entry, "x") == 0 &&
+        dbGetNRecords(&entry) == 7 && dbGetNAliases(&entry) == 3);
+    dbFinishEntry(&entry);
+
+    testIocInitOk();
+    testdbGetFieldEqual("srcAlias.VAL", DBF_LONG, 42);
+    testdbGetFieldEqual("src.INP", DBF_STRING, "dst.VAL NPP NMS");
+    testdbGetFieldEqual("src.FLNK", DBF_STRING, "dst");
+    testdbGetFieldEqual("dstAlias.PRIO", DBF_STRING, "HIGH");
+    testdbGetFieldEqual("arr.NELM", DBF_ULONG, 10);
+    testOk(dbWriteImage(badFile) != 0, "No image written after iocInit");
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+static void testErrors(void)
+{
+    testDiag("Images which can't be loaded");
+
+    prepare();
+    eltc(0);
+    testOk1(dbLoadImage("dbImageTest.db") == S_dbLib_badImage);
+    testOk1(dbLoadImage("no-such-file.dbi") == S_dbLib_badImage);
+
+    /* the checksum follows the magic, version and byte order */
+    copyImage(16, -1);
+    testOk1(dbLoadImage(badFile) == S_dbLib_badImage);
+    copyImage(-1, 30);
+    testOk1(dbLoadImage(badFile) == S_dbLib_badImage);
+
+    testOk1(dbLoadImage(imageFile) == 0);
+    testOk1(dbLoadImage(imageFile) == S_dbLib_recExists);
+    eltc(1);
+    testdbCleanup();
+
+    remove(badFile);
+    remove(imageFile);
+}
+
+MAIN(dbImageTest)
+{
+    testPlan(20);
+    testRoundTrip();
+    testErrors();
+    return testDone();
+}
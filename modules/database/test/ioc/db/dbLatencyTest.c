@@ -0,0 +1,152 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Tests for the monitor latency histograms
+ */
+
+#include "caeventmask.h"
+#include "dbAccess.h"
+#include "dbEvent.h"
+#include "dbLatency.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void testHistogram(void)
+{
+    epicsUInt64 i, p;
+
+    testDiag("Histogram percentiles");
+
+    dbLatencyReset();
+    testOk1(dbLatencyCount(dbLatencySend) == 0);
+    testOk1(dbLatencyPercentile(dbLatencySend, 0.5) == 0);
+
+    for (i = 1; i <= 10; i++)
+        dbLatencyAdd(dbLatencySend, i);
+    testOk1(dbLatencyCount(dbLatencySend) == 10);
+    /* small values are counted exactly */
+    testOk1(dbLatencyPercentile(dbLatencySend, 0.5) == 5);
+    testOk1(dbLatencyPercentile(dbLatencySend, 1.0) == 10);
+
+    dbLatencyReset();
+    for (i = 1; i <= 100000; i++)
+        dbLatencyAdd(dbLatencySend, i * 100);
+    testOk1(dbLatencyCount(dbLatencySend) == 100000);
+
+    p = dbLatencyPercentile(dbLatencySend, 0.5);
+    testOk(p >= 5000000 && p <= 5000000 * 1.125,
+        "p50 %.0f within 12.5%% of 5000000", (double) p);
+    p = dbLatencyPercentile(dbLatencySend, 0.99);
+    testOk(p >= 9900000 && p <= 9900000 * 1.125,
+        "p99 %.0f within 12.5%% of 9900000", (double) p);
+    /* never more than the largest value seen */
+    testOk1(dbLatencyPercentile(dbLatencySend, 0.999) <= 10000000);
+    testOk1(dbLatencyPercentile(dbLatencySend, 1.0) == 10000000);
+
+    /* the other stages are separate */
+    testOk1(dbLatencyCount(dbLatencyProcess) == 0);
+    testOk1(dbLatencyCount(dbLatencyQueue) == 0);
+
+    dbLatencyReset();
+    testOk1(dbLatencyCount(dbLatencySend) == 0);
+}
+
+static void slowPost(xRecord *prec)
+{
+    epicsThreadSleep(0.01);
+    prec->val++;
+    db_post_events(prec, &prec->val, DBE_VALUE);
+}
+
+static void postSeveral(xRecord *prec)
+{
+    prec->val++;
+    db_post_events(prec, &prec->val, DBE_VALUE);
+    db_post_events(prec, &prec->val, DBE_LOG);
+    db_post_events(prec, NULL, DBE_ALARM);
+}
+
+static void testStages(void)
+{
+    testMonitor *mon;
+    xRecord *prec;
+    epicsUInt64 p;
+
+    testDiag("Process and queue stages");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = (xRecord *) testdbRecordPtr("x");
+    mon = testMonitorCreate("x", DBE_VALUE, 0);
+
+    dbScanLock((dbCommon *) prec);
+    prec->clbk = slowPost;
+    dbScanUnlock((dbCommon *) prec);
+
+    /* nothing is recorded unless enabled */
+    dbLatencyReset();
+    testdbPutFieldOk("x.PROC", DBF_LONG, 1);
+    testMonitorWait(mon);
+    testOk1(dbLatencyCount(dbLatencyProcess) == 0);
+    testOk1(dbLatencyCount(dbLatencyQueue) == 0);
+
+    dbLatencyEnable(1);
+    testMonitorCount(mon, 1);
+    testdbPutFieldOk("x.PROC", DBF_LONG, 1);
+    testMonitorWait(mon);
+    dbLatencyEnable(0);
+
+    testOk1(dbLatencyCount(dbLatencyProcess) == 1);
+    p = dbLatencyPercentile(dbLatencyProcess, 0.5);
+    testOk(p >= 9000000, "process time %.0f includes the 10 ms delay",
+        (double) p);
+    testOk1(dbLatencyCount(dbLatencyQueue) >= 1);
+
+    testDiag("One process stage sample for several posts");
+    dbScanLock((dbCommon *) prec);
+    prec->clbk = postSeveral;
+    dbScanUnlock((dbCommon *) prec);
+    dbLatencyReset();
+    dbLatencyEnable(1);
+    testMonitorCount(mon, 1);
+    testdbPutFieldOk("x.PROC", DBF_LONG, 1);
+    testMonitorWait(mon);
+    dbLatencyEnable(0);
+    testOk1(dbLatencyCount(dbLatencyProcess) == 1);
+
+    dbScanLock((dbCommon *) prec);
+    prec->clbk = NULL;
+    dbScanUnlock((dbCommon *) prec);
+
+    testMonitorDestroy(mon);
+
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+MAIN(dbLatencyTest)
+{
+    testPlan(22);
+    testHistogram();
+    testStages();
+    return testDone();
+}
@@ -183,11 +183,49 @@ static void testDbVerify(const char *record)
     dbFinishEntry(&entry);
 }
 
+static void testFieldHash(const char *record)
+{
+    DBENTRY entry;
+    dbRecordType *prt;
+    const char *pname = "VAL$";
+    int i, found = 0;
+
+    testDiag("testFieldHash(\"%s\")", record);
+
+    dbInitEntry(pdbbase, &entry);
+    if (dbFindRecord(&entry, record) != 0)
+        testAbort("no entry for %s", record);
+    prt = entry.precordType;
+    testOk(prt->fieldHash != NULL, "Record type %s has a field hash",
+        prt->name);
+
+    for (i = 0; i < prt->no_fields; i++) {
+        if (dbFindField(&entry, prt->papFldDes[i]->name) == 0 &&
+            entry.indfield == i)
+            found++;
+        else
+            testDiag("Field %s not found", prt->papFldDes[i]->name);
+    }
+    testOk(found == prt->no_fields, "Found %d of %d fields",
+        found, prt->no_fields);
+
+    testOk1(dbFindFieldPart(&entry, &pname) == 0 &&
+        strcmp(pname, "$") == 0 && strcmp(entry.pflddes->name, "VAL") == 0);
+    pname = "VA";
+    testOk1(dbFindFieldPart(&entry, &pname) == S_dbLib_fieldNotFound);
+    pname = "VALX";
+    testOk1(dbFindFieldPart(&entry, &pname) == S_dbLib_fieldNotFound);
+    pname = "NOSUCHFIELD";
+    testOk1(dbFindFieldPart(&entry, &pname) == S_dbLib_fieldNotFound);
+
+    dbFinishEntry(&entry);
+}
+
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
 MAIN(dbStaticTest)
 {
-    testPlan(223);
+    testPlan(229);
     testdbPrepare();
 
     testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
@@ -206,6 +244,7 @@ MAIN(dbStaticTest)
     testRec2Entry("testalias");
     testRec2Entry("testalias2");
     testRec2Entry("testalias3");
+    testFieldHash("testrec");
 
     eltc(0);
     testIocInitOk();
@@ -20,11 +20,15 @@ int testdbConvert(void);
 int callbackTest(void);
 int callbackParallelTest(void);
 int dbStateTest(void);
+int dbLatencyTest(void);
+int dbImageTest(void);
+int scanLayoutTest(void);
 int dbServerTest(void);
 int dbCaStatsTest(void);
 int dbShutdownTest(void);
 int dbScanTest(void);
 int scanIoTest(void);
+int scanPeriodicTest(void);
 int dbLockTest(void);
 int dbPutLinkTest(void);
 int dbStaticTest(void);
@@ -42,11 +46,15 @@ void epicsRunDbTests(void)
     runTest(callbackTest);
     runTest(callbackParallelTest);
     runTest(dbStateTest);
+    runTest(dbLatencyTest);
+    runTest(dbImageTest);
+    runTest(scanLayoutTest);
     runTest(dbServerTest);
     runTest(dbCaStatsTest);
     runTest(dbShutdownTest);
     runTest(dbScanTest);
     runTest(scanIoTest);
+    runTest(scanPeriodicTest);
     runTest(dbLockTest);
     runTest(dbPutLinkTest);
     runTest(dbStaticTest);
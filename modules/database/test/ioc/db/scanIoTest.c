@@ -15,10 +15,13 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsMessageQueue.h"
 #include "epicsPrint.h"
 #include "epicsMath.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
 #include "alarm.h"
 #include "menuPriority.h"
 #include "dbChannel.h"
@@ -46,6 +49,8 @@ STATIC_ASSERT(NUM_CALLBACK_PRIORITIES==3);
 
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
+extern int scanIoParallelMin;
+
 static void loadRecord(int group, int member, const char *prio)
 {
     char buf[40];
@@ -295,14 +300,201 @@ static void testMultiThreading(void)
     }
 }
 
+typedef struct {
+    int count;
+    int completions;
+    epicsEventId started;
+    epicsEventId release;
+    epicsEventId done;
+} testcoalesce;
+
+static void testcbcoalesce(xpriv *priv, void *raw)
+{
+    testcoalesce *td = raw;
+
+    if (++td->count == 1) {
+        epicsEventMustTrigger(td->started);
+        epicsEventMustWait(td->release);
+    }
+}
+
+static void testcompcoalesce(void *raw, IOSCANPVT scan, int prio)
+{
+    testcoalesce *td = raw;
+
+    epicsAtomicIncrIntT(&td->completions);
+    epicsEventMustTrigger(td->done);
+}
+
+static void testCoalesce(void)
+{
+    testcoalesce data;
+    scanIoStats stats;
+    xdrv *drv;
+    int i;
+
+    testDiag("Test coalescing of queued I/O Intr requests");
+
+    memset(&data, 0, sizeof(data));
+    data.started = epicsEventMustCreate(epicsEventEmpty);
+    data.release = epicsEventMustCreate(epicsEventEmpty);
+    data.done = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    loadRecord(0, 0, "HIGH");
+    drv = xdrv_add(0, &testcbcoalesce, &data);
+    scanIoSetComplete(drv->scan, &testcompcoalesce, &data);
+
+    /* one thread, so a queued scan waits for the running one */
+    callbackParallelThreads(1, "HIGH");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk1(scanIoRequest(drv->scan)==0x4);
+    epicsEventMustWait(data.started);
+
+    testDiag("While scanning, queue one more scan and coalesce the rest");
+    for (i = 0; i < 5; i++)
+        testOk1(scanIoRequest(drv->scan)==0x4);
+    testOk1(scanIoStatus(drv->scan, 2, 0, &stats)==0);
+    testOk(stats.requests==6 && stats.coalesced==4 && stats.processed==0,
+        "requests %d, coalesced %d, processed %d",
+        stats.requests, stats.coalesced, stats.processed);
+
+    epicsEventMustTrigger(data.release);
+    while (epicsAtomicGetIntT(&data.completions) < 2)
+        epicsEventMustWait(data.done);
+    testOk(data.count==2, "Processed twice (%d)", data.count);
+
+    testOk1(scanIoStatus(drv->scan, 2, 1, &stats)==0);
+    testOk(stats.processed==2 && stats.maxLatency > 0.0,
+        "processed %d, max latency %g s", stats.processed,
+        stats.maxLatency);
+    testOk1(scanIoStatus(drv->scan, 2, 0, &stats)==0);
+    testOk1(stats.requests==0 && stats.processed==0 &&
+        stats.maxLatency==0.0);
+    testOk1(scanIoStatus(drv->scan, 3, 0, &stats)==-1);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    xdrv_reset();
+    epicsEventDestroy(data.started);
+    epicsEventDestroy(data.release);
+    epicsEventDestroy(data.done);
+}
+
+#define NLOCKSETS 40
+
+typedef struct {
+    int processed;
+    int again;
+    int completions;
+    int atComplete[2];
+    int next[NLOCKSETS];            /* PHAS of the next record */
+    epicsThreadId thread[NLOCKSETS];
+    int bad;
+    epicsEventId done;
+} testparallel;
+
+static void testcbparallel(xpriv *priv, void *raw)
+{
+    testparallel *td = raw;
+    int n = priv->member;
+    int phas = priv->prec->phas;
+
+    /* A request while the scan is running must not start another one.
+     * The other threads finish their chunks and take the new request
+     * while this one is still busy.
+     */
+    if (epicsAtomicIncrIntT(&td->processed) == 1 && td->again) {
+        scanIoRequest(priv->drv->scan);
+        epicsThreadSleep(0.2);
+    }
+
+    if (phas == 0)
+        td->thread[n] = epicsThreadGetIdSelf();
+    else if (td->thread[n] != epicsThreadGetIdSelf())
+        td->bad = 1;
+    if (phas != td->next[n])
+        td->bad = 1;
+    td->next[n] = (phas + 1) % 3;
+}
+
+static void testcompparallel(void *raw, IOSCANPVT scan, int prio)
+{
+    testparallel *td = raw;
+    int n = epicsAtomicIncrIntT(&td->completions);
+
+    if (n <= 2)
+        td->atComplete[n - 1] = epicsAtomicGetIntT(&td->processed);
+    epicsEventMustTrigger(td->done);
+}
+
+static void testParallelScan(void)
+{
+    testparallel data;
+    xdrv *drv;
+    int i;
+
+    testDiag("Test I/O Intr scan lists split across callback threads");
+
+    memset(&data, 0, sizeof(data));
+    data.done = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NLOCKSETS; i++) {
+        char macros[20];
+
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("scanIoTestParallel.db", NULL, macros);
+    }
+
+    drv = xdrv_add(0, &testcbparallel, &data);
+    scanIoSetComplete(drv->scan, &testcompparallel, &data);
+    callbackParallelThreads(4, "LOW");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    scanIoParallelMin = 2;
+    data.again = 1;
+    testOk1(scanIoRequest(drv->scan)==0x1);
+    while (epicsAtomicGetIntT(&data.completions) < 2)
+        epicsEventMustWait(data.done);
+    scanIoParallelMin = 0;
+
+    testOk(!data.bad, "Each lock set in one thread, in PHAS order");
+    testOk(data.atComplete[0] == 3 * NLOCKSETS &&
+        data.atComplete[1] == 6 * NLOCKSETS,
+        "Scans did not overlap (%d, %d records at completion)",
+        data.atComplete[0], data.atComplete[1]);
+    epicsThreadSleep(0.1);
+    testOk(data.completions == 2, "One completion per scan (%d)",
+        data.completions);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    xdrv_reset();
+    epicsEventDestroy(data.done);
+}
+
 MAIN(scanIoTest)
 {
-    testPlan(152);
+    testPlan(170);
     testSingleThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testSingleThreading();
     testMultiThreading();
     testDiag("run a second time to verify shutdown and restart works");
     testMultiThreading();
+    testCoalesce();
+    testParallelScan();
     return testDone();
 }
@@ -0,0 +1,71 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Tests for relocating records into scan list order during iocInit
+ */
+
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int iocInitScanLayout;
+
+static void testLayout(void)
+{
+    /* Passive first, then "1 second" by phase, each in database order */
+    static const char * const order[] = {"b", "e", "c", "d", "a"};
+    dbCommon *prec[NELEMENTS(order)];
+    DBENTRY entry;
+    int i, ascending = 1;
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("scanLayoutTest.db", NULL, NULL);
+
+    iocInitScanLayout = 1;
+    testIocInitOk();
+    iocInitScanLayout = 0;
+
+    for (i = 0; i < NELEMENTS(order); i++) {
+        prec[i] = testdbRecordPtr(order[i]);
+        if (i && (char *) prec[i] <= (char *) prec[i - 1])
+            ascending = 0;
+    }
+    testOk(ascending, "Records are in scan list order");
+
+    testOk1(testdbRecordPtr("cAlias") == prec[2]);
+    testdbGetFieldEqual("cAlias.NAME", DBF_STRING, "c");
+    testdbGetFieldEqual("c.INP", DBF_STRING, "b NPP NMS");
+    testdbGetFieldEqual("b.VAL", DBF_LONG, 2);
+    testdbGetFieldEqual("e.DESC", DBF_STRING, "passive");
+
+    dbInitEntry(pdbbase, &entry);
+    testOk1(dbFindRecord(&entry, "c") == 0 &&
+        entry.precnode->precord == prec[2] &&
+        strcmp(dbGetInfo(&entry, "test"), "value") == 0);
+    testOk1(dbFindRecord(&entry, "cAlias") == 0 &&
+        entry.precnode->precord == prec[2]);
+    dbFinishEntry(&entry);
+
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+MAIN(scanLayoutTest)
+{
+    testPlan(8);
+    testLayout();
+    return testDone();
+}
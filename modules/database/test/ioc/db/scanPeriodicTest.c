@@ -0,0 +1,150 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Test of periodic scan lists spread over slices of their period
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "errlog.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int scanPeriodicSlices;
+
+#define NRECORDS 20
+#define NEVENTS (3 * NRECORDS)
+
+static struct {
+    int phas;
+    epicsUInt64 time;
+} events[NEVENTS];
+static int nevents;
+
+static void processed(xRecord *prec)
+{
+    int i = epicsAtomicIncrIntT(&nevents) - 1;
+
+    if (i < NEVENTS) {
+        events[i].phas = prec->phas;
+        events[i].time = epicsMonotonicGet();
+    }
+}
+
+static epicsUInt64 gap(int i)
+{
+    return events[i + 1].time - events[i].time;
+}
+
+/* Run the IOC until NEVENTS records have processed */
+static void runScans(int nslices)
+{
+    int i;
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    /* added in reverse, the scan list is sorted by PHAS */
+    for (i = NRECORDS - 1; i >= 0; i--) {
+        char macros[16];
+
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("scanPeriodicTest.db", NULL, macros);
+    }
+
+    for (i = 0; i < NRECORDS; i++) {
+        char name[16];
+
+        sprintf(name, "rec%d", i);
+        ((xRecord *) testdbRecordPtr(name))->clbk = processed;
+    }
+
+    memset(events, 0, sizeof(events));
+    nevents = 0;
+    scanPeriodicSlices = nslices;
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    for (i = 0; i < 40 && epicsAtomicGetIntT(&nevents) < NEVENTS; i++)
+        epicsThreadSleep(0.1);
+    testOk(epicsAtomicGetIntT(&nevents) >= NEVENTS,
+        "%d records processed", epicsAtomicGetIntT(&nevents));
+
+    testIocShutdownOk();
+    testdbCleanup();
+    scanPeriodicSlices = 0;
+}
+
+static void testOrder(void)
+{
+    int i, ok = 1;
+
+    for (i = 0; i < NEVENTS; i++)
+        if (events[i].phas != i % NRECORDS) {
+            testDiag("event %d is PHAS %d", i, events[i].phas);
+            ok = 0;
+        }
+    testOk(ok, "Records processed in PHAS order");
+}
+
+/* The records must be processed in groups of size records: every pause
+ * between two groups is longer than any pause inside a group. This
+ * compares the pauses with each other rather than with a fixed time.
+ */
+static void testGroups(int size)
+{
+    epicsUInt64 inside = 0, between = (epicsUInt64) -1;
+    int i;
+
+    for (i = 0; i < NEVENTS - 1; i++) {
+        if ((i + 1) % size == 0) {
+            if (gap(i) < between)
+                between = gap(i);
+        }
+        else if (gap(i) > inside)
+            inside = gap(i);
+    }
+    testOk(inside < between,
+        "Processed in groups of %d (pauses inside %.3f ms, between %.3f ms)",
+        size, inside * 1e-6, between * 1e-6);
+}
+
+static void testUnsliced(void)
+{
+    testDiag("Whole list at the start of each period");
+    runScans(0);
+    testOrder();
+    testGroups(NRECORDS);
+}
+
+static void testSliced(void)
+{
+    testDiag("List spread over 5 slices of 0.1 second");
+    runScans(5);
+    testOrder();
+    testGroups(NRECORDS / 5);
+}
+
+MAIN(scanPeriodicTest)
+{
+    testPlan(6);
+    testUnsliced();
+    testSliced();
+    return testDone();
+}
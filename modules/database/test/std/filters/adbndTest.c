@@ -0,0 +1,216 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Tests for the array deadband filter
+ */
+
+#include <string.h>
+
+#include "dbStaticLib.h"
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbCommon.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "epicsMath.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+static dbChannel* openChannel(const char *name)
+{
+    dbChannel *pch = dbChannelCreate(name);
+
+    testOk(pch && !dbChannelOpen(pch), "channel %s opened", name);
+    return pch;
+}
+
+/* Put an array and run an update through the pre-chain */
+static int passes(dbChannel *pch, short type, long n, const void *val)
+{
+    db_field_log *pfl;
+    DBADDR addr;
+
+    if (dbNameToAddr(dbChannelRecord(pch)->name, &addr) ||
+        dbPutField(&addr, type, val, n))
+        testAbort("Put to %s failed", dbChannelRecord(pch)->name);
+
+    pfl = db_create_read_log(pch);
+    pfl->ctx = dbfl_context_event;
+    pfl = dbChannelRunPreChain(pch, pfl);
+    if (!pfl)
+        return 0;
+    db_delete_field_log(pfl);
+    return 1;
+}
+
+static void testExact(void)
+{
+    static const double a1[] = {1, 2, 3};
+    static const double a2[] = {1, 2, 3.0001};
+    dbChannel *pch;
+    db_field_log *pfl, *pfl2;
+
+    testDiag("Any change (d=0)");
+    pch = openChannel("y.VAL{\"adbnd\":{}}");
+    testOk(passes(pch, DBR_DOUBLE, 3, a1), "first update sent");
+    testOk(!passes(pch, DBR_DOUBLE, 3, a1), "same array dropped");
+    testOk(passes(pch, DBR_DOUBLE, 3, a2), "one changed element sent");
+    testOk(passes(pch, DBR_DOUBLE, 2, a2), "shorter array sent");
+    testOk(!passes(pch, DBR_DOUBLE, 2, a1), "same shorter array dropped");
+
+    pfl = db_create_read_log(pch);
+    pfl2 = dbChannelRunPreChain(pch, pfl);
+    testOk(pfl2 == pfl, "reads are not filtered");
+    db_delete_field_log(pfl);
+    dbChannelDelete(pch);
+}
+
+static void testDeadband(void)
+{
+    static const double a1[] = {1, 2, 3};
+    static const double a2[] = {1.4, 2, 3};
+    static const double a3[] = {1.6, 2, 3};
+    static const double a4[] = {1.2, 2, 3};
+    static const double r1[] = {10, 20};
+    static const double r2[] = {10.5, 21};
+    static const double r3[] = {11.5, 20};
+    static const epicsInt32 l1[] = {5, 6, 7, 8};
+    static const epicsInt32 l2[] = {5, 6, 7, 10};
+    double n1[2], n2[2];
+    dbChannel *pch;
+
+    testDiag("Absolute deadband");
+    pch = openChannel("y.VAL{\"adbnd\":{\"abs\":0.5}}");
+    testOk(passes(pch, DBR_DOUBLE, 3, a1), "first update sent");
+    testOk(!passes(pch, DBR_DOUBLE, 3, a2), "change of 0.4 dropped");
+    testOk(passes(pch, DBR_DOUBLE, 3, a3), "change of 0.6 sent");
+    testOk(!passes(pch, DBR_DOUBLE, 3, a4),
+           "change of 0.4 from the last update sent dropped");
+
+    testDiag("NaN is the same as NaN");
+    n1[0] = n2[0] = epicsNAN;
+    n1[1] = 1;
+    n2[1] = 1.1;
+    testOk(passes(pch, DBR_DOUBLE, 2, n1), "NaN sent");
+    testOk(!passes(pch, DBR_DOUBLE, 2, n2), "NaN again dropped");
+    dbChannelDelete(pch);
+
+    testDiag("Relative deadband");
+    pch = openChannel("y.VAL{\"adbnd\":{\"rel\":10}}");
+    testOk(passes(pch, DBR_DOUBLE, 2, r1), "first update sent");
+    testOk(!passes(pch, DBR_DOUBLE, 2, r2), "changes of 5%% dropped");
+    testOk(passes(pch, DBR_DOUBLE, 2, r3), "change of 15%% sent");
+    dbChannelDelete(pch);
+
+    testDiag("Integer array");
+    pch = openChannel("x.VAL{\"adbnd\":{\"d\":1}}");
+    testOk(passes(pch, DBR_LONG, 4, l1), "first update sent");
+    testOk(!passes(pch, DBR_LONG, 4, l1), "same array dropped");
+    testOk(passes(pch, DBR_LONG, 4, l2), "change of 2 sent");
+    dbChannelDelete(pch);
+}
+
+static void testChecksum(void)
+{
+    static const char s1[2][MAX_STRING_SIZE] = {"alpha", "beta"};
+    static const char s2[2][MAX_STRING_SIZE] = {"alpha", "gamma"};
+    static const epicsInt32 l1[] = {5, 6, 7, 8};
+    static const epicsInt32 l2[] = {5, 6, 8, 7};
+    dbChannel *pch;
+
+    testDiag("Checksum of strings");
+    pch = openChannel("z.VAL{\"adbnd\":{\"m\":\"sum\"}}");
+    testOk(passes(pch, DBR_STRING, 2, s1), "first update sent");
+    testOk(!passes(pch, DBR_STRING, 2, s1), "same strings dropped");
+    testOk(passes(pch, DBR_STRING, 2, s2), "changed string sent");
+    dbChannelDelete(pch);
+
+    testDiag("Checksum of integers");
+    pch = openChannel("x.VAL{\"adbnd\":{\"m\":\"sum\"}}");
+    testOk(passes(pch, DBR_LONG, 4, l1), "first update sent");
+    testOk(!passes(pch, DBR_LONG, 4, l1), "same array dropped");
+    testOk(passes(pch, DBR_LONG, 4, l2), "swapped elements sent");
+    dbChannelDelete(pch);
+
+    testDiag("A deadband on strings does nothing");
+    pch = openChannel("z.VAL{\"adbnd\":{\"abs\":1}}");
+    testOk(ellCount(&pch->pre_chain) == 0, "no filter in pre chain");
+    testOk(passes(pch, DBR_STRING, 2, s1) && passes(pch, DBR_STRING, 2, s1),
+           "same strings sent");
+    dbChannelDelete(pch);
+}
+
+/* Time the filter on 64k element arrays */
+static void benchBig(const char *name)
+{
+    static double a[65536];
+    epicsTimeStamp start, end;
+    dbChannel *pch;
+    int i, sent = 0;
+
+    for (i = 0; i < 65536; i++)
+        a[i] = i;
+    pch = openChannel(name);
+    passes(pch, DBR_DOUBLE, 65536, a);
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < 20; i++)
+        sent += passes(pch, DBR_DOUBLE, 65536, a);
+    epicsTimeGetCurrent(&end);
+    testOk(sent == 0, "unchanged 64k arrays dropped (%d sent)", sent);
+    testDiag("%s: %.3f ms per update (put and filter)", name,
+             epicsTimeDiffInSeconds(&end, &start) * 1e3 / 20);
+    dbChannelDelete(pch);
+}
+
+MAIN(adbndTest)
+{
+    char adbnd[] = "adbnd";
+    dbEventCtx evtctx;
+
+    testPlan(41);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("arrTest.db", NULL, NULL);
+    testdbReadDatabase("adbndTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    evtctx = db_init_events();
+
+    testOk(!!dbFindFilter(adbnd, strlen(adbnd)), "plugin adbnd registered correctly");
+    testOk(!dbChannelCreate("y.VAL{\"adbnd\":{\"d\":-1}}"),
+           "channel with negative deadband is rejected");
+
+    testExact();
+    testDeadband();
+    testChecksum();
+    benchBig("big.VAL{\"adbnd\":{}}");
+    benchBig("big.VAL{\"adbnd\":{\"abs\":0.1}}");
+    benchBig("big.VAL{\"adbnd\":{\"m\":\"sum\"}}");
+
+    db_close_events(evtctx);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
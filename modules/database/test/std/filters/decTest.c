@@ -0,0 +1,168 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Tests for the decimation filter
+ */
+
+#include <string.h>
+
+#include "dbStaticLib.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "caeventmask.h"
+#include "dbEvent.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "filterMonitor.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+static fmon mon;
+
+static void post(epicsInt32 val)
+{
+    fmonPostX("x", val, DBE_VALUE);
+}
+
+static void testCount(void)
+{
+    epicsInt32 i;
+    int ok;
+
+    testDiag("Every 3rd update");
+    fmonSubscribe(&mon, "x.VAL{\"dec\":{\"n\":3}}", DBE_VALUE);
+    for (i = 1; i <= 7; i++)
+        post(i);
+    ok = fmonWait(&mon, 1, 3, 5.0);
+    epicsThreadSleep(0.1);
+    testOk(ok && mon.count == 3, "3 of 7 updates sent (%u)", mon.count);
+    testOk(mon.last == 7, "last update has value 7 (%g)", mon.last);
+    fmonCancel(&mon);
+}
+
+static void testTime(void)
+{
+    epicsTimeStamp start, now;
+    double delay;
+    int ok;
+
+    testDiag("No more than 2 Hz, trailing update at the end");
+    fmonSubscribe(&mon, "x.VAL{\"dec\":{\"t\":0.5}}", DBE_VALUE);
+    epicsTimeGetCurrent(&start);
+    post(1);
+    ok = fmonWait(&mon, 1, 1, 5.0);
+    testOk(ok && mon.last == 1, "first update sent");
+    post(2);
+    post(3);
+    epicsThreadSleep(0.1);
+    testOk(mon.count == 1, "updates within 0.5 s held back (%u)", mon.count);
+    fmonWait(&mon, 1, 2, 5.0);
+    epicsTimeGetCurrent(&now);
+    delay = epicsTimeDiffInSeconds(&now, &start);
+    testOk(mon.count == 2 && mon.last == 3,
+           "latest value 3 sent at the end of the interval (%g)", mon.last);
+    testOk(delay >= 0.45 && delay < 2.0, "after %.3f s", delay);
+
+    testDiag("The trailing update starts a new interval");
+    post(4);
+    epicsThreadSleep(0.1);
+    testOk(mon.count == 2, "update held back (%u)", mon.count);
+    ok = fmonWait(&mon, 1, 3, 5.0);
+    testOk(ok && mon.last == 4, "then sent (%g)", mon.last);
+
+    testDiag("An update after a quiet interval is sent at once");
+    epicsThreadSleep(0.6);
+    post(5);
+    ok = fmonWait(&mon, 1, 4, 0.25);
+    testOk(ok && mon.last == 5, "update sent (%g)", mon.last);
+
+    testDiag("Closing the channel with a trailing update pending");
+    post(6);
+    fmonCancel(&mon);
+    epicsThreadSleep(0.6);
+    testPass("channel closed");
+}
+
+static void testTrailing(void)
+{
+    int ok;
+
+    testDiag("The trailing update skips the filters before dec");
+    fmonSubscribe(&mon, "x.VAL{\"stat\":{\"n\":2},\"dec\":{\"t\":0.3}}",
+        DBE_VALUE);
+    post(1);
+    post(3);
+    ok = fmonWait(&mon, 1, 1, 5.0);
+    testOk(ok && mon.last == 2, "mean of 1 and 3 sent (%g)", mon.last);
+    post(5);
+    post(7);
+    ok = fmonWait(&mon, 1, 2, 5.0);
+    testOk(ok && mon.last == 6,
+           "mean of 5 and 7 held back, then sent (%g)", mon.last);
+    post(9);
+    post(11);
+    ok = fmonWait(&mon, 1, 3, 5.0);
+    testOk(ok && mon.count == 3 && mon.last == 10,
+           "stat saw no extra sample, mean of 9 and 11 sent (%g)", mon.last);
+    fmonCancel(&mon);
+
+    testDiag("The trailing update keeps the events it was posted for");
+    fmonSubscribe(&mon, "x.VAL{\"dec\":{\"t\":0.3}}", DBE_ALARM);
+    fmonPostX("x", 1, DBE_ALARM);
+    ok = fmonWait(&mon, 1, 1, 5.0);
+    testOk(ok && mon.last == 1, "first alarm update sent");
+    fmonPostX("x", 2, DBE_ALARM);
+    ok = fmonWait(&mon, 1, 2, 5.0);
+    testOk(ok && mon.last == 2, "held back alarm update sent (%g)", mon.last);
+    fmonCancel(&mon);
+}
+
+MAIN(decTest)
+{
+    char dec[] = "dec";
+
+    testPlan(19);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(fmonStart("decTest") == DB_EVENT_OK, "event task started");
+
+    testOk(!!dbFindFilter(dec, strlen(dec)), "plugin dec registered correctly");
+    testOk(!dbChannelCreate("x.VAL{\"dec\":{\"n\":0}}"),
+           "channel with n=0 is rejected");
+    testOk(!dbChannelCreate("x.VAL{\"dec\":{\"t\":-1}}"),
+           "channel with negative t is rejected");
+
+    testCount();
+    testTime();
+    testTrailing();
+
+    fmonStop();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
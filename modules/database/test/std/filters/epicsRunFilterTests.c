@@ -17,6 +17,10 @@ int tsTest(void);
 int dbndTest(void);
 int syncTest(void);
 int arrTest(void);
+int statTest(void);
+int decTest(void);
+int adbndTest(void);
+int shareTest(void);
 
 void epicsRunFilterTests(void)
 {
@@ -26,6 +30,10 @@ void epicsRunFilterTests(void)
     runTest(dbndTest);
     runTest(syncTest);
     runTest(arrTest);
+    runTest(statTest);
+    runTest(decTest);
+    runTest(adbndTest);
+    runTest(shareTest);
 
     dbmfFreeChunks();
 
@@ -0,0 +1,111 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbCommon.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "db_field_log.h"
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "xRecord.h"
+
+#include <epicsExport.h>
+
+#include "filterMonitor.h"
+
+static dbEventCtx evtctx;
+static epicsMutexId lock;
+static epicsEventId event;
+
+static void update(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    fmon *pmon = (fmon *) user_arg;
+    double val = -1;
+    long nReq = 1;
+
+    dbChannelGet(chan, DBR_DOUBLE, &val, NULL, &nReq, pfl);
+    epicsMutexMustLock(lock);
+    pmon->count++;
+    pmon->last = val;
+    pmon->data = pfl && pfl->type == dbfl_type_ref ? pfl->u.r.field : NULL;
+    epicsMutexUnlock(lock);
+    epicsEventMustTrigger(event);
+}
+
+int fmonStart(const char *taskname)
+{
+    lock = epicsMutexMustCreate();
+    event = epicsEventMustCreate(epicsEventEmpty);
+    evtctx = db_init_events();
+    return db_start_events(evtctx, taskname, NULL, NULL,
+        epicsThreadPriorityLow);
+}
+
+void fmonStop(void)
+{
+    db_close_events(evtctx);
+    evtctx = NULL;
+    epicsEventDestroy(event);
+    epicsMutexDestroy(lock);
+}
+
+void fmonSubscribe(fmon *pmon, const char *name, unsigned mask)
+{
+    pmon->chan = dbChannelCreate(name);
+    if (!pmon->chan || dbChannelOpen(pmon->chan))
+        testAbort("Can't open channel %s", name);
+    pmon->count = 0;
+    pmon->last = -1;
+    pmon->data = NULL;
+    pmon->sub = db_add_event(evtctx, pmon->chan, update, pmon, mask);
+    db_event_enable(pmon->sub);
+}
+
+void fmonCancel(fmon *pmon)
+{
+    db_event_disable(pmon->sub);
+    db_cancel_event(pmon->sub);
+    dbChannelDelete(pmon->chan);
+}
+
+int fmonWait(fmon *pmon, int n, unsigned count, double timeout)
+{
+    epicsTimeStamp start, now;
+
+    epicsTimeGetCurrent(&start);
+    for (;;) {
+        int i, done = 1;
+
+        epicsMutexMustLock(lock);
+        for (i = 0; i < n; i++)
+            done &= pmon[i].count >= count;
+        epicsMutexUnlock(lock);
+        if (done)
+            return 1;
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &start) > timeout)
+            return 0;
+        epicsEventWaitWithTimeout(event, 0.05);
+    }
+}
+
+void fmonPostX(const char *name, epicsInt32 val, unsigned mask)
+{
+    xRecord *prec = (xRecord *) testdbRecordPtr(name);
+
+    dbScanLock((dbCommon *) prec);
+    prec->val = val;
+    db_post_events(prec, &prec->val, mask);
+    dbScanUnlock((dbCommon *) prec);
+}
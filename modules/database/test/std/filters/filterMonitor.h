@@ -0,0 +1,48 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Monitors on filtered channels for the filter tests. Each one counts
+ *  its updates and keeps the value of the last one.
+ */
+
+#ifndef INC_filterMonitor_H
+#define INC_filterMonitor_H
+
+#include <epicsTypes.h>
+#include <dbEvent.h>
+
+#include <shareLib.h>
+
+struct dbChannel;
+
+typedef struct fmon {
+    struct dbChannel *chan;
+    dbEventSubscription sub;
+    unsigned count;             /* updates received */
+    double last;                /* value of the last one */
+    const void *data;           /* its array data, NULL for values */
+} fmon;
+
+/* Start the event task, returns the db_start_events() status */
+epicsShareFunc int fmonStart(const char *taskname);
+epicsShareFunc void fmonStop(void);
+
+/* Subscribe to the events in mask of the channel name */
+epicsShareFunc void fmonSubscribe(fmon *pmon, const char *name,
+    unsigned mask);
+epicsShareFunc void fmonCancel(fmon *pmon);
+
+/* Wait up to timeout seconds until n monitors have count updates each */
+epicsShareFunc int fmonWait(fmon *pmon, int n, unsigned count,
+    double timeout);
+
+/* Set the VAL of an x record and post the events in mask, as it would */
+epicsShareFunc void fmonPostX(const char *name, epicsInt32 val,
+    unsigned mask);
+
+#endif /* INC_filterMonitor_H */
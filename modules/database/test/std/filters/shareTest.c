@@ -0,0 +1,216 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Tests for filter chains shared between channels with the same name
+ */
+
+#include <string.h>
+
+#include "dbStaticLib.h"
+#include "dbAccessDefs.h"
+#include "dbCommon.h"
+#include "dbChannel.h"
+#include "caeventmask.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "filterMonitor.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+#define NMON 3
+
+static fmon mon[NMON];
+
+static void postX(epicsInt32 val)
+{
+    fmonPostX("x", val, DBE_VALUE);
+}
+
+static void testCreate(void)
+{
+    const char *name = "x.VAL{\"dbnd\":{\"abs\":1}}";
+    dbChannel *ch1, *ch2, *ch3, *ch4, *ch5;
+
+    testDiag("Channel creation");
+    ch1 = dbChannelCreate(name);
+    testOk(ch1 && !dbChannelOpen(ch1), "channel opened");
+    ch2 = dbChannelCreate(name);
+    testOk(ch2 == ch1, "same name gets the same channel");
+    testOk(ch2 && !dbChannelOpen(ch2), "which opens again");
+    ch3 = dbChannelCreate("x.VAL{\"dbnd\":{\"abs\":2}}");
+    testOk(ch3 && ch3 != ch1, "different filter gets a different channel");
+    ch4 = dbChannelCreate("x.VAL");
+    testOk(ch4 && !dbChannelOpen(ch4), "channel without filters opened");
+    ch5 = dbChannelCreate("x.VAL");
+    testOk(ch5 && ch5 != ch4, "channels without filters are not shared");
+    dbChannelDelete(ch2);
+    testOk(ch1->refs == 1 && ch1->shared, "delete drops one reference");
+    dbChannelDelete(ch1);
+    ch2 = dbChannelCreate(name);
+    testOk(ch2 && ch2->refs == 1, "last delete removes the shared channel");
+    dbChannelDelete(ch2);
+    dbChannelDelete(ch3);
+    dbChannelDelete(ch4);
+    dbChannelDelete(ch5);
+
+    dbChannelShareFilters = 0;
+    ch1 = dbChannelCreate(name);
+    dbChannelOpen(ch1);
+    ch2 = dbChannelCreate(name);
+    testOk(ch1 && ch2 && ch1 != ch2 && !ch1->shared,
+           "no sharing with dbChannelShareFilters = 0");
+    dbChannelDelete(ch1);
+    dbChannelDelete(ch2);
+    dbChannelShareFilters = 1;
+}
+
+static void testOncePerPost(void)
+{
+    int i;
+
+    testDiag("The chain of a shared channel runs once per post");
+    for (i = 0; i < NMON; i++)
+        fmonSubscribe(&mon[i], "x.VAL{\"dec\":{\"n\":2}}", DBE_VALUE);
+    testOk(mon[0].chan == mon[NMON - 1].chan && mon[0].chan->refs == NMON,
+           "%d subscriptions to one channel", NMON);
+    for (i = 1; i <= 6; i++)
+        postX(i);
+    testOk(fmonWait(mon, NMON, 3, 5.0), "all subscriptions got 3 updates");
+    epicsThreadSleep(0.1);
+    for (i = 0; i < NMON; i++)
+        testOk(mon[i].count == 3 && mon[i].last == 5,
+               "monitor %d: %u updates, last %g", i, mon[i].count,
+               mon[i].last);
+    for (i = 0; i < NMON; i++)
+        fmonCancel(&mon[i]);
+}
+
+static void testNewSubscription(void)
+{
+    testDiag("A new subscription gets the last update sent");
+    postX(0);
+    fmonSubscribe(&mon[0], "x.VAL{\"dbnd\":{\"abs\":10}}", DBE_VALUE);
+    db_post_single_event(mon[0].sub);
+    testOk(fmonWait(mon, 1, 1, 5.0) && mon[0].last == 0,
+           "first gets initial value 0");
+    postX(5);
+    epicsThreadSleep(0.1);
+    testOk(mon[0].count == 1, "update of 5 inside the deadband dropped");
+
+    fmonSubscribe(&mon[1], "x.VAL{\"dbnd\":{\"abs\":10}}", DBE_VALUE);
+    db_post_single_event(mon[1].sub);
+    testOk(fmonWait(mon, 2, 1, 5.0) && mon[1].last == 0,
+           "second gets last value sent (%g)", mon[1].last);
+    postX(20);
+    testOk(fmonWait(mon, 2, 2, 5.0) && mon[0].last == 20 &&
+           mon[1].last == 20, "both get update of 20");
+    fmonCancel(&mon[1]);
+    fmonCancel(&mon[0]);
+
+    testDiag("but not when it asks for events the others don't get");
+    postX(1);
+    fmonSubscribe(&mon[0], "x.VAL{\"ts\":{}}", DBE_ALARM);
+    db_post_single_event(mon[0].sub);
+    testOk(fmonWait(mon, 1, 1, 5.0) && mon[0].last == 1,
+           "alarm subscription gets initial value 1");
+    postX(2);
+    fmonSubscribe(&mon[1], "x.VAL{\"ts\":{}}", DBE_VALUE);
+    db_post_single_event(mon[1].sub);
+    testOk(fmonWait(mon + 1, 1, 1, 5.0) && mon[1].last == 2,
+           "value subscription gets current value (%g)", mon[1].last);
+    fmonCancel(&mon[1]);
+    fmonCancel(&mon[0]);
+
+    testDiag("and without running the shared filters");
+    fmonSubscribe(&mon[0], "x.VAL{\"dec\":{\"n\":2}}", DBE_VALUE);
+    postX(1);
+    testOk(fmonWait(mon, 1, 1, 5.0) && mon[0].last == 1,
+           "first gets update of 1");
+    fmonSubscribe(&mon[1], "x.VAL{\"dec\":{\"n\":2}}",
+        DBE_VALUE | DBE_ALARM);
+    db_post_single_event(mon[1].sub);
+    testOk(fmonWait(mon + 1, 1, 1, 5.0) && mon[1].last == 1,
+           "second gets current value (%g)", mon[1].last);
+    postX(2);
+    postX(3);
+    testOk(fmonWait(mon, 2, 2, 5.0), "both get another update");
+    epicsThreadSleep(0.1);
+    testOk(mon[0].count == 2 && mon[0].last == 3 &&
+           mon[1].count == 2 && mon[1].last == 3,
+           "dec dropped 2 and passed 3 (%g, %g)", mon[0].last, mon[1].last);
+    fmonCancel(&mon[1]);
+    fmonCancel(&mon[0]);
+}
+
+static void testArray(void)
+{
+    static const double vals[] = {1, 2, 3, 4, 5, 6};
+    dbCommon *prec = testdbRecordPtr("wf");
+    DBADDR addr;
+    int i;
+
+    testDiag("Subscriptions share the output of arr");
+    for (i = 0; i < NMON; i++)
+        fmonSubscribe(&mon[i], "wf.VAL{\"arr\":{\"s\":2,\"e\":4}}",
+            DBE_VALUE);
+    if (dbNameToAddr("wf", &addr))
+        testAbort("No record wf");
+    dbScanLock(prec);
+    dbPut(&addr, DBR_DOUBLE, vals, 6);
+    db_post_events(prec, NULL, DBE_VALUE);
+    dbScanUnlock(prec);
+    testOk(fmonWait(mon, NMON, 1, 5.0), "all subscriptions updated");
+    for (i = 0; i < NMON; i++)
+        testOk(mon[i].last == 3, "monitor %d: first element %g", i,
+               mon[i].last);
+    testOk(mon[0].data && mon[0].data == mon[1].data &&
+           mon[1].data == mon[2].data, "updates reference the same data");
+    for (i = 0; i < NMON; i++)
+        fmonCancel(&mon[i]);
+}
+
+MAIN(shareTest)
+{
+    testPlan(30);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    testdbReadDatabase("shareTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(fmonStart("shareTest") == DB_EVENT_OK, "event task started");
+
+    dbChannelShareFilters = 1;
+
+    testCreate();
+    testOncePerPost();
+    testNewSubscription();
+    testArray();
+
+    fmonStop();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,264 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Tests for the windowed statistics filter
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "dbStaticLib.h"
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbCommon.h"
+#include "dbChannel.h"
+#include "caeventmask.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "alarm.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+/* Run one scalar update through the pre-chain */
+static db_field_log* feed(dbChannel *pch, long val, double t,
+    unsigned short sevr)
+{
+    db_field_log *pfl = db_create_read_log(pch);
+
+    pfl->ctx  = dbfl_context_event;
+    pfl->type = dbfl_type_val;
+    pfl->stat = sevr ? HIGH_ALARM : NO_ALARM;
+    pfl->sevr = sevr;
+    pfl->time.secPastEpoch = 1000 + (epicsUInt32) t;
+    pfl->time.nsec = (epicsUInt32) ((t - floor(t)) * 1e9 + 0.5);
+    pfl->field_type  = DBF_LONG;
+    pfl->no_elements = 1;
+    pfl->u.v.field.dbf_long = val;
+    return dbChannelRunPreChain(pch, pfl);
+}
+
+/* Feed a window of scalar updates, only the last may pass */
+static db_field_log* feedAll(dbChannel *pch, const long *val, int n)
+{
+    db_field_log *pfl = NULL;
+    int i, dropped = 0;
+
+    for (i = 0; i < n; i++) {
+        pfl = feed(pch, val[i], i, NO_ALARM);
+        if (!pfl) dropped++;
+    }
+    testOk(dropped == n - 1 && pfl, "%d updates dropped, the last passes",
+           dropped);
+    return pfl;
+}
+
+static void testResult(db_field_log *pfl, double expected)
+{
+    if (!pfl) {
+        testSkip(2, "no update");
+        return;
+    }
+    testOk(pfl->type == dbfl_type_val && pfl->field_type == DBF_DOUBLE,
+           "update is a DOUBLE value (type %d, field_type %d)",
+           pfl->type, pfl->field_type);
+    testOk(fabs(pfl->u.v.field.dbf_double - expected) < 1e-9,
+           "value %g == %g", pfl->u.v.field.dbf_double, expected);
+    db_delete_field_log(pfl);
+}
+
+static dbChannel* openChannel(const char *name)
+{
+    dbChannel *pch = dbChannelCreate(name);
+
+    testOk(pch && !dbChannelOpen(pch), "channel %s opened", name);
+    return pch;
+}
+
+/* Put an array and run an update of type rec through the pre-chain */
+static db_field_log* feedArray(dbChannel *pch, const double *val, long n)
+{
+    db_field_log *pfl;
+
+    testdbPutArrFieldOk("sa", DBF_DOUBLE, n, val);
+    pfl = db_create_read_log(pch);
+    pfl->ctx = dbfl_context_event;
+    return dbChannelRunPreChain(pch, pfl);
+}
+
+static void testScalar(void)
+{
+    static const long val[] = {1, 2, 3, 6};
+    static const long next[] = {3, 6, 4, 5};
+    static const long val8[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    static const long val3[] = {5, 1, 3};
+    dbChannel *pch;
+    db_field_log *pfl, *pfl2;
+    int i;
+
+    testDiag("Scalar mean over 4 samples");
+    pch = openChannel("sx.VAL{\"stat\":{\"n\":4}}");
+    testOk(dbChannelFinalFieldType(pch) == DBF_DOUBLE,
+           "final field type is DBF_DOUBLE");
+    testResult(feedAll(pch, val, 4), 3.0);
+
+    testDiag("The next window starts afresh");
+    testResult(feedAll(pch, next, 4), 4.5);
+
+    testDiag("Reads are not filtered");
+    pfl = db_create_read_log(pch);
+    pfl2 = dbChannelRunPreChain(pch, pfl);
+    testOk(pfl2 == pfl, "read field_log passes unchanged");
+    db_delete_field_log(pfl);
+
+    testDiag("Worst alarm of the window");
+    for (i = 0; i < 3; i++)
+        testOk(!feed(pch, 1, i, i == 1 ? MAJOR_ALARM : NO_ALARM),
+               "update %d dropped", i);
+    pfl = feed(pch, 1, 3, MINOR_ALARM);
+    testOk(pfl && pfl->sevr == MAJOR_ALARM && pfl->stat == HIGH_ALARM,
+           "window has MAJOR severity");
+    testResult(pfl, 1.0);
+    dbChannelDelete(pch);
+
+    testDiag("Standard deviation");
+    pch = openChannel("sx.VAL{\"stat\":{\"n\":8,\"s\":\"std\"}}");
+    testResult(feedAll(pch, val8, 8), 2.0);
+    dbChannelDelete(pch);
+
+    testDiag("Minimum and maximum");
+    pch = openChannel("sx.VAL{\"stat\":{\"n\":3,\"s\":\"min\"}}");
+    testResult(feedAll(pch, val3, 3), 1.0);
+    dbChannelDelete(pch);
+    pch = openChannel("sx.VAL{\"stat\":{\"n\":3,\"s\":\"max\"}}");
+    testResult(feedAll(pch, val3, 3), 5.0);
+    dbChannelDelete(pch);
+
+    testDiag("Time window of 1 second");
+    pch = openChannel("sx.VAL{\"stat\":{\"t\":1}}");
+    testOk(!feed(pch, 1, 0.0, NO_ALARM) && !feed(pch, 2, 0.4, NO_ALARM) &&
+           !feed(pch, 3, 0.8, NO_ALARM), "updates within 1 second dropped");
+    testResult(feed(pch, 6, 1.0, NO_ALARM), 3.0);
+    testOk(!feed(pch, 4, 1.2, NO_ALARM), "next window started");
+    testResult(feed(pch, 8, 2.5, NO_ALARM), 6.0);
+    dbChannelDelete(pch);
+}
+
+static void testArray(void)
+{
+    static const double a1[] = {1, 2, 3, 4};
+    static const double a2[] = {3, 4, 5, 6};
+    dbChannel *pch;
+    db_field_log *pfl;
+    double *pval;
+
+    testDiag("Element-wise mean of arrays");
+    pch = openChannel("sa.VAL{\"stat\":{\"n\":2}}");
+    testOk(dbChannelFinalElements(pch) == 4, "final elements 4");
+
+    testOk(!feedArray(pch, a1, 4), "first array dropped");
+    pfl = feedArray(pch, a2, 4);
+    testOk(pfl && pfl->type == dbfl_type_ref &&
+           pfl->field_type == DBF_DOUBLE && pfl->no_elements == 4,
+           "update is a DOUBLE array of 4 elements");
+    if (pfl && pfl->type == dbfl_type_ref) {
+        pval = (double *) pfl->u.r.field;
+        testOk(pval[0] == 2 && pval[1] == 3 && pval[2] == 4 && pval[3] == 5,
+               "mean [%g %g %g %g]", pval[0], pval[1], pval[2], pval[3]);
+    }
+    else
+        testSkip(1, "no array");
+    if (pfl) db_delete_field_log(pfl);
+
+    testDiag("A change of length starts a new window");
+    testOk(!feedArray(pch, a1, 4), "4 elements dropped");
+    testOk(!feedArray(pch, a2, 3), "3 elements restart the window");
+    pfl = feedArray(pch, a1, 3);
+    testOk(pfl && pfl->no_elements == 3, "update has 3 elements");
+    if (pfl && pfl->type == dbfl_type_ref) {
+        pval = (double *) pfl->u.r.field;
+        testOk(pval[0] == 2 && pval[1] == 3 && pval[2] == 4,
+               "mean [%g %g %g]", pval[0], pval[1], pval[2]);
+    }
+    else
+        testSkip(1, "no array");
+    if (pfl) db_delete_field_log(pfl);
+    dbChannelDelete(pch);
+}
+
+static void postVal(dbCommon *prec, epicsInt32 val)
+{
+    dbScanLock(prec);
+    ((xRecord *) prec)->val = val;
+    db_post_events(prec, &((xRecord *) prec)->val, DBE_VALUE);
+    dbScanUnlock(prec);
+}
+
+static void testTimer(void)
+{
+    dbCommon *prec = testdbRecordPtr("sx");
+    testMonitor *mon;
+
+    testDiag("A time window ends without another update");
+    mon = testMonitorCreate("sx.VAL{\"stat\":{\"t\":0.2}}", DBE_VALUE, 0);
+    postVal(prec, 2);
+    postVal(prec, 4);
+    testMonitorWait(mon);
+    testOk(testMonitorCount(mon, 1) == 1, "window sent when its time was up");
+    epicsThreadSleep(0.3);
+    testOk(testMonitorCount(mon, 0) == 0, "no update for the empty window");
+    testMonitorDestroy(mon);
+}
+
+MAIN(statTest)
+{
+    char stat[] = "stat";
+    dbEventCtx evtctx;
+
+    testPlan(53);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("statTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    evtctx = db_init_events();
+
+    testOk(!!dbFindFilter(stat, strlen(stat)), "plugin stat registered correctly");
+    testOk(!dbChannelCreate("sx.VAL{\"stat\":{}}"),
+           "channel without a window is rejected");
+    testOk(!dbChannelCreate("sx.VAL{\"stat\":{\"n\":-1}}"),
+           "channel with negative n is rejected");
+
+    testScalar();
+    testArray();
+    testTimer();
+
+    db_close_events(evtctx);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
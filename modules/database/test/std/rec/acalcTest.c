@@ -0,0 +1,101 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void testScaled(void)
+{
+    static const double expect[] = {10.5, 20.5, 30.5, 40.5, 50.5};
+    static const double longer[] = {1, 2, 3, 4, 5, 6, 7};
+    static const double expect2[] = {0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5};
+
+    testDiag("Array times scalar plus constant");
+    testdbPutFieldOk("wave.PROC", DBR_LONG, 1);
+    testdbPutFieldOk("scaled.PROC", DBR_LONG, 1);
+    testdbGetFieldEqual("scaled.NORD", DBR_LONG, 5);
+    testdbGetArrFieldEqual("scaled", DBR_DOUBLE, 8, 5, expect);
+    testdbGetFieldEqual("scaled.NEA", DBR_LONG, 5);
+    testdbGetFieldEqual("scaled.SEVR", DBR_LONG, NO_ALARM);
+
+    testDiag("A longer input gives a longer result");
+    testdbPutArrFieldOk("wave", DBR_DOUBLE, 7, longer);
+    testdbPutFieldOk("gain", DBR_DOUBLE, 0.0);
+    testdbPutFieldOk("scaled.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("scaled", DBR_DOUBLE, 8, 7, expect2);
+}
+
+static void testCalcChange(void)
+{
+    static const double longer[] = {1, 2, 3, 4, 5, 6, 7};
+    static const double expect[] = {0, 0, 3, 4, 5, 6, 7};
+    static const double sum[] = {28};
+
+    testDiag("Conditional on each element");
+    testdbPutArrFieldOk("wave", DBR_DOUBLE, 7, longer);
+    testdbPutFieldOk("stats.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("stats", DBR_DOUBLE, 8, 7, expect);
+
+    testDiag("A reduction gives one element");
+    testdbPutFieldOk("stats.CALC", DBR_STRING, "SUM(A)");
+    testdbGetFieldEqual("stats.NORD", DBR_LONG, 1);
+    testdbGetArrFieldEqual("stats", DBR_DOUBLE, 8, 1, sum);
+
+    testDiag("An invalid expression raises an alarm");
+    eltc(0);
+    testdbPutFieldOk("stats.CALC", DBR_STRING, "A+");
+    eltc(1);
+    testdbPutFieldOk("stats.PROC", DBR_LONG, 1);
+    testdbGetFieldEqual("stats.SEVR", DBR_LONG, INVALID_ALARM);
+    testdbGetFieldEqual("stats.STAT", DBR_LONG, CALC_ALARM);
+}
+
+static void testConstants(void)
+{
+    static const double expect[] = {101, 102, 103, 104};
+    static const double put[] = {-1, -2};
+    static const double expect2[] = {99, 98};
+
+    testDiag("Constant array and scalar inputs");
+    testdbGetFieldEqual("consts.NEA", DBR_LONG, 4);
+    testdbGetFieldEqual("consts.NEB", DBR_LONG, 1);
+    testdbPutFieldOk("consts.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("consts", DBR_DOUBLE, 4, 4, expect);
+
+    testDiag("Put to a constant input");
+    testdbPutArrFieldOk("consts.A", DBR_DOUBLE, 2, put);
+    testdbGetFieldEqual("consts.NEA", DBR_LONG, 2);
+    testdbGetArrFieldEqual("consts", DBR_DOUBLE, 4, 2, expect2);
+}
+
+MAIN(acalcTest)
+{
+    testPlan(27);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("acalcTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testScaled();
+    testCalcChange();
+    testConstants();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -4,8 +4,12 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "dbUnitTest.h"
 #include "testMain.h"
+#include "epicsTime.h"
 #include "dbLock.h"
 #include "errlog.h"
 #include "dbAccess.h"
@@ -345,10 +349,197 @@ void testLIFOCirc(void)
     testdbCleanup();
 }
 
+static
+void testAlg(int alg, const char *name, double pctl, const double *expect)
+{
+    testDiag("Test %s", name);
+    testdbPutFieldOk("acomp.ALG", DBR_LONG, alg);
+    testdbPutFieldOk("acomp.PCTL", DBR_DOUBLE, pctl);
+    testdbPutFieldOk("acomp.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("acomp", DBR_DOUBLE, 3, 3, expect);
+}
+
+static
+void testArrayAlgs(void)
+{
+    /* three blocks of N=4 */
+    static const double wf[] = {4, 1, 3, 2,  8, 5, 7, 6,  10, 12, 9, 11};
+    static const double low[] = {1, 5, 9};
+    static const double high[] = {4, 8, 12};
+    static const double avg[] = {2.5, 6.5, 10.5};
+    static const double median[] = {3, 7, 11};
+    static const double p25[] = {2, 6, 10};
+    double rms[3];
+
+    rms[0] = sqrt((16 + 1 + 9 + 4) / 4.0);
+    rms[1] = sqrt((64 + 25 + 49 + 36) / 4.0);
+    rms[2] = sqrt((100 + 144 + 81 + 121) / 4.0);
+
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, NELEMENTS(wf), wf);
+    testAlg(compressALG_N_to_1_Low_Value, "N to 1 Low Value", 0, low);
+    testAlg(compressALG_N_to_1_High_Value, "N to 1 High Value", 0, high);
+    testAlg(compressALG_N_to_1_Average, "N to 1 Average", 0, avg);
+    testAlg(compressALG_N_to_1_Median, "N to 1 Median", 0, median);
+    testAlg(compressALG_N_to_1_RMS, "N to 1 RMS", 0, rms);
+    testAlg(compressALG_N_to_1_Percentile, "N to 1 Percentile 25", 25, p25);
+    testAlg(compressALG_N_to_1_Percentile, "N to 1 Percentile 0", 0, low);
+    testAlg(compressALG_N_to_1_Percentile, "N to 1 Percentile 100", 100, high);
+}
+
+static
+void testBulkInsert(void)
+{
+    static const double first[] = {1, 2, 3};
+    static const double second[] = {4, 5, 6};
+    static const double fifo[] = {2, 3, 4, 5, 6};
+    static const double lifo[] = {6, 5, 4, 3, 2};
+    static const double wf[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    static const double fifoLast[] = {8, 9, 10, 11, 12};
+    static const double lifoLast[] = {12, 11, 10, 9, 8};
+
+    testDiag("Test inserting arrays into the buffer");
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, NELEMENTS(first), first);
+    testdbPutFieldOk("fcomp.PROC", DBR_LONG, 1);
+    testdbPutFieldOk("lcomp.PROC", DBR_LONG, 1);
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, NELEMENTS(second), second);
+    testdbPutFieldOk("fcomp.PROC", DBR_LONG, 1);
+    testdbPutFieldOk("lcomp.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("fcomp", DBR_DOUBLE, 5, 5, fifo);
+    testdbGetArrFieldEqual("lcomp", DBR_DOUBLE, 5, 5, lifo);
+
+    testDiag("Only the last NSAM values of a longer array are kept");
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, NELEMENTS(wf), wf);
+    testdbPutFieldOk("fcomp.PROC", DBR_LONG, 1);
+    testdbPutFieldOk("lcomp.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("fcomp", DBR_DOUBLE, 5, 5, fifoLast);
+    testdbGetArrFieldEqual("lcomp", DBR_DOUBLE, 5, 5, lifoLast);
+}
+
+static
+void testScalarAlgs(void)
+{
+    static const double samples[] = {3, 1, 4, 2};
+    double rms = sqrt((9 + 1 + 16 + 4) / 4.0);
+    int i;
+
+    testDiag("Test N to 1 RMS of scalars");
+    testdbPutFieldOk("scomp.ALG", DBR_LONG, compressALG_N_to_1_RMS);
+    for (i = 0; i < 4; i++) {
+        testdbPutFieldOk("val", DBR_DOUBLE, samples[i]);
+        testdbPutFieldOk("scomp.PROC", DBR_LONG, 1);
+    }
+    testdbGetArrFieldEqual("scomp", DBR_DOUBLE, 2, 1, &rms);
+
+    testDiag("Test N to 1 Percentile of scalars");
+    testdbPutFieldOk("scomp.ALG", DBR_LONG, compressALG_N_to_1_Percentile);
+    testdbPutFieldOk("scomp.PCTL", DBR_DOUBLE, 75.0);
+    for (i = 0; i < 4; i++) {
+        testdbPutFieldOk("val", DBR_DOUBLE, samples[i]);
+        testdbPutFieldOk("scomp.PROC", DBR_LONG, 1);
+    }
+    testdbGetFieldEqual("scomp.NUSE", DBR_LONG, 1);
+    testdbGetFieldEqual("scomp", DBR_DOUBLE, 3.0);
+}
+
+static
+int compareDouble(const void *pa, const void *pb)
+{
+    double a = *(const double *)pa;
+    double b = *(const double *)pb;
+
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static
+void benchAlgs(void)
+{
+    static const struct {
+        int alg;
+        const char *name;
+    } algs[] = {
+        {compressALG_N_to_1_Low_Value, "N to 1 Low Value"},
+        {compressALG_N_to_1_High_Value, "N to 1 High Value"},
+        {compressALG_N_to_1_Average, "N to 1 Average"},
+        {compressALG_N_to_1_Median, "N to 1 Median"},
+        {compressALG_N_to_1_RMS, "N to 1 RMS"},
+        {compressALG_N_to_1_Percentile, "N to 1 Percentile"},
+        {compressALG_Circular_Buffer, "Circular Buffer"},
+    };
+    enum {count = 100000, block = 100, passes = 20};
+    compressRecord *prec = (compressRecord*)testdbRecordPtr("bcomp");
+    double *data = malloc(count * sizeof(double));
+    double *work = malloc(count * sizeof(double));
+    epicsTimeStamp start, stop;
+    double seconds;
+    unsigned i, pass;
+
+    if (!data || !work)
+        testAbort("Out of memory");
+    srand(1);
+    for (i = 0; i < count; i++)
+        data[i] = rand() / (double) RAND_MAX;
+    testdbPutArrFieldOk("big", DBR_DOUBLE, count, data);
+
+    testDiag("Compressing %d values %d to 1, ms per process:", count, block);
+    for (i = 0; i < NELEMENTS(algs); i++) {
+        testdbPutFieldOk("bcomp.ALG", DBR_LONG, algs[i].alg);
+        dbScanLock((dbCommon*)prec);
+        epicsTimeGetCurrent(&start);
+        for (pass = 0; pass < passes; pass++)
+            dbProcess((dbCommon*)prec);
+        epicsTimeGetCurrent(&stop);
+        dbScanUnlock((dbCommon*)prec);
+        seconds = epicsTimeDiffInSeconds(&stop, &start);
+        testDiag("  %-20s %8.3f", algs[i].name, 1e3 * seconds / passes);
+    }
+
+    /* the median used to sort each block */
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < passes; pass++) {
+        memcpy(work, data, count * sizeof(double));
+        for (i = 0; i < count; i += block)
+            qsort(work + i, block, sizeof(double), compareDouble);
+    }
+    epicsTimeGetCurrent(&stop);
+    seconds = epicsTimeDiffInSeconds(&stop, &start);
+    testDiag("  %-20s %8.3f", "qsort per block", 1e3 * seconds / passes);
+
+    free(data);
+    free(work);
+}
+
+static
+void testAlgorithms(void)
+{
+    testDiag("Test compression algorithms");
+
+    testdbPrepare();
+
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("compressTest.db", NULL, "ALG=Circular Buffer,BALG=FIFO Buffer,NSAM=4");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testArrayAlgs();
+    testBulkInsert();
+    testScalarAlgs();
+    benchAlgs();
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+}
+
 MAIN(compressTest)
 {
-    testPlan(116);
+    testPlan(192);
     testFIFOCirc();
     testLIFOCirc();
+    testAlgorithms();
     return testDone();
 }
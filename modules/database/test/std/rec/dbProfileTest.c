@@ -0,0 +1,144 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Tests for the per-record processing time profiler
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbProfile.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void testSelect(void)
+{
+    dbProfileStats stats;
+
+    testDiag("Selecting records");
+
+    testOk1(dbProfileEnabled == 0);
+    testOk1(dbProfileGet("prof:a", &stats) == -1);
+    testOk1(dbProfileType("nosuchtype", 1) == -1);
+
+    testOk1(dbProfileType("calc", 1) == 3);
+    testOk1(dbProfileEnabled != 0);
+    testOk1(dbProfileGet("prof:a", &stats) == 0 && stats.count == 0);
+    testOk1(dbProfileGet("prof:co", &stats) == -1);
+
+    testOk1(dbProfileScan("Event", 0) == 1);
+    testOk1(dbProfileScan("Passive", 1) == 3);
+    testOk1(dbProfileType("*", 0) == 4);
+    testOk1(dbProfileEnabled == 0);
+}
+
+static void testNested(void)
+{
+    dbProfileStats a, b;
+    int i;
+
+    testDiag("Nested processing");
+
+    dbProfileReset();
+    dbProfileType("calc", 1);
+    for (i = 0; i < 3; i++)
+        testdbPutFieldOk("prof:a.PROC", DBR_LONG, 1);
+
+    testOk1(dbProfileGet("prof:a", &a) == 0 && a.count == 3);
+    testOk1(dbProfileGet("prof:b", &b) == 0 && b.count == 3);
+    testOk(a.total == a.self + b.total,
+        "total %.0f = self %.0f + nested %.0f",
+        (double) a.total, (double) a.self, (double) b.total);
+    testOk1(a.maxTotal >= a.maxSelf && a.maxTotal > 0);
+    testOk1(b.total == b.self);
+    testOk1(a.asyncCount == 0);
+
+    /* deselected records keep their statistics but stop counting */
+    dbProfileType("calc", 0);
+    testdbPutFieldOk("prof:a.PROC", DBR_LONG, 1);
+    testOk1(dbProfileGet("prof:a", &a) == 0 && a.count == 3);
+
+    dbProfileReset();
+    testOk1(dbProfileGet("prof:b", &b) == 0 && b.count == 0 && b.total == 0);
+}
+
+static void testAsync(void)
+{
+    dbProfileStats stats;
+    int i;
+
+    testDiag("Asynchronous completion");
+
+    dbProfileScan("Passive", 1);
+    testdbPutFieldOk("prof:co.PROC", DBR_LONG, 1);
+    for (i = 0; i < 100; i++) {
+        if (dbProfileGet("prof:co", &stats) == 0 && stats.asyncCount)
+            break;
+        epicsThreadSleep(0.05);
+    }
+    testOk(stats.count == 1 && stats.asyncCount == 1,
+        "Processed once (%.0f), completed once (%.0f)",
+        (double) stats.count, (double) stats.asyncCount);
+    testOk(stats.asyncTotal >= 90000000 && stats.asyncMax == stats.asyncTotal,
+        "Async latency %.3f s includes the 0.1 s delay",
+        1e-9 * stats.asyncTotal);
+    testOk(stats.total < stats.asyncTotal,
+        "Process time %.6f s excludes it", 1e-9 * stats.total);
+}
+
+static void testOutput(void)
+{
+    const char *file = "dbProfileTest.json";
+    char buf[4096];
+    size_t n = 0;
+    FILE *fp;
+
+    testDiag("Report and JSON");
+
+    testOk1(dbProfileReport(2, "async") == 0);
+    testOk1(dbProfileReport(0, "bogus") == -1);
+    testOk1(dbProfileJSON(file) == 0);
+    fp = fopen(file, "r");
+    if (fp) {
+        n = fread(buf, 1, sizeof(buf) - 1, fp);
+        fclose(fp);
+        remove(file);
+    }
+    buf[n] = '\0';
+    testOk(strstr(buf, "\"prof:co\"") && strstr(buf, "\"async_count\": 1"),
+        "JSON has the calcout record's async completion");
+    dbProfileType("*", 0);
+}
+
+MAIN(dbProfileTest)
+{
+    testPlan(31);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbProfileTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testSelect();
+    testNested();
+    testAsync();
+    testOutput();
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
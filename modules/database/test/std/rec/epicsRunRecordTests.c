@@ -16,9 +16,13 @@ int analogMonitorTest(void);
 int compressTest(void);
 int recMiscTest(void);
 int arrayOpTest(void);
+int acalcTest(void);
+int histogramTest(void);
+int dbProfileTest(void);
 int asTest(void);
 int linkRetargetLinkTest(void);
 int linkInitTest(void);
+int parallelInitTest(void);
 int asyncSoftTest(void);
 int simmTest(void);
 int mbbioDirectTest(void);
@@ -35,12 +39,16 @@ void epicsRunRecordTests(void)
     runTest(recMiscTest);
 
     runTest(arrayOpTest);
+    runTest(acalcTest);
+    runTest(histogramTest);
+    runTest(dbProfileTest);
 
     runTest(asTest);
 
     runTest(linkRetargetLinkTest);
 
     runTest(linkInitTest);
+    runTest(parallelInitTest);
 
     runTest(asyncSoftTest);
 
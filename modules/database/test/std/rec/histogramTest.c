@@ -0,0 +1,166 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#include "histogramRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NBIG 100000
+
+/* Writing SGNL adds a count */
+static void countScalar(double sgnl)
+{
+    testdbPutFieldOk("scalar.SGNL", DBR_DOUBLE, sgnl);
+}
+
+static void testScalar(void)
+{
+    static const epicsUInt32 expect[] = {1, 1, 0, 0, 0, 0, 0, 0, 0, 2};
+
+    testDiag("Scalar signal, values on bin edges");
+    countScalar(0.0);
+    countScalar(0.2);       /* upper edge of bin 1 */
+    countScalar(0.9999);
+    countScalar(0.95);
+    countScalar(1.0);       /* ULIM is outside */
+    countScalar(-0.1);
+    testdbGetArrFieldEqual("scalar", DBR_ULONG, 10, 10, expect);
+}
+
+static void testArray(void)
+{
+    static const double small[] = {0.5, 1.5, 1.7, 9.9, 10.0, -1, 5};
+    static const epicsUInt32 expect[] = {1, 2, 0, 0, 1, 0, 0, 0, 0, 1};
+    epicsUInt32 expect2[10];
+    epicsTimeStamp start, end;
+    double *big = calloc(NBIG, sizeof(double));
+    int i;
+
+    testDiag("All samples of an array binned in one process");
+    testdbPutArrFieldOk("samples", DBR_DOUBLE, 7, small);
+    testdbPutFieldOk("hist.PROC", DBR_LONG, 1);
+    testdbGetFieldEqual("hist.NORD", DBR_LONG, 7);
+    testdbGetArrFieldEqual("hist", DBR_ULONG, 10, 10, expect);
+
+    testDiag("%d samples", NBIG);
+    testdbPutFieldOk("hist.CMD", DBR_LONG, histogramCMD_Clear);
+    for (i = 0; i < NBIG; i++)
+        big[i] = (i % 1000) / 100.;
+    /* each 1000 samples put 101 in bin 0 and 99 in bin 9 */
+    for (i = 0; i < 10; i++)
+        expect2[i] = NBIG / 10;
+    expect2[0] += NBIG / 1000;
+    expect2[9] -= NBIG / 1000;
+    testdbPutArrFieldOk("samples", DBR_DOUBLE, NBIG, big);
+    epicsTimeGetCurrent(&start);
+    testdbPutFieldOk("hist.PROC", DBR_LONG, 1);
+    epicsTimeGetCurrent(&end);
+    testdbGetArrFieldEqual("hist", DBR_ULONG, 10, 10, expect2);
+    testDiag("Process took %.3f ms", epicsTimeDiffInSeconds(&end, &start) * 1e3);
+    free(big);
+}
+
+typedef struct {
+    histogramRecord *prec;
+    epicsEventId done;
+} accumArgs;
+
+static void accumThread(void *arg)
+{
+    accumArgs *pargs = (accumArgs *) arg;
+    static const double samples[] = {0.5, 1.5, 2.5, 3.5, 4.5};
+    int i;
+
+    for (i = 0; i < 10000; i++)
+        histogramAccumulate(pargs->prec, samples, 5);
+    epicsEventMustTrigger(pargs->done);
+}
+
+static void testAccumulate(void)
+{
+    static const epicsUInt32 expect[] = {20000, 20000, 20000, 20000};
+    static const epicsUInt32 zero[] = {0, 0, 0, 0};
+    static const epicsUInt32 bin1[] = {0, 1, 0, 0};
+    static const double one[] = {1.5, 4.5};
+    static const double two[] = {1.5, 1.5};
+    accumArgs args[2];
+    int i;
+
+    testDiag("Counts accumulated by two threads");
+    for (i = 0; i < 2; i++) {
+        args[i].prec = (histogramRecord *) testdbRecordPtr("accum");
+        args[i].done = epicsEventMustCreate(epicsEventEmpty);
+        epicsThreadMustCreate("accum", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall), accumThread,
+            &args[i]);
+    }
+    for (i = 0; i < 2; i++) {
+        epicsEventMustWait(args[i].done);
+        epicsEventDestroy(args[i].done);
+    }
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, zero);
+    testdbPutFieldOk("accum.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, expect);
+
+    testDiag("Clear discards accumulated counts");
+    testOk1(histogramAccumulate(args[0].prec, one, 2) == 1);
+    testdbPutFieldOk("accum.CMD", DBR_LONG, histogramCMD_Clear);
+    testdbPutFieldOk("accum.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, zero);
+
+    testDiag("Stop keeps accumulated counts out of VAL");
+    testOk1(histogramAccumulate(args[0].prec, one, 2) == 1);
+    testdbPutFieldOk("accum.CMD", DBR_LONG, histogramCMD_Stop);
+    testdbPutFieldOk("accum.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, zero);
+    testdbPutFieldOk("accum.CMD", DBR_LONG, histogramCMD_Start);
+    testdbPutFieldOk("accum.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, bin1);
+
+    testDiag("Accumulated counts wrap like single counts");
+    dbScanLock((dbCommon *) args[0].prec);
+    args[0].prec->bptr[1] = UINT_MAX - 1;
+    dbScanUnlock((dbCommon *) args[0].prec);
+    testOk1(histogramAccumulate(args[0].prec, two, 2) == 2);
+    testdbPutFieldOk("accum.PROC", DBR_LONG, 1);
+    testdbGetArrFieldEqual("accum", DBR_ULONG, 4, 4, bin1);
+}
+
+MAIN(histogramTest)
+{
+    testPlan(32);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("histogramTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testScalar();
+    testArray();
+    testAccumulate();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,117 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Parallel record initialization in iocInit
+ */
+
+#include <stdio.h>
+
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "epicsUnitTest.h"
+#include "errlog.h"
+#include "iocInit.h"
+#include "testMain.h"
+
+#include "aiRecord.h"
+#include "boRecord.h"
+#include "calcRecord.h"
+#include "longinRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+extern int iocInitThreads;
+extern int iocInitTiming;
+
+#define NINSTANCES 200
+
+static void loadRecords(void)
+{
+    int i;
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NINSTANCES; i++) {
+        char macros[40];
+
+        sprintf(macros, "P=r%d:,N=%d", i, i);
+        testdbReadDatabase("parallelInitTest.db", NULL, macros);
+    }
+}
+
+static void checkRecords(const char *mode)
+{
+    int bad = 0;
+    int i;
+
+    for (i = 0; i < NINSTANCES; i++) {
+        char name[40];
+        aiRecord *pai;
+        calcRecord *pcalc;
+        longinRecord *pli;
+        boRecord *pbo;
+
+        sprintf(name, "r%d:ai", i);
+        pai = (aiRecord *) testdbRecordPtr(name);
+        sprintf(name, "r%d:calc", i);
+        pcalc = (calcRecord *) testdbRecordPtr(name);
+        sprintf(name, "r%d:li", i);
+        pli = (longinRecord *) testdbRecordPtr(name);
+        sprintf(name, "r%d:bo", i);
+        pbo = (boRecord *) testdbRecordPtr(name);
+
+        if (pai->val != i || pai->udf ||
+            pcalc->b != i || pcalc->val != 2 * i ||
+            pli->val != i || pbo->val != 1) {
+            if (!bad)
+                testDiag("Instance %d: ai %g calc B %g VAL %g li %d bo %d",
+                    i, pai->val, pcalc->b, pcalc->val, pli->val, pbo->val);
+            bad++;
+        }
+    }
+    testOk(bad == 0, "%s: all %d instances initialized", mode, NINSTANCES);
+}
+
+static void testSerial(void)
+{
+    testDiag("Serial initialization");
+    loadRecords();
+    iocInitThreads = 0;
+    testIocInitOk();
+    checkRecords("serial");
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+static void testParallel(void)
+{
+    testDiag("Parallel initialization");
+    loadRecords();
+    iocInitThreads = 3;
+    iocInitTiming = 1;
+    testOk1(iocInitParallelType("ai, calc longin") == 0);
+    testOk1(iocInitParallelType(NULL) != 0);
+    /* an unknown type is only reported */
+    testOk1(iocInitParallelType("noSuchType") == 0);
+    testIocInitOk();
+    iocInitThreads = 0;
+    iocInitTiming = 0;
+    checkRecords("parallel");
+    testOk1(iocInitParallelType("bo") != 0);
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+MAIN(parallelInitTest)
+{
+    testPlan(6);
+    testSerial();
+    testParallel();
+    return testDone();
+}
@@ -0,0 +1,532 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Element-wise evaluation of compiled calc expressions over arrays
+ *
+ * Each operation runs once over whole arrays, in simple loops which the
+ * compiler can vectorize, instead of the expression running once per
+ * element. A scalar operand applies to every element of the other, and
+ * the result of combining two arrays is as long as the shorter one.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define epicsExportSharedSymbols
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+/* Array conditionals evaluate both branches, leaving their results above
+ * the condition, so nesting them can use more stack than calcPerform().
+ */
+#define STACK_SIZE (2 * CALCPERFORM_STACK + 2)
+
+/* A stack entry or variable, a scalar when n is 1 */
+typedef struct {
+    double *pv;
+    unsigned long n;
+    double s;
+} avalue;
+
+struct calcArrayWork {
+    unsigned long size;			/* length of each buffer */
+    double *stack[STACK_SIZE];		/* buffer of each stack entry */
+    double *vars[CALCPERFORM_NARGS];	/* buffers of assigned variables */
+};
+
+typedef struct {
+    calcArrayWork *pwork;
+    const calcInst *pfirst;
+    avalue stack[STACK_SIZE];
+    avalue vars[CALCPERFORM_NARGS];
+    avalue val;				/* previous result */
+    int top;				/* index of the top entry */
+    int branches;			/* array conditionals being run */
+} aeval;
+
+#define VALUES(pa) ((pa)->n == 1 ? &(pa)->s : (pa)->pv)
+
+static double * buffer(double **pbuf, unsigned long size)
+{
+    if (!*pbuf)
+        *pbuf = malloc(size * sizeof(double));
+    return *pbuf;
+}
+
+/* Operations on one operand, result in place */
+#define UNARY(expr) \
+    { \
+        avalue *pa = &pe->stack[pe->top]; \
+        if (pa->n == 1) { \
+            double x = pa->s; \
+            pa->s = (expr); \
+        } \
+        else { \
+            const double *a = pa->pv; \
+            double *out = buffer(&pe->pwork->stack[pe->top], size); \
+            unsigned long i, n = pa->n; \
+            if (!out) return -1; \
+            for (i = 0; i < n; i++) { \
+                double x = a[i]; \
+                out[i] = (expr); \
+            } \
+            pa->pv = out; \
+        } \
+    }
+
+/* Operations on two operands, x below y, result replaces x */
+#define BINARY(expr) \
+    { \
+        avalue *pa = &pe->stack[pe->top - 1]; \
+        avalue *pb = &pe->stack[pe->top]; \
+        pe->top--; \
+        if (pa->n == 1 && pb->n == 1) { \
+            double x = pa->s, y = pb->s; \
+            pa->s = (expr); \
+        } \
+        else { \
+            const double *a = VALUES(pa); \
+            const double *b = VALUES(pb); \
+            double *out = buffer(&pe->pwork->stack[pe->top], size); \
+            unsigned long i, n; \
+            if (!out) return -1; \
+            if (pa->n == 1) { \
+                double x = a[0]; \
+                n = pb->n; \
+                for (i = 0; i < n; i++) { \
+                    double y = b[i]; \
+                    out[i] = (expr); \
+                } \
+            } \
+            else if (pb->n == 1) { \
+                double y = b[0]; \
+                n = pa->n; \
+                for (i = 0; i < n; i++) { \
+                    double x = a[i]; \
+                    out[i] = (expr); \
+                } \
+            } \
+            else { \
+                n = pa->n < pb->n ? pa->n : pb->n; \
+                for (i = 0; i < n; i++) { \
+                    double x = a[i], y = b[i]; \
+                    out[i] = (expr); \
+                } \
+            } \
+            pa->pv = out; \
+            pa->n = n; \
+        } \
+    }
+
+/* Push the right operand of an _ARG or _LIT instruction, for BINARY */
+static int pushOperand(aeval *pe, const calcInst *pinst, int fromArg)
+{
+    avalue *pa;
+
+    if (pe->top + 1 >= STACK_SIZE)
+        return -1;
+    pa = &pe->stack[++pe->top];
+    if (fromArg)
+        *pa = pe->vars[pinst->arg];
+    else {
+        pa->n = 1;
+        pa->s = pinst->value;
+    }
+    return 0;
+}
+
+/* Reduce the top entry to a scalar */
+static void reduce(avalue *pa, int op)
+{
+    const double *a = pa->pv;
+    unsigned long i, n = pa->n;
+    double r;
+
+    if (n == 1)
+        return;
+    switch (op) {
+    case INST_ARRAY_SUM:
+    case INST_ARRAY_AVG:
+        r = 0.0;
+        for (i = 0; i < n; i++)
+            r += a[i];
+        if (op == INST_ARRAY_AVG)
+            r = n ? r / n : epicsNAN;
+        break;
+    case INST_ARRAY_MIN:
+        r = n ? a[0] : epicsNAN;
+        for (i = 1; i < n; i++)
+            if (r > a[i] || isnan(a[i]))
+                r = a[i];
+        break;
+    default:
+        r = n ? a[0] : epicsNAN;
+        for (i = 1; i < n; i++)
+            if (r < a[i] || isnan(a[i]))
+                r = a[i];
+    }
+    pa->n = 1;
+    pa->s = r;
+}
+
+/* Run instructions start up to end, or to a jump past end. The operators
+ * do to each element what calcRun() does to a scalar.
+ */
+static long run(aeval *pe, int start, int end, unsigned long size)
+{
+    const calcInst *pfirst = pe->pfirst;
+    int pc = start;
+    int nargs;
+
+    while (pc < end) {
+        const calcInst *pinst = &pfirst[pc++];
+        epicsInt32 itop;
+        epicsUInt32 utop;
+
+        if (pe->top + 1 >= STACK_SIZE)
+            return -1;
+
+        switch (pinst->op) {
+        case INST_END:
+            return 0;
+
+        case INST_PUSH:
+            pe->top++;
+            pe->stack[pe->top].n = 1;
+            pe->stack[pe->top].s = pinst->value;
+            break;
+
+        case INST_FETCH:
+            pe->stack[++pe->top] = pe->vars[pinst->arg];
+            break;
+
+        case INST_FETCH_VAL:
+            pe->stack[++pe->top] = pe->val;
+            break;
+
+        case INST_STORE: {
+            avalue *pa = &pe->stack[pe->top--];
+            avalue *pv = &pe->vars[pinst->arg];
+
+            /* assigning in only one branch of an array conditional
+             * would need a merge that calcPerform() can't express */
+            if (pe->branches)
+                return -1;
+            if (pa->n == 1) {
+                pv->n = 1;
+                pv->s = pa->s;
+            }
+            else {
+                double *pbuf = buffer(&pe->pwork->vars[pinst->arg], size);
+
+                if (!pbuf) return -1;
+                memmove(pbuf, pa->pv, pa->n * sizeof(double));
+                pv->pv = pbuf;
+                pv->n = pa->n;
+            }
+            break;
+        }
+
+        case INST_UNARY_NEG:    UNARY(- x) break;
+        case INST_ADD:          BINARY(x + y) break;
+        case INST_SUB:          BINARY(x - y) break;
+        case INST_MULT:         BINARY(x * y) break;
+        case INST_DIV:          BINARY(x / y) break;
+
+        case INST_MODULO:
+            BINARY((itop = (epicsInt32) y) ?
+                (double) ((epicsInt32) x % itop) : epicsNAN)
+            break;
+
+        case INST_POWER:        BINARY(pow(x, y)) break;
+        case INST_ABS_VAL:      UNARY(fabs(x)) break;
+        case INST_EXP:          UNARY(exp(x)) break;
+        case INST_LOG_10:       UNARY(log10(x)) break;
+        case INST_LOG_E:        UNARY(log(x)) break;
+
+        case INST_MAX:
+            for (nargs = pinst->arg; --nargs; )
+                BINARY((x < y || isnan(y)) ? y : x)
+            break;
+
+        case INST_MIN:
+            for (nargs = pinst->arg; --nargs; )
+                BINARY((x > y || isnan(y)) ? y : x)
+            break;
+
+        case INST_SQU_RT:       UNARY(sqrt(x)) break;
+        case INST_ACOS:         UNARY(acos(x)) break;
+        case INST_ASIN:         UNARY(asin(x)) break;
+        case INST_ATAN:         UNARY(atan(x)) break;
+        case INST_ATAN2:        BINARY(atan2(y, x)) break;
+        case INST_COS:          UNARY(cos(x)) break;
+        case INST_COSH:         UNARY(cosh(x)) break;
+        case INST_SIN:          UNARY(sin(x)) break;
+        case INST_SINH:         UNARY(sinh(x)) break;
+        case INST_TAN:          UNARY(tan(x)) break;
+        case INST_TANH:         UNARY(tanh(x)) break;
+        case INST_CEIL:         UNARY(ceil(x)) break;
+        case INST_FLOOR:        UNARY(floor(x)) break;
+
+        case INST_FINITE:
+            UNARY(finite(x))
+            for (nargs = pinst->arg; --nargs; )
+                BINARY(y && finite(x))
+            break;
+
+        case INST_ISINF:        UNARY(isinf(x)) break;
+
+        case INST_ISNAN:
+            UNARY(isnan(x))
+            for (nargs = pinst->arg; --nargs; )
+                BINARY(y || isnan(x))
+            break;
+
+        case INST_NINT:
+            UNARY((epicsInt32) (x >= 0 ? x + 0.5 : x - 0.5))
+            break;
+
+        case INST_RANDOM:
+            pe->top++;
+            pe->stack[pe->top].n = 1;
+            pe->stack[pe->top].s = epicsCalcRandom();
+            break;
+
+        case INST_REL_OR:       BINARY(x || y) break;
+        case INST_REL_AND:      BINARY(x && y) break;
+        case INST_REL_NOT:      UNARY(! x) break;
+
+        case INST_BIT_OR:
+            BINARY((utop = y, (epicsInt32) ((epicsUInt32) x | utop)))
+            break;
+        case INST_BIT_AND:
+            BINARY((utop = y, (epicsInt32) ((epicsUInt32) x & utop)))
+            break;
+        case INST_BIT_EXCL_OR:
+            BINARY((utop = y, (epicsInt32) ((epicsUInt32) x ^ utop)))
+            break;
+        case INST_BIT_NOT:
+            UNARY((utop = x, (epicsInt32) ~utop))
+            break;
+        case INST_RIGHT_SHIFT:
+            BINARY((utop = y,
+                ((epicsInt32) (epicsUInt32) x) >> (utop & 31)))
+            break;
+        case INST_LEFT_SHIFT:
+            BINARY((utop = y,
+                ((epicsInt32) (epicsUInt32) x) << (utop & 31)))
+            break;
+
+        case INST_NOT_EQ:       BINARY(x != y) break;
+        case INST_LESS_THAN:    BINARY(x < y) break;
+        case INST_LESS_OR_EQ:   BINARY(x <= y) break;
+        case INST_EQUAL:        BINARY(x == y) break;
+        case INST_GR_OR_EQ:     BINARY(x >= y) break;
+        case INST_GR_THAN:      BINARY(x > y) break;
+
+        case INST_ADD_ARG:
+        case INST_SUB_ARG:
+        case INST_MULT_ARG:
+        case INST_DIV_ARG:
+        case INST_NOT_EQ_ARG:
+        case INST_LESS_THAN_ARG:
+        case INST_LESS_OR_EQ_ARG:
+        case INST_EQUAL_ARG:
+        case INST_GR_OR_EQ_ARG:
+        case INST_GR_THAN_ARG:
+        case INST_ADD_LIT:
+        case INST_SUB_LIT:
+        case INST_MULT_LIT:
+        case INST_DIV_LIT:
+        case INST_NOT_EQ_LIT:
+        case INST_LESS_THAN_LIT:
+        case INST_LESS_OR_EQ_LIT:
+        case INST_EQUAL_LIT:
+        case INST_GR_OR_EQ_LIT:
+        case INST_GR_THAN_LIT: {
+            int fromArg = pinst->op < INST_ADD_LIT;
+            int op = pinst->op - (fromArg ? INST_ADD_ARG : INST_ADD_LIT);
+
+            if (pushOperand(pe, pinst, fromArg))
+                return -1;
+            switch (op + INST_ADD_ARG) {
+            case INST_ADD_ARG:          BINARY(x + y) break;
+            case INST_SUB_ARG:          BINARY(x - y) break;
+            case INST_MULT_ARG:         BINARY(x * y) break;
+            case INST_DIV_ARG:          BINARY(x / y) break;
+            case INST_NOT_EQ_ARG:       BINARY(x != y) break;
+            case INST_LESS_THAN_ARG:    BINARY(x < y) break;
+            case INST_LESS_OR_EQ_ARG:   BINARY(x <= y) break;
+            case INST_EQUAL_ARG:        BINARY(x == y) break;
+            case INST_GR_OR_EQ_ARG:     BINARY(x >= y) break;
+            case INST_GR_THAN_ARG:      BINARY(x > y) break;
+            }
+            break;
+        }
+
+        case INST_ARRAY_SUM:
+        case INST_ARRAY_AVG:
+        case INST_ARRAY_MIN:
+        case INST_ARRAY_MAX:
+            reduce(&pe->stack[pe->top], pinst->op);
+            break;
+
+        case INST_JUMP_FALSE: {
+            int other = pinst->arg;     /* first of the false branch */
+            int join;                   /* after both branches */
+
+            if (pe->stack[pe->top].n == 1) {
+                if (pe->stack[pe->top--].s == 0.0)
+                    pc = other;
+                break;
+            }
+
+            /* An array condition picks each element from one of the two
+             * branches, so run both and keep their results above it. A
+             * branch can jump past the end of the one it is nested in.
+             */
+            join = pfirst[other - 1].arg;
+            if (join > end)
+                join = end;
+            pe->branches++;
+            if (run(pe, pc, other - 1, size) ||
+                run(pe, other, join, size)) {
+                pe->branches--;
+                return -1;
+            }
+            pe->branches--;
+            {
+                avalue *pcond = &pe->stack[pe->top - 2];
+                avalue *pt = &pe->stack[pe->top - 1];
+                avalue *pf = &pe->stack[pe->top];
+                const double *c = pcond->pv;
+                const double *t = VALUES(pt);
+                const double *f = VALUES(pf);
+                unsigned long i, n = pcond->n;
+                double *out = buffer(&pe->pwork->stack[pe->top - 2], size);
+
+                if (!out) return -1;
+                if (pt->n != 1 && pt->n < n) n = pt->n;
+                if (pf->n != 1 && pf->n < n) n = pf->n;
+                for (i = 0; i < n; i++)
+                    out[i] = c[i] != 0.0 ? t[pt->n == 1 ? 0 : i] :
+                        f[pf->n == 1 ? 0 : i];
+                pcond->pv = out;
+                pcond->n = n;
+                pe->top -= 2;
+            }
+            pc = join;
+            break;
+        }
+
+        case INST_JUMP:
+            pc = pinst->arg;
+            break;
+
+        default:
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* calcArrayCreate
+ *
+ * Allocate buffers for calcArrayExecute()
+ */
+epicsShareFunc calcArrayWork *
+    calcArrayCreate(void)
+{
+    return calloc(1, sizeof(calcArrayWork));
+}
+
+static void freeBuffers(calcArrayWork *pwork)
+{
+    int i;
+
+    for (i = 0; i < STACK_SIZE; i++) {
+        free(pwork->stack[i]);
+        pwork->stack[i] = NULL;
+    }
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        free(pwork->vars[i]);
+        pwork->vars[i] = NULL;
+    }
+}
+
+/* calcArrayExecute
+ *
+ * Evaluate a compiled expression element-wise over the arrays parg[0]
+ * to parg[CALCPERFORM_NARGS-1]. presult gives the previous value for VAL
+ * and receives up to maxcount elements of the new one.
+ */
+epicsShareFunc long
+    calcArrayExecute(calcArrayWork *pwork, const calcArrayArg *parg,
+        calcArrayArg *presult, unsigned long maxcount,
+        const calcProgram *pprog)
+{
+    aeval eval;
+    avalue *pa;
+    unsigned long size = presult->count;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        avalue *pv = &eval.vars[i];
+
+        if (parg[i].count > size)
+            size = parg[i].count;
+        pv->n = parg[i].count;
+        pv->pv = parg[i].pvalue;
+        pv->s = parg[i].count == 1 ? parg[i].pvalue[0] : 0.0;
+    }
+    if (size == 0)
+        size = 1;
+    if (size > pwork->size) {
+        freeBuffers(pwork);
+        pwork->size = size;
+    }
+    eval.val.n = presult->count;
+    eval.val.pv = presult->pvalue;
+    eval.val.s = presult->count == 1 ? presult->pvalue[0] : 0.0;
+
+    eval.pwork = pwork;
+    eval.pfirst = pprog->inst;
+    eval.top = 0;
+    eval.branches = 0;
+
+    if (run(&eval, 0, INT_MAX, pwork->size) || eval.top != 1)
+        return -1;
+
+    pa = &eval.stack[1];
+    if (pa->n == 1) {
+        presult->pvalue[0] = pa->s;
+        presult->count = 1;
+    }
+    else {
+        unsigned long n = pa->n < maxcount ? pa->n : maxcount;
+
+        memmove(presult->pvalue, pa->pv, n * sizeof(double));
+        presult->count = n;
+    }
+    return 0;
+}
+
+/* calcArrayDestroy
+ *
+ * Release the buffers of calcArrayCreate()
+ */
+epicsShareFunc void
+    calcArrayDestroy(calcArrayWork *pwork)
+{
+    if (!pwork) return;
+    freeBuffers(pwork);
+    free(pwork);
+}
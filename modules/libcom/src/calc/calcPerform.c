@@ -25,7 +25,6 @@
 #include "postfix.h"
 #include "postfixPvt.h"
 
-static double calcRandom(void);
 static int cond_search(const char **ppinst, int match);
 
 #ifndef PI
@@ -270,7 +269,7 @@ epicsShareFunc long
 	    break;
 
 	case RANDOM:
-	    *++ptop = calcRandom();
+	    *++ptop = epicsCalcRandom();
 	    break;
 
 	case REL_OR:
@@ -370,6 +369,13 @@ epicsShareFunc long
 	case COND_END:
 	    break;
 
+	/* A scalar is its own sum, average, minimum and maximum */
+	case ARRAY_SUM:
+	case ARRAY_AVG:
+	case ARRAY_MIN:
+	case ARRAY_MAX:
+	    break;
+
 	default:
 	    errlogPrintf("calcPerform: Bad Opcode %d at %p\n", op, pinst-1);
 	    return -1;
@@ -382,6 +388,272 @@ epicsShareFunc long
     *presult = *ptop;
     return 0;
 }
+/* calcRun
+ *
+ * Evaluate compiled instructions. Every operator here must do exactly what
+ * calcPerform() does for it, so the results of the two are identical.
+ * GCC and clang dispatch through a table of label addresses, with a jump
+ * at the end of each operation, otherwise this is a switch in a loop.
+ */
+#if defined(__GNUC__)
+#  define INST_LABEL(op) &&do_##op,
+#  define EVAL_BEGIN  goto *dispatch[pinst->op]; {
+#  define EVAL_END    }
+#  define CASE(op)    do_##op:
+#  define NEXT        goto *dispatch[(++pinst)->op]
+#else
+#  define EVAL_BEGIN  for (;;) { switch (pinst->op) {
+#  define EVAL_END    default: \
+                          errlogPrintf("calcRun: Bad Opcode %d at %p\n", \
+                              pinst->op, (void *) pinst); \
+                          return -1; \
+                      } }
+#  define CASE(op)    case INST_##op:
+#  define NEXT        pinst++; continue
+#endif
+
+#define BINARY(op, expr) \
+    CASE(op) \
+	top = *ptop--; \
+	*ptop = expr; \
+	NEXT; \
+    CASE(op##_ARG) \
+	top = parg[pinst->arg]; \
+	*ptop = expr; \
+	NEXT; \
+    CASE(op##_LIT) \
+	top = pinst->value; \
+	*ptop = expr; \
+	NEXT;
+
+#define UNARY(op, expr) \
+    CASE(op) \
+	*ptop = expr; \
+	NEXT;
+
+long calcRun(const calcInst *pinst, double *parg, double *presult)
+{
+#if defined(__GNUC__)
+    static const void * const dispatch[] = {
+	CALC_INST_OPCODES(INST_LABEL)
+    };
+#endif
+    double stack[CALCPERFORM_STACK+1];	/* zero'th entry not used */
+    double *ptop = stack;		/* stack pointer */
+    double top; 			/* value from top of stack */
+    epicsInt32 itop;			/* integer from top of stack */
+    epicsUInt32 utop;			/* unsigned integer from top of stack */
+    int nargs;
+    const calcInst *pfirst = pinst;
+
+    EVAL_BEGIN
+
+    CASE(END)
+	goto done;
+
+    CASE(PUSH)
+	*++ptop = pinst->value;
+	NEXT;
+
+    CASE(FETCH)
+	*++ptop = parg[pinst->arg];
+	NEXT;
+
+    CASE(FETCH_VAL)
+	*++ptop = *presult;
+	NEXT;
+
+    CASE(STORE)
+	parg[pinst->arg] = *ptop--;
+	NEXT;
+
+    UNARY(UNARY_NEG, - *ptop)
+
+    BINARY(ADD, *ptop + top)
+    BINARY(SUB, *ptop - top)
+    BINARY(MULT, *ptop * top)
+    BINARY(DIV, *ptop / top)
+
+    CASE(MODULO)
+	itop = (epicsInt32) *ptop--;
+	if (itop)
+	    *ptop = (epicsInt32) *ptop % itop;
+	else
+	    *ptop = epicsNAN;
+	NEXT;
+
+    CASE(POWER)
+	top = *ptop--;
+	*ptop = pow(*ptop, top);
+	NEXT;
+
+    UNARY(ABS_VAL, fabs(*ptop))
+    UNARY(EXP, exp(*ptop))
+    UNARY(LOG_10, log10(*ptop))
+    UNARY(LOG_E, log(*ptop))
+
+    CASE(MAX)
+	nargs = pinst->arg;
+	while (--nargs) {
+	    top = *ptop--;
+	    if (*ptop < top || isnan(top))
+		*ptop = top;
+	}
+	NEXT;
+
+    CASE(MIN)
+	nargs = pinst->arg;
+	while (--nargs) {
+	    top = *ptop--;
+	    if (*ptop > top || isnan(top))
+		*ptop = top;
+	}
+	NEXT;
+
+    UNARY(SQU_RT, sqrt(*ptop))
+    UNARY(ACOS, acos(*ptop))
+    UNARY(ASIN, asin(*ptop))
+    UNARY(ATAN, atan(*ptop))
+
+    CASE(ATAN2)
+	top = *ptop--;
+	*ptop = atan2(top, *ptop);	/* Ouch!: Args backwards! */
+	NEXT;
+
+    UNARY(COS, cos(*ptop))
+    UNARY(COSH, cosh(*ptop))
+    UNARY(SIN, sin(*ptop))
+    UNARY(SINH, sinh(*ptop))
+    UNARY(TAN, tan(*ptop))
+    UNARY(TANH, tanh(*ptop))
+    UNARY(CEIL, ceil(*ptop))
+    UNARY(FLOOR, floor(*ptop))
+
+    CASE(FINITE)
+	nargs = pinst->arg;
+	top = finite(*ptop);
+	while (--nargs) {
+	    --ptop;
+	    top = top && finite(*ptop);
+	}
+	*ptop = top;
+	NEXT;
+
+    UNARY(ISINF, isinf(*ptop))
+
+    CASE(ISNAN)
+	nargs = pinst->arg;
+	top = isnan(*ptop);
+	while (--nargs) {
+	    --ptop;
+	    top = top || isnan(*ptop);
+	}
+	*ptop = top;
+	NEXT;
+
+    CASE(NINT)
+	top = *ptop;
+	*ptop = (epicsInt32) (top >= 0 ? top + 0.5 : top - 0.5);
+	NEXT;
+
+    CASE(RANDOM)
+	*++ptop = epicsCalcRandom();
+	NEXT;
+
+    CASE(REL_OR)
+	top = *ptop--;
+	*ptop = *ptop || top;
+	NEXT;
+
+    CASE(REL_AND)
+	top = *ptop--;
+	*ptop = *ptop && top;
+	NEXT;
+
+    UNARY(REL_NOT, ! *ptop)
+
+    CASE(BIT_OR)
+	utop = *ptop--;
+	*ptop = (epicsInt32) ((epicsUInt32) *ptop | utop);
+	NEXT;
+
+    CASE(BIT_AND)
+	utop = *ptop--;
+	*ptop = (epicsInt32) ((epicsUInt32) *ptop & utop);
+	NEXT;
+
+    CASE(BIT_EXCL_OR)
+	utop = *ptop--;
+	*ptop = (epicsInt32) ((epicsUInt32) *ptop ^ utop);
+	NEXT;
+
+    CASE(BIT_NOT)
+	utop = *ptop;
+	*ptop = (epicsInt32) ~utop;
+	NEXT;
+
+    CASE(RIGHT_SHIFT)
+	utop = *ptop--;
+	*ptop = ((epicsInt32) (epicsUInt32) *ptop) >> (utop & 31);
+	NEXT;
+
+    CASE(LEFT_SHIFT)
+	utop = *ptop--;
+	*ptop = ((epicsInt32) (epicsUInt32) *ptop) << (utop & 31);
+	NEXT;
+
+    BINARY(NOT_EQ, *ptop != top)
+    BINARY(LESS_THAN, *ptop < top)
+    BINARY(LESS_OR_EQ, *ptop <= top)
+    BINARY(EQUAL, *ptop == top)
+    BINARY(GR_OR_EQ, *ptop >= top)
+    BINARY(GR_THAN, *ptop > top)
+
+    CASE(ARRAY_SUM)
+    CASE(ARRAY_AVG)
+    CASE(ARRAY_MIN)
+    CASE(ARRAY_MAX)
+	NEXT;
+
+    CASE(JUMP_FALSE)
+	if (*ptop-- == 0.0) {
+	    pinst = pfirst + pinst->arg;
+	    pinst--;
+	}
+	NEXT;
+
+    CASE(JUMP)
+	pinst = pfirst + pinst->arg;
+	pinst--;
+	NEXT;
+
+    EVAL_END
+
+done:
+    /* The stack should now have one item on it, the expression value */
+    if (ptop != stack + 1)
+	return -1;
+    *presult = *ptop;
+    return 0;
+}
+
+#undef INST_LABEL
+#undef EVAL_BEGIN
+#undef EVAL_END
+#undef CASE
+#undef NEXT
+#undef BINARY
+#undef UNARY
+
+/* calcExecute
+ *
+ * Evaluate an expression compiled by calcCompile()
+ */
+epicsShareFunc long
+    calcExecute(double *parg, double *presult, const calcProgram *pprog)
+{
+    return calcRun(pprog->inst, parg, presult);
+}
 #if defined(_WIN32) && defined(_M_X64) && !defined(_MINGW)
 #  pragma optimize("", on)
 #endif
@@ -459,7 +731,7 @@ static unsigned short seed = 0xa3bf;
 static unsigned short multy = 191 * 8 + 5;  /* 191 % 8 == 5 */
 static unsigned short addy = 0x3141;
 
-static double calcRandom(void)
+double epicsCalcRandom(void)
 {
     seed = (seed * multy) + addy;
 
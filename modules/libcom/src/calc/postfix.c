@@ -14,6 +14,7 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
@@ -27,6 +28,10 @@
 #include "postfixPvt.h"
 #include "shareLib.h"
 
+#ifndef PI
+#define PI 3.14159265358979323
+#endif
+
 
 /* declarations for postfix */
 
@@ -85,9 +90,12 @@ static const ELEMENT operands[] = {
 {"A",		0, 0,	1,	OPERAND,	FETCH_A},
 {"ABS",		7, 8,	0,	UNARY_OPERATOR,	ABS_VAL},
 {"ACOS",	7, 8,	0,	UNARY_OPERATOR,	ACOS},
+{"AMAX",	7, 8,	0,	UNARY_OPERATOR,	ARRAY_MAX},
+{"AMIN",	7, 8,	0,	UNARY_OPERATOR,	ARRAY_MIN},
 {"ASIN",	7, 8,	0,	UNARY_OPERATOR,	ASIN},
 {"ATAN",	7, 8,	0,	UNARY_OPERATOR,	ATAN},
 {"ATAN2",	7, 8,	-1,	UNARY_OPERATOR,	ATAN2},
+{"AVG",		7, 8,	0,	UNARY_OPERATOR,	ARRAY_AVG},
 {"B",		0, 0,	1,	OPERAND,	FETCH_B},
 {"C",		0, 0,	1,	OPERAND,	FETCH_C},
 {"CEIL",	7, 8,	0,	UNARY_OPERATOR,	CEIL},
@@ -124,6 +132,7 @@ static const ELEMENT operands[] = {
 {"SINH",	7, 8,	0,	UNARY_OPERATOR,	SINH},
 {"SQR",		7, 8,	0,	UNARY_OPERATOR,	SQU_RT},
 {"SQRT",	7, 8,	0,	UNARY_OPERATOR,	SQU_RT},
+{"SUM",		7, 8,	0,	UNARY_OPERATOR,	ARRAY_SUM},
 {"TAN",		7, 8,	0,	UNARY_OPERATOR,	TAN},
 {"TANH",	7, 8,	0,	UNARY_OPERATOR,	TANH},
 {"VAL",		0, 0,	1,	OPERAND,	FETCH_VAL},
@@ -485,6 +494,338 @@ bad:
 }
 
 
+/* State of calcCompile() */
+typedef struct {
+    calcInst *pinst;	/* instructions so far */
+    int ninst;
+    int label;		/* index of the last jump target */
+} compiler;
+
+/* Pure operators with all operands PUSHed since the last jump target
+ * are evaluated now, by the same code that would run them later. A
+ * binary operator whose right operand was the last instruction takes it
+ * from that instruction instead. Otherwise the operator is appended.
+ */
+static void compileOp(compiler *pc, int op, int nargs, int arg, int fused)
+{
+    calcInst *pinst = pc->pinst;
+    int n = pc->ninst;
+    int i;
+
+    if (op != INST_RANDOM && n - nargs >= pc->label) {
+	for (i = n - nargs; i < n; i++)
+	    if (pinst[i].op != INST_PUSH) break;
+	if (i == n) {
+	    calcInst fold[CALCPERFORM_STACK + 2];
+	    double value = 0.0;
+
+	    memcpy(fold, &pinst[n - nargs], nargs * sizeof(calcInst));
+	    fold[nargs].op = op;
+	    fold[nargs].arg = arg;
+	    fold[nargs + 1].op = INST_END;
+	    if (calcRun(fold, NULL, &value) == 0) {
+		pc->ninst = n - nargs + 1;
+		pinst[n - nargs].op = INST_PUSH;
+		pinst[n - nargs].value = value;
+		return;
+	    }
+	}
+    }
+    if (fused && n - 1 >= pc->label) {
+	if (pinst[n - 1].op == INST_FETCH) {
+	    pinst[n - 1].op = fused;
+	    return;
+	}
+	if (pinst[n - 1].op == INST_PUSH) {
+	    pinst[n - 1].op = fused + (INST_ADD_LIT - INST_ADD_ARG);
+	    return;
+	}
+    }
+    pinst[n].op = op;
+    pinst[n].arg = arg;
+    pinst[n].value = 0.0;
+    pc->ninst++;
+}
+
+static void compilePush(compiler *pc, int op, int arg, double value)
+{
+    calcInst *pinst = &pc->pinst[pc->ninst++];
+
+    pinst->op = op;
+    pinst->arg = arg;
+    pinst->value = value;
+}
+
+/* Index of the operation after the one that cond_search() in
+ * calcPerform.c would find for the conditional operation k, or -1.
+ */
+static int compileTarget(const char **popk, int nops, int k, int match)
+{
+    int count = 1;
+
+    while (++k < nops) {
+	int op = *popk[k];
+
+	if (op == match && --count == 0)
+	    return k + 1;
+	if (op == COND_IF)
+	    count++;
+    }
+    return -1;
+}
+
+/* calcCompile
+ *
+ * Pre-decode postfix instructions for calcExecute(). Returns NULL if
+ * the expression can't be compiled or no memory is available, in which
+ * case calcPerform() should be used instead.
+ */
+epicsShareFunc calcProgram *
+    calcCompile(const char *ppostfix)
+{
+    const char *pinst = ppostfix;
+    const char **popk = NULL;	/* start of each operation */
+    int *target = NULL;		/* operation a conditional jumps to */
+    int *index = NULL;		/* first instruction of each operation */
+    calcProgram *pprog = NULL;
+    compiler comp;
+    int nops = 0;
+    int k;
+    epicsInt32 lit_i;
+    double lit_d;
+    char op;
+
+    if (!ppostfix) return NULL;
+
+    /* count the operations */
+    while ((op = *pinst++) != END_EXPRESSION) {
+	nops++;
+	switch (op) {
+	case LITERAL_DOUBLE:
+	    pinst += sizeof(double);
+	    break;
+	case LITERAL_INT:
+	    pinst += sizeof(epicsInt32);
+	    break;
+	case MIN:
+	case MAX:
+	case FINITE:
+	case ISNAN:
+	    pinst++;
+	    break;
+	}
+    }
+
+    pprog = malloc((nops + 1) * sizeof(calcInst));
+    popk = malloc((nops + 1) * sizeof(const char *));
+    target = calloc(nops + 1, sizeof(int));
+    index = calloc(nops + 1, sizeof(int));
+    if (!pprog || !popk || !target || !index)
+	goto fail;
+
+    pinst = ppostfix;
+    for (k = 0; k <= nops; k++) {
+	popk[k] = pinst;
+	switch (*pinst++) {
+	case LITERAL_DOUBLE:
+	    pinst += sizeof(double);
+	    break;
+	case LITERAL_INT:
+	    pinst += sizeof(epicsInt32);
+	    break;
+	case MIN:
+	case MAX:
+	case FINITE:
+	case ISNAN:
+	    pinst++;
+	    break;
+	}
+    }
+
+    /* Resolve the conditionals, marking their targets with index -1 */
+    for (k = 0; k < nops; k++) {
+	op = *popk[k];
+	if (op == COND_IF)
+	    target[k] = compileTarget(popk, nops, k, COND_ELSE);
+	else if (op == COND_ELSE)
+	    target[k] = compileTarget(popk, nops, k, COND_END);
+	else
+	    continue;
+	if (target[k] < 0)
+	    goto fail;
+	index[target[k]] = -1;
+    }
+
+    comp.pinst = pprog->inst;
+    comp.ninst = 0;
+    comp.label = 0;
+
+    for (k = 0; k <= nops; k++) {
+	/* nothing gets folded or fused across a jump target */
+	if (index[k] < 0)
+	    comp.label = comp.ninst;
+	index[k] = comp.ninst;
+
+	pinst = popk[k];
+	switch (op = *pinst++) {
+
+	case END_EXPRESSION:
+	    compilePush(&comp, INST_END, 0, 0.0);
+	    break;
+
+	case LITERAL_DOUBLE:
+	    memcpy(&lit_d, pinst, sizeof(double));
+	    compilePush(&comp, INST_PUSH, 0, lit_d);
+	    break;
+
+	case LITERAL_INT:
+	    memcpy(&lit_i, pinst, sizeof(epicsInt32));
+	    compilePush(&comp, INST_PUSH, 0, lit_i);
+	    break;
+
+	case CONST_PI:
+	    compilePush(&comp, INST_PUSH, 0, PI);
+	    break;
+
+	case CONST_D2R:
+	    compilePush(&comp, INST_PUSH, 0, PI/180.);
+	    break;
+
+	case CONST_R2D:
+	    compilePush(&comp, INST_PUSH, 0, 180./PI);
+	    break;
+
+	case FETCH_VAL:
+	    compilePush(&comp, INST_FETCH_VAL, 0, 0.0);
+	    break;
+
+	case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+	case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+	case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+	    compilePush(&comp, INST_FETCH, op - FETCH_A, 0.0);
+	    break;
+
+	case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+	case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+	case STORE_I: case STORE_J: case STORE_K: case STORE_L:
+	    compilePush(&comp, INST_STORE, op - STORE_A, 0.0);
+	    break;
+
+	case UNARY_NEG:	compileOp(&comp, INST_UNARY_NEG, 1, 0, 0); break;
+	case ADD:	compileOp(&comp, INST_ADD, 2, 0, INST_ADD_ARG); break;
+	case SUB:	compileOp(&comp, INST_SUB, 2, 0, INST_SUB_ARG); break;
+	case MULT:	compileOp(&comp, INST_MULT, 2, 0, INST_MULT_ARG); break;
+	case DIV:	compileOp(&comp, INST_DIV, 2, 0, INST_DIV_ARG); break;
+	case MODULO:	compileOp(&comp, INST_MODULO, 2, 0, 0); break;
+	case POWER:	compileOp(&comp, INST_POWER, 2, 0, 0); break;
+	case ABS_VAL:	compileOp(&comp, INST_ABS_VAL, 1, 0, 0); break;
+	case EXP:	compileOp(&comp, INST_EXP, 1, 0, 0); break;
+	case LOG_10:	compileOp(&comp, INST_LOG_10, 1, 0, 0); break;
+	case LOG_E:	compileOp(&comp, INST_LOG_E, 1, 0, 0); break;
+	case SQU_RT:	compileOp(&comp, INST_SQU_RT, 1, 0, 0); break;
+	case ACOS:	compileOp(&comp, INST_ACOS, 1, 0, 0); break;
+	case ASIN:	compileOp(&comp, INST_ASIN, 1, 0, 0); break;
+	case ATAN:	compileOp(&comp, INST_ATAN, 1, 0, 0); break;
+	case ATAN2:	compileOp(&comp, INST_ATAN2, 2, 0, 0); break;
+	case COS:	compileOp(&comp, INST_COS, 1, 0, 0); break;
+	case COSH:	compileOp(&comp, INST_COSH, 1, 0, 0); break;
+	case SIN:	compileOp(&comp, INST_SIN, 1, 0, 0); break;
+	case SINH:	compileOp(&comp, INST_SINH, 1, 0, 0); break;
+	case TAN:	compileOp(&comp, INST_TAN, 1, 0, 0); break;
+	case TANH:	compileOp(&comp, INST_TANH, 1, 0, 0); break;
+	case CEIL:	compileOp(&comp, INST_CEIL, 1, 0, 0); break;
+	case FLOOR:	compileOp(&comp, INST_FLOOR, 1, 0, 0); break;
+	case ISINF:	compileOp(&comp, INST_ISINF, 1, 0, 0); break;
+	case NINT:	compileOp(&comp, INST_NINT, 1, 0, 0); break;
+	case ARRAY_SUM:	compileOp(&comp, INST_ARRAY_SUM, 1, 0, 0); break;
+	case ARRAY_AVG:	compileOp(&comp, INST_ARRAY_AVG, 1, 0, 0); break;
+	case ARRAY_MIN:	compileOp(&comp, INST_ARRAY_MIN, 1, 0, 0); break;
+	case ARRAY_MAX:	compileOp(&comp, INST_ARRAY_MAX, 1, 0, 0); break;
+	case RANDOM:	compileOp(&comp, INST_RANDOM, 0, 0, 0); break;
+	case REL_OR:	compileOp(&comp, INST_REL_OR, 2, 0, 0); break;
+	case REL_AND:	compileOp(&comp, INST_REL_AND, 2, 0, 0); break;
+	case REL_NOT:	compileOp(&comp, INST_REL_NOT, 1, 0, 0); break;
+	case BIT_OR:	compileOp(&comp, INST_BIT_OR, 2, 0, 0); break;
+	case BIT_AND:	compileOp(&comp, INST_BIT_AND, 2, 0, 0); break;
+	case BIT_EXCL_OR: compileOp(&comp, INST_BIT_EXCL_OR, 2, 0, 0); break;
+	case BIT_NOT:	compileOp(&comp, INST_BIT_NOT, 1, 0, 0); break;
+	case RIGHT_SHIFT: compileOp(&comp, INST_RIGHT_SHIFT, 2, 0, 0); break;
+	case LEFT_SHIFT: compileOp(&comp, INST_LEFT_SHIFT, 2, 0, 0); break;
+	case NOT_EQ:	compileOp(&comp, INST_NOT_EQ, 2, 0,
+			    INST_NOT_EQ_ARG); break;
+	case LESS_THAN:	compileOp(&comp, INST_LESS_THAN, 2, 0,
+			    INST_LESS_THAN_ARG); break;
+	case LESS_OR_EQ: compileOp(&comp, INST_LESS_OR_EQ, 2, 0,
+			    INST_LESS_OR_EQ_ARG); break;
+	case EQUAL:	compileOp(&comp, INST_EQUAL, 2, 0,
+			    INST_EQUAL_ARG); break;
+	case GR_OR_EQ:	compileOp(&comp, INST_GR_OR_EQ, 2, 0,
+			    INST_GR_OR_EQ_ARG); break;
+	case GR_THAN:	compileOp(&comp, INST_GR_THAN, 2, 0,
+			    INST_GR_THAN_ARG); break;
+
+	case MAX:
+	case MIN:
+	case FINITE:
+	case ISNAN:
+	    {
+		int nargs = *pinst;
+		int iop = op == MAX ? INST_MAX : op == MIN ? INST_MIN :
+		    op == FINITE ? INST_FINITE : INST_ISNAN;
+
+		if (nargs < 1 || nargs > CALCPERFORM_STACK)
+		    goto fail;
+		compileOp(&comp, iop, nargs, nargs, 0);
+	    }
+	    break;
+
+	/* Jump targets are operation numbers until all are known */
+	case COND_IF:
+	    compilePush(&comp, INST_JUMP_FALSE, target[k], 0.0);
+	    break;
+
+	case COND_ELSE:
+	    compilePush(&comp, INST_JUMP, target[k], 0.0);
+	    break;
+
+	case COND_END:
+	    break;
+
+	default:
+	    goto fail;
+	}
+    }
+
+    for (k = 0; k < comp.ninst; k++) {
+	calcInst *pci = &comp.pinst[k];
+
+	if (pci->op == INST_JUMP_FALSE || pci->op == INST_JUMP)
+	    pci->arg = index[pci->arg];
+    }
+    free(popk);
+    free(target);
+    free(index);
+    return pprog;
+
+fail:
+    free(pprog);
+    free(popk);
+    free(target);
+    free(index);
+    return NULL;
+}
+
+/* calcProgramFree
+ *
+ * Release a program from calcCompile()
+ */
+epicsShareFunc void
+    calcProgramFree(calcProgram *pprog)
+{
+    free(pprog);
+}
+
+
 /* calcErrorStr
  *
  * Return a message string appropriate for the given error code
@@ -592,6 +933,11 @@ epicsShareFunc void
 	"COND_IF",
 	"COND_ELSE",
 	"COND_END",
+    /* Array reductions */
+	"ARRAY_SUM",
+	"ARRAY_AVG",
+	"ARRAY_MIN",
+	"ARRAY_MAX",
     /* Misc */
 	"NOT_GENERATED"
     };
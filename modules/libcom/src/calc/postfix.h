@@ -63,6 +63,20 @@
 /* Changes in the above errors must also be made in calcErrorStr() */
 
 
+/* A postfix expression pre-decoded by calcCompile() */
+typedef struct calcProgram calcProgram;
+
+/* An input or result of calcArrayExecute(), count values where a count
+ * of 1 is a scalar that applies to every element of the other operands.
+ */
+typedef struct calcArrayArg {
+    double *pvalue;
+    unsigned long count;
+} calcArrayArg;
+
+/* Buffers for intermediate arrays, reused by calcArrayExecute() */
+typedef struct calcArrayWork calcArrayWork;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -76,6 +90,26 @@ epicsShareFunc long
 epicsShareFunc long
     calcArgUsage(const char *ppostfix, unsigned long *pinputs, unsigned long *pstores);
 
+epicsShareFunc calcProgram *
+    calcCompile(const char *ppostfix);
+
+epicsShareFunc long
+    calcExecute(double *parg, double *presult, const calcProgram *pprog);
+
+epicsShareFunc void
+    calcProgramFree(calcProgram *pprog);
+
+epicsShareFunc calcArrayWork *
+    calcArrayCreate(void);
+
+epicsShareFunc long
+    calcArrayExecute(calcArrayWork *pwork, const calcArrayArg *parg,
+        calcArrayArg *presult, unsigned long maxcount,
+        const calcProgram *pprog);
+
+epicsShareFunc void
+    calcArrayDestroy(calcArrayWork *pwork);
+
 epicsShareFunc const char *
     calcErrorStr(short error);
 
@@ -97,8 +97,68 @@ typedef enum {
 	COND_IF,
 	COND_ELSE,
 	COND_END,
+    /* Array reductions */
+	ARRAY_SUM,
+	ARRAY_AVG,
+	ARRAY_MIN,
+	ARRAY_MAX,
     /* Misc */
 	NOT_GENERATED
 } rpn_opcode;
 
+
+/* Compiled instructions, see calcCompile()
+ *  1. Literals and the trigonometry constants become PUSH with a value,
+ *     the FETCH and STORE opcodes take the argument index in arg.
+ *  2. COND_IF and COND_ELSE become jumps to the instruction index in arg,
+ *     COND_END generates nothing.
+ *  3. The _ARG and _LIT forms of the binary operators take their right
+ *     operand from the argument or value of the instruction itself.
+ *  4. MAX, MIN, FINITE and ISNAN take their argument count in arg.
+ *  5. The ARRAY_ reductions leave a scalar unchanged, only calcArrayExecute()
+ *     has arrays to reduce.
+ */
+#define CALC_INST_OPCODES(X) \
+    X(END) X(PUSH) X(FETCH) X(FETCH_VAL) X(STORE) \
+    X(UNARY_NEG) X(ADD) X(SUB) X(MULT) X(DIV) X(MODULO) X(POWER) \
+    X(ABS_VAL) X(EXP) X(LOG_10) X(LOG_E) X(MAX) X(MIN) X(SQU_RT) \
+    X(ACOS) X(ASIN) X(ATAN) X(ATAN2) X(COS) X(COSH) X(SIN) X(SINH) \
+    X(TAN) X(TANH) \
+    X(CEIL) X(FLOOR) X(FINITE) X(ISINF) X(ISNAN) X(NINT) X(RANDOM) \
+    X(REL_OR) X(REL_AND) X(REL_NOT) \
+    X(BIT_OR) X(BIT_AND) X(BIT_EXCL_OR) X(BIT_NOT) \
+    X(RIGHT_SHIFT) X(LEFT_SHIFT) \
+    X(NOT_EQ) X(LESS_THAN) X(LESS_OR_EQ) X(EQUAL) X(GR_OR_EQ) X(GR_THAN) \
+    X(ARRAY_SUM) X(ARRAY_AVG) X(ARRAY_MIN) X(ARRAY_MAX) \
+    X(JUMP_FALSE) X(JUMP) \
+    X(ADD_ARG) X(SUB_ARG) X(MULT_ARG) X(DIV_ARG) \
+    X(NOT_EQ_ARG) X(LESS_THAN_ARG) X(LESS_OR_EQ_ARG) X(EQUAL_ARG) \
+    X(GR_OR_EQ_ARG) X(GR_THAN_ARG) \
+    X(ADD_LIT) X(SUB_LIT) X(MULT_LIT) X(DIV_LIT) \
+    X(NOT_EQ_LIT) X(LESS_THAN_LIT) X(LESS_OR_EQ_LIT) X(EQUAL_LIT) \
+    X(GR_OR_EQ_LIT) X(GR_THAN_LIT)
+
+#define CALC_INST_ENUM(op) INST_##op,
+typedef enum {
+    CALC_INST_OPCODES(CALC_INST_ENUM)
+    INST_NOT_GENERATED
+} calc_inst_opcode;
+#undef CALC_INST_ENUM
+
+typedef struct calcInst {
+    int op;             /* calc_inst_opcode */
+    int arg;            /* argument index, argument count or jump target */
+    double value;       /* PUSH and _LIT operand */
+} calcInst;
+
+struct calcProgram {
+    calcInst inst[1];   /* as many as needed, the last one is INST_END */
+};
+
+/* Evaluate compiled instructions, in calcPerform.c */
+long calcRun(const calcInst *pinst, double *parg, double *presult);
+
+/* The RNDM generator shared by all of the evaluators */
+double epicsCalcRandom(void);
+
 #endif /* INCpostfixPvth */
@@ -15,12 +15,20 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 #define epicsExportSharedSymbols
 #include "dbDefs.h"
 #include "ellLib.h"
 #include "epicsMutex.h"
+#include "epicsString.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
+#include "yajl_gen.h"
 
 #include "initHooks.h"
 
@@ -32,6 +40,41 @@ typedef struct initHookLink {
 static ELLLIST functionList = ELLLIST_INIT;
 static epicsMutexId listLock;
 
+/*
+ * Startup profiling, protected by listLock
+ */
+#define NO_MEMORY -1L
+
+typedef struct timingCommand {
+    char *text;
+    int depth;
+    double seconds;
+    long memory;
+} timingCommand;
+
+typedef struct timingPhase {
+    int reached;
+    double seconds;
+    long memory;
+} timingPhase;
+
+typedef struct timingToken {
+    epicsUInt64 start;
+    long memory;
+} timingToken;
+
+static int timingEnabled;
+static int timingDepth;
+static int timingReportDue;     /* report when the commands finish */
+static char *timingJson;
+static epicsUInt64 timingStart;
+static epicsUInt64 timingLast;
+static long timingLastMemory;
+static timingCommand *timingCommands;
+static size_t nTimingCommands;
+static size_t timingCommandsSize;
+static timingPhase timingPhases[initHookAtEnd + 1];
+
 /*
  * Lazy initialization functions
  */
@@ -74,6 +117,9 @@ int initHookRegister(initHookFunction func)
  * Called by iocInit at various points during initialization.
  * This function must only be called by iocInit and relatives.
  */
+static void timingPhaseReached(initHookState state);
+static void timingDone(void);
+
 void initHookAnnounce(initHookState state)
 {
     initHookLink *hook;
@@ -81,6 +127,8 @@ void initHookAnnounce(initHookState state)
     initHookInit();
 
     epicsMutexMustLock(listLock);
+    if (timingEnabled)
+        timingPhaseReached(state);
     hook = (initHookLink *)ellFirst(&functionList);
     epicsMutexUnlock(listLock);
 
@@ -91,6 +139,18 @@ void initHookAnnounce(initHookState state)
         hook = (initHookLink *)ellNext(&hook->node);
         epicsMutexUnlock(listLock);
     }
+
+    if (state == initHookAtEnd && timingEnabled) {
+        int inCommand;
+
+        /* wait until the iocInit command has been recorded */
+        epicsMutexMustLock(listLock);
+        inCommand = timingDepth > 0;
+        timingReportDue = inCommand;
+        epicsMutexUnlock(listLock);
+        if (!inCommand)
+            timingDone();
+    }
 }
 
 void initHookFree(void)
@@ -136,3 +196,329 @@ const char *initHookName(int state)
     }
     return stateName[state];
 }
+
+/*
+ * Startup profiling
+ */
+static long memoryUsed(void)
+{
+#ifdef __linux__
+    FILE *fp = fopen("/proc/self/statm", "r");
+    unsigned long size, resident;
+    int n;
+
+    if (!fp)
+        return NO_MEMORY;
+    n = fscanf(fp, "%lu %lu", &size, &resident);
+    fclose(fp);
+    if (n != 2)
+        return NO_MEMORY;
+    return (long) resident * sysconf(_SC_PAGESIZE);
+#else
+    return NO_MEMORY;
+#endif
+}
+
+static long memoryGrowth(long before, long after)
+{
+    if (before == NO_MEMORY || after == NO_MEMORY)
+        return NO_MEMORY;
+    return after - before;
+}
+
+static void timingClear(void)
+{
+    size_t i;
+
+    for (i = 0; i < nTimingCommands; i++)
+        free(timingCommands[i].text);
+    free(timingCommands);
+    timingCommands = NULL;
+    nTimingCommands = timingCommandsSize = 0;
+    memset(timingPhases, 0, sizeof(timingPhases));
+    timingDepth = 0;
+    timingReportDue = 0;
+}
+
+void initHookTimingEnable(int enable, const char *jsonFile)
+{
+    initHookInit();
+    epicsMutexMustLock(listLock);
+    timingClear();
+    free(timingJson);
+    timingJson = NULL;
+    timingEnabled = enable;
+    if (enable) {
+        if (jsonFile && *jsonFile)
+            timingJson = epicsStrDup(jsonFile);
+        timingStart = timingLast = epicsMonotonicGet();
+        timingLastMemory = memoryUsed();
+    }
+    epicsMutexUnlock(listLock);
+}
+
+/* Called with listLock held */
+static void timingPhaseReached(initHookState state)
+{
+    epicsUInt64 now = epicsMonotonicGet();
+    long memory = memoryUsed();
+    timingPhase *phase;
+
+    if ((int) state < 0 || state >= NELEMENTS(timingPhases))
+        return;
+    phase = &timingPhases[state];
+    phase->reached = 1;
+    phase->seconds = (now - timingLast) * 1e-9;
+    phase->memory = memoryGrowth(timingLastMemory, memory);
+    timingLast = now;
+    timingLastMemory = memory;
+}
+
+static void timingDone(void)
+{
+    char *jsonFile;
+
+    epicsMutexMustLock(listLock);
+    jsonFile = timingJson;
+    timingJson = NULL;
+    epicsMutexUnlock(listLock);
+
+    initHookTimingShow(jsonFile);
+    free(jsonFile);
+    initHookTimingEnable(0, NULL);
+}
+
+void * initHookCommandStart(void)
+{
+    timingToken *token = NULL;
+
+    /* read without the lock, so commands run as usual when not timing */
+    if (!timingEnabled)
+        return NULL;
+    initHookInit();
+    epicsMutexMustLock(listLock);
+    if (timingEnabled) {
+        token = (timingToken *) malloc(sizeof(timingToken));
+        if (token) {
+            timingDepth++;
+            token->memory = memoryUsed();
+            token->start = epicsMonotonicGet();
+        }
+    }
+    epicsMutexUnlock(listLock);
+    return token;
+}
+
+void initHookCommandDone(void *ptoken, int argc, char **argv)
+{
+    timingToken *token = (timingToken *) ptoken;
+    epicsUInt64 now = epicsMonotonicGet();
+    timingCommand *cmd;
+    size_t length = 1;
+    int i, report;
+
+    if (!token)
+        return;
+
+    epicsMutexMustLock(listLock);
+    /* profiling was switched off or restarted while this command ran */
+    if (!timingEnabled || timingDepth == 0)
+        goto done;
+    timingDepth--;
+
+    if (nTimingCommands == timingCommandsSize) {
+        size_t newSize = timingCommandsSize ? 2 * timingCommandsSize : 64;
+        timingCommand *newCommands = (timingCommand *)
+            realloc(timingCommands, newSize * sizeof(timingCommand));
+
+        if (!newCommands)
+            goto done;
+        timingCommands = newCommands;
+        timingCommandsSize = newSize;
+    }
+    cmd = &timingCommands[nTimingCommands];
+    for (i = 0; i < argc; i++)
+        length += strlen(argv[i]) + 1;
+    cmd->text = (char *) malloc(length);
+    if (!cmd->text)
+        goto done;
+    cmd->text[0] = '\0';
+    for (i = 0; i < argc; i++) {
+        if (i)
+            strcat(cmd->text, " ");
+        strcat(cmd->text, argv[i]);
+    }
+    cmd->depth = timingDepth;
+    cmd->seconds = (now - token->start) * 1e-9;
+    cmd->memory = memoryGrowth(token->memory, memoryUsed());
+    nTimingCommands++;
+
+done:
+    report = timingEnabled && timingReportDue && timingDepth == 0;
+    epicsMutexUnlock(listLock);
+    free(token);
+    if (report)
+        timingDone();
+}
+
+static int compareCommands(const void *a, const void *b)
+{
+    const timingCommand *ca = *(const timingCommand * const *) a;
+    const timingCommand *cb = *(const timingCommand * const *) b;
+
+    return (ca->seconds < cb->seconds) - (ca->seconds > cb->seconds);
+}
+
+static int comparePhases(const void *a, const void *b)
+{
+    const timingPhase *pa = &timingPhases[*(const int *) a];
+    const timingPhase *pb = &timingPhases[*(const int *) b];
+
+    return (pa->seconds < pb->seconds) - (pa->seconds > pb->seconds);
+}
+
+static void printMemory(long memory)
+{
+    if (memory == NO_MEMORY)
+        printf(" %10s", "n/a");
+    else
+        printf(" %10ld", memory / 1024);
+}
+
+static void genString(yajl_gen gen, const char *str)
+{
+    yajl_gen_string(gen, (const unsigned char *) str, strlen(str));
+}
+
+static void genMemory(yajl_gen gen, long memory)
+{
+    genString(gen, "memory");
+    if (memory == NO_MEMORY)
+        yajl_gen_null(gen);
+    else
+        yajl_gen_integer(gen, memory);
+}
+
+static int writeJson(const char *jsonFile, double total)
+{
+    yajl_gen gen = yajl_gen_alloc(NULL);
+    const unsigned char *buf;
+    size_t length, i;
+    FILE *fp;
+    int state, status = -1;
+
+    if (!gen)
+        return -1;
+    yajl_gen_config(gen, yajl_gen_beautify, 1);
+    yajl_gen_map_open(gen);
+    genString(gen, "seconds");
+    yajl_gen_double(gen, total);
+    genString(gen, "commands");
+    yajl_gen_array_open(gen);
+    for (i = 0; i < nTimingCommands; i++) {
+        timingCommand *cmd = &timingCommands[i];
+
+        yajl_gen_map_open(gen);
+        genString(gen, "command");
+        genString(gen, cmd->text);
+        genString(gen, "depth");
+        yajl_gen_integer(gen, cmd->depth);
+        genString(gen, "seconds");
+        yajl_gen_double(gen, cmd->seconds);
+        genMemory(gen, cmd->memory);
+        yajl_gen_map_close(gen);
+    }
+    yajl_gen_array_close(gen);
+    genString(gen, "phases");
+    yajl_gen_array_open(gen);
+    for (state = 0; state < NELEMENTS(timingPhases); state++) {
+        timingPhase *phase = &timingPhases[state];
+
+        if (!phase->reached)
+            continue;
+        yajl_gen_map_open(gen);
+        genString(gen, "state");
+        genString(gen, initHookName(state));
+        genString(gen, "seconds");
+        yajl_gen_double(gen, phase->seconds);
+        genMemory(gen, phase->memory);
+        yajl_gen_map_close(gen);
+    }
+    yajl_gen_array_close(gen);
+    yajl_gen_map_close(gen);
+
+    if (yajl_gen_get_buf(gen, &buf, &length) == yajl_gen_status_ok &&
+        (fp = fopen(jsonFile, "w")) != NULL) {
+        if (fwrite(buf, 1, length, fp) == length)
+            status = 0;
+        if (fclose(fp))
+            status = -1;
+    }
+    yajl_gen_free(gen);
+    return status;
+}
+
+void initHookTimingShow(const char *jsonFile)
+{
+    timingCommand **sorted;
+    int order[NELEMENTS(timingPhases)];
+    int nPhases = 0;
+    double total, commands = 0;
+    size_t i;
+    int state;
+
+    initHookInit();
+    epicsMutexMustLock(listLock);
+    if (!timingEnabled) {
+        epicsMutexUnlock(listLock);
+        printf("Startup timing is not enabled\n");
+        return;
+    }
+    total = (epicsMonotonicGet() - timingStart) * 1e-9;
+
+    sorted = (timingCommand **)
+        malloc((nTimingCommands + 1) * sizeof(timingCommand *));
+    if (sorted) {
+        for (i = 0; i < nTimingCommands; i++) {
+            sorted[i] = &timingCommands[i];
+            if (!timingCommands[i].depth)
+                commands += timingCommands[i].seconds;
+        }
+        qsort(sorted, nTimingCommands, sizeof(timingCommand *),
+            compareCommands);
+
+        printf("Startup commands, %.3f s of %.3f s since timing was "
+            "enabled\n", commands, total);
+        printf("%10s %10s  %s\n", "seconds", "memory kB", "command");
+        for (i = 0; i < nTimingCommands; i++) {
+            printf("%10.3f", sorted[i]->seconds);
+            printMemory(sorted[i]->memory);
+            printf("  %*s%s\n", 2 * sorted[i]->depth, "", sorted[i]->text);
+        }
+        free(sorted);
+    }
+
+    for (state = 0; state < NELEMENTS(timingPhases); state++)
+        if (timingPhases[state].reached)
+            order[nPhases++] = state;
+    if (nPhases) {
+        qsort(order, nPhases, sizeof(int), comparePhases);
+        printf("Intervals ending at each init hook state\n");
+        printf("%10s %10s  %s\n", "seconds", "memory kB", "state");
+        for (i = 0; i < (size_t) nPhases; i++) {
+            timingPhase *phase = &timingPhases[order[i]];
+
+            printf("%10.3f", phase->seconds);
+            printMemory(phase->memory);
+            printf("  %s\n", initHookName(order[i]));
+        }
+    }
+
+    if (jsonFile && *jsonFile) {
+        if (writeJson(jsonFile, total))
+            printf("Can't write startup timing to %s\n", jsonFile);
+        else
+            printf("Startup timing written to %s\n", jsonFile);
+    }
+    epicsMutexUnlock(listLock);
+}
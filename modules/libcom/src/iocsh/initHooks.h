@@ -61,6 +61,21 @@ epicsShareFunc void initHookAnnounce(initHookState state);
 epicsShareFunc const char *initHookName(int state);
 epicsShareFunc void initHookFree(void);
 
+/* Startup profiling.
+ * While enabled, iocsh times every command it runs and initHookAnnounce()
+ * records the time and resident memory growth since the previous state.
+ * When initHookAtEnd is announced, or when the iocsh command that announced
+ * it (usually iocInit) has finished, the commands and intervals are printed
+ * sorted by time, also written as JSON if jsonFile was given, and the
+ * profiling is switched off again. Memory is only known on Linux.
+ */
+epicsShareFunc void initHookTimingEnable(int enable, const char *jsonFile);
+epicsShareFunc void initHookTimingShow(const char *jsonFile);
+
+/* Used by iocsh around each command, Start returns NULL when disabled */
+epicsShareFunc void * initHookCommandStart(void);
+epicsShareFunc void initHookCommandDone(void *token, int argc, char **argv);
+
 #ifdef __cplusplus
 }
 #endif
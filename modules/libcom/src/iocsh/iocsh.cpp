@@ -29,6 +29,7 @@
 #include "registry.h"
 #include "epicsReadline.h"
 #include "cantProceed.h"
+#include "initHooks.h"
 #include "iocsh.h"
 
 extern "C" {
@@ -833,8 +834,11 @@ iocshBody (const char *pathname, const char *commandLine, const char *macros)
                 struct iocshFuncDef const *piocshFuncDef = found->def.pFuncDef;
                 for (int iarg = 0 ; ; ) {
                     if (iarg == piocshFuncDef->nargs) {
+                        void *timing = initHookCommandStart();
+
                         startRedirect(filename, lineno, redirects);
                         (*found->def.func)(argBuf);
+                        initHookCommandDone(timing, argc, argv);
                         break;
                     }
                     if (iarg >= argBufCapacity) {
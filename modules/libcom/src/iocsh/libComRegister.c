@@ -24,6 +24,7 @@
 #include "taskwd.h"
 #include "registry.h"
 #include "epicsGeneralTime.h"
+#include "initHooks.h"
 #include "libComRegister.h"
 
 
@@ -325,6 +326,36 @@ static void epicsMutexShowAllCallFunc(const iocshArgBuf *args)
     epicsMutexShowAll(args[0].ival,args[1].ival);
 }
 
+/* epicsMutexProfileEnable */
+static const iocshArg epicsMutexProfileEnableArg0 = { "enable",iocshArgInt};
+static const iocshArg * const epicsMutexProfileEnableArgs[1] =
+    {&epicsMutexProfileEnableArg0};
+static const iocshFuncDef epicsMutexProfileEnableFuncDef =
+    {"epicsMutexProfileEnable",1,epicsMutexProfileEnableArgs};
+static void epicsMutexProfileEnableCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileEnable(args[0].ival);
+}
+
+/* epicsMutexProfileReset */
+static const iocshFuncDef epicsMutexProfileResetFuncDef =
+    {"epicsMutexProfileReset",0,NULL};
+static void epicsMutexProfileResetCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileReset();
+}
+
+/* epicsMutexProfileShow */
+static const iocshArg epicsMutexProfileShowArg0 = { "count",iocshArgInt};
+static const iocshArg * const epicsMutexProfileShowArgs[1] =
+    {&epicsMutexProfileShowArg0};
+static const iocshFuncDef epicsMutexProfileShowFuncDef =
+    {"epicsMutexProfileShow",1,epicsMutexProfileShowArgs};
+static void epicsMutexProfileShowCallFunc(const iocshArgBuf *args)
+{
+    epicsMutexProfileShow(args[0].ival);
+}
+
 /* epicsThreadSleep */
 static const iocshArg epicsThreadSleepArg0 = { "seconds",iocshArgDouble};
 static const iocshArg * const epicsThreadSleepArgs[1] = {&epicsThreadSleepArg0};
@@ -393,6 +424,29 @@ static void installLastResortEventProviderCallFunc(const iocshArgBuf *args)
     installLastResortEventProvider();
 }
 
+/* initHookTimingEnable */
+static const iocshArg initHookTimingEnableArg0 = { "enable",iocshArgInt};
+static const iocshArg initHookTimingEnableArg1 = { "JSON file",iocshArgString};
+static const iocshArg * const initHookTimingEnableArgs[2] =
+    {&initHookTimingEnableArg0, &initHookTimingEnableArg1};
+static const iocshFuncDef initHookTimingEnableFuncDef =
+    {"initHookTimingEnable",2,initHookTimingEnableArgs};
+static void initHookTimingEnableCallFunc(const iocshArgBuf *args)
+{
+    initHookTimingEnable(args[0].ival, args[1].sval);
+}
+
+/* initHookTimingShow */
+static const iocshArg initHookTimingShowArg0 = { "JSON file",iocshArgString};
+static const iocshArg * const initHookTimingShowArgs[1] =
+    {&initHookTimingShowArg0};
+static const iocshFuncDef initHookTimingShowFuncDef =
+    {"initHookTimingShow",1,initHookTimingShowArgs};
+static void initHookTimingShowCallFunc(const iocshArgBuf *args)
+{
+    initHookTimingShow(args[0].sval);
+}
+
 void epicsShareAPI libComRegister(void)
 {
     iocshRegister(&dateFuncDef, dateCallFunc);
@@ -420,9 +474,15 @@ void epicsShareAPI libComRegister(void)
     iocshRegister(&threadFuncDef, threadCallFunc);
     iocshRegister(&taskwdShowFuncDef,taskwdShowCallFunc);
     iocshRegister(&epicsMutexShowAllFuncDef,epicsMutexShowAllCallFunc);
+    iocshRegister(&epicsMutexProfileEnableFuncDef,epicsMutexProfileEnableCallFunc);
+    iocshRegister(&epicsMutexProfileResetFuncDef,epicsMutexProfileResetCallFunc);
+    iocshRegister(&epicsMutexProfileShowFuncDef,epicsMutexProfileShowCallFunc);
     iocshRegister(&epicsThreadSleepFuncDef,epicsThreadSleepCallFunc);
     iocshRegister(&epicsThreadResumeFuncDef,epicsThreadResumeCallFunc);
     
     iocshRegister(&generalTimeReportFuncDef,generalTimeReportCallFunc);
     iocshRegister(&installLastResortEventProviderFuncDef, installLastResortEventProviderCallFunc);
+
+    iocshRegister(&initHookTimingEnableFuncDef,initHookTimingEnableCallFunc);
+    iocshRegister(&initHookTimingShowFuncDef,initHookTimingShowCallFunc);
 }
@@ -10,12 +10,13 @@
  * Implementation of core macro substitution library (macLib)
  *
  * The implementation is fairly unsophisticated and linked lists are
- * used to store macro values. Typically there will will be only a
- * small number of macros and performance won't be a problem. Special
- * measures are taken to avoid unnecessary expansion of macros whose
- * definitions reference other macros. Whenever a macro is created,
- * modified or deleted, a "dirty" flag is set; this causes a full
- * expansion of all macros the next time a macro value is read
+ * used to store macro values, with a hash index by name so that large
+ * substitution sets can be used efficiently. Special measures are taken
+ * to avoid unnecessary expansion of macros whose definitions reference
+ * other macros. Whenever a macro is created, modified or deleted, a
+ * "dirty" flag is set; this causes an expansion of the macros the next
+ * time a macro value is read. Only macros whose definitions reference
+ * other macros or which have changed are expanded again.
  *
  * Original Author: William Lupton, W. M. Keck Observatory
  */
@@ -29,6 +30,7 @@
 #include "dbDefs.h"
 #include "errlog.h"
 #include "dbmf.h"
+#include "epicsString.h"
 #include "macLib.h"
 
 
@@ -48,6 +50,10 @@ typedef struct mac_entry {
     int         visited;        /* ever been visited? */
     int         special;        /* special (internal) entry? */
     int         level;          /* scoping level */
+    int         hasRefs;        /* raw value contains macro references? */
+    int         stale;          /* raw value changed since expanded? */
+    unsigned    hash;           /* hash of name */
+    struct mac_entry *hashNext; /* next entry in hash chain */
 } MAC_ENTRY;
 
 
@@ -57,10 +63,9 @@ typedef struct mac_entry {
  * These static functions peform low-level operations on macro entries
  */
 static MAC_ENTRY *first   ( MAC_HANDLE *handle );
-static MAC_ENTRY *last    ( MAC_HANDLE *handle );
 static MAC_ENTRY *next    ( MAC_ENTRY  *entry );
-static MAC_ENTRY *previous( MAC_ENTRY  *entry );
 
+static void       hashAdd( MAC_HANDLE *handle, MAC_ENTRY *entry );
 static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special );
 static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special );
 static char      *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value );
@@ -89,6 +94,12 @@ static char *Strdup( const char *string );
 #define FLAG_SUPPRESS_WARNINGS  0x1
 #define FLAG_USE_ENVIRONMENT    0x80
 
+/*
+ * Initial number of hash chains; the index doubles in size whenever there
+ * are more than two entries per chain
+ */
+#define MAC_HASH_SIZE 16
+
 
 /*** Library routines ***/
 
@@ -126,6 +137,9 @@ epicsShareAPI macCreateHandle(
     handle->debug = 0;
     handle->flags = 0;
     ellInit( &handle->list );
+    handle->hash = NULL;
+    handle->hashSize = 0;
+    handle->nEntries = 0;
 
     /* use environment variables if so specified */
     if (pairs && pairs[0] && !strcmp(pairs[0],"") && pairs[1] && !strcmp(pairs[1],"environ") && !pairs[3]) {
@@ -135,7 +149,7 @@ epicsShareAPI macCreateHandle(
         /* if supplied, load macro definitions */
         for ( ; pairs && pairs[0]; pairs += 2 ) {
             if ( macPutValue( handle, pairs[0], pairs[1] ) < 0 ) {
-                dbmfFree( handle );
+                macDeleteHandle( handle );
                 return -1;
             }
         }
@@ -381,6 +395,7 @@ epicsShareAPI macDeleteHandle(
 
     /* clear magic field and free context structure */
     handle->magic = 0;
+    free( handle->hash );
     dbmfFree( handle );
 
     return 0;
@@ -513,14 +528,6 @@ static MAC_ENTRY *first( MAC_HANDLE *handle )
     return ( MAC_ENTRY * ) ellFirst( &handle->list );
 }
 
-/*
- * Return pointer to last macro entry (could be preprocessor macro)
- */
-static MAC_ENTRY *last( MAC_HANDLE *handle )
-{
-    return ( MAC_ENTRY * ) ellLast( &handle->list );
-}
-
 /*
  * Return pointer to next macro entry (could be preprocessor macro)
  */
@@ -530,11 +537,35 @@ static MAC_ENTRY *next( MAC_ENTRY *entry )
 }
 
 /*
- * Return pointer to previous macro entry (could be preprocessor macro)
+ * Add an entry to the front of its hash chain, growing the index if it
+ * has become too full. The chains are kept in the reverse order of the
+ * list so the most recently created entry with a name is found first
  */
-static MAC_ENTRY *previous( MAC_ENTRY *entry )
+static void hashAdd( MAC_HANDLE *handle, MAC_ENTRY *entry )
 {
-    return ( MAC_ENTRY * ) ellPrevious( ( ELLNODE * ) entry );
+    if ( handle->nEntries > 2 * handle->hashSize ) {
+        unsigned size = handle->hashSize ? 2 * handle->hashSize : MAC_HASH_SIZE;
+        MAC_ENTRY **hash = calloc( size, sizeof( MAC_ENTRY * ) );
+
+        /* if that fails the existing chains just get longer */
+        if ( hash != NULL ) {
+            MAC_ENTRY *e;
+
+            free( handle->hash );
+            handle->hash = hash;
+            handle->hashSize = size;
+
+            /* this includes the new entry, which is already in the list */
+            for ( e = first( handle ); e != NULL; e = next( e ) ) {
+                e->hashNext = hash[e->hash & ( size - 1 )];
+                hash[e->hash & ( size - 1 )] = e;
+            }
+            return;
+        }
+    }
+
+    entry->hashNext = handle->hash[entry->hash & ( handle->hashSize - 1 )];
+    handle->hash[entry->hash & ( handle->hashSize - 1 )] = entry;
 }
 
 /*
@@ -543,8 +574,16 @@ static MAC_ENTRY *previous( MAC_ENTRY *entry )
 static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
 {
     ELLLIST   *list  = &handle->list;
-    MAC_ENTRY *entry = ( MAC_ENTRY * ) dbmfMalloc( sizeof( MAC_ENTRY ) );
+    MAC_ENTRY *entry;
+
+    if ( handle->hash == NULL ) {
+        handle->hash = calloc( MAC_HASH_SIZE, sizeof( MAC_ENTRY * ) );
+        if ( handle->hash == NULL )
+            return NULL;
+        handle->hashSize = MAC_HASH_SIZE;
+    }
 
+    entry = ( MAC_ENTRY * ) dbmfMalloc( sizeof( MAC_ENTRY ) );
     if ( entry != NULL ) {
         entry->name   = Strdup( name );
         if ( entry->name == NULL ) {
@@ -560,8 +599,13 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
             entry->visited = FALSE;
             entry->special = special;
             entry->level   = handle->level;
+            entry->hasRefs = FALSE;
+            entry->stale   = TRUE;
+            entry->hash    = epicsStrHash( name, 0 );
 
             ellAdd( list, ( ELLNODE * ) entry );
+            handle->nEntries++;
+            hashAdd( handle, entry );
         }
     }
 
@@ -573,18 +617,23 @@ static MAC_ENTRY *create( MAC_HANDLE *handle, const char *name, int special )
  */
 static MAC_ENTRY *lookup( MAC_HANDLE *handle, const char *name, int special )
 {
-    MAC_ENTRY *entry;
+    MAC_ENTRY *entry = NULL;
 
     if ( handle->debug & 2 )
         printf( "lookup-> level = %d, name = %s, special = %d\n",
                 handle->level, name, special );
 
-    /* search backwards so scoping works */
-    for ( entry = last( handle ); entry != NULL; entry = previous( entry ) ) {
-        if ( entry->special != special )
-            continue;
-        if ( strcmp( name, entry->name ) == 0 )
-            break;
+    /* chains hold the newest entries first so scoping works */
+    if ( handle->hash != NULL ) {
+        unsigned hash = epicsStrHash( name, 0 );
+
+        for ( entry = handle->hash[hash & ( handle->hashSize - 1 )];
+              entry != NULL; entry = entry->hashNext ) {
+            if ( entry->special != special || entry->hash != hash )
+                continue;
+            if ( strcmp( name, entry->name ) == 0 )
+                break;
+        }
     }
     if ( (special == FALSE) && (entry == NULL) &&
          (handle->flags & FLAG_USE_ENVIRONMENT) ) {
@@ -615,6 +664,9 @@ static char *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value )
         dbmfFree( entry->rawval );
     entry->rawval = Strdup( value );
 
+    /* values without references only need expanding again if changed */
+    entry->hasRefs = value && ( strstr( value, "$(" ) || strstr( value, "${" ) );
+    entry->stale = TRUE;
     handle->dirty = TRUE;
 
     return entry->rawval;
@@ -627,8 +679,14 @@ static char *rawval( MAC_HANDLE *handle, MAC_ENTRY *entry, const char *value )
 static void delete( MAC_HANDLE *handle, MAC_ENTRY *entry )
 {
     ELLLIST *list = &handle->list;
+    MAC_ENTRY **pprev = &handle->hash[entry->hash & ( handle->hashSize - 1 )];
+
+    while ( *pprev != entry )
+        pprev = &( *pprev )->hashNext;
+    *pprev = entry->hashNext;
 
     ellDelete( list, ( ELLNODE * ) entry );
+    handle->nEntries--;
 
     dbmfFree( entry->name );
     if ( entry->rawval != NULL )
@@ -641,7 +699,8 @@ static void delete( MAC_HANDLE *handle, MAC_ENTRY *entry )
 }
 
 /*
- * Expand macro definitions (expensive but done very infrequently)
+ * Expand macro definitions (expensive but done very infrequently); a value
+ * without macro references can only change when its raw value does
  */
 static long expand( MAC_HANDLE *handle )
 {
@@ -654,6 +713,9 @@ static long expand( MAC_HANDLE *handle )
 
     for ( entry = first( handle ); entry != NULL; entry = next( entry ) ) {
 
+        if ( !entry->stale && !entry->hasRefs )
+            continue;
+
         if ( handle->debug & 2 )
             printf( "\nexpand %s = %s\n", entry->name,
                 entry->rawval ? entry->rawval : "" );
@@ -673,6 +735,7 @@ static long expand( MAC_HANDLE *handle )
         trans( handle, entry, 1, "", &rawval, &value, entry->value + MAC_SIZE );
         entry->length = value - entry->value;
         entry->value[MAC_SIZE] = '\0';
+        entry->stale = FALSE;
     }
 
     handle->dirty = FALSE;
@@ -41,6 +41,9 @@ typedef struct {
     int         debug;          /* debugging level */
     ELLLIST     list;           /* macro name / value list */
     int         flags;          /* operating mode flags */
+    struct mac_entry **hash;    /* index of list entries by name */
+    unsigned    hashSize;       /* number of hash chains, a power of 2 */
+    unsigned    nEntries;       /* number of entries in list */
 } MAC_HANDLE;
 
 /*
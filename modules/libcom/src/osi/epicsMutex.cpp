@@ -16,6 +16,8 @@
  * it slows down the system at run time, anfd because its not 
  * currently safe to convert a thread id to a thread name because
  * the thread may have exited making the thread id invalid.
+ * 2) The profiling statistics are only modified by the thread which
+ * owns the mutex, so they need no additional locking.
  */
 
 #include <new>
@@ -33,6 +35,7 @@
 #include "errlog.h"
 #include "epicsMutex.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 
 static epicsThreadOnceId epicsMutexOsiOnce = EPICS_THREAD_ONCE_INIT;
 static ELLLIST mutexList;
@@ -46,9 +49,13 @@ struct epicsMutexParm {
 #   endif
     const char *pFileName;
     int lineno;
+    epicsMutexProfileStats prof;
+    epicsUInt64 lockedAt;
+    unsigned profDepth;
 };
 
 static epicsMutexOSD * epicsMutexGlobalLock;
+static volatile int epicsMutexProfiling;
 
 
 // vxWorks 5.4 gcc fails during compile when I use std::exception
@@ -112,6 +119,9 @@ epicsMutexId epicsShareAPI epicsMutexOsiCreate(
 #   endif
     pmutexNode->pFileName = pFileName;
     pmutexNode->lineno = lineno;
+    memset(&pmutexNode->prof, 0, sizeof(pmutexNode->prof));
+    pmutexNode->lockedAt = 0;
+    pmutexNode->profDepth = 0;
     ellAdd(&mutexList,&pmutexNode->node);
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
     return(pmutexNode);
@@ -138,15 +148,65 @@ void epicsShareAPI epicsMutexDestroy(epicsMutexId pmutexNode)
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
 }
 
+// called by the owner after it has acquired the mutex
+static void profileLocked(epicsMutexId pmutexNode, epicsUInt64 now)
+{
+    if ( pmutexNode->profDepth++ == 0u ) {
+        pmutexNode->lockedAt = now;
+        pmutexNode->prof.nLock++;
+    }
+}
+
+// called by the owner before it releases the mutex
+static void profileUnlock(epicsMutexId pmutexNode)
+{
+    if ( --pmutexNode->profDepth == 0u ) {
+        epicsUInt64 held = epicsMonotonicGet() - pmutexNode->lockedAt;
+        pmutexNode->prof.holdNs += held;
+        if ( held > pmutexNode->prof.maxHoldNs ) {
+            pmutexNode->prof.maxHoldNs = held;
+        }
+    }
+}
+
 void epicsShareAPI epicsMutexUnlock(epicsMutexId pmutexNode)
 {
+    // also completes a hold which started while profiling was enabled
+    if ( pmutexNode->profDepth ) {
+        profileUnlock(pmutexNode);
+    }
     epicsMutexOsdUnlock(pmutexNode->id);
 }
 
+static epicsMutexLockStatus profileLock(epicsMutexId pmutexNode)
+{
+    epicsMutexLockStatus status =
+        epicsMutexOsdTryLock(pmutexNode->id);
+    if ( status == epicsMutexLockOK ) {
+        profileLocked(pmutexNode, epicsMonotonicGet());
+    }
+    else if ( status == epicsMutexLockTimeout ) {
+        epicsUInt64 start = epicsMonotonicGet();
+        status = epicsMutexOsdLock(pmutexNode->id);
+        if ( status == epicsMutexLockOK ) {
+            epicsUInt64 now = epicsMonotonicGet();
+            epicsUInt64 wait = now - start;
+            profileLocked(pmutexNode, now);
+            pmutexNode->prof.nContended++;
+            pmutexNode->prof.waitNs += wait;
+            if ( wait > pmutexNode->prof.maxWaitNs ) {
+                pmutexNode->prof.maxWaitNs = wait;
+            }
+        }
+    }
+    return status;
+}
+
 epicsMutexLockStatus epicsShareAPI epicsMutexLock(
     epicsMutexId pmutexNode)
 {
-    epicsMutexLockStatus status = 
+    epicsMutexLockStatus status = epicsMutexProfiling ?
+        profileLock(pmutexNode) :
         epicsMutexOsdLock(pmutexNode->id);
 #   ifdef LOG_LAST_OWNER
         if ( status == epicsMutexLockOK ) {
@@ -161,6 +221,9 @@ epicsMutexLockStatus epicsShareAPI epicsMutexTryLock(
 {
     epicsMutexLockStatus status = 
         epicsMutexOsdTryLock(pmutexNode->id);
+    if ( epicsMutexProfiling && status == epicsMutexLockOK ) {
+        profileLocked(pmutexNode, epicsMonotonicGet());
+    }
 #   ifdef LOG_LAST_OWNER
         if ( status == epicsMutexLockOK ) {
             pmutexNode->lastOwner = epicsThreadGetIdSelf();
@@ -247,6 +310,147 @@ void epicsShareAPI epicsMutexShowAll(int onlyLocked,unsigned  int level)
     epicsMutexOsdUnlock(epicsMutexGlobalLock);
 }
 
+void epicsShareAPI epicsMutexProfileEnable(int enable)
+{
+    epicsMutexProfiling = enable;
+}
+
+void epicsShareAPI epicsMutexProfileReset(void)
+{
+    epicsMutexParm *pmutexNode;
+
+    if (epicsMutexOsiOnce == EPICS_THREAD_ONCE_INIT)
+        return;
+
+    epicsMutexLockStatus lockStat =
+        epicsMutexOsdLock(epicsMutexGlobalLock);
+    assert ( lockStat == epicsMutexLockOK );
+    pmutexNode = reinterpret_cast < epicsMutexParm * > ( ellFirst(&mutexList) );
+    while(pmutexNode) {
+        // racy with respect to the owner, but these are only statistics
+        memset(&pmutexNode->prof, 0, sizeof(pmutexNode->prof));
+        pmutexNode =
+            reinterpret_cast < epicsMutexParm * > ( ellNext(&pmutexNode->node) );
+    }
+    epicsMutexOsdUnlock(epicsMutexGlobalLock);
+}
+
+void epicsShareAPI epicsMutexProfileGet(
+    epicsMutexId pmutexNode, epicsMutexProfileStats *pStats)
+{
+    *pStats = pmutexNode->prof;
+}
+
+namespace {
+struct profileSite {
+    const char *pFileName;
+    int lineno;
+    unsigned nMutex;
+    epicsMutexProfileStats prof;
+};
+}
+
+extern "C" {
+static int profileSiteCmp(const void *pA, const void *pB)
+{
+    const profileSite *a = static_cast < const profileSite * > ( pA );
+    const profileSite *b = static_cast < const profileSite * > ( pB );
+    int cmp = strcmp(a->pFileName, b->pFileName);
+    if (cmp)
+        return cmp;
+    return a->lineno - b->lineno;
+}
+
+static int profileWaitCmp(const void *pA, const void *pB)
+{
+    const profileSite *a = static_cast < const profileSite * > ( pA );
+    const profileSite *b = static_cast < const profileSite * > ( pB );
+    if (a->prof.waitNs != b->prof.waitNs)
+        return a->prof.waitNs < b->prof.waitNs ? 1 : -1;
+    if (a->prof.nContended != b->prof.nContended)
+        return a->prof.nContended < b->prof.nContended ? 1 : -1;
+    return a->prof.nLock < b->prof.nLock ? 1 :
+        a->prof.nLock > b->prof.nLock ? -1 : 0;
+}
+}
+
+void epicsShareAPI epicsMutexProfileShow(unsigned count)
+{
+    epicsMutexParm *pmutexNode;
+    profileSite *pSites;
+    unsigned nSites = 0u, i, j;
+
+    if (epicsMutexOsiOnce == EPICS_THREAD_ONCE_INIT)
+        return;
+
+    epicsMutexLockStatus lockStat =
+        epicsMutexOsdLock(epicsMutexGlobalLock);
+    assert ( lockStat == epicsMutexLockOK );
+    pSites = static_cast < profileSite * >
+        ( calloc(ellCount(&mutexList) + 1, sizeof(profileSite)) );
+    if (!pSites) {
+        epicsMutexOsdUnlock(epicsMutexGlobalLock);
+        printf("epicsMutexProfileShow: out of memory\n");
+        return;
+    }
+    pmutexNode = reinterpret_cast < epicsMutexParm * > ( ellFirst(&mutexList) );
+    while(pmutexNode) {
+        profileSite *pSite = &pSites[nSites++];
+        pSite->pFileName = pmutexNode->pFileName ?
+            pmutexNode->pFileName : "<unknown>";
+        pSite->lineno = pmutexNode->lineno;
+        pSite->nMutex = 1u;
+        pSite->prof = pmutexNode->prof;
+        pmutexNode =
+            reinterpret_cast < epicsMutexParm * > ( ellNext(&pmutexNode->node) );
+    }
+    epicsMutexOsdUnlock(epicsMutexGlobalLock);
+
+    // merge the mutexes created at the same source location
+    qsort(pSites, nSites, sizeof(profileSite), profileSiteCmp);
+    for (i = 0u, j = 0u; i < nSites; i++) {
+        if (j > 0u && profileSiteCmp(&pSites[j-1], &pSites[i]) == 0) {
+            epicsMutexProfileStats *pTo = &pSites[j-1].prof;
+            const epicsMutexProfileStats *pFrom = &pSites[i].prof;
+            pSites[j-1].nMutex++;
+            pTo->nLock += pFrom->nLock;
+            pTo->nContended += pFrom->nContended;
+            pTo->waitNs += pFrom->waitNs;
+            pTo->holdNs += pFrom->holdNs;
+            if (pFrom->maxWaitNs > pTo->maxWaitNs)
+                pTo->maxWaitNs = pFrom->maxWaitNs;
+            if (pFrom->maxHoldNs > pTo->maxHoldNs)
+                pTo->maxHoldNs = pFrom->maxHoldNs;
+        }
+        else {
+            pSites[j++] = pSites[i];
+        }
+    }
+    nSites = j;
+    qsort(pSites, nSites, sizeof(profileSite), profileWaitCmp);
+
+    // sites which were never locked sort last
+    while (nSites > 0u && pSites[nSites-1].prof.nLock == 0u)
+        nSites--;
+    if (count == 0u || count > nSites)
+        count = nSites;
+    printf("Mutex contention profiling is %s, times in milliseconds\n",
+        epicsMutexProfiling ? "enabled" : "disabled");
+    printf("%10s %10s %6s %12s %10s %12s %10s  %s\n",
+        "locks", "contended", "%", "wait", "max wait",
+        "held", "max held", "source (mutexes)");
+    for (i = 0u; i < count; i++) {
+        const epicsMutexProfileStats *p = &pSites[i].prof;
+        printf("%10lu %10lu %6.2f %12.3f %10.3f %12.3f %10.3f  %s:%d (%u)\n",
+            (unsigned long) p->nLock, (unsigned long) p->nContended,
+            100.0 * p->nContended / p->nLock,
+            p->waitNs * 1e-6, p->maxWaitNs * 1e-6,
+            p->holdNs * 1e-6, p->maxHoldNs * 1e-6,
+            pSites[i].pFileName, pSites[i].lineno, pSites[i].nMutex);
+    }
+    free(pSites);
+}
+
 epicsMutex :: epicsMutex () :
     id ( epicsMutexCreate () )
 {
@@ -10,7 +10,10 @@
 #ifndef epicsMutexh
 #define epicsMutexh
 
+#include <stddef.h>
+
 #include "epicsAssert.h"
+#include "epicsTypes.h"
 
 #include "shareLib.h"
 
@@ -91,6 +94,31 @@ epicsShareFunc void epicsShareAPI epicsMutexShow(
 epicsShareFunc void epicsShareAPI epicsMutexShowAll(
     int onlyLocked,unsigned  int level);
 
+/* Lock contention profiling.
+ * While enabled, every lock of an epicsMutex first tries the lock and
+ * only when that fails measures how long it waits. The time each mutex
+ * is held is also measured, from the outermost lock to its unlock.
+ * Statistics are kept per mutex and are discarded when it is destroyed.
+ */
+typedef struct epicsMutexProfileStats {
+    size_t nLock;           /* acquisitions, excluding recursive locks */
+    size_t nContended;      /* acquisitions which had to wait */
+    epicsUInt64 waitNs;     /* total time spent waiting */
+    epicsUInt64 maxWaitNs;
+    epicsUInt64 holdNs;     /* total time held */
+    epicsUInt64 maxHoldNs;
+} epicsMutexProfileStats;
+
+epicsShareFunc void epicsShareAPI epicsMutexProfileEnable(int enable);
+epicsShareFunc void epicsShareAPI epicsMutexProfileReset(void);
+epicsShareFunc void epicsShareAPI epicsMutexProfileGet(
+    epicsMutexId id, epicsMutexProfileStats *pStats);
+/* Print the top creation sites (all when count is 0) sorted by total
+ * wait time, with the statistics of all mutexes created at the same
+ * source file and line summed.
+ */
+epicsShareFunc void epicsShareAPI epicsMutexProfileShow(unsigned count);
+
 /*NOTES:
     epicsMutex MUST implement recursive locking
     epicsMutex should implement priority inheritance and deletion safe
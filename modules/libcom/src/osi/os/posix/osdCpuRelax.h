@@ -0,0 +1,23 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Hint to the CPU that the caller is busy-waiting, used by the
+ * spinning lock implementations in osdSpin.c and osdMutex.c
+ */
+
+#ifndef INC_osdCpuRelax_H
+#define INC_osdCpuRelax_H
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  define osdCpuRelax() __asm__ __volatile__ ("pause" ::: "memory")
+#elif defined(__GNUC__) && defined(__aarch64__)
+#  define osdCpuRelax() __asm__ __volatile__ ("yield" ::: "memory")
+#else
+#  define osdCpuRelax() do {} while (0)
+#endif
+
+#endif /* INC_osdCpuRelax_H */
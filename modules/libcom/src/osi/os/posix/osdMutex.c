@@ -17,15 +17,19 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <pthread.h>
 
 #define epicsExportSharedSymbols
 #include "epicsMutex.h"
 #include "cantProceed.h"
+#include "envDefs.h"
+#include "epicsThread.h"
 #include "epicsTime.h"
 #include "errlog.h"
 #include "epicsAssert.h"
+#include "osdCpuRelax.h"
 
 #define checkStatus(status,message) \
     if((status)) { \
@@ -68,10 +72,30 @@ typedef struct epicsMutexOSD {
     pthread_mutexattr_t mutexAttr;
 } epicsMutexOSD;
 
+/* Adaptive locking: a contended lock is retried up to EPICS_MUTEX_SPIN_COUNT
+ * times before the thread blocks, which avoids the cost of sleeping and
+ * waking when the owner will release it within a few microseconds. This
+ * is pointless on a uniprocessor, where the owner can't run while we spin.
+ */
+static pthread_once_t spinCountOnce = PTHREAD_ONCE_INIT;
+static int mutexSpinCount;
+
+static void spinCountInit(void)
+{
+    const char *val = envGetConfigParamPtr(&EPICS_MUTEX_SPIN_COUNT);
+    long count = val ? strtol(val, NULL, 10) : 0;
+
+    if (count < 0 || epicsThreadGetCPUs() < 2)
+        count = 0;
+    mutexSpinCount = count > INT_MAX ? INT_MAX : (int) count;
+}
+
 epicsMutexOSD * epicsMutexOsdCreate(void) {
     epicsMutexOSD *pmutex;
     int status;
 
+    pthread_once(&spinCountOnce, spinCountInit);
+
     pmutex = calloc(1, sizeof(*pmutex));
     if(!pmutex)
         goto fail;
@@ -127,6 +151,16 @@ epicsMutexLockStatus epicsMutexOsdLock(struct epicsMutexOSD * pmutex)
 {
     int status;
 
+    if (mutexSpinCount) {
+        int tries = mutexSpinCount;
+
+        while ((status = pthread_mutex_trylock(&pmutex->lock)) == EBUSY &&
+               --tries > 0)
+            osdCpuRelax();
+        if (status == 0)
+            return epicsMutexLockOK;
+    }
+
     status = mutexLock(&pmutex->lock);
     if (status == EINVAL) return epicsMutexLockError;
     if(status) {
@@ -15,11 +15,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 #define epicsExportSharedSymbols
 #include "errlog.h"
 #include "cantProceed.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsString.h"
 #include "epicsSpin.h"
+#include "osdCpuRelax.h"
 
 /* POSIX spinlocks may be subject to priority inversion
  * and so can't be guaranteed safe in situations where
@@ -107,19 +113,71 @@ void epicsSpinUnlock(epicsSpinId spin) {
 
 /*
  *  POSIX MUTEX IMPLEMENTATION
+ *
+ * If EPICS_SPIN_BUSY_WAIT is YES a test-and-test-and-set busy-wait lock
+ * is used instead of the mutex. Waiters back off, first with the CPU's
+ * spin-wait hint, then by yielding and finally by sleeping so that a
+ * lower priority owner on the same CPU can run and release the lock.
  */
 
+#define SPIN_RELAX_LIMIT 64
+#define SPIN_YIELD_LIMIT 128
+
 typedef struct epicsSpin {
     pthread_mutex_t lock;
+    int busyWait;
+    int locked;
 } epicsSpin;
 
+static pthread_once_t busyWaitOnce = PTHREAD_ONCE_INIT;
+static int busyWaitDefault;
+
+static void busyWaitInit(void)
+{
+    const char *val = envGetConfigParamPtr(&EPICS_SPIN_BUSY_WAIT);
+
+    busyWaitDefault = val && epicsStrCaseCmp(val, "YES") == 0;
+}
+
+static void busyWaitBackoff(unsigned *pTries)
+{
+    unsigned tries = ++*pTries;
+
+    if (tries < SPIN_RELAX_LIMIT) {
+        unsigned n = 1u << (tries < 6 ? tries : 6);
+        while (n--)
+            osdCpuRelax();
+    }
+    else if (tries < SPIN_YIELD_LIMIT) {
+        sched_yield();
+    }
+    else {
+        struct timespec delay = {0, 50000};
+        nanosleep(&delay, NULL);
+    }
+}
+
+static void busyWaitLock(epicsSpin *spin)
+{
+    unsigned tries = 0;
+
+    while (epicsAtomicCmpAndSwapIntT(&spin->locked, 0, 1) != 0) {
+        /* only retry the atomic operation when it might succeed */
+        while (epicsAtomicGetIntT(&spin->locked))
+            busyWaitBackoff(&tries);
+    }
+}
+
 epicsSpinId epicsSpinCreate(void) {
     epicsSpin *spin;
     int status;
 
+    pthread_once(&busyWaitOnce, busyWaitInit);
+
     spin = calloc(1, sizeof(*spin));
     if (!spin)
         goto fail;
+    spin->busyWait = busyWaitDefault;
 
     status = pthread_mutex_init(&spin->lock, NULL);
     checkStatus(status, "pthread_mutex_init");
@@ -145,6 +203,10 @@ void epicsSpinDestroy(epicsSpinId spin) {
 void epicsSpinLock(epicsSpinId spin) {
     int status;
 
+    if (spin->busyWait) {
+        busyWaitLock(spin);
+        return;
+    }
     status = pthread_mutex_lock(&spin->lock);
     checkStatus(status, "pthread_mutex_lock");
     if (status)
@@ -154,6 +216,8 @@ void epicsSpinLock(epicsSpinId spin) {
 int epicsSpinTryLock(epicsSpinId spin) {
     int status;
 
+    if (spin->busyWait)
+        return epicsAtomicCmpAndSwapIntT(&spin->locked, 0, 1) != 0;
     status = pthread_mutex_trylock(&spin->lock);
     if (status == EBUSY)
         return 1;
@@ -164,6 +228,11 @@ int epicsSpinTryLock(epicsSpinId spin) {
 void epicsSpinUnlock(epicsSpinId spin) {
     int status;
 
+    if (spin->busyWait) {
+        /* full barrier, the critical section must complete first */
+        epicsAtomicCmpAndSwapIntT(&spin->locked, 1, 0);
+        return;
+    }
     status = pthread_mutex_unlock(&spin->lock);
     checkStatus(status, "pthread_mutex_unlock");
 }
@@ -0,0 +1,319 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsMath.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "postfix.h"
+#include "testMain.h"
+
+#define NELEM 16
+
+static double ramp[NELEM];              /* 1, 2, 3 ... */
+static double wave[NELEM];              /* 0, 1, 0, -1 ... */
+static double scalars[CALCPERFORM_NARGS] = {
+    1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+};
+
+static calcArrayWork *work;
+
+/* A is ramp, B is wave, C is ramp cut to nc, the rest are scalars */
+static void setArgs(calcArrayArg *parg, unsigned long nc)
+{
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        parg[i].pvalue = &scalars[i];
+        parg[i].count = 1;
+    }
+    parg[0].pvalue = ramp;
+    parg[0].count = NELEM;
+    parg[1].pvalue = wave;
+    parg[1].count = NELEM;
+    parg[2].pvalue = ramp;
+    parg[2].count = nc;
+}
+
+static long execute(const char *expr, calcArrayArg *parg,
+    calcArrayArg *presult, unsigned long maxcount)
+{
+    char rpn[MAX_POSTFIX_SIZE];
+    calcProgram *prog;
+    short err;
+    long status;
+
+    if (postfix(expr, rpn, &err)) {
+        testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+        return -2;
+    }
+    prog = calcCompile(rpn);
+    if (!prog) {
+        testDiag("calcCompile: failed for '%s'", expr);
+        return -2;
+    }
+    status = calcArrayExecute(work, parg, presult, maxcount, prog);
+    calcProgramFree(prog);
+    return status;
+}
+
+/* With only scalar inputs the result must match calcPerform() */
+static void testScalar(const char *expr)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    char rpn[MAX_POSTFIX_SIZE];
+    double expect = 0.0, value = 0.0;
+    short err;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        args[i].pvalue = &scalars[i];
+        args[i].count = 1;
+    }
+    result.pvalue = &value;
+    result.count = 1;
+    if (postfix(expr, rpn, &err) || calcPerform(scalars, &expect, rpn)) {
+        testFail("%s: calcPerform failed", expr);
+        return;
+    }
+    if (execute(expr, args, &result, 1) || result.count != 1) {
+        testFail("%s: calcArrayExecute failed", expr);
+        return;
+    }
+    testOk(value == expect || (isnan(value) && isnan(expect)),
+        "%s = %g (calcPerform %g)", expr, value, expect);
+}
+
+typedef double (*elementFunc)(int i);
+
+/* Array inputs, the result must have count elements given by fn */
+static void testArray(const char *expr, unsigned long nc,
+    unsigned long count, elementFunc fn)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    double value[NELEM];
+    unsigned long i;
+    int ok;
+
+    setArgs(args, nc);
+    result.pvalue = value;
+    result.count = 0;
+    if (execute(expr, args, &result, NELEM)) {
+        testFail("%s: calcArrayExecute failed", expr);
+        return;
+    }
+    ok = result.count == count;
+    for (i = 0; ok && i < count; i++) {
+        double expect = fn(i);
+
+        if (value[i] != expect && !(isnan(value[i]) && isnan(expect))) {
+            testDiag("%s: element %lu is %g, expected %g", expr, i,
+                value[i], expect);
+            ok = 0;
+        }
+    }
+    testOk(ok, "%s, %lu elements (count %lu)", expr, count, result.count);
+}
+
+static double fnScaled(int i)   { return ramp[i] * 2 + 1; }
+static double fnSum(int i)      { return ramp[i] + wave[i]; }
+static double fnShort(int i)    { return ramp[i] * ramp[i]; }
+static double fnLiteral(int i)  { return 10 - ramp[i]; }
+static double fnAbs(int i)      { return fabs(wave[i]) + sin(ramp[i]); }
+static double fnMax(int i)      { return ramp[i] > 8 ? ramp[i] : 8; }
+static double fnMaxWave(int i)  { return wave[i] > 0 ? wave[i] : 0; }
+static double fnCond(int i)     { return ramp[i] > 4 ? ramp[i] : -ramp[i]; }
+static double fnScalarCond(int i) { return ramp[i] + 3; }
+static double fnNested(int i)
+{
+    return ramp[i] < 3 ? 0 : ramp[i] < 6 ? wave[i] : ramp[i] * 10;
+}
+static double fnStore(int i)    { return ramp[i] * ramp[i] + 1; }
+static double fnNorm(int i)
+{
+    return ramp[i] / (NELEM * (NELEM + 1) / 2);
+}
+
+static void testReduce(const char *expr, unsigned long nc, double expect)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    double value[NELEM];
+
+    setArgs(args, nc);
+    result.pvalue = value;
+    result.count = 0;
+    if (execute(expr, args, &result, NELEM)) {
+        testFail("%s: calcArrayExecute failed", expr);
+        return;
+    }
+    testOk(result.count == 1 &&
+        (value[0] == expect || (isnan(value[0]) && isnan(expect))),
+        "%s = %g (expected %g)", expr, value[0], expect);
+}
+
+static void testStore(void)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    double value[NELEM];
+
+    setArgs(args, NELEM);
+    result.pvalue = value;
+    result.count = 0;
+    testOk(execute("D:=A>2?1:0;D", args, &result, NELEM) == 0 &&
+        result.count == NELEM && value[1] == 0 && value[2] == 1,
+        "Assign an array conditional");
+    testOk(execute("A:=A*2;A", args, &result, NELEM) == 0 &&
+        value[1] == 4 && ramp[1] == 2, "Assignment leaves the input alone");
+}
+
+static void testLimits(void)
+{
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    double value[NELEM];
+    int i, ok = 1;
+
+    setArgs(args, NELEM);
+    result.pvalue = value;
+    result.count = 0;
+    testOk(execute("A", args, &result, 5) == 0 && result.count == 5,
+        "Result cut to maxcount (count %lu)", result.count);
+
+    /* VAL is the previous result */
+    for (i = 0; i < 5; i++)
+        value[i] = i;
+    testOk(execute("VAL+A", args, &result, NELEM) == 0 &&
+        result.count == 5, "VAL+A has VAL's 5 elements");
+    for (i = 0; i < 5; i++)
+        ok &= value[i] == i + ramp[i];
+    testOk(ok, "VAL+A values");
+}
+
+static void benchArray(void)
+{
+    enum {count = 10000, passes = 200};
+    double *a = malloc(count * sizeof(double));
+    double *out = malloc(count * sizeof(double));
+    calcArrayArg args[CALCPERFORM_NARGS];
+    calcArrayArg result;
+    double scalar[CALCPERFORM_NARGS];
+    char rpn[MAX_POSTFIX_SIZE];
+    calcProgram *prog;
+    epicsTimeStamp start, stop;
+    double perElement, perArray;
+    short err;
+    int i, pass;
+
+    if (!a || !out || postfix("A*B+C>D?SQRT(A):A*A", rpn, &err) ||
+        !(prog = calcCompile(rpn))) {
+        testDiag("Can't set up benchmark");
+        free(a);
+        free(out);
+        return;
+    }
+    for (i = 0; i < count; i++)
+        a[i] = i * 0.01;
+    memcpy(scalar, scalars, sizeof(scalar));
+
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < passes; pass++) {
+        for (i = 0; i < count; i++) {
+            scalar[0] = a[i];
+            calcExecute(scalar, &out[i], prog);
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    perElement = epicsTimeDiffInSeconds(&stop, &start);
+
+    setArgs(args, 1);
+    args[0].pvalue = a;
+    args[0].count = count;
+    args[1].pvalue = &scalars[1];
+    args[1].count = 1;
+    result.pvalue = out;
+    epicsTimeGetCurrent(&start);
+    for (pass = 0; pass < passes; pass++) {
+        result.count = 0;
+        calcArrayExecute(work, args, &result, count, prog);
+    }
+    epicsTimeGetCurrent(&stop);
+    perArray = epicsTimeDiffInSeconds(&stop, &start);
+
+    testDiag("%d elements: calcExecute per element %.0f elements/s, "
+        "calcArrayExecute %.0f elements/s (%.1fx)", count,
+        passes * count / perElement, passes * count / perArray,
+        perElement / perArray);
+    calcProgramFree(prog);
+    free(a);
+    free(out);
+}
+
+MAIN(calcArrayTest)
+{
+    int i;
+
+    for (i = 0; i < NELEM; i++) {
+        ramp[i] = i + 1;
+        wave[i] = (i & 1) ? 0.0 : (i & 2) ? -1.0 : 1.0;
+    }
+    wave[0] = 0.0;
+
+    testPlan(38);
+    work = calcArrayCreate();
+    if (!work)
+        testAbort("calcArrayCreate failed");
+
+    testScalar("A*B+C");
+    testScalar("-A/(B-C)%D");
+    testScalar("A<B?SQRT(C):LOG(D)");
+    testScalar("A>B?C:D>E?F:G");
+    testScalar("MAX(A,B,C)+MIN(D,E)");
+    testScalar("FINITE(A,B)&&!ISNAN(C)");
+    testScalar("(A|B)<<C^~D");
+    testScalar("E:=A+B;E*E");
+    testScalar("SUM(A)+AVG(B)*AMIN(C)-AMAX(D)");
+    testScalar("ATAN2(A,B)+NINT(C/D)");
+
+    testArray("A*2+1", NELEM, NELEM, fnScaled);
+    testArray("A+B", NELEM, NELEM, fnSum);
+    testArray("A*C", 5, 5, fnShort);
+    testArray("10-A", NELEM, NELEM, fnLiteral);
+    testArray("ABS(B)+SIN(A)", NELEM, NELEM, fnAbs);
+    testArray("MAX(A,8)", NELEM, NELEM, fnMax);
+    testArray("MAX(B,0)", NELEM, NELEM, fnMaxWave);
+    testArray("A>4?A:-A", NELEM, NELEM, fnCond);
+    testArray("D>1?A+3:A", NELEM, NELEM, fnScalarCond);
+    testArray("A<3?0:A<6?B:A*10", NELEM, NELEM, fnNested);
+    testArray("E:=A*A;E+1", NELEM, NELEM, fnStore);
+    testArray("A/SUM(A)", NELEM, NELEM, fnNorm);
+
+    testReduce("SUM(A)", NELEM, NELEM * (NELEM + 1) / 2);
+    testReduce("AVG(A)", NELEM, (NELEM + 1) / 2.0);
+    testReduce("AMIN(B)", NELEM, -1.0);
+    testReduce("AMAX(A*B)", NELEM, 13.0);
+    testReduce("SUM(C)", 0, 0.0);
+    testReduce("AVG(C)", 0, epicsNAN);
+    testReduce("AMAX(C)", 0, epicsNAN);
+    testReduce("SUM(A*A)-AVG(C)", 4, 1496 - 2.5);
+    testReduce("AMAX(A<5?A:-A)", NELEM, 4.0);
+
+    testStore();
+    testLimits();
+
+    testReduce("SUM(A+C)", NELEM, NELEM * (NELEM + 1));
+    testReduce("SUM(D)", 1, 4.0);
+
+    benchArray();
+    calcArrayDestroy(work);
+    return testDone();
+}
@@ -13,6 +13,7 @@
 #include "epicsTypes.h"
 #include "epicsMath.h"
 #include "epicsAlgorithm.h"
+#include "epicsTime.h"
 #include "postfix.h"
 #include "testMain.h"
 
@@ -43,9 +44,34 @@ double doCalc(const char *expr) {
     return result;
 }
 
+bool sameCompiled(const char *expr, const char *rpn, long status,
+    double start, double result) {
+    /* Evaluate the compiled expression, it must match calcPerform() */
+    double args[CALCPERFORM_NARGS] = {
+        1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+    };
+    calcProgram *prog = calcCompile(rpn);
+    double cresult = start;
+    long cstatus;
+
+    if (!prog) {
+        testDiag("calcCompile: failed for '%s'", expr);
+        return false;
+    }
+    cstatus = calcExecute(args, &cresult, prog);
+    calcProgramFree(prog);
+    if (cstatus != status || memcmp(&cresult, &result, sizeof(double))) {
+        testDiag("calcExecute: got %g (status %ld), calcPerform %g (%ld)",
+                 cresult, cstatus, result, status);
+        return false;
+    }
+    return true;
+}
+
 void testCalc(const char *expr, double expected) {
     /* Evaluate expression, test against expected result */
     bool pass = false;
+    bool compiled = false;
     double args[CALCPERFORM_NARGS] = {
         1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
     };
@@ -61,10 +87,15 @@ void testCalc(const char *expr, double expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        double start = result;
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        compiled = sameCompiled(expr, rpn, status, start, result);
+    }
 
     if (finite(expected) && finite(result)) {
         pass = fabs(expected - result) < 1e-8;
@@ -73,6 +104,7 @@ void testCalc(const char *expr, double expected) {
     } else {
         pass = (result == expected);
     }
+    pass = pass && compiled;
     if (!testOk(pass, "%s", expr)) {
         testDiag("Expected result is %g, actually got %g", expected, result);
         calcExprDump(rpn);
@@ -83,6 +115,7 @@ void testCalc(const char *expr, double expected) {
 void testUInt32Calc(const char *expr, epicsUInt32 expected) {
     /* Evaluate expression, test against expected result */
     bool pass = false;
+    bool compiled = false;
     double args[CALCPERFORM_NARGS] = {
         1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
     };
@@ -99,13 +132,18 @@ void testUInt32Calc(const char *expr, epicsUInt32 expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        double start = result;
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        compiled = sameCompiled(expr, rpn, status, start, result);
+    }
 
     uresult = (epicsUInt32) result;
-    pass = (uresult == expected);
+    pass = (uresult == expected) && compiled;
     if (!testOk(pass, "%s", expr)) {
         testDiag("Expected result is 0x%x (%u), actually got 0x%x (%u)",
                  expected, expected, uresult, uresult);
@@ -157,6 +195,44 @@ void testBadExpr(const char *expr, short expected_err) {
     free(rpn);
 }
 
+void benchCalc(const char *expr) {
+    /* Compare calcPerform() and calcExecute() evaluation rates */
+    const int count = 200000;
+    double args[CALCPERFORM_NARGS] = {
+        1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+    };
+    char *rpn = (char*)malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr)+1));
+    calcProgram *prog;
+    epicsTimeStamp start, stop;
+    double result = 0.0, interp, compiled;
+    short err;
+    int n;
+
+    if (!rpn || postfix(expr, rpn, &err) || !(prog = calcCompile(rpn))) {
+        testFail("Can't compile '%s'", expr);
+        free(rpn);
+        return;
+    }
+    epicsTimeGetCurrent(&start);
+    for (n = 0; n < count; n++) {
+        args[0] = n;
+        calcPerform(args, &result, rpn);
+    }
+    epicsTimeGetCurrent(&stop);
+    interp = count / epicsTimeDiffInSeconds(&stop, &start);
+    epicsTimeGetCurrent(&start);
+    for (n = 0; n < count; n++) {
+        args[0] = n;
+        calcExecute(args, &result, prog);
+    }
+    epicsTimeGetCurrent(&stop);
+    compiled = count / epicsTimeDiffInSeconds(&stop, &start);
+    testDiag("%-36s %6.2f M/s interpreted, %6.2f M/s compiled (%.2fx)",
+             expr, interp / 1e6, compiled / 1e6, compiled / interp);
+    calcProgramFree(prog);
+    free(rpn);
+}
+
 /* Test an expression that is also valid C code */
 #define testExpr(expr) testCalc(#expr, expr);
 
@@ -987,6 +1063,15 @@ MAIN(epicsCalcTest)
     testUInt32Calc("-1431655766.1 << 0.1", 0xaaaaaaaau);
     testUInt32Calc("2863311530.1 << 0.1", 0xaaaaaaaau);
 
+    testDiag("Throughput of calcPerform() and calcExecute()");
+    benchCalc("A+B");
+    benchCalc("(A+B)*C/D-1");
+    benchCalc("A>B?C:D");
+    benchCalc("A%2?B+1:(C>2?D*2:E)");
+    benchCalc("ABS(A-B)<0.5*PI/180 && C#D");
+    benchCalc("MAX(A,B,C,D)-MIN(E,F,G,H)+SQRT(L)");
+    benchCalc("VAL+(A-VAL)/10");
+
     return testDone();
 }
 
@@ -21,6 +21,7 @@
 #include <errno.h>
 #include <time.h>
 
+#include "envDefs.h"
 #include "epicsTime.h"
 #include "epicsThread.h"
 #include "epicsMutex.h"
@@ -199,6 +200,81 @@ void epicsMutexPerformance ()
     testDiag("lock()*4/unlock()*4 takes %f microseconds", delay);
 }
 
+/* Contended throughput, each thread repeatedly takes the lock
+ * to increment a shared counter until the deadline passes.
+ */
+struct throughput {
+    epicsMutexId mutex;
+    epicsUInt64 deadline;
+    unsigned long shared;
+};
+
+struct throughputEnt {
+    struct throughput *main;
+    unsigned long count;
+    epicsEventId done;
+};
+
+extern "C" void throughputThread ( void *pArg )
+{
+    struct throughputEnt *pEnt = ( struct throughputEnt * ) pArg;
+    struct throughput *pMain = pEnt->main;
+
+    while ( epicsMonotonicGet () < pMain->deadline ) {
+        for ( unsigned i = 0; i < 100; i++ ) {
+            epicsMutexMustLock ( pMain->mutex );
+            pMain->shared++;
+            epicsMutexUnlock ( pMain->mutex );
+        }
+        pEnt->count += 100;
+    }
+    epicsEventSignal ( pEnt->done );
+}
+
+static int throughputMaxThreads ()
+{
+    int n = 2 * epicsThreadGetCPUs ();
+    return n < 4 ? 4 : n > 8 ? 8 : n;
+}
+
+void epicsMutexThroughput ()
+{
+    static const double runTime = 0.2;
+    const int nmax = throughputMaxThreads ();
+    struct throughputEnt *ents;
+    struct throughput tp;
+
+    testDiag ( "Contended throughput with EPICS_MUTEX_SPIN_COUNT=%s",
+        envGetConfigParamPtr ( &EPICS_MUTEX_SPIN_COUNT ) );
+
+    tp.mutex = epicsMutexMustCreate ();
+    ents = ( struct throughputEnt * ) calloc ( nmax, sizeof ( *ents ) );
+    for ( int n = 1; n <= nmax; n++ ) {
+        unsigned long total = 0;
+        epicsUInt64 start = epicsMonotonicGet ();
+
+        tp.shared = 0;
+        tp.deadline = start + ( epicsUInt64 ) ( runTime * 1e9 );
+        for ( int i = 0; i < n; i++ ) {
+            ents[i].main = &tp;
+            ents[i].count = 0;
+            ents[i].done = epicsEventMustCreate ( epicsEventEmpty );
+            epicsThreadMustCreate ( "mutexThroughput", 40,
+                epicsThreadGetStackSize ( epicsThreadStackSmall ),
+                throughputThread, &ents[i] );
+        }
+        for ( int i = 0; i < n; i++ ) {
+            epicsEventMustWait ( ents[i].done );
+            epicsEventDestroy ( ents[i].done );
+            total += ents[i].count;
+        }
+        testOk ( tp.shared == total, "%d threads: %.0f lock pairs per second",
+            n, total / ( ( epicsMonotonicGet () - start ) * 1e-9 ) );
+    }
+    free ( ents );
+    epicsMutexDestroy ( tp.mutex );
+}
+
 struct verifyTryLock {
     epicsMutexId mutex;
     epicsEventId done;
@@ -233,6 +309,62 @@ void verifyTryLock ()
     epicsEventDestroy ( verify.done );
 }
 
+extern "C" void verifyProfileThread ( void *pArg )
+{
+    struct verifyTryLock *pVerify =
+        ( struct verifyTryLock * ) pArg;
+
+    epicsMutexMustLock ( pVerify->mutex );
+    epicsMutexUnlock ( pVerify->mutex );
+    epicsEventSignal ( pVerify->done );
+}
+
+void verifyProfile ()
+{
+    struct verifyTryLock verify;
+    epicsMutexProfileStats stats;
+
+    verify.mutex = epicsMutexMustCreate ();
+    verify.done = epicsEventMustCreate ( epicsEventEmpty );
+
+    epicsMutexMustLock ( verify.mutex );
+    epicsMutexUnlock ( verify.mutex );
+    epicsMutexProfileGet ( verify.mutex, &stats );
+    testOk(stats.nLock == 0u, "No statistics while profiling is disabled");
+
+    epicsMutexProfileEnable ( 1 );
+
+    epicsMutexMustLock ( verify.mutex );
+    /* recursive locks aren't counted */
+    epicsMutexMustLock ( verify.mutex );
+    epicsMutexUnlock ( verify.mutex );
+
+    epicsThreadCreate ( "verifyProfileThread", 40,
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        verifyProfileThread, &verify );
+    epicsThreadSleep ( 0.1 );
+    epicsMutexUnlock ( verify.mutex );
+    testOk1(epicsEventWait ( verify.done ) == epicsEventWaitOK);
+
+    epicsMutexProfileEnable ( 0 );
+
+    epicsMutexProfileGet ( verify.mutex, &stats );
+    testOk(stats.nLock == 2u, "nLock %lu", (unsigned long) stats.nLock);
+    testOk(stats.nContended == 1u, "nContended %lu",
+        (unsigned long) stats.nContended);
+    testOk(stats.waitNs >= 50000000u && stats.maxWaitNs == stats.waitNs,
+        "waited %.3f ms", stats.waitNs * 1e-6);
+    testOk(stats.maxHoldNs >= 90000000u && stats.holdNs >= stats.maxHoldNs,
+        "held %.3f ms", stats.maxHoldNs * 1e-6);
+
+    epicsMutexProfileReset ();
+    epicsMutexProfileGet ( verify.mutex, &stats );
+    testOk1(stats.nLock == 0u && stats.waitNs == 0u);
+
+    epicsMutexDestroy ( verify.mutex );
+    epicsEventDestroy ( verify.done );
+}
+
 MAIN(epicsMutexTest)
 {
     const int nthreads = 3;
@@ -246,9 +378,10 @@ MAIN(epicsMutexTest)
     epicsMutexId mutex;
     int status;
 
-    testPlan(5 + nthreads * nrounds);
+    testPlan(12 + nthreads * nrounds + throughputMaxThreads ());
 
     verifyTryLock ();
+    verifyProfile ();
 
     mutex = epicsMutexMustCreate();
     status = epicsMutexLock(mutex);
@@ -278,6 +411,7 @@ MAIN(epicsMutexTest)
     epicsThreadSleep(2.0 + nrounds);
 
     epicsMutexPerformance ();
+    epicsMutexThroughput ();
 
     free(pinfo);
     free(arg);
@@ -21,6 +21,7 @@ int blockingSockTest(void);
 int epicsAlgorithm(void);
 int epicsAtomicTest(void);
 int epicsCalcTest(void);
+int calcArrayTest(void);
 int epicsEllTest(void);
 int epicsEnvTest(void);
 int epicsErrlogTest(void);
@@ -49,6 +50,7 @@ int epicsTimeZoneTest(void);
 #endif
 int epicsTypesTest(void);
 int epicsInlineTest(void);
+int initHookTimingTest(void);
 int ipAddrToAsciiTest(void);
 int macDefExpandTest(void);
 int macLibTest(void);
@@ -79,6 +81,7 @@ void epicsRunLibComTests(void)
     runTest(epicsAlgorithm);
     runTest(epicsAtomicTest);
     runTest(epicsCalcTest);
+    runTest(calcArrayTest);
     runTest(epicsEllTest);
     runTest(epicsEnvTest);
     runTest(epicsErrlogTest);
@@ -104,6 +107,7 @@ void epicsRunLibComTests(void)
     runTest(epicsTimeZoneTest);
 #endif
     runTest(epicsTypesTest);
+    runTest(initHookTimingTest);
     runTest(ipAddrToAsciiTest);
     runTest(macDefExpandTest);
     runTest(macLibTest);
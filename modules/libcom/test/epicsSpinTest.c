@@ -20,6 +20,7 @@
 #include <errno.h>
 #include <time.h>
 
+#include "envDefs.h"
 #include "epicsTime.h"
 #include "epicsThread.h"
 #include "epicsAtomic.h"
@@ -116,6 +117,83 @@ void epicsSpinPerformance ()
     epicsSpinDestroy(spin);
 }
 
+/* Contended throughput, each thread repeatedly takes the lock
+ * to increment a shared counter until the deadline passes.
+ */
+struct throughput {
+    epicsSpinId spin;
+    epicsUInt64 deadline;
+    unsigned long shared;
+};
+
+struct throughputEnt {
+    struct throughput *main;
+    unsigned long count;
+    epicsEventId done;
+};
+
+static void throughputThread(void *pArg)
+{
+    struct throughputEnt *pEnt = (struct throughputEnt *) pArg;
+    struct throughput *pMain = pEnt->main;
+
+    while (epicsMonotonicGet() < pMain->deadline) {
+        unsigned i;
+        for (i = 0; i < 100; i++) {
+            epicsSpinLock(pMain->spin);
+            pMain->shared++;
+            epicsSpinUnlock(pMain->spin);
+        }
+        pEnt->count += 100;
+    }
+    epicsEventSignal(pEnt->done);
+}
+
+static int throughputMaxThreads(void)
+{
+    int n = 2 * epicsThreadGetCPUs();
+    return n < 4 ? 4 : n > 8 ? 8 : n;
+}
+
+static void epicsSpinThroughput(void)
+{
+    static const double runTime = 0.2;
+    const int nmax = throughputMaxThreads();
+    struct throughputEnt *ents;
+    struct throughput tp;
+    int n, i;
+
+    testDiag("Contended throughput with EPICS_SPIN_BUSY_WAIT=%s",
+        envGetConfigParamPtr(&EPICS_SPIN_BUSY_WAIT));
+
+    tp.spin = epicsSpinMustCreate();
+    ents = calloc(nmax, sizeof(*ents));
+    for (n = 1; n <= nmax; n++) {
+        unsigned long total = 0;
+        epicsUInt64 start = epicsMonotonicGet();
+
+        tp.shared = 0;
+        tp.deadline = start + (epicsUInt64) (runTime * 1e9);
+        for (i = 0; i < n; i++) {
+            ents[i].main = &tp;
+            ents[i].count = 0;
+            ents[i].done = epicsEventMustCreate(epicsEventEmpty);
+            epicsThreadMustCreate("spinThroughput", 40,
+                epicsThreadGetStackSize(epicsThreadStackSmall),
+                throughputThread, &ents[i]);
+        }
+        for (i = 0; i < n; i++) {
+            epicsEventMustWait(ents[i].done);
+            epicsEventDestroy(ents[i].done);
+            total += ents[i].count;
+        }
+        testOk(tp.shared == total, "%d threads: %.0f lock pairs per second",
+            n, total / ((epicsMonotonicGet() - start) * 1e-9));
+    }
+    free(ents);
+    epicsSpinDestroy(tp.spin);
+}
+
 struct verifyTryLock;
 
 struct verifyTryLockEnt {
@@ -201,7 +279,7 @@ MAIN(epicsSpinTest)
     info **pinfo;
     epicsSpinId spin;
 
-    testPlan(2);
+    testPlan(2 + throughputMaxThreads());
 
     verifyTryLock();
 
@@ -242,6 +320,7 @@ MAIN(epicsSpinTest)
     epicsSpinDestroy(spin);
 
     epicsSpinPerformance();
+    epicsSpinThroughput();
 
     return testDone();
 }
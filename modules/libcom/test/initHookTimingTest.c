@@ -0,0 +1,180 @@
+/*************************************************************************\
+* Copyright (c) 2019 UChicago Argonne LLC, as Operator of Argonne
+*     National Laboratory.
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Tests for the startup profiling of iocsh commands and init hook states
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "initHooks.h"
+#include "iocsh.h"
+#include "libComRegister.h"
+#include "testMain.h"
+
+static const char jsonFile[] = "initHookTimingTest.json";
+
+static char * readFile(const char *name)
+{
+    FILE *fp = fopen(name, "rb");
+    char *text;
+    long size;
+
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    text = calloc(1, size + 1);
+    if (text && fread(text, 1, size, fp) != (size_t) size) {
+        free(text);
+        text = NULL;
+    }
+    fclose(fp);
+    return text;
+}
+
+static int hookCalls;
+
+static void slowHook(initHookState state)
+{
+    hookCalls++;
+    if (state == initHookAfterInitDatabase)
+        epicsThreadSleep(0.1);
+}
+
+static void testDisabled(void)
+{
+    testDiag("Nothing is recorded unless enabled");
+
+    remove(jsonFile);
+    testOk1(initHookCommandStart() == NULL);
+    iocshCmd("epicsThreadSleep 0.01");
+    initHookAnnounce(initHookAtIocBuild);
+    initHookAnnounce(initHookAtEnd);
+    testOk1(readFile(jsonFile) == NULL);
+}
+
+static void testProfile(void)
+{
+    const char *p;
+    char *json;
+    int state;
+
+    testDiag("Commands and intervals are reported at initHookAtEnd");
+
+    iocshCmd("initHookTimingEnable 1 initHookTimingTest.json");
+    iocshCmd("epicsThreadSleep 0.05");
+    iocshCmd("iocshCmd \"date\"");
+
+    hookCalls = 0;
+    for (state = initHookAtIocBuild; state <= initHookAfterIocBuilt; state++)
+        initHookAnnounce((initHookState) state);
+    initHookAnnounce(initHookAtEnd);
+    testOk(hookCalls == initHookAfterIocBuilt - initHookAtIocBuild + 2,
+        "Hooks were called (%d)", hookCalls);
+
+    json = readFile(jsonFile);
+    testOk(json != NULL, "JSON file written");
+    if (!json)
+        json = calloc(1, 1);
+
+    p = strstr(json, "\"epicsThreadSleep 0.05\"");
+    testOk(p != NULL, "Command recorded");
+    if (p) {
+        double seconds = -1;
+
+        p = strstr(p, "\"seconds\"");
+        if (p)
+            sscanf(p, "\"seconds\": %lf", &seconds);
+        testOk(seconds >= 0.04 && seconds < 5,
+            "Command took %.3f s", seconds);
+    }
+    else
+        testSkip(1, "Command not recorded");
+
+    /* nested commands are recorded one level deeper */
+    p = strstr(json, "\"date\"");
+    testOk(p && strstr(p, "\"depth\": 1"), "Nested command recorded");
+    testOk1(strstr(json, "\"iocshCmd date\"") != NULL);
+
+    p = strstr(json, "\"initHookAfterInitDatabase\"");
+    testOk(p != NULL, "Interval recorded");
+    if (p) {
+        double seconds = -1;
+
+        p = strstr(p, "\"seconds\"");
+        if (p)
+            sscanf(p, "\"seconds\": %lf", &seconds);
+        testOk(seconds < 0.05, "Hooks are timed by the next interval (%.3f s)",
+            seconds);
+        p = strstr(json, "\"initHookAfterFinishDevSup\"");
+        p = p ? strstr(p, "\"seconds\"") : NULL;
+        seconds = -1;
+        if (p)
+            sscanf(p, "\"seconds\": %lf", &seconds);
+        testOk(seconds >= 0.09, "Slow hook counted in the next interval "
+            "(%.3f s)", seconds);
+    }
+    else
+        testSkip(2, "Interval not recorded");
+    testOk1(strstr(json, "\"initHookAtIocRun\"") == NULL);
+    free(json);
+
+    /* profiling switches itself off after the report */
+    remove(jsonFile);
+    testOk1(initHookCommandStart() == NULL);
+    initHookAnnounce(initHookAtEnd);
+    testOk1(readFile(jsonFile) == NULL);
+}
+
+/* Announces the states like iocInit does */
+static const iocshFuncDef fakeIocInitFuncDef = {"fakeIocInit", 0, NULL};
+static void fakeIocInitCallFunc(const iocshArgBuf *args)
+{
+    int state;
+
+    for (state = initHookAtIocBuild; state <= initHookAfterIocBuilt; state++)
+        initHookAnnounce((initHookState) state);
+    epicsThreadSleep(0.05);
+    initHookAnnounce(initHookAtEnd);
+}
+
+static void testIocInitCommand(void)
+{
+    char *json;
+
+    testDiag("The command that announces initHookAtEnd is reported");
+
+    remove(jsonFile);
+    iocshRegister(&fakeIocInitFuncDef, fakeIocInitCallFunc);
+    iocshCmd("initHookTimingEnable 1 initHookTimingTest.json");
+    iocshCmd("fakeIocInit");
+
+    json = readFile(jsonFile);
+    testOk(json && strstr(json, "\"fakeIocInit\"") != NULL,
+        "fakeIocInit recorded");
+    testOk1(initHookCommandStart() == NULL);
+    free(json);
+    remove(jsonFile);
+}
+
+MAIN(initHookTimingTest)
+{
+    testPlan(16);
+    libComRegister();
+    initHookRegister(slowHook);
+    testDisabled();
+    testProfile();
+    testIocInitCommand();
+    initHookFree();
+    return testDone();
+}
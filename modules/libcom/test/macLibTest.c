@@ -16,6 +16,7 @@
 #include "dbDefs.h"
 #include "envDefs.h"
 #include "errlog.h"
+#include "epicsTime.h"
 #include "epicsUnitTest.h"
 #include "testMain.h"
 
@@ -63,9 +64,106 @@ static void ovcheck(void)
     testOk(output[53] == '~', "sentinel character %x, expect 7e, (~)", output[53]);
 }
 
+/* Enough macros that the hash index has to grow a few times */
+#define NMACROS 200
+
+static void scopecheck(void)
+{
+    MAC_HANDLE *save = h;
+    char name[16], value[16];
+    int i;
+
+    testDiag("Scoping with %d macros", NMACROS);
+    if (macCreateHandle(&h, NULL))
+        testAbort("macCreateHandle() failed");
+
+    for (i = 0; i < NMACROS; i++) {
+        sprintf(name, "M%d", i);
+        sprintf(value, "a%d", i);
+        macPutValue(h, name, value);
+    }
+    check("$(M0)$(M199)", " a0a199");
+
+    macPushScope(h);
+    macPutValue(h, "M5", "b5");
+    macPutValue(h, "NEW", "new");
+    check("$(M5)$(M6)$(NEW)", " b5a6new");
+    macPushScope(h);
+    macPutValue(h, "M5", "c5");
+    check("$(M5)", " c5");
+    macPopScope(h);
+    check("$(M5)", " b5");
+    macPopScope(h);
+    check("$(M5)$(M199)", " a5a199");
+    check("$(NEW)", "!$(NEW,undefined)");
+    testOk1(macGetValue(h, "M5", value, sizeof(value)) == 2 &&
+        strcmp(value, "a5") == 0);
+
+    macPutValue(h, "M7", NULL);
+    check("$(M7)", "!$(M7,undefined)");
+    macPutValue(h, "M7", "d7");
+    check("$(M7)", " d7");
+
+    /* cached values are updated when anything they use changes */
+    macPutValue(h, "REF", "$(M8)-$(M9)");
+    check("$(REF)", " a8-a9");
+    macPutValue(h, "M9", "e9");
+    check("$(REF)", " a8-e9");
+    check("$(REF,M8=f8)", " f8-e9");
+    check("$(REF)", " a8-e9");
+    macPutValue(h, "M8", NULL);
+    check("$(REF)", "!$(M8,undefined)-e9");
+
+    macDeleteHandle(h);
+    h = save;
+}
+
+/* Like loading a template with NMACROS substitutions many times */
+static void benchmark(void)
+{
+    const int ninstances = 2000, nlines = 20;
+    char defns[NMACROS * 24], line[NMACROS];
+    char output[MAC_SIZE];
+    epicsTimeStamp start, stop;
+    double elapsed;
+    long nrefs = 0;
+    int i, j;
+
+    defns[0] = '\0';
+    for (i = 0; i < NMACROS; i++)
+        sprintf(defns + strlen(defns), "%sMACRO%d=value%d", i ? "," : "", i, i);
+
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < ninstances; i++) {
+        MAC_HANDLE *handle;
+        char **pairs;
+
+        if (macCreateHandle(&handle, NULL))
+            testAbort("macCreateHandle() failed");
+        macParseDefns(handle, defns, &pairs);
+        macInstallMacros(handle, pairs);
+        free(pairs);
+
+        for (j = 0; j < nlines; j++) {
+            sprintf(line, "record(ai, \"$(MACRO%d):$(MACRO%d)\") "
+                "{ field(INP, \"$(MACRO%d)\") }",
+                j, NMACROS - 1 - j, (i + j) % NMACROS);
+            macExpandString(handle, line, output, sizeof(output));
+            nrefs += 3;
+        }
+        macDeleteHandle(handle);
+    }
+    epicsTimeGetCurrent(&stop);
+    elapsed = epicsTimeDiffInSeconds(&stop, &start);
+
+    testDiag("%d instances with %d macros and %d lines in %.3f s, "
+        "%.0f references/s", ninstances, NMACROS, nlines, elapsed,
+        nrefs / elapsed);
+}
+
 MAIN(macLibTest)
 {
-    testPlan(93);
+    testPlan(107);
 
     if (macCreateHandle(&h, NULL))
         testAbort("macCreateHandle() failed");
@@ -220,6 +318,8 @@ MAIN(macLibTest)
     check("${FOO}", "!$(BAR)");
 
     ovcheck();
+    scopecheck();
+    benchmark();
 
     return testDone();
 }